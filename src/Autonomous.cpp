@@ -29,6 +29,8 @@ namespace frc973 {
                 return "KillerHopper";
             case AutonomousRoutine::MidPegKpa:
                 return "MidPegKpa";
+            case AutonomousRoutine::KillerHopperSequenced:
+                return "KillerHopperSeq";
             default:
                 return "Error. RESTART!";
         }
@@ -44,10 +46,18 @@ namespace frc973 {
         m_autoTimer = GetMsecTime();
 
         m_autoState = 0;
+
+        if (m_autoRoutine == AutonomousRoutine::KillerHopperSequenced) {
+            BuildKillerHopperSequence();
+            m_autoSequencer.Start();
+        }
     }
 
     void Robot::AutonomousStop(void) {
         printf("***auto stop\n");
+        if (m_autoRoutine == AutonomousRoutine::KillerHopperSequenced) {
+            m_autoSequencer.PrintStepTimes();
+        }
     }
 
     void Robot::AutonomousContinuous(void) {
@@ -80,6 +90,11 @@ namespace frc973 {
             case AutonomousRoutine::MidPegKpa:
                 MidPegKpaAuto();
                 break;
+            case AutonomousRoutine::KillerHopperSequenced:
+                m_autoSequencer.Update();
+                DBStringPrintf(DB_LINE2, "auto %s",
+                        m_autoSequencer.GetCurrentStepName());
+                break;
         }
     }
 }
@@ -7,6 +7,7 @@
 #include "controllers/PIDDrive.h"
 #include "lib/JoystickHelper.h"
 #include "lib/WrapDash.h"
+#include "lib/Tracer.h"
 
 using namespace frc;
 
@@ -14,6 +15,16 @@ namespace frc973 {
 
 void Robot::DisabledStart(void) {
     fprintf(stderr, "***disable start\n");
+    this->PrintTaskStats();
+    RTThread::PrintThreadReport();
+
+    if (Tracer::IsEnabled()) {
+        char traceName[64];
+
+        snprintf(traceName, sizeof(traceName), "/home/lvuser/trace-%llu.json",
+                (unsigned long long) GetFPGATime());
+        Tracer::WriteChromeTraceAsync(traceName);
+    }
 }
 
 void Robot::DisabledStop(void) {
@@ -28,7 +39,7 @@ void Robot::DisabledContinuous(void) {
   }
 
   DBStringPrintf(DBStringPos::DB_LINE0,
-                 "%c %s %s",
+                 "%c",
                  (m_alliance == Alliance::Red) ? 'R' : 'B');
 }
 
@@ -39,6 +50,7 @@ void Robot::HandleDisabledButton(uint32_t port, uint32_t button,
     switch (button) {
         case DualAction::BtnA:
             if (pressedP) {
+                m_autoRoutine = AutonomousRoutine::KillerHopperSequenced;
             }
             break;
         case DualAction::BtnB:
@@ -5,8 +5,14 @@
 
 #include "lib/GreyCompressor.h"
 #include "lib/logging/LogSpreadsheet.h"
+#include "lib/logging/DeferredLog.h"
+#include "lib/logging/TaskStatsLogger.h"
+#include "lib/logging/FlightRecorder.h"
 #include "lib/WrapDash.h"
+#include "lib/DashboardPublisher.h"
+#include "lib/SingleThreadTaskMgr.h"
 #include "lib/SPIGyro.h"
+#include "lib/Tracer.h"
 #include "subsystems/Drive.h"
 #include "subsystems/Hanger.h"
 #include "subsystems/BallIntake.h"
@@ -22,6 +28,59 @@ using namespace frc;
 
 namespace frc973 {
 
+/**
+ * Run tasks that don't share resources on both cores.  Off until every
+ * task declares its resources (TaskMgr::SetTaskResources); until then the
+ * undeclared ones serialize everything anyway and the worker only adds
+ * handoffs.  False runs every task one after another on the robot thread.
+ */
+static constexpr bool PARALLEL_TASKS = false;
+
+/**
+ * How to write the log.  Compressed logs are binary rows squeezed into
+ * blocks about a tenth the size; turn either kind of binary log back into
+ * CSV on a laptop with tools/logtocsv.
+ */
+static constexpr LogFormat ROBOT_LOG_FORMAT = LOG_FORMAT_COMPRESSED;
+
+/**
+ * Trace every task call, drive controller update and gyro reading on every
+ * thread.  The trace is written to /home/lvuser/trace-<time>.json each
+ * time the robot is disabled; open it in chrome://tracing or
+ * ui.perfetto.dev.
+ */
+static constexpr bool ROBOT_TRACE = false;
+
+/**
+ * Least severe diagnostics (DebugPrintf and friends) printed to the
+ * console.  They're formatted and written by their own thread, so the
+ * control loop never waits on netconsole.
+ */
+static constexpr DeferredLogLevel ROBOT_LOG_LEVEL = DLOG_DEBUG;
+
+/**
+ * How often the debug string lines (DBStringPrintf) that changed are sent
+ * to the dashboard, from a thread of their own
+ */
+static constexpr double DASHBOARD_PUBLISH_HZ = 10.0;
+
+/**
+ * The flight recorder keeps the last FLIGHT_RECORDER_HISTORY_SEC seconds
+ * of every numeric log cell and the task timing, sampled at
+ * FLIGHT_RECORDER_HZ, in RAM.  On a brownout, an uncaught exception, a
+ * mode change or the driver's back button it records
+ * FLIGHT_RECORDER_POST_TRIGGER_SEC more and writes it all to
+ * /home/lvuser/log-flight-<time>.bin (read it with tools/logtocsv).
+ * FLIGHT_RECORDER_ON_OVERRUN adds main loop overruns to the triggers; a
+ * loop that keeps overrunning then dumps every few seconds.
+ */
+static constexpr bool FLIGHT_RECORDER = true;
+static constexpr double FLIGHT_RECORDER_HZ = 200.0;
+static constexpr double FLIGHT_RECORDER_HISTORY_SEC = 10.0;
+static constexpr double FLIGHT_RECORDER_POST_TRIGGER_SEC = 2.0;
+static constexpr double FLIGHT_RECORDER_BROWNOUT_VOLTS = 7.5;
+static constexpr bool FLIGHT_RECORDER_ON_OVERRUN = false;
+
 Robot::Robot(void
     ) :
     CoopMTRobot(),
@@ -32,6 +91,7 @@ Robot::Robot(void
     m_autoTimer(0),
     m_teleopTimer(0),
     m_autoRoutine(AutonomousRoutine::KillerHopper),
+    m_autoSequencer(this),
     m_speedSetpt(2900),
     m_flailSetpt(1.0),
     m_alliance(Alliance::Red),
@@ -123,37 +183,44 @@ Robot::Robot(void
     m_leftAgitatorTalon = new CANTalon(LEFT_AGITATOR_CAN_ID, 5);
     fprintf(stderr, "Initialized drive controllers\n");
 
-    m_logger = new LogSpreadsheet(this);
-    m_time = new LogCell("Time");
+    m_logger = new LogSpreadsheet(this, LOG_WRITER_THREAD_RT);
+    m_logger->SetFormat(ROBOT_LOG_FORMAT);
+    if (ROBOT_LOG_FORMAT == LOG_FORMAT_COMPRESSED) {
+        /* bigger blocks compress better; at most two seconds of rows are
+         * waiting in memory if the power goes */
+        m_logger->SetBuffering(LogWriter::DEFAULT_RING_ROWS, 100, 2000);
+    }
+    m_time = new LogCell("Time", LOG_CELL_DOUBLE);
     m_logger->RegisterCell(m_time);
     m_driverJoystick->RegisterLog(m_logger);
     m_operatorJoystick->RegisterLog(m_logger);
     m_lights = new Lights(this);
     m_boilerPixy = new BoilerPixy(this, m_lights, m_logger);
-    m_pixyR = new PixyThread(*this);
+    m_pixyR = new PixyThread(*this, GEAR_PIXY_THREAD_RT);
     m_austinGyro = new ADXRS450_Gyro();
     m_drive = new Drive(this,
             m_leftDriveTalonA, m_rightDriveTalonA, m_leftAgitatorTalon,
             m_logger, m_boilerPixy, m_pixyR,
             m_austinGyro);
 
-    m_battery = new LogCell("Battery voltage");
+    m_battery = new LogCell("Battery voltage", LOG_CELL_DOUBLE);
     m_state = new LogCell("Game State");
     m_messages = new LogCell("Robot messages", 100, true);
     m_buttonPresses = new LogCell("Button Presses", 100, true);
-    m_xAccel = new LogCell("X acceleration", 32, true);
-    m_yAccel = new LogCell("Y acceleration", 32, true);
-    m_zAccel = new LogCell("Z acceleration", 32, true);
+    m_xAccel = new LogCell("X acceleration", LOG_CELL_DOUBLE, true);
+    m_yAccel = new LogCell("Y acceleration", LOG_CELL_DOUBLE, true);
+    m_zAccel = new LogCell("Z acceleration", LOG_CELL_DOUBLE, true);
     m_autoStateLog = new LogCell("Auto state", 32, true);
     m_autoSelectLog = new LogCell("Selected auto routine", 32, true);
-    m_boilerOffset = new LogCell("AngleOffset", 32, true);
-    m_gearOffset = new LogCell("GearOffset", 32, true);
+    m_boilerOffset = new LogCell("AngleOffset", LOG_CELL_DOUBLE, true);
+    m_gearOffset = new LogCell("GearOffset", LOG_CELL_DOUBLE, true);
 
-    m_austinGyroLog = new LogCell("Austin Gyro Angle");
-    m_austinGyroRateLog = new LogCell("Austin Gyro Angular Rate");
+    m_austinGyroLog = new LogCell("Austin Gyro Angle", LOG_CELL_DOUBLE);
+    m_austinGyroRateLog = new LogCell("Austin Gyro Angular Rate",
+            LOG_CELL_DOUBLE);
 
     m_logger->RegisterCell(m_battery);
-    m_logger->RegisterCell(m_state);
+    m_logger->RegisterCell(m_state, LOG_SAMPLE_ON_CHANGE);
     m_logger->RegisterCell(m_messages);
     m_logger->RegisterCell(m_buttonPresses);
     m_logger->RegisterCell(m_xAccel);
@@ -175,6 +242,59 @@ Robot::Robot(void
     m_compressorRelay = new Relay(COMPRESSOR_RELAY, Relay::kForwardOnly);
     m_compressor = new GreyCompressor(m_airPressureSwitch, m_compressorRelay, this);
 
+    m_taskStatsLogger = new TaskStatsLogger(this, m_logger);
+
+    m_dashboard = new DashboardPublisher(PutDBString, nullptr);
+    /* the boiler pixy voltages flicker every cycle */
+    m_dashboard->SetLineMinPeriod(DB_LINE7, 500);
+    m_dashboardThread = new SingleThreadTaskMgr(*this,
+            1.0 / DASHBOARD_PUBLISH_HZ, false);
+    m_dashboardThread->SetThreadConfig(DASHBOARD_THREAD_RT);
+    m_dashboardThread->RegisterTask("Dashboard", m_dashboard, TASK_PERIODIC);
+    m_dashboardThread->Start();
+
+    m_flightRecorder = nullptr;
+    m_flightRecorderThread = nullptr;
+    if (FLIGHT_RECORDER) {
+        m_flightRecorder = new FlightRecorder(this, m_logger,
+                FLIGHT_RECORDER_HISTORY_SEC * FLIGHT_RECORDER_HZ,
+                FLIGHT_RECORDER_POST_TRIGGER_SEC * FLIGHT_RECORDER_HZ,
+                FLIGHT_WRITER_THREAD_RT);
+        m_flightRecorder->SetBrownoutTrigger(m_battery,
+                FLIGHT_RECORDER_BROWNOUT_VOLTS);
+        if (FLIGHT_RECORDER_ON_OVERRUN) {
+            m_flightRecorder->SetAutoTriggers(FLIGHT_TRIGGER_ALL);
+        }
+        m_flightRecorderThread = new SingleThreadTaskMgr(*this,
+                1.0 / FLIGHT_RECORDER_HZ, false);
+        m_flightRecorderThread->SetThreadConfig(FLIGHT_RECORDER_THREAD_RT);
+        m_flightRecorderThread->RegisterTask("Flight recorder",
+                m_flightRecorder, TASK_START_MODE | TASK_PERIODIC);
+        m_flightRecorderThread->Start();
+    }
+
+    /* anything not declared here (joysticks, logger...) runs on its own */
+    this->SetTaskResources(m_drive, 0, RES_DRIVE | RES_BOILER_PIXY);
+    this->SetTaskResources(m_shooter, 0,
+            RES_SHOOTER | RES_DRIVE | RES_BOILER_PIXY);
+    this->SetTaskResources(m_boilerPixy, 0, RES_BOILER_PIXY | RES_LIGHTS);
+    this->SetTaskResources(m_gearIntake, 0, RES_GEAR_INTAKE | RES_LIGHTS);
+    this->SetTaskResources(m_lights, 0, RES_LIGHTS);
+    this->SetTaskResources(m_ballIntake, 0, RES_BALL_INTAKE);
+    this->SetTaskResources(m_hanger, 0, RES_HANGER);
+    this->SetTaskResources(m_compressor, 0, RES_COMPRESSOR);
+    /* writing a log row shouldn't eat more than a fifth of the cycle */
+    this->SetTaskBudget(m_logger, ROBOT_LOOP_PERIOD_US / 5);
+    if (PARALLEL_TASKS) {
+        this->SetExecutionMode(TaskMgr::ParallelExecution,
+                DEFAULT_TASK_THREADS, TASK_WORKER_THREAD_RT);
+    }
+    if (ROBOT_TRACE) {
+        Tracer::Enable();
+    }
+    DeferredLog::SetLevel(ROBOT_LOG_LEVEL);
+    DeferredLog::Start(DEFERRED_LOG_THREAD_RT);
+
     fprintf(stderr, "initializing aliance\n");
     fprintf(stderr, "done w/ constructor\n");
 
@@ -184,17 +304,27 @@ Robot::~Robot(void) {
 }
 
 void Robot::Initialize(void) {
+    RTThread::Configure(ROBOT_MAIN_THREAD_RT);
+    if (LOCK_ROBOT_MEMORY) {
+        RTThread::LockAllMemory();
+    }
     printf("gonna initialize logger\n");
     m_logger->InitializeTable();
+    if (m_flightRecorder != nullptr) {
+        /* every cell and task is registered by now */
+        m_flightRecorder->Initialize();
+        FlightRecorder::DumpOnTerminate(m_flightRecorder);
+    }
     m_austinGyro->Calibrate();
     printf("initialized\n");
  }
 
 void Robot::AllStateContinuous(void) {
-    m_battery->LogPrintf("%f",
-            DriverStation::GetInstance().GetBatteryVoltage());
+    RobotStateSnapshot state = GetRobotState();
+
+    m_battery->LogDouble(state.batteryVoltage);
     m_time->LogDouble(GetSecTime());
-    m_state->LogPrintf("%s", GetRobotModeString());
+    m_state->LogPrintf("%s", robotModes[state.mode]);
 
     m_autoSelectLog->LogPrintf("%c %s",
             (m_alliance == Alliance::Red) ? 'R' : 'B',
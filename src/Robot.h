@@ -2,6 +2,7 @@
 
 #include "lib/CoopMTRobot.h"
 #include "lib/JoystickHelper.h"
+#include "lib/AutoSequencer.h"
 #include "RobotInfo.h"
 #include "stdio.h"
 #include "lib/WrapDash.h"
@@ -28,6 +29,10 @@ class GreyCompressor;
 class BoilerPixy;
 class Lights;
 class SPIGyro;
+class TaskStatsLogger;
+class DashboardPublisher;
+class FlightRecorder;
+class SingleThreadTaskMgr;
 
 class Robot:
         public CoopMTRobot,
@@ -43,7 +48,8 @@ private:
         CitrusHopper,
         SpartanHopper,
         KillerHopper,
-        MidPegKpa
+        MidPegKpa,
+        KillerHopperSequenced
     };
 
     const char *GetAutoName(AutonomousRoutine routine);
@@ -65,6 +71,11 @@ private:
     };
 
     LogSpreadsheet *m_logger;
+    TaskStatsLogger *m_taskStatsLogger;
+    SingleThreadTaskMgr *m_dashboardThread;
+    DashboardPublisher *m_dashboard;
+    SingleThreadTaskMgr *m_flightRecorderThread;
+    FlightRecorder *m_flightRecorder;
 
     PowerDistributionPanel *m_pdp;
 
@@ -110,6 +121,7 @@ private:
     uint32_t 					m_autoTimer;
     uint32_t 					m_teleopTimer;
     AutonomousRoutine m_autoRoutine;
+    AutoSequencer     m_autoSequencer;
     int						    m_speedSetpt;
     double						m_flailSetpt;
     Alliance          m_alliance;
@@ -172,6 +184,7 @@ public:
     void SpartanHopperAuto(void);
     void KillerHopperAuto(void);
     void MidPegKpaAuto(void);
+    void BuildKillerHopperSequence(void);
     /**
      * Defined in Teleop.h
      */
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "lib/util/Util.h"
+#include "lib/RTThread.h"
 
 namespace frc973 {
 
@@ -75,6 +76,39 @@ constexpr int BALL_CONVEYOR_CAN_ID = 5;
 
 constexpr int SPARE_TALON_A = 61;
 constexpr int SPARE_TALON_B = 62;
+/**
+ * Shared resources each task touches (see TaskMgr::SetTaskResources)
+ */
+constexpr uint32_t RES_DRIVE = 1 << 0;        //drive and the shared agitator
+constexpr uint32_t RES_SHOOTER = 1 << 1;
+constexpr uint32_t RES_BOILER_PIXY = 1 << 2;  //reading it updates its filters
+constexpr uint32_t RES_LIGHTS = 1 << 3;
+constexpr uint32_t RES_GEAR_INTAKE = 1 << 4;
+constexpr uint32_t RES_BALL_INTAKE = 1 << 5;
+constexpr uint32_t RES_HANGER = 1 << 6;
+constexpr uint32_t RES_COMPRESSOR = 1 << 7;
+
+/**
+ * Real-time setup of every thread the robot starts (see RTThread).  The
+ * main loop is pinned to cpu 0 and the task worker to cpu 1, both at
+ * FIFO 40.  Everything else is left free to run on either core (cpu -1)
+ * in whatever time those two leave; none of it can preempt them, and
+ * none of it is stuck behind the worker when cpu 0 is idle.
+ */
+constexpr RTThreadConfig ROBOT_MAIN_THREAD_RT = {"robot main", 40, 0, 256 * 1024};
+constexpr RTThreadConfig TASK_WORKER_THREAD_RT = {"task worker", 40, 1, 64 * 1024};
+constexpr RTThreadConfig GEAR_PIXY_THREAD_RT = {"gear pixy", 0, -1, 16 * 1024};
+constexpr RTThreadConfig LOG_WRITER_THREAD_RT = {"log writer", 0, -1, 16 * 1024};
+constexpr RTThreadConfig DEFERRED_LOG_THREAD_RT = {"deferred log", 0, -1, 16 * 1024};
+constexpr RTThreadConfig DASHBOARD_THREAD_RT = {"dashboard", 0, -1, 16 * 1024};
+constexpr RTThreadConfig FLIGHT_RECORDER_THREAD_RT = {"flight recorder", 20, -1, 16 * 1024};
+constexpr RTThreadConfig FLIGHT_WRITER_THREAD_RT = {"flight writer", 0, -1, 16 * 1024};
+
+/**
+ * Lock all memory into RAM at startup so no thread waits on a page fault
+ */
+constexpr bool LOCK_ROBOT_MEMORY = false;
+
 //default rate is 10ms
 constexpr int FLYWHEEL_CONTROL_PERIOD_MS = 5;
 /**
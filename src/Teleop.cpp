@@ -10,6 +10,7 @@
 #include "controllers/SplineDriveController.h"
 #include "lib/JoystickHelper.h"
 #include "lib/WrapDash.h"
+#include "lib/logging/FlightRecorder.h"
 
 using namespace frc;
 
@@ -177,7 +178,10 @@ void Robot::HandleTeleopButton(uint32_t port, uint32_t button,
             }
             break;
         case DualAction::Back:
-
+            if (pressedP && m_flightRecorder != nullptr) {
+                /* something just went wrong, keep the last few seconds */
+                m_flightRecorder->Trigger(FLIGHT_TRIGGER_BUTTON);
+            }
             break;
         }
     }
@@ -0,0 +1,99 @@
+/**
+ * KillerHopperAuto ported to the AutoSequencer.  Same moves as
+ * KillerBeeHopperAuto.cpp, but each step starts in the cycle the one
+ * before it finished instead of on the next tick.
+ *
+ * This auto routine must start with the hopper away from the wall
+ * because we move forward.
+ */
+
+#include "Robot.h"
+#include "AutoCommon.h"
+
+namespace frc973 {
+
+void Robot::BuildKillerHopperSequence(void) {
+    AutoSequencer &seq = m_autoSequencer;
+
+    /* lambdas declared in a Robot method can reach Robot's members */
+    auto driveOnTarget = [](void *ctx) {
+        return static_cast<Robot*>(ctx)->m_drive->OnTarget();
+    };
+
+    seq.Clear();
+    seq.BeginSequence("killer hopper");
+        seq.Do("setup", [](void *ctx) {
+            Robot *robot = static_cast<Robot*>(ctx);
+            robot->m_compressor->Disable();
+            robot->m_ballIntake->ExpandHopper();
+            robot->m_shooter->SetFlywheelSpeed(3040);
+            robot->m_shooter->SetKickerRate(3040);
+            robot->m_gearIntake->SetPickUpManual();
+            robot->m_gearIntake->SetGearPos(GearIntake::GearPosition::down);
+            robot->m_shooter->StopAgitator();
+            robot->m_shooter->StartConveyor(0.0);
+        });
+        seq.BeginParallel("out to hopper");
+            seq.Do("spline out", [](void *ctx) {
+                Robot *robot = static_cast<Robot*>(ctx);
+                double initial_dist = 47.0;
+
+                if (robot->m_alliance == Alliance::Red) {
+                    initial_dist += 3.0;
+                }
+                else {
+                    initial_dist += 12.0;
+                }
+                robot->m_drive
+                    ->SplineDrive(DriveBase::RelativeTo::Now,
+                                  initial_dist, 0.0)
+                    ->SetMaxVelAccel(70.0, 70.0)
+                    ->SetStartEndVel(0.0, 70.0);
+            }, driveOnTarget);
+            seq.BeginSequence("clear gear");
+                seq.Wait("gear down", 250);
+                seq.Do("gear up", [](void *ctx) {
+                    static_cast<Robot*>(ctx)->m_gearIntake
+                        ->SetGearPos(GearIntake::GearPosition::up);
+                });
+            seq.End();
+        seq.End();
+        seq.Do("turn to hopper", [](void *ctx) {
+            Robot *robot = static_cast<Robot*>(ctx);
+            robot->m_drive
+                ->TrapDrive(DriveBase::RelativeTo::SetPoint, 53.0,
+                            robot->m_autoDirection * 94.0)
+                ->SetHalt(false, true)
+                ->SetConstraints(70.0, 70.0);
+        }, driveOnTarget);
+        seq.Do("push hopper", [](void *ctx) {
+            Robot *robot = static_cast<Robot*>(ctx);
+            robot->m_ballIntake->BallIntakeStart();
+            robot->m_drive->DriveStraight(Drive::RelativeTo::Now, 0.6, 0.0);
+        });
+        seq.Wait("collect balls", 2800);
+        seq.Do("back to boiler", [](void *ctx) {
+            Robot *robot = static_cast<Robot*>(ctx);
+            robot->m_drive
+                ->TrapDrive(DriveBase::RelativeTo::Now, -24.0,
+                            robot->m_autoDirection * 64.0)
+                ->SetHalt(true, true)
+                ->SetConstraints(60.0, 38.0);
+        }, driveOnTarget, 3000);
+        seq.Do("shoot", [](void *ctx) {
+            Robot *robot = static_cast<Robot*>(ctx);
+            robot->m_ballIntake->BallIntakeStop();
+            robot->m_shooter->SetShooterState(
+                    Shooter::ShootingSequenceState::manual);
+            robot->m_shooter->StartConveyor(0.9);
+            robot->m_shooter->StartAgitator(1.0, Shooter::Side::right);
+            robot->m_shooter->StartAgitator(1.0, Shooter::Side::left);
+        });
+        seq.WaitUntil("settle", driveOnTarget, 1000);
+        seq.Do("retract hopper", [](void *ctx) {
+            static_cast<Robot*>(ctx)->m_ballIntake->RetractHopper();
+        });
+    seq.End();
+}
+
+}
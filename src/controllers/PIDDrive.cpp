@@ -9,6 +9,7 @@
 #include "lib/filters/PID.h"
 #include <stdio.h>
 #include "lib/WrapDash.h"
+#include "lib/logging/DeferredLog.h"
 
 namespace frc973 {
 
@@ -76,11 +77,11 @@ void PIDDriveController::CalcDriveOutput(DriveStateProvider *state,
             MAX_SPEED * m_speedCap * throttle,
             MAX_SPEED * m_speedCap * turn);
 
-	printf("dist target %lf, dist curr %lf, dist error: %lf \n",
+	DebugPrintf("dist target %lf, dist curr %lf, dist error: %lf \n",
 			m_targetDist, m_prevDist, m_targetDist - m_prevDist);
-	printf("angle target %lf, angle curr %lf, turn error %lf\n",
+	DebugPrintf("angle target %lf, angle curr %lf, turn error %lf\n",
 			m_targetAngle, m_prevAngle, m_targetAngle - m_prevAngle);
-	printf("throttle %lf  turn %lf\n",
+	DebugPrintf("throttle %lf  turn %lf\n",
 			throttle, turn);
 
 	DBStringPrintf(DBStringPos::DB_LINE6, "err d %.3lf a %.3lf",
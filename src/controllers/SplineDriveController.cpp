@@ -3,6 +3,7 @@
 #include "RobotInfo.h"
 #include "lib/util/Util.h"
 #include "lib/WrapDash.h"
+#include "lib/logging/DeferredLog.h"
 
 namespace frc973 {
 
@@ -26,19 +27,19 @@ SplineDriveController::SplineDriveController(DriveStateProvider *state,
     m_a_vel_pid(0.2, 0.0, 0.0),
     m_done(false),
     m_needSetControlMode(false),
-    m_l_pos_setpt_log(new LogCell("s_linear pos incr goal")),
-    m_l_pos_real_log(new LogCell("s_linear pos incr actual")),
-    m_l_vel_setpt_log(new LogCell("s_linear vel incr goal")),
-    m_l_vel_real_log(new LogCell("s_linear vel incr actual")),
-    m_a_pos_setpt_log(new LogCell("s_angular pos incr goal")),
-    m_a_pos_real_log(new LogCell("s_angular pos incr actual")),
-    m_a_vel_setpt_log(new LogCell("s_angular vel incr goal")),
-    m_max_vel_log(new LogCell("spline max velocity")),
-    m_max_acc_log(new LogCell("spline max accel")),
-    m_dist_endgoal_log(new LogCell("s_linear pos end goal")),
-    m_angle_endgoal_log(new LogCell("s_angle pos end goal")),
-    m_left_output(new LogCell("s_left output")),
-    m_right_output(new LogCell("s_right output"))
+    m_l_pos_setpt_log(new LogCell("s_linear pos incr goal", LOG_CELL_DOUBLE)),
+    m_l_pos_real_log(new LogCell("s_linear pos incr actual", LOG_CELL_DOUBLE)),
+    m_l_vel_setpt_log(new LogCell("s_linear vel incr goal", LOG_CELL_DOUBLE)),
+    m_l_vel_real_log(new LogCell("s_linear vel incr actual", LOG_CELL_DOUBLE)),
+    m_a_pos_setpt_log(new LogCell("s_angular pos incr goal", LOG_CELL_DOUBLE)),
+    m_a_pos_real_log(new LogCell("s_angular pos incr actual", LOG_CELL_DOUBLE)),
+    m_a_vel_setpt_log(new LogCell("s_angular vel incr goal", LOG_CELL_DOUBLE)),
+    m_max_vel_log(new LogCell("spline max velocity", LOG_CELL_DOUBLE)),
+    m_max_acc_log(new LogCell("spline max accel", LOG_CELL_DOUBLE)),
+    m_dist_endgoal_log(new LogCell("s_linear pos end goal", LOG_CELL_DOUBLE)),
+    m_angle_endgoal_log(new LogCell("s_angle pos end goal", LOG_CELL_DOUBLE)),
+    m_left_output(new LogCell("s_left output", LOG_CELL_DOUBLE)),
+    m_right_output(new LogCell("s_right output", LOG_CELL_DOUBLE))
 {
     m_l_pos_pid.SetBounds(-100, 100);
     m_l_vel_pid.SetBounds(-100, 100);
@@ -53,10 +54,10 @@ SplineDriveController::SplineDriveController(DriveStateProvider *state,
         logger->RegisterCell(m_a_pos_setpt_log);
         logger->RegisterCell(m_a_pos_real_log);
         logger->RegisterCell(m_a_vel_setpt_log);
-        logger->RegisterCell(m_max_vel_log);
-        logger->RegisterCell(m_max_acc_log);
-        logger->RegisterCell(m_dist_endgoal_log);
-        logger->RegisterCell(m_angle_endgoal_log);
+        logger->RegisterCell(m_max_vel_log, LOG_SAMPLE_ON_CHANGE);
+        logger->RegisterCell(m_max_acc_log, LOG_SAMPLE_ON_CHANGE);
+        logger->RegisterCell(m_dist_endgoal_log, LOG_SAMPLE_ON_CHANGE);
+        logger->RegisterCell(m_angle_endgoal_log, LOG_SAMPLE_ON_CHANGE);
         logger->RegisterCell(m_left_output);
         logger->RegisterCell(m_right_output);
     }
@@ -131,12 +132,12 @@ void SplineDriveController::CalcDriveOutput(DriveStateProvider *state,
             m_max_vel, m_max_acc,
             m_start_vel, m_end_vel);
   }
-  printf("spline drive d %lf a %lf vel %lf acc %lf start %lf end %lf\n",
+  DebugPrintf("spline drive d %lf a %lf vel %lf acc %lf start %lf end %lf\n",
          m_dist, m_angle, m_max_vel, m_max_acc, m_start_vel, m_end_vel);
   DBStringPrintf(DB_LINE3, "lo%0.3lf ro%0.3lf", m_left_output, m_right_output);
 
   if (goal.error) {
-      printf("trap drive error\n");
+      ErrorPrintf("trap drive error\n");
       out->SetDriveOutput(1.0, -1.0);
       return;
   }
@@ -159,7 +160,7 @@ void SplineDriveController::CalcDriveOutput(DriveStateProvider *state,
   double linear_vel_term = m_l_vel_pid.CalcOutput(state->GetRate());
   double angular_dist_term = m_a_pos_pid.CalcOutput(AngleFromStart());
   double angular_vel_term = m_a_vel_pid.CalcOutput(state->GetAngularRate());
-  printf("angle_dist_term: %lf angle_from_start %lf angle_goal %lf\n",
+  DebugPrintf("angle_dist_term: %lf angle_from_start %lf angle_goal %lf\n",
           angular_dist_term, AngleFromStart(), goal.angular_dist);
 
   /* right side receives positive angle correction */
@@ -189,7 +190,7 @@ void SplineDriveController::CalcDriveOutput(DriveStateProvider *state,
   m_left_output->LogDouble(left_output);
   m_right_output->LogDouble(right_output);
 
-  printf("SplineDriveController active time %lf pos %lf\n",
+  DebugPrintf("SplineDriveController active time %lf pos %lf\n",
           time, goal.linear_dist);
 }
 
@@ -2,6 +2,7 @@
 #include "lib/TrapProfile.h"
 #include "RobotInfo.h"
 #include "lib/util/Util.h"
+#include "lib/logging/DeferredLog.h"
 
 namespace frc973 {
 
@@ -25,17 +26,17 @@ TrapDriveController::TrapDriveController(DriveStateProvider *state,
     m_a_vel_pid(0.2, 0.0, 0.0),
     m_done(false),
     m_needSetControlMode(false),
-    m_l_pos_setpt_log(new LogCell("linear pos incr goal")),
-    m_l_pos_real_log(new LogCell("linear pos incr actual")),
-    m_l_vel_setpt_log(new LogCell("linear vel incr goal")),
-    m_l_vel_real_log(new LogCell("linear vel incr actual")),
-    m_a_pos_setpt_log(new LogCell("angular pos incr goal")),
-    m_a_pos_real_log(new LogCell("angular pos incr actual")),
-    m_a_vel_setpt_log(new LogCell("angular vel incr goal")),
-    m_max_vel_log(new LogCell("trap max velocity")),
-    m_max_acc_log(new LogCell("trap max accel")),
-    m_dist_endgoal_log(new LogCell("linear pos end goal")),
-    m_angle_endgoal_log(new LogCell("angle pos end goal"))
+    m_l_pos_setpt_log(new LogCell("linear pos incr goal", LOG_CELL_DOUBLE)),
+    m_l_pos_real_log(new LogCell("linear pos incr actual", LOG_CELL_DOUBLE)),
+    m_l_vel_setpt_log(new LogCell("linear vel incr goal", LOG_CELL_DOUBLE)),
+    m_l_vel_real_log(new LogCell("linear vel incr actual", LOG_CELL_DOUBLE)),
+    m_a_pos_setpt_log(new LogCell("angular pos incr goal", LOG_CELL_DOUBLE)),
+    m_a_pos_real_log(new LogCell("angular pos incr actual", LOG_CELL_DOUBLE)),
+    m_a_vel_setpt_log(new LogCell("angular vel incr goal", LOG_CELL_DOUBLE)),
+    m_max_vel_log(new LogCell("trap max velocity", LOG_CELL_DOUBLE)),
+    m_max_acc_log(new LogCell("trap max accel", LOG_CELL_DOUBLE)),
+    m_dist_endgoal_log(new LogCell("linear pos end goal", LOG_CELL_DOUBLE)),
+    m_angle_endgoal_log(new LogCell("angle pos end goal", LOG_CELL_DOUBLE))
 {
     m_l_pos_pid.SetBounds(-100, 100);
     m_l_vel_pid.SetBounds(-100, 100);
@@ -50,10 +51,10 @@ TrapDriveController::TrapDriveController(DriveStateProvider *state,
         logger->RegisterCell(m_a_pos_setpt_log);
         logger->RegisterCell(m_a_pos_real_log);
         logger->RegisterCell(m_a_vel_setpt_log);
-        logger->RegisterCell(m_max_vel_log);
-        logger->RegisterCell(m_max_acc_log);
-        logger->RegisterCell(m_dist_endgoal_log);
-        logger->RegisterCell(m_angle_endgoal_log);
+        logger->RegisterCell(m_max_vel_log, LOG_SAMPLE_ON_CHANGE);
+        logger->RegisterCell(m_max_acc_log, LOG_SAMPLE_ON_CHANGE);
+        logger->RegisterCell(m_dist_endgoal_log, LOG_SAMPLE_ON_CHANGE);
+        logger->RegisterCell(m_angle_endgoal_log, LOG_SAMPLE_ON_CHANGE);
     }
 }
 
@@ -119,11 +120,11 @@ void TrapDriveController::CalcDriveOutput(DriveStateProvider *state,
             m_max_vel, m_max_acc,
             m_start_halt, m_end_halt);
 
-    printf("trap drive d %lf a %lf vel %lf acc %lf start %d end %d\n",
+    DebugPrintf("trap drive d %lf a %lf vel %lf acc %lf start %d end %d\n",
            m_dist, m_angle, m_max_vel, m_max_acc, m_start_halt, m_end_halt);
 
     if (goal.error) {
-        printf("trap drive error\n");
+        ErrorPrintf("trap drive error\n");
         out->SetDriveOutput(1.0, -1.0);
         return;
     }
@@ -146,7 +147,7 @@ void TrapDriveController::CalcDriveOutput(DriveStateProvider *state,
     double linear_vel_term = m_l_vel_pid.CalcOutput(state->GetRate());
     double angular_dist_term = m_a_pos_pid.CalcOutput(AngleFromStart());
     double angular_vel_term = m_a_vel_pid.CalcOutput(state->GetAngularRate());
-    printf("angle_dist_term: %lf angle_from_start %lf angle_goal %lf\n",
+    DebugPrintf("angle_dist_term: %lf angle_from_start %lf angle_goal %lf\n",
             angular_dist_term, AngleFromStart(), goal.angular_dist);
 
     /* right side receives positive angle correction */
@@ -174,7 +175,7 @@ void TrapDriveController::CalcDriveOutput(DriveStateProvider *state,
     m_dist_endgoal_log->LogDouble(m_dist);
     m_angle_endgoal_log->LogDouble(m_angle);
 
-    printf("TrapDriveController active time %lf pos %lf\n",
+    DebugPrintf("TrapDriveController active time %lf pos %lf\n",
             time, goal.linear_dist);
 }
 
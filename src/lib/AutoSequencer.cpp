@@ -0,0 +1,353 @@
+/*
+ * AutoSequencer.cpp
+ */
+
+#include "lib/AutoSequencer.h"
+#include "lib/util/Util.h"
+
+#include <stdio.h>
+
+namespace frc973 {
+
+AutoSequencer::AutoSequencer(void *ctx)
+	 : m_ctx(ctx)
+{
+	Clear();
+}
+
+AutoSequencer::~AutoSequencer() {
+}
+
+void AutoSequencer::Clear() {
+	m_numSteps = 0;
+	m_firstRoot = -1;
+	m_lastRoot = -1;
+	m_currentRoot = -1;
+	m_numOpenGroups = 0;
+	m_error = false;
+	m_started = false;
+	m_cycle = 0;
+	m_routineStartUs = 0;
+}
+
+int AutoSequencer::AddStep(const char *name, StepKind kind) {
+	if (m_numSteps >= MAX_AUTO_STEPS) {
+		fprintf(stderr, "AutoSequencer: no room for step %s (max %d)\n",
+				name, MAX_AUTO_STEPS);
+		m_error = true;
+		return -1;
+	}
+
+	int index = m_numSteps++;
+	Step &step = m_steps[index];
+
+	step.name = name;
+	step.kind = kind;
+	step.status = StepPending;
+	step.start = nullptr;
+	step.done = nullptr;
+	step.durationUs = 0;
+	step.firstChild = -1;
+	step.nextSibling = -1;
+	step.current = -1;
+	step.depth = m_numOpenGroups;
+	step.startCycle = 0;
+	step.startUs = 0;
+	step.endUs = 0;
+	m_lastChild[index] = -1;
+
+	if (m_numOpenGroups == 0) {
+		if (m_lastRoot < 0) {
+			m_firstRoot = index;
+		}
+		else {
+			m_steps[m_lastRoot].nextSibling = index;
+		}
+		m_lastRoot = index;
+	}
+	else {
+		int parent = m_openGroups[m_numOpenGroups - 1];
+
+		if (m_lastChild[parent] < 0) {
+			m_steps[parent].firstChild = index;
+		}
+		else {
+			m_steps[m_lastChild[parent]].nextSibling = index;
+		}
+		m_lastChild[parent] = index;
+	}
+
+	return index;
+}
+
+int AutoSequencer::BeginSequence(const char *name) {
+	return BeginGroup(name, SequenceStep);
+}
+
+int AutoSequencer::BeginParallel(const char *name) {
+	return BeginGroup(name, ParallelStep);
+}
+
+int AutoSequencer::BeginGroup(const char *name, StepKind kind) {
+	if (m_numOpenGroups >= MAX_AUTO_DEPTH) {
+		fprintf(stderr, "AutoSequencer: group %s nested too deep (max %d)\n",
+				name, MAX_AUTO_DEPTH);
+		m_error = true;
+		return -1;
+	}
+
+	int index = AddStep(name, kind);
+	if (index >= 0) {
+		m_openGroups[m_numOpenGroups++] = index;
+	}
+	return index;
+}
+
+void AutoSequencer::End() {
+	if (m_numOpenGroups == 0) {
+		fprintf(stderr, "AutoSequencer: End without a matching Begin\n");
+		m_error = true;
+		return;
+	}
+	m_numOpenGroups--;
+}
+
+int AutoSequencer::Do(const char *name, StartFunc start, DoneFunc done,
+		uint32_t timeoutMs) {
+	int index = AddStep(name, CommandStep);
+
+	if (index >= 0) {
+		m_steps[index].start = start;
+		m_steps[index].done = done;
+		m_steps[index].durationUs = timeoutMs * 1000ULL;
+	}
+	return index;
+}
+
+int AutoSequencer::Wait(const char *name, uint32_t waitMs) {
+	int index = AddStep(name, WaitStep);
+
+	if (index >= 0) {
+		m_steps[index].durationUs = waitMs * 1000ULL;
+	}
+	return index;
+}
+
+int AutoSequencer::WaitUntil(const char *name, DoneFunc done,
+		uint32_t timeoutMs) {
+	int index = AddStep(name, WaitUntilStep);
+
+	if (index >= 0) {
+		m_steps[index].done = done;
+		m_steps[index].durationUs = timeoutMs * 1000ULL;
+	}
+	return index;
+}
+
+void AutoSequencer::Start() {
+	if (m_numOpenGroups != 0) {
+		fprintf(stderr, "AutoSequencer: %d groups never Ended\n",
+				m_numOpenGroups);
+		m_error = true;
+	}
+
+	for (int i = 0; i < m_numSteps; i++) {
+		m_steps[i].status = StepPending;
+		m_steps[i].current = -1;
+		m_steps[i].startCycle = 0;
+		m_steps[i].startUs = 0;
+		m_steps[i].endUs = 0;
+	}
+	m_currentRoot = m_firstRoot;
+	m_started = false;
+	m_cycle = 0;
+}
+
+bool AutoSequencer::Update() {
+	uint64_t nowUs = GetUsecTime();
+
+	if (m_error) {
+		return false;
+	}
+
+	if (!m_started) {
+		m_routineStartUs = nowUs;
+		m_started = true;
+	}
+	m_cycle++;
+
+	while (m_currentRoot >= 0 && Tick(m_currentRoot, nowUs)) {
+		m_currentRoot = m_steps[m_currentRoot].nextSibling;
+	}
+
+	return IsDone();
+}
+
+void AutoSequencer::BeginStep(Step &step, uint64_t nowUs) {
+	step.status = StepRunning;
+	step.startCycle = m_cycle;
+	step.startUs = nowUs;
+	step.current = step.firstChild;
+
+	if (step.start != nullptr) {
+		step.start(m_ctx);
+	}
+}
+
+void AutoSequencer::FinishStep(Step &step, StepStatus status,
+		uint64_t nowUs) {
+	step.status = status;
+	step.endUs = nowUs;
+}
+
+bool AutoSequencer::Tick(int index, uint64_t nowUs) {
+	Step &step = m_steps[index];
+
+	if (step.status == StepDone || step.status == StepTimedOut) {
+		return true;
+	}
+	if (step.status == StepPending) {
+		BeginStep(step, nowUs);
+	}
+
+	switch (step.kind) {
+		case SequenceStep:
+			/* keep going while children finish so the next one starts in
+			 * the same cycle */
+			while (step.current >= 0 && Tick(step.current, nowUs)) {
+				step.current = m_steps[step.current].nextSibling;
+			}
+			if (step.current >= 0) {
+				return false;
+			}
+			break;
+		case ParallelStep: {
+			bool allDone = true;
+			for (int child = step.firstChild; child >= 0;
+					child = m_steps[child].nextSibling) {
+				if (!Tick(child, nowUs)) {
+					allDone = false;
+				}
+			}
+			if (!allDone) {
+				return false;
+			}
+			break;
+		}
+		case CommandStep:
+			if (step.done == nullptr) {
+				break;
+			}
+			if (step.startCycle == m_cycle) {
+				return false;
+			}
+			/* fall through */
+		case WaitUntilStep:
+			if (step.done(m_ctx)) {
+				break;
+			}
+			if (step.durationUs != 0 &&
+					nowUs - step.startUs >= step.durationUs) {
+				FinishStep(step, StepTimedOut, nowUs);
+				return true;
+			}
+			return false;
+		case WaitStep:
+			if (nowUs - step.startUs < step.durationUs) {
+				return false;
+			}
+			break;
+	}
+
+	FinishStep(step, StepDone, nowUs);
+	return true;
+}
+
+bool AutoSequencer::IsDone() const {
+	return !m_error && m_started && m_currentRoot < 0;
+}
+
+bool AutoSequencer::HasError() const {
+	return m_error;
+}
+
+int AutoSequencer::GetNumSteps() const {
+	return m_numSteps;
+}
+
+const char *AutoSequencer::GetStepName(int step) const {
+	return m_steps[step].name;
+}
+
+AutoSequencer::StepStatus AutoSequencer::GetStepStatus(int step) const {
+	return m_steps[step].status;
+}
+
+uint64_t AutoSequencer::GetStepStartUs(int step) const {
+	if (m_steps[step].status == StepPending) {
+		return 0;
+	}
+	return m_steps[step].startUs - m_routineStartUs;
+}
+
+uint64_t AutoSequencer::GetStepDurationUs(int step) const {
+	const Step &s = m_steps[step];
+
+	switch (s.status) {
+		case StepPending:
+			return 0;
+		case StepRunning:
+			return GetUsecTime() - s.startUs;
+		default:
+			return s.endUs - s.startUs;
+	}
+}
+
+const char *AutoSequencer::GetCurrentStepName() const {
+	int index = m_currentRoot;
+
+	while (index >= 0) {
+		const Step &step = m_steps[index];
+
+		if (step.kind == SequenceStep && step.current >= 0) {
+			index = step.current;
+		}
+		else if (step.kind == ParallelStep) {
+			int running = -1;
+			for (int child = step.firstChild; child >= 0;
+					child = m_steps[child].nextSibling) {
+				if (m_steps[child].status == StepRunning) {
+					running = child;
+					break;
+				}
+			}
+			if (running < 0) {
+				return step.name;
+			}
+			index = running;
+		}
+		else {
+			return step.name;
+		}
+	}
+
+	return IsDone() ? "done" : "";
+}
+
+void AutoSequencer::PrintStepTimes() const {
+	static const char *statusNames[] = {
+		"pending", "running", "done", "timed out"
+	};
+
+	printf("%-32s %10s %10s %s\n", "step", "start ms", "dur ms", "status");
+	for (int i = 0; i < m_numSteps; i++) {
+		const Step &step = m_steps[i];
+
+		printf("%*s%-*s %10.1f %10.1f %s\n",
+				step.depth * 2, "", 32 - step.depth * 2, step.name,
+				GetStepStartUs(i) / 1000.0, GetStepDurationUs(i) / 1000.0,
+				statusNames[step.status]);
+	}
+}
+
+}
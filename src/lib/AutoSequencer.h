@@ -0,0 +1,228 @@
+/*
+ * AutoSequencer.h
+ *
+ * AutoSequencer - runs an autonomous routine described as a tree of steps
+ * instead of a hand written switch(m_autoState) machine.
+ *
+ * A routine is built out of
+ *  - commands: a start function that issues something (a drive, an
+ *    intake change...) and a done function that says when it's finished,
+ *    with an optional timeout
+ *  - waits for a fixed time and waits for a condition
+ *  - sequences, which run their children one after the other
+ *  - parallel groups, which start all their children at once and finish
+ *    when every child has
+ *
+ * The difference from a state machine is what happens when a step
+ * finishes: Update keeps walking the tree in the same call, so the next
+ * step is started in the same cycle the previous one was seen to finish
+ * rather than on the following tick.  Steps that finish immediately (an
+ * instant command, a condition that already holds) chain straight through.
+ *
+ * All the steps live in a fixed array inside the sequencer, so building a
+ * routine and running it never allocates.  Each step remembers when it
+ * started and finished so PrintStepTimes can show where the time went.
+ *
+ * Build a routine with the Begin/End and step methods:
+ *
+ *     m_autoSequencer.Clear();
+ *     m_autoSequencer.BeginSequence("killer hopper");
+ *         m_autoSequencer.Do("spline out", StartSpline, DriveOnTarget);
+ *         m_autoSequencer.BeginParallel("drive and intake");
+ *             ...
+ *         m_autoSequencer.End();
+ *         m_autoSequencer.Wait("settle", 250);
+ *     m_autoSequencer.End();
+ *
+ * and call Start from AutonomousStart and Update from
+ * AutonomousContinuous.  Every start and done function is given the
+ * context pointer the sequencer was constructed with.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace frc973 {
+
+class AutoSequencer {
+public:
+	typedef void (*StartFunc)(void *ctx);
+	typedef bool (*DoneFunc)(void *ctx);
+
+	/**
+	 * Most steps (including sequences and groups) one routine can have
+	 */
+	static constexpr int MAX_AUTO_STEPS = 64;
+
+	/**
+	 * Deepest Begin/End nesting allowed
+	 */
+	static constexpr int MAX_AUTO_DEPTH = 8;
+
+	enum StepKind {
+		SequenceStep,
+		ParallelStep,
+		CommandStep,
+		WaitStep,
+		WaitUntilStep
+	};
+
+	enum StepStatus {
+		StepPending,
+		StepRunning,
+		StepDone,
+		StepTimedOut
+	};
+
+	/**
+	 * Construct an empty sequencer.
+	 *
+	 * @param ctx passed to every start and done function (usually the Robot)
+	 */
+	explicit AutoSequencer(void *ctx);
+	virtual ~AutoSequencer();
+
+	/**
+	 * Throw away the routine so a new one can be built
+	 */
+	void Clear();
+
+	/**
+	 * Open a group whose children run one after the other.  Steps added
+	 * until the matching End become its children.
+	 */
+	int BeginSequence(const char *name);
+
+	/**
+	 * Open a group whose children all start together.  The group
+	 * finishes once every child has.
+	 */
+	int BeginParallel(const char *name);
+
+	/**
+	 * Close the innermost open group
+	 */
+	void End();
+
+	/**
+	 * Add a command.  |start| is called once when the step is reached.
+	 * |done| is first asked on the next Update (the subsystem hasn't seen
+	 * the command before then); a null |done| makes the command instant
+	 * so the step after it starts in the same cycle.
+	 *
+	 * @param timeoutMs give up waiting on |done| after this long, 0 for never
+	 *
+	 * @return index of the step, or -1 if the step array is full
+	 */
+	int Do(const char *name, StartFunc start, DoneFunc done = nullptr,
+			uint32_t timeoutMs = 0);
+
+	/**
+	 * Add a step that finishes |waitMs| after it starts
+	 */
+	int Wait(const char *name, uint32_t waitMs);
+
+	/**
+	 * Add a step that finishes as soon as |done| returns true, checked
+	 * right away when the step is reached and then once per Update.
+	 *
+	 * @param timeoutMs give up after this long, 0 for never
+	 */
+	int WaitUntil(const char *name, DoneFunc done, uint32_t timeoutMs = 0);
+
+	/**
+	 * Rewind the routine to its first step.  Nothing is started until
+	 * the next Update.
+	 */
+	void Start();
+
+	/**
+	 * Advance the routine as far as it can go this cycle: check the
+	 * running steps and start everything that becomes ready as a result.
+	 *
+	 * @return true once the whole routine has finished
+	 */
+	bool Update();
+
+	/**
+	 * @return true once the whole routine has finished
+	 */
+	bool IsDone() const;
+
+	/**
+	 * @return true if building overflowed the step array or the Begin/End
+	 * nesting didn't match; the routine won't run
+	 */
+	bool HasError() const;
+
+	int GetNumSteps() const;
+	const char *GetStepName(int step) const;
+	StepStatus GetStepStatus(int step) const;
+
+	/**
+	 * Time from Start to when |step| started, in microseconds
+	 */
+	uint64_t GetStepStartUs(int step) const;
+
+	/**
+	 * How long |step| ran, or has been running so far, in microseconds
+	 */
+	uint64_t GetStepDurationUs(int step) const;
+
+	/**
+	 * Name of the innermost running command or wait, for the dashboard
+	 */
+	const char *GetCurrentStepName() const;
+
+	/**
+	 * Print each step's start offset and duration, indented by nesting
+	 */
+	void PrintStepTimes() const;
+
+private:
+	struct Step {
+		const char *name;
+		StepKind kind;
+		StepStatus status;
+		StartFunc start;
+		DoneFunc done;
+		uint64_t durationUs;		/* wait time or timeout, 0 for none */
+		int firstChild;
+		int nextSibling;
+		int current;				/* running child of a sequence */
+		int depth;
+		uint32_t startCycle;
+		uint64_t startUs;
+		uint64_t endUs;
+	};
+
+	int AddStep(const char *name, StepKind kind);
+	int BeginGroup(const char *name, StepKind kind);
+	bool Tick(int index, uint64_t nowUs);
+	void BeginStep(Step &step, uint64_t nowUs);
+	void FinishStep(Step &step, StepStatus status, uint64_t nowUs);
+
+	AutoSequencer(const AutoSequencer&) = delete;
+	AutoSequencer &operator=(const AutoSequencer&) = delete;
+
+	void *m_ctx;
+	Step m_steps[MAX_AUTO_STEPS];
+	int m_numSteps;
+
+	/* top level steps run one after the other like a sequence */
+	int m_firstRoot;
+	int m_lastRoot;
+	int m_currentRoot;
+
+	int m_openGroups[MAX_AUTO_DEPTH];
+	int m_numOpenGroups;
+	int m_lastChild[MAX_AUTO_STEPS];
+
+	bool m_error;
+	bool m_started;
+	uint32_t m_cycle;
+	uint64_t m_routineStartUs;
+};
+
+}
@@ -10,22 +10,32 @@
 #include "WPILib.h"
 
 #include "CoopMTRobot.h"
+#include "Tracer.h"
 #include "lib/util/Ansi.h"
 #include "util/Util.h"
 #include "WrapDash.h"
 #include <stdio.h>
 #include <unistd.h>
 
-static constexpr bool ENABLE_PROFILING = false;
-
 namespace frc973 {
 
+/* instant events marking mode transitions on the trace */
+static const char *modeStartEvents[] = {
+	"Start Disabled", "Start Auto", "Start Teleop", "Start Test"
+};
+static const char *modeStopEvents[] = {
+	"Stop Disabled", "Stop Auto", "Stop Teleop", "Stop Test"
+};
+
 CoopMTRobot::CoopMTRobot(void
 		): IterativeRobot()
 		 , TaskMgr()
 		 , m_prevMode(RobotMode::MODE_DISABLED)
-		 , m_robotModeMutex(PTHREAD_MUTEX_INITIALIZER)
+		 , m_robotState()
+		 , m_stepStarted(false)
 {
+	this->SetCycleOverrunThreshold(ROBOT_LOOP_PERIOD_US);
+	Tracer::SetThreadName("robot loop");
 }
 
 CoopMTRobot::~CoopMTRobot() {
@@ -56,95 +66,87 @@ void CoopMTRobot::RobotInit(void) {
 
 void CoopMTRobot::DisabledInit(void) {
 	this->ModeStop(this->m_prevMode);
-	pthread_mutex_lock(&m_robotModeMutex);
 	this->m_prevMode = RobotMode::MODE_DISABLED;
-	pthread_mutex_unlock(&m_robotModeMutex);
+	this->PublishRobotState();
 	this->ModeStart(this->m_prevMode);
 }
 
 void CoopMTRobot::AutonomousInit(void) {
 	this->ModeStop(this->m_prevMode);
-	pthread_mutex_lock(&m_robotModeMutex);
 	this->m_prevMode = RobotMode::MODE_AUTO;
-	pthread_mutex_unlock(&m_robotModeMutex);
+	this->PublishRobotState();
 	this->ModeStart(this->m_prevMode);
 }
 
 void CoopMTRobot::TeleopInit(void) {
 	this->ModeStop(this->m_prevMode);
-	pthread_mutex_lock(&m_robotModeMutex);
 	this->m_prevMode = RobotMode::MODE_TELEOP;
-	pthread_mutex_unlock(&m_robotModeMutex);
+	this->PublishRobotState();
 	this->ModeStart(this->m_prevMode);
 }
 
 void CoopMTRobot::TestInit(void) {
 	this->ModeStop(this->m_prevMode);
-	pthread_mutex_lock(&m_robotModeMutex);
 	this->m_prevMode = RobotMode::MODE_TEST;
-	pthread_mutex_unlock(&m_robotModeMutex);
+	this->PublishRobotState();
 	this->ModeStart(this->m_prevMode);
 }
 
 void CoopMTRobot::DisabledPeriodic(void) {
-    uint64_t startTime = GetUsecTime();
+	uint64_t startTime = GetUsecTime();
 
+	this->PublishRobotState();
 	this->TaskPrePeriodicAll(this->m_prevMode);
-    if (ENABLE_PROFILING) {
-        printf("DisabledPrePeriodic toook %llu us\n", 
-               GetUsecTime() - startTime);
-    }
-
 	this->DisabledContinuous();
-    if (ENABLE_PROFILING) {
-        printf("DisabledContinuous toook %llu us\n", 
-               GetUsecTime() - startTime);
-    }
-
 	this->AllStateContinuous();
-    if (ENABLE_PROFILING) {
-        printf("DisabledAllStateContinuous toook %llu us\n", 
-               GetUsecTime() - startTime);
-    }
-
 	this->TaskPeriodicAll(this->m_prevMode);
-    if (ENABLE_PROFILING) {
-        printf("DisabledTaskPeriodic toook %llu us\n", 
-               GetUsecTime() - startTime);
-    }
-    
 	this->TaskPostPeriodicAll(this->m_prevMode);
-    if (ENABLE_PROFILING) {
-        printf("DisabledTaskPostPeriodic toook %llu us\n", 
-               GetUsecTime() - startTime);
-    }
+
+	this->EndCycle(GetUsecTime() - startTime);
 }
 
 void CoopMTRobot::AutonomousPeriodic(void) {
+	uint64_t startTime = GetUsecTime();
+
+	this->PublishRobotState();
 	this->TaskPrePeriodicAll(this->m_prevMode);
 	this->AutonomousContinuous();
 	this->AllStateContinuous();
 	this->TaskPeriodicAll(this->m_prevMode);
 	this->TaskPostPeriodicAll(this->m_prevMode);
+
+	this->EndCycle(GetUsecTime() - startTime);
 }
 
 void CoopMTRobot::TeleopPeriodic(void) {
+	uint64_t startTime = GetUsecTime();
+
+	this->PublishRobotState();
 	this->TaskPrePeriodicAll(this->m_prevMode);
 	this->TeleopContinuous();
 	this->AllStateContinuous();
 	this->TaskPeriodicAll(this->m_prevMode);
 	this->TaskPostPeriodicAll(this->m_prevMode);
+
+	this->EndCycle(GetUsecTime() - startTime);
 }
 
 void CoopMTRobot::TestPeriodic(void) {
+	uint64_t startTime = GetUsecTime();
+
+	this->PublishRobotState();
 	this->TaskPrePeriodicAll(this->m_prevMode);
 	this->TestContinuous();
 	this->AllStateContinuous();
 	this->TaskPeriodicAll(this->m_prevMode);
 	this->TaskPostPeriodicAll(this->m_prevMode);
+
+	this->EndCycle(GetUsecTime() - startTime);
 }
 
 void CoopMTRobot::ModeStop(RobotMode toStop) {
+	Tracer::Instant(modeStopEvents[toStop], "mode");
+
 	switch (toStop) {
 	case RobotMode::MODE_DISABLED:
 		TaskStopModeAll(toStop);
@@ -166,6 +168,8 @@ void CoopMTRobot::ModeStop(RobotMode toStop) {
 }
 
 void CoopMTRobot::ModeStart(RobotMode toStart) {
+	Tracer::Instant(modeStartEvents[toStart], "mode");
+
 	switch (toStart) {
 	case RobotMode::MODE_DISABLED:
 		TaskStartModeAll(toStart);
@@ -186,11 +190,62 @@ void CoopMTRobot::ModeStart(RobotMode toStart) {
 	}
 }
 
+void CoopMTRobot::StepCycle(RobotMode mode) {
+	bool modeChanged = mode != m_prevMode;
+
+	if (!m_stepStarted) {
+		/* nothing has started yet, so there's no mode to stop */
+		this->RobotInit();
+		m_stepStarted = true;
+		m_prevMode = mode;
+		this->PublishRobotState();
+		this->ModeStart(mode);
+		modeChanged = false;
+	}
+
+	switch (mode) {
+	case RobotMode::MODE_DISABLED:
+		if (modeChanged) {
+			this->DisabledInit();
+		}
+		this->DisabledPeriodic();
+		break;
+	case RobotMode::MODE_AUTO:
+		if (modeChanged) {
+			this->AutonomousInit();
+		}
+		this->AutonomousPeriodic();
+		break;
+	case RobotMode::MODE_TELEOP:
+		if (modeChanged) {
+			this->TeleopInit();
+		}
+		this->TeleopPeriodic();
+		break;
+	case RobotMode::MODE_TEST:
+		if (modeChanged) {
+			this->TestInit();
+		}
+		this->TestPeriodic();
+		break;
+	}
+}
+
+void CoopMTRobot::PublishRobotState(void) {
+	RobotStateSnapshot state;
+	DriverStation &ds = DriverStation::GetInstance();
+
+	state.mode = m_prevMode;
+	state.cycle = GetCycleCount();
+	state.cycleStartUs = GetUsecTime();
+	state.batteryVoltage = ds.GetBatteryVoltage();
+	state.alliance = ds.GetAlliance();
+
+	m_robotState.Write(state);
+}
+
 bool CoopMTRobot::IsDisabled() const {
-	pthread_mutex_lock(&m_robotModeMutex);
-	bool res = m_prevMode == MODE_DISABLED;
-	pthread_mutex_unlock(&m_robotModeMutex);
-	return res;
+	return m_robotState.Read().mode == MODE_DISABLED;
 }
 
 bool CoopMTRobot::IsEnabled() const {
@@ -198,24 +253,15 @@ bool CoopMTRobot::IsEnabled() const {
 }
 
 bool CoopMTRobot::IsOperatorControl() const {
-	pthread_mutex_lock(&m_robotModeMutex);
-	bool res = m_prevMode == MODE_TELEOP;
-	pthread_mutex_unlock(&m_robotModeMutex);
-	return res;
+	return m_robotState.Read().mode == MODE_TELEOP;
 }
 
 bool CoopMTRobot::IsAutonomous() const {
-	pthread_mutex_lock(&m_robotModeMutex);
-	bool res = m_prevMode == MODE_AUTO;
-	pthread_mutex_unlock(&m_robotModeMutex);
-	return res;
+	return m_robotState.Read().mode == MODE_AUTO;
 }
 
 bool CoopMTRobot::IsTest() const {
-	pthread_mutex_lock(&m_robotModeMutex);
-	bool res = m_prevMode == MODE_TEST;
-	pthread_mutex_unlock(&m_robotModeMutex);
-	return res;
+	return m_robotState.Read().mode == MODE_TEST;
 }
 
 }
@@ -20,8 +20,9 @@
 #include "stdint.h"
 #include "WPILib.h"
 #include "TaskMgr.h"
+#include "LockstepRunner.h"
 #include "util/Util.h"
-#include <pthread.h>
+#include "util/SeqLock.h"
 
 #ifndef PROGRAM_NAME
 #define PROGRAM_NAME "(unspecified)"
@@ -33,9 +34,28 @@ namespace frc973 {
 
 static constexpr int MAXHOSTNAMELEN = 128;
 
+/**
+ * Period at which the driver station drives the main robot loop; cycles
+ * taking longer than this count as overruns in the cycle stats.
+ */
+static constexpr uint32_t ROBOT_LOOP_PERIOD_US = 20000;
+
+/**
+ * State of the robot as of the start of the current cycle.  All of it is
+ * captured at the same moment so every task sees the same picture.
+ */
+struct RobotStateSnapshot {
+	RobotMode mode;
+	uint32_t cycle;				/* TaskMgr cycle count */
+	uint64_t cycleStartUs;		/* GetUsecTime() at the start of the cycle */
+	double batteryVoltage;
+	DriverStation::Alliance alliance;
+};
+
 class CoopMTRobot:
 	public IterativeRobot,
 	public TaskMgr,
+	public LockstepLoop,
 	public frc::RobotStateInterface
 {
 public:
@@ -84,6 +104,38 @@ public:
 	 */
 	virtual void AllStateContinuous(void) {}
 
+	/**
+	 * Get the robot state published at the start of this cycle (or at the
+	 * last mode change).  Never blocks, may be called from any thread.
+	 *
+	 * @param out filled with the snapshot
+	 *
+	 * @return number of snapshots published so far
+	 */
+	uint32_t GetRobotState(RobotStateSnapshot *out) const {
+		return m_robotState.Read(out);
+	}
+
+	RobotStateSnapshot GetRobotState() const {
+		return m_robotState.Read();
+	}
+
+	/**
+	 * LockstepLoop: the robot loop runs every ROBOT_LOOP_PERIOD_US
+	 */
+	uint64_t GetLockstepPeriodUs() override {
+		return ROBOT_LOOP_PERIOD_US;
+	}
+
+	/**
+	 * LockstepLoop: run one robot cycle in |mode| the way IterativeRobot
+	 * would (RobotInit on the first step, <Mode>Init on every mode change,
+	 * then <Mode>Periodic), so the robot can be stepped on the virtual
+	 * clock without a driver station.  The first step only starts |mode|;
+	 * no mode was running before it to stop.
+	 */
+	void StepCycle(RobotMode mode) override;
+
 protected:
 	/**
 	 * For internal use only.  Children of this object should not try to
@@ -104,9 +156,16 @@ protected:
 	void ModeStop(RobotMode toStop);
 	void ModeStart(RobotMode toStart);
 
+	/**
+	 * Capture the robot state and publish it for GetRobotState.  Called
+	 * at the start of every cycle and on every mode change.
+	 */
+	void PublishRobotState(void);
+
 	/**
 	 * Implement the RobotStateInterface interface so that we may
-	 * cache robor mode.
+	 * cache robor mode.  These read the published snapshot so they never
+	 * block, whichever thread they are called from.
 	 */
 	bool IsDisabled() const override;
 	bool IsEnabled() const override;
@@ -115,7 +174,8 @@ protected:
 	bool IsTest() const override;
 private:
 	RobotMode m_prevMode;
-	mutable pthread_mutex_t m_robotModeMutex;
+	SeqLock<RobotStateSnapshot> m_robotState;
+	bool m_stepStarted;
 };
 
 }
@@ -0,0 +1,105 @@
+/*
+ * DashboardPublisher.cpp
+ */
+
+#include "lib/DashboardPublisher.h"
+#include "lib/util/SeqLock.h"
+#include "lib/util/Util.h"
+
+#include <string.h>
+#include <atomic>
+
+namespace frc973 {
+
+namespace {
+
+struct DBLine {
+	SeqLock<DeferredLogRecord> record;
+	std::atomic<bool> writing;	/* tasks on different threads share lines */
+};
+
+DBLine dbLines[DB_NUM_LINES];
+
+}
+
+void SetDBString(DBStringPos position, const DeferredLogRecord &record) {
+	if (position < 0 || position >= DB_NUM_LINES) {
+		return;
+	}
+
+	DBLine &line = dbLines[position];
+
+	/* SeqLock takes one writer at a time.  A write is a short copy, so
+	 * spinning on another thread's is cheaper than anything else */
+	while (line.writing.exchange(true, std::memory_order_acquire)) {
+	}
+	line.record.Write(record);
+	line.writing.store(false, std::memory_order_release);
+}
+
+DashboardPublisher::DashboardPublisher(PutFunc put, void *ctx)
+	 : m_put(put)
+	 , m_ctx(ctx)
+	 , m_lines()
+	 , m_numSent(0)
+{
+	ResendAll();
+}
+
+DashboardPublisher::~DashboardPublisher() {
+}
+
+void DashboardPublisher::SetLineMinPeriod(DBStringPos line,
+		uint32_t periodMs) {
+	if (line >= 0 && line < DB_NUM_LINES) {
+		m_lines[line].minPeriodUs = periodMs * 1000;
+	}
+}
+
+int DashboardPublisher::Publish() {
+	uint64_t now = GetUsecTime();
+	int numSent = 0;
+
+	for (int i = 0; i < DB_NUM_LINES; i++) {
+		LineState &state = m_lines[i];
+		DeferredLogRecord record;
+		char text[DBSTRING_MAX_LENGTH];
+
+		/* nothing written since last time (or ever) */
+		if (dbLines[i].record.GetVersion() == state.version) {
+			continue;
+		}
+		if (state.sent && now - state.sentUs < state.minPeriodUs) {
+			continue;
+		}
+
+		state.version = dbLines[i].record.Read(&record);
+		/* the same length DBStringPrintf always cut lines to */
+		DeferredLog::Format(record, text, DBSTRING_MAX_LENGTH - 1);
+		if (state.sent && strcmp(text, state.text) == 0) {
+			continue;
+		}
+
+		m_put(m_ctx, static_cast<DBStringPos>(i), text);
+		strcpy(state.text, text);
+		state.sentUs = now;
+		state.sent = true;
+		numSent++;
+	}
+
+	m_numSent += numSent;
+	return numSent;
+}
+
+void DashboardPublisher::ResendAll() {
+	for (int i = 0; i < DB_NUM_LINES; i++) {
+		m_lines[i].version = 0;
+		m_lines[i].sent = false;
+	}
+}
+
+void DashboardPublisher::TaskPeriodic(RobotMode mode) {
+	Publish();
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+ * DashboardPublisher.h
+ *
+ * DashboardPublisher - sends the debug string lines written with
+ * DBStringPrintf to the dashboard, without the control loop paying for
+ * the formatting or the network table updates.
+ *
+ * DBStringPrintf only copies its format and arguments into the line's slot
+ * (a SeqLock, so writers never wait on the publisher) and returns; when
+ * several tasks write one line, the last write before the publisher runs
+ * wins.  The publisher is a task meant for a slow thread of its own (10Hz
+ * on the robot).  Each time it runs it formats the lines written since it
+ * last looked and sends only the ones whose text changed, no more often
+ * than each line's rate limit allows.  A change held back by a limit goes
+ * out, as the newest text, the next time the line is allowed.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "lib/CoopTask.h"
+#include "lib/WrapDash.h"
+
+namespace frc973 {
+
+class DashboardPublisher : public CoopTask {
+public:
+	/**
+	 * Sends the text of one line to the dashboard (PutDBString on the
+	 * robot)
+	 */
+	typedef void (*PutFunc)(void *ctx, DBStringPos line, const char *text);
+
+	/**
+	 * How often the publisher thread should run
+	 */
+	static constexpr double DEFAULT_PERIOD_SEC = 0.1;
+
+	/**
+	 * @param put called with each line that changed
+	 * @param ctx passed to |put|
+	 */
+	DashboardPublisher(PutFunc put, void *ctx);
+	virtual ~DashboardPublisher();
+
+	/**
+	 * Send |line| at most once every |periodMs|.  0 (the default) sends it
+	 * every time it changed when the publisher runs.
+	 */
+	void SetLineMinPeriod(DBStringPos line, uint32_t periodMs);
+
+	/**
+	 * Send every line that changed, as far as the rate limits allow
+	 *
+	 * @return number of lines sent
+	 */
+	int Publish();
+
+	/**
+	 * Forget what was sent, so every line that has been written goes out
+	 * again on the next Publish
+	 */
+	void ResendAll();
+
+	/**
+	 * Number of lines sent so far
+	 */
+	uint64_t GetNumSent() const {
+		return m_numSent;
+	}
+
+	void TaskPeriodic(RobotMode mode) override;
+
+private:
+	struct LineState {
+		uint32_t version;			/* of the slot when last looked at */
+		uint32_t minPeriodUs;
+		uint64_t sentUs;
+		bool sent;
+		char text[DBSTRING_MAX_LENGTH];
+	};
+
+	PutFunc m_put;
+	void *m_ctx;
+	LineState m_lines[DB_NUM_LINES];
+	uint64_t m_numSent;
+};
+
+}
@@ -7,6 +7,7 @@
 
 #include <lib/DriveBase.h>
 #include "lib/util/Util.h"
+#include "lib/Tracer.h"
 
 #include "WPILib.h"
 
@@ -29,6 +30,8 @@ DriveBase::~DriveBase() {
 
 void DriveBase::TaskPostPeriodic(RobotMode mode) {
 	if (m_controller != nullptr) {
+		TraceSpan span("CalcDriveOutput", "drive");
+
 		m_controller->CalcDriveOutput(m_stateProvider, m_driveOutput);
 	}
 }
@@ -31,7 +31,7 @@ GreyCompressor::GreyCompressor(DigitalInput *pressureSwitch, Relay *compressor,
 	m_compressor = compressor;
 	m_scheduler = scheduler;
 
-	this->m_scheduler->RegisterTask("Compressor", this, TASK_PERIODIC);
+	this->m_scheduler->RegisterTask("Compressor", this, TASK_PERIODIC, 5);
 }
 
 GreyCompressor::~GreyCompressor() {
@@ -0,0 +1,73 @@
+/*
+ * LockstepRunner.cpp
+ */
+
+#include "lib/LockstepRunner.h"
+#include "lib/util/VirtualClock.h"
+
+namespace frc973 {
+
+LockstepRunner::LockstepRunner(uint64_t startUs)
+	 : m_loops()
+	 , m_mode(MODE_DISABLED)
+{
+	VirtualClock::Enable(startUs);
+}
+
+LockstepRunner::~LockstepRunner() {
+	VirtualClock::Disable();
+}
+
+void LockstepRunner::AddLoop(LockstepLoop *loop) {
+	LoopState state;
+
+	state.loop = loop;
+	state.nextDeadlineUs = VirtualClock::GetTimeUs();
+	m_loops.push_back(state);
+}
+
+int LockstepRunner::NextLoop() const {
+	int next = -1;
+
+	for (unsigned int i = 0; i < m_loops.size(); i++) {
+		if (next == -1 ||
+				m_loops[i].nextDeadlineUs < m_loops[next].nextDeadlineUs) {
+			next = i;
+		}
+	}
+
+	return next;
+}
+
+void LockstepRunner::StepOnce() {
+	int next = NextLoop();
+
+	if (next == -1) {
+		return;
+	}
+
+	LoopState &state = m_loops[next];
+	uint64_t periodUs = state.loop->GetLockstepPeriodUs();
+
+	VirtualClock::SetTimeUs(state.nextDeadlineUs);
+	state.loop->StepCycle(m_mode);
+	state.nextDeadlineUs += periodUs == 0 ? 1 : periodUs;
+}
+
+uint64_t LockstepRunner::RunFor(uint64_t durationUs) {
+	uint64_t endUs = VirtualClock::GetTimeUs() + durationUs;
+	uint64_t cycles = 0;
+	int next;
+
+	while ((next = NextLoop()) != -1 &&
+			m_loops[next].nextDeadlineUs < endUs) {
+		StepOnce();
+		cycles++;
+	}
+
+	VirtualClock::SetTimeUs(endUs);
+
+	return cycles;
+}
+
+}
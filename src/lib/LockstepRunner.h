@@ -0,0 +1,106 @@
+/*
+ * LockstepRunner.h
+ *
+ * LockstepRunner - steps any number of robot loops (the CoopMTRobot main
+ * loop, SingleThreadTaskMgr threads...) on the virtual clock, one cycle at
+ * a time, with no sleeping.
+ *
+ * Each loop gets a deadline every period.  The runner always steps the
+ * loop with the earliest deadline next (loops added first win ties), after
+ * setting the virtual clock to that deadline, so a run is the same every
+ * time and a 15 second autonomous mode takes only as long as the code in
+ * it.  Task timing stats, cycle times and best-effort budgets all go by
+ * GetUsecTime, which is the virtual clock while stepping, and it doesn't
+ * move inside a cycle: every task and cycle records 0us, so overruns and
+ * degradation never kick in and a run doesn't depend on how fast the host
+ * is.  Time the whole run from outside to benchmark it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "lib/util/Util.h"
+
+namespace frc973 {
+
+/**
+ * Anything the LockstepRunner can step.
+ */
+class LockstepLoop {
+public:
+	virtual ~LockstepLoop() {}
+
+	/**
+	 * Length of one cycle of this loop in microseconds
+	 */
+	virtual uint64_t GetLockstepPeriodUs() = 0;
+
+	/**
+	 * Run exactly one cycle of the loop in the given mode (running mode
+	 * start/stop callbacks first if the mode changed) without sleeping
+	 */
+	virtual void StepCycle(RobotMode mode) = 0;
+};
+
+class LockstepRunner {
+public:
+	/**
+	 * Enable the virtual clock at the given time.  Add the loops before
+	 * anything that owns a thread (e.g. SingleThreadTaskMgr::Start) is
+	 * started so no real thread gets created.
+	 *
+	 * @param startUs virtual time to start at
+	 */
+	explicit LockstepRunner(uint64_t startUs = 0);
+
+	/**
+	 * Switches GetUsecTime back to the FPGA clock
+	 */
+	virtual ~LockstepRunner();
+
+	/**
+	 * Add a loop to step.  Its first cycle runs at the current time.
+	 */
+	void AddLoop(LockstepLoop *loop);
+
+	/**
+	 * Set the mode every loop is stepped in from now on
+	 */
+	void SetMode(RobotMode mode) {
+		m_mode = mode;
+	}
+
+	RobotMode GetMode() const {
+		return m_mode;
+	}
+
+	/**
+	 * Step every loop whose deadline falls within the next |durationUs|
+	 * microseconds and leave the clock at the end of that time.
+	 *
+	 * @return number of cycles stepped
+	 */
+	uint64_t RunFor(uint64_t durationUs);
+
+	/**
+	 * Step just the loop with the earliest deadline, one cycle
+	 */
+	void StepOnce();
+
+private:
+	struct LoopState {
+		LockstepLoop *loop;
+		uint64_t nextDeadlineUs;
+	};
+
+	/**
+	 * Index of the loop that should be stepped next, -1 if there are none
+	 */
+	int NextLoop() const;
+
+	std::vector<LoopState> m_loops;
+	RobotMode m_mode;
+};
+
+}
@@ -9,7 +9,8 @@ using namespace frc;
 namespace frc973 {
 
 // Channel is a bounded concurrent FIFO queue.  It's roughly equivalent
-// to a buffered channel in Go.
+// to a buffered channel in Go.  For a single producer and consumer that
+// must not allocate or block each other, use SpscRing (SpscChannel.h).
 template <class T> class Channel {
   public:
     Channel(int size) : m(PTHREAD_MUTEX_INITIALIZER), cond(PTHREAD_COND_INITIALIZER), sz(size) {
@@ -40,7 +41,6 @@ template <class T> class Channel {
         pthread_mutex_lock(&m);
         while (!q.empty()) {
             q.pop();
-            pthread_cond_wait(&cond, &m);
         }
         q.push(val);
         pthread_cond_signal(&cond);
@@ -70,6 +70,7 @@ template <class T> class Channel {
     T recvNonBlock() {
       pthread_mutex_lock(&m);
       if (q.empty()) {
+          pthread_mutex_unlock(&m);
           return NULL;
       }
       T val = q.front();
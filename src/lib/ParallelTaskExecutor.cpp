@@ -0,0 +1,280 @@
+/*
+ * ParallelTaskExecutor.cpp
+ */
+
+#include "lib/ParallelTaskExecutor.h"
+
+#include <stdio.h>
+
+namespace frc973 {
+
+ParallelTaskExecutor::ParallelTaskExecutor(int numThreads,
+		const RTThreadConfig &workerConfig)
+	 : m_numThreads(numThreads < 1 ? 1 : numThreads)
+	 , m_workerConfig(workerConfig)
+	 , m_threads()
+	 , m_workerArgs(m_numThreads)
+	 , m_queues(m_numThreads)
+	 , m_graph(nullptr)
+	 , m_func(nullptr)
+	 , m_ctx(nullptr)
+	 , m_pendingDeps(nullptr)
+	 , m_capacity(0)
+	 , m_remaining(0)
+	 , m_readyVersion(0)
+	 , m_readyWaiters(0)
+	 , m_generation(0)
+	 , m_finishedWorkers(0)
+	 , m_shutdown(false)
+{
+	pthread_mutex_init(&m_readyMutex, NULL);
+	pthread_cond_init(&m_readyCond, NULL);
+	pthread_mutex_init(&m_wakeMutex, NULL);
+	pthread_cond_init(&m_wakeCond, NULL);
+	pthread_cond_init(&m_doneCond, NULL);
+
+	for (int i = 0; i < m_numThreads; i++) {
+		pthread_mutex_init(&m_queues[i].mutex, NULL);
+		m_queues[i].top = 0;
+		m_queues[i].bottom = 0;
+	}
+
+	for (int i = 1; i < m_numThreads; i++) {
+		pthread_t thread;
+
+		m_workerArgs[i].executor = this;
+		m_workerArgs[i].worker = i;
+		if (pthread_create(&thread, NULL, WorkerMain, &m_workerArgs[i]) != 0) {
+			fprintf(stderr, "ParallelTaskExecutor: could not start worker %d, "
+					"running on %d threads\n", i, i);
+			m_numThreads = i;
+			break;
+		}
+		m_threads.push_back(thread);
+	}
+}
+
+ParallelTaskExecutor::~ParallelTaskExecutor() {
+	pthread_mutex_lock(&m_wakeMutex);
+	m_shutdown = true;
+	pthread_cond_broadcast(&m_wakeCond);
+	pthread_mutex_unlock(&m_wakeMutex);
+
+	for (unsigned int i = 0; i < m_threads.size(); i++) {
+		pthread_join(m_threads[i], NULL);
+	}
+
+	for (unsigned int i = 0; i < m_queues.size(); i++) {
+		pthread_mutex_destroy(&m_queues[i].mutex);
+	}
+	pthread_cond_destroy(&m_doneCond);
+	pthread_cond_destroy(&m_wakeCond);
+	pthread_mutex_destroy(&m_wakeMutex);
+	pthread_cond_destroy(&m_readyCond);
+	pthread_mutex_destroy(&m_readyMutex);
+
+	delete[] m_pendingDeps;
+}
+
+void ParallelTaskExecutor::Reserve(int numNodes) {
+	if (numNodes <= m_capacity) {
+		return;
+	}
+
+	delete[] m_pendingDeps;
+	m_pendingDeps = new std::atomic<int>[numNodes];
+	m_capacity = numNodes;
+
+	/* any one worker might end up holding every node */
+	for (int i = 0; i < m_numThreads; i++) {
+		m_queues[i].nodes.resize(numNodes);
+	}
+}
+
+void ParallelTaskExecutor::Run(const TaskGraph &graph, NodeFunc func,
+		void *ctx) {
+	int numNodes = graph.GetNumNodes();
+
+	if (numNodes == 0) {
+		return;
+	}
+
+	Reserve(numNodes);
+
+	for (int i = 0; i < m_numThreads; i++) {
+		m_queues[i].top = 0;
+		m_queues[i].bottom = 0;
+	}
+
+	/* deal the nodes with nothing to wait on out to all the workers */
+	int nextWorker = 0;
+	for (int i = 0; i < numNodes; i++) {
+		int numDeps = graph.GetNumDeps(i);
+
+		m_pendingDeps[i].store(numDeps, std::memory_order_relaxed);
+		if (numDeps == 0) {
+			WorkQueue &queue = m_queues[nextWorker];
+			queue.nodes[queue.bottom++] = i;
+			nextWorker = (nextWorker + 1) % m_numThreads;
+		}
+	}
+
+	m_graph = &graph;
+	m_func = func;
+	m_ctx = ctx;
+	m_remaining.store(numNodes, std::memory_order_release);
+
+	if (m_numThreads > 1) {
+		pthread_mutex_lock(&m_wakeMutex);
+		m_finishedWorkers = 0;
+		m_generation++;
+		pthread_cond_broadcast(&m_wakeCond);
+		pthread_mutex_unlock(&m_wakeMutex);
+	}
+
+	WorkLoop(0);
+
+	/* don't let the graph go out from under a worker still looking at it */
+	if (m_numThreads > 1) {
+		pthread_mutex_lock(&m_wakeMutex);
+		while (m_finishedWorkers < m_numThreads - 1) {
+			pthread_cond_wait(&m_doneCond, &m_wakeMutex);
+		}
+		pthread_mutex_unlock(&m_wakeMutex);
+	}
+
+	m_graph = nullptr;
+}
+
+void *ParallelTaskExecutor::WorkerMain(void *p) {
+	WorkerArgs *args = static_cast<WorkerArgs*>(p);
+	ParallelTaskExecutor *executor = args->executor;
+	uint32_t seenGeneration = 0;
+
+	RTThread::Configure(executor->m_workerConfig);
+
+	pthread_mutex_lock(&executor->m_wakeMutex);
+	while (true) {
+		while (executor->m_generation == seenGeneration &&
+				!executor->m_shutdown) {
+			pthread_cond_wait(&executor->m_wakeCond, &executor->m_wakeMutex);
+		}
+		if (executor->m_shutdown) {
+			break;
+		}
+		seenGeneration = executor->m_generation;
+		pthread_mutex_unlock(&executor->m_wakeMutex);
+
+		executor->WorkLoop(args->worker);
+
+		pthread_mutex_lock(&executor->m_wakeMutex);
+		executor->m_finishedWorkers++;
+		pthread_cond_signal(&executor->m_doneCond);
+	}
+	pthread_mutex_unlock(&executor->m_wakeMutex);
+
+	return NULL;
+}
+
+void ParallelTaskExecutor::WorkLoop(int worker) {
+	while (m_remaining.load(std::memory_order_acquire) > 0) {
+		/* read before looking so a node readied while we look isn't
+		 * slept through */
+		uint32_t seenVersion = m_readyVersion.load();
+		int node = Pop(worker);
+		bool readied = false;
+
+		if (node < 0) {
+			node = Steal(worker);
+		}
+		if (node < 0) {
+			/* everything left is running or waiting on something running */
+			WaitForReady(seenVersion);
+			continue;
+		}
+
+		m_func(m_ctx, node);
+
+		/* successors have to be queued before |m_remaining| drops or the
+		 * other workers could decide the graph is finished */
+		const std::vector<int> &successors = m_graph->GetSuccessors(node);
+		for (unsigned int i = 0; i < successors.size(); i++) {
+			int next = successors[i];
+			if (m_pendingDeps[next].fetch_sub(1,
+						std::memory_order_acq_rel) == 1) {
+				Push(worker, next);
+				readied = true;
+			}
+		}
+
+		if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 ||
+				readied) {
+			NotifyReady();
+		}
+	}
+}
+
+void ParallelTaskExecutor::NotifyReady() {
+	/* seq_cst on both sides: either this sees the waiter or the waiter
+	 * sees the new version, so the lock is only taken when somebody is
+	 * actually asleep */
+	m_readyVersion.fetch_add(1);
+	if (m_readyWaiters.load() > 0) {
+		pthread_mutex_lock(&m_readyMutex);
+		pthread_cond_broadcast(&m_readyCond);
+		pthread_mutex_unlock(&m_readyMutex);
+	}
+}
+
+void ParallelTaskExecutor::WaitForReady(uint32_t seenVersion) {
+	pthread_mutex_lock(&m_readyMutex);
+	m_readyWaiters.fetch_add(1);
+	while (m_readyVersion.load() == seenVersion &&
+			m_remaining.load(std::memory_order_acquire) > 0) {
+		pthread_cond_wait(&m_readyCond, &m_readyMutex);
+	}
+	m_readyWaiters.fetch_sub(1);
+	pthread_mutex_unlock(&m_readyMutex);
+}
+
+void ParallelTaskExecutor::Push(int worker, int node) {
+	WorkQueue &queue = m_queues[worker];
+
+	pthread_mutex_lock(&queue.mutex);
+	queue.nodes[queue.bottom++] = node;
+	pthread_mutex_unlock(&queue.mutex);
+}
+
+int ParallelTaskExecutor::Pop(int worker) {
+	WorkQueue &queue = m_queues[worker];
+	int node = -1;
+
+	pthread_mutex_lock(&queue.mutex);
+	if (queue.bottom > queue.top) {
+		node = queue.nodes[--queue.bottom];
+	}
+	pthread_mutex_unlock(&queue.mutex);
+
+	return node;
+}
+
+int ParallelTaskExecutor::Steal(int thief) {
+	for (int i = 1; i < m_numThreads; i++) {
+		WorkQueue &queue = m_queues[(thief + i) % m_numThreads];
+		int node = -1;
+
+		pthread_mutex_lock(&queue.mutex);
+		if (queue.bottom > queue.top) {
+			node = queue.nodes[queue.top++];
+		}
+		pthread_mutex_unlock(&queue.mutex);
+
+		if (node >= 0) {
+			return node;
+		}
+	}
+
+	return -1;
+}
+
+}
@@ -0,0 +1,188 @@
+/*
+ * ParallelTaskExecutor.h
+ *
+ * ParallelTaskExecutor - runs a dependency graph of jobs on a small pool
+ * of worker threads.
+ *
+ * The graph is described by a TaskGraph: nodes are numbered 0 to N-1 and
+ * an edge from a to b means b may not start until a has finished.  Run
+ * hands every node to the NodeFunc exactly once, respecting the edges, and
+ * only returns once every node has finished, so back to back calls to Run
+ * act as barriers between phases.
+ *
+ * Each worker (the calling thread is worker 0) keeps its own deque of
+ * ready nodes: a worker pops the newest node from its own deque and, when
+ * that is empty, steals the oldest node from another worker's deque.
+ * Nodes that become ready are pushed onto the deque of the worker that
+ * finished their last dependency, which keeps chains on one core.  A
+ * worker that finds nothing to run sleeps until a node becomes ready or
+ * the graph finishes, rather than spinning on a core the rest of the
+ * robot needs.
+ *
+ * All buffers are sized when a bigger graph is first run; steady state
+ * runs do not allocate.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+#include <vector>
+#include "RTThread.h"
+
+namespace frc973 {
+
+class TaskGraph {
+public:
+	TaskGraph() {}
+
+	/**
+	 * Remove all nodes and edges
+	 */
+	void Clear() {
+		m_numDeps.clear();
+		m_successors.clear();
+	}
+
+	/**
+	 * Add a node with no dependencies
+	 *
+	 * @return the number of the new node
+	 */
+	int AddNode() {
+		m_numDeps.push_back(0);
+		m_successors.push_back(std::vector<int>());
+		return m_numDeps.size() - 1;
+	}
+
+	/**
+	 * Make |to| wait for |from| to finish
+	 */
+	void AddEdge(int from, int to) {
+		m_successors[from].push_back(to);
+		m_numDeps[to]++;
+	}
+
+	int GetNumNodes() const {
+		return m_numDeps.size();
+	}
+
+	int GetNumDeps(int node) const {
+		return m_numDeps[node];
+	}
+
+	const std::vector<int> &GetSuccessors(int node) const {
+		return m_successors[node];
+	}
+
+private:
+	std::vector<int> m_numDeps;
+	std::vector<std::vector<int>> m_successors;
+};
+
+class ParallelTaskExecutor {
+public:
+	typedef void (*NodeFunc)(void *ctx, int node);
+
+	/**
+	 * Start the worker threads.
+	 *
+	 * @param numThreads total number of threads to run nodes on, including
+	 * 		the thread that calls Run (so 2 starts one extra thread)
+	 * @param workerConfig real-time setup of the extra threads
+	 */
+	explicit ParallelTaskExecutor(int numThreads,
+			const RTThreadConfig &workerConfig = {"task worker", 0, -1, 0});
+	virtual ~ParallelTaskExecutor();
+
+	/**
+	 * Run every node of |graph|, calling func(ctx, node) for each, and
+	 * wait for all of them to finish.  Only one thread may call Run at a
+	 * time.
+	 */
+	void Run(const TaskGraph &graph, NodeFunc func, void *ctx);
+
+	/**
+	 * Get the number of threads (including the caller) nodes run on
+	 */
+	int GetNumThreads() const {
+		return m_numThreads;
+	}
+
+	/**
+	 * Get the pthread of one of the worker threads (1 to GetNumThreads()-1)
+	 */
+	pthread_t GetWorkerThread(int worker) const {
+		return m_threads[worker - 1];
+	}
+
+private:
+	/**
+	 * Per-worker deque of ready nodes.  The owner pushes and pops at the
+	 * bottom, thieves take from the top.
+	 */
+	struct WorkQueue {
+		pthread_mutex_t mutex;
+		std::vector<int> nodes;
+		int top;
+		int bottom;
+		char pad[64];
+	};
+
+	struct WorkerArgs {
+		ParallelTaskExecutor *executor;
+		int worker;
+	};
+
+	ParallelTaskExecutor(const ParallelTaskExecutor&) = delete;
+	ParallelTaskExecutor &operator=(const ParallelTaskExecutor&) = delete;
+
+	static void *WorkerMain(void *p);
+
+	void Reserve(int numNodes);
+	void WorkLoop(int worker);
+	void Push(int worker, int node);
+	int Pop(int worker);
+	int Steal(int thief);
+
+	/**
+	 * Wake the workers sleeping in WaitForReady, if there are any
+	 */
+	void NotifyReady();
+
+	/**
+	 * Sleep until NotifyReady has been called since |seenVersion| was
+	 * read from m_readyVersion, or the graph is finished
+	 */
+	void WaitForReady(uint32_t seenVersion);
+
+	int m_numThreads;
+	RTThreadConfig m_workerConfig;
+	std::vector<pthread_t> m_threads;
+	std::vector<WorkerArgs> m_workerArgs;
+	std::vector<WorkQueue> m_queues;
+
+	/* state of the graph currently being run */
+	const TaskGraph *m_graph;
+	NodeFunc m_func;
+	void *m_ctx;
+	std::atomic<int> *m_pendingDeps;
+	int m_capacity;
+	std::atomic<int> m_remaining;
+
+	/* bumped every time nodes become ready or the graph finishes */
+	std::atomic<uint32_t> m_readyVersion;
+	std::atomic<int> m_readyWaiters;
+	pthread_mutex_t m_readyMutex;
+	pthread_cond_t m_readyCond;
+
+	pthread_mutex_t m_wakeMutex;
+	pthread_cond_t m_wakeCond;
+	pthread_cond_t m_doneCond;
+	uint32_t m_generation;
+	int m_finishedWorkers;
+	bool m_shutdown;
+};
+
+}
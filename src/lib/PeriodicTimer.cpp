@@ -0,0 +1,98 @@
+/*
+ * PeriodicTimer.cpp
+ */
+
+#include "lib/PeriodicTimer.h"
+
+#include <errno.h>
+#include <time.h>
+
+namespace frc973 {
+
+static constexpr uint64_t NSEC_PER_SEC = 1000000000ULL;
+static constexpr uint64_t NSEC_PER_USEC = 1000ULL;
+
+PeriodicTimer::PeriodicTimer(uint64_t periodNs, MissedPeriodPolicy policy)
+	 : m_periodNs(periodNs)
+	 , m_policy(policy)
+	 , m_deadlineNs(0)
+	 , m_started(false)
+	 , m_missedPeriods(0)
+	 , m_jitterStats()
+{
+}
+
+void PeriodicTimer::Reset() {
+	m_deadlineNs = GetMonotonicNs();
+	m_started = true;
+}
+
+uint32_t PeriodicTimer::WaitForNextPeriod() {
+	uint32_t missed = 0;
+
+	if (!m_started) {
+		Reset();
+	}
+
+	m_deadlineNs = AdvanceDeadline(m_deadlineNs, GetMonotonicNs(),
+			GetPeriodNs(), GetMissedPeriodPolicy(), &missed);
+
+	struct timespec deadline;
+	deadline.tv_sec = m_deadlineNs / NSEC_PER_SEC;
+	deadline.tv_nsec = m_deadlineNs % NSEC_PER_SEC;
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline,
+				NULL) == EINTR) {
+		/* interrupted by a signal... just go back to sleep */
+	}
+
+	uint64_t wakeNs = GetMonotonicNs();
+	if (wakeNs > m_deadlineNs) {
+		m_jitterStats.Record((wakeNs - m_deadlineNs) / NSEC_PER_USEC);
+	}
+	else {
+		m_jitterStats.Record(0);
+	}
+
+	if (missed != 0) {
+		m_missedPeriods.fetch_add(missed, std::memory_order_relaxed);
+	}
+
+	return missed;
+}
+
+uint64_t PeriodicTimer::AdvanceDeadline(uint64_t deadlineNs, uint64_t nowNs,
+		uint64_t periodNs, MissedPeriodPolicy policy, uint32_t *missed) {
+	uint64_t next = deadlineNs + periodNs;
+
+	*missed = 0;
+
+	if (periodNs == 0) {
+		return nowNs;
+	}
+	else if (next > nowNs) {
+		return next;
+	}
+
+	/* |behind| period boundaries have already gone by */
+	uint64_t behind = (nowNs - next) / periodNs + 1;
+
+	if (policy == CatchUp && behind <= MAX_CATCH_UP_PERIODS) {
+		/* next deadline is in the past so the next period runs right
+		 * away; keep doing that until we are back on schedule */
+		return next;
+	}
+
+	*missed = behind;
+	return deadlineNs + (behind + 1) * periodNs;
+}
+
+uint64_t PeriodicTimer::GetMonotonicNs() {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((uint64_t) now.tv_sec) * NSEC_PER_SEC + now.tv_nsec;
+}
+
+}
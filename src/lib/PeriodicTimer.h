@@ -0,0 +1,131 @@
+/*
+ * PeriodicTimer.h
+ *
+ * PeriodicTimer - sleeps a thread until the start of its next period.
+ *
+ * Deadlines are kept as absolute CLOCK_MONOTONIC times and the thread is
+ * put to sleep with clock_nanosleep(TIMER_ABSTIME), so the period does not
+ * drift no matter how long the work in each period takes.  When a period
+ * is missed entirely, the missed period policy decides whether to run the
+ * missed periods back to back (CatchUp) or to drop them and line up with
+ * the next period boundary (SkipMissed).
+ *
+ * Every wake-up is compared with the deadline it was meant for and the
+ * difference is kept in a TaskStats histogram, so the period jitter of a
+ * loop can be read at runtime.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "lib/TaskStats.h"
+
+namespace frc973 {
+
+class PeriodicTimer {
+public:
+	enum MissedPeriodPolicy {
+		CatchUp,	/* run every missed period, back to back */
+		SkipMissed	/* drop missed periods, wait for the next boundary */
+	};
+
+	/**
+	 * Most periods CatchUp will run back to back before giving up and
+	 * lining up with the next period boundary anyway
+	 */
+	static constexpr uint32_t MAX_CATCH_UP_PERIODS = 5;
+
+	/**
+	 * Create a timer.  The first period starts when Reset (or the first
+	 * WaitForNextPeriod) is called.
+	 *
+	 * @param periodNs length of each period in nanoseconds
+	 * @param policy what to do when a period is missed
+	 */
+	explicit PeriodicTimer(uint64_t periodNs,
+			MissedPeriodPolicy policy = SkipMissed);
+
+	/**
+	 * Start a new period now.
+	 */
+	void Reset();
+
+	/**
+	 * Change the period.  Takes effect at the next deadline.
+	 */
+	void SetPeriodNs(uint64_t periodNs) {
+		m_periodNs.store(periodNs, std::memory_order_relaxed);
+	}
+
+	uint64_t GetPeriodNs() const {
+		return m_periodNs.load(std::memory_order_relaxed);
+	}
+
+	void SetMissedPeriodPolicy(MissedPeriodPolicy policy) {
+		m_policy.store(policy, std::memory_order_relaxed);
+	}
+
+	MissedPeriodPolicy GetMissedPeriodPolicy() const {
+		return m_policy.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Sleep until the start of the next period.
+	 *
+	 * @return number of periods that were missed since the last call
+	 */
+	uint32_t WaitForNextPeriod();
+
+	/**
+	 * Get the time (in nanoseconds on CLOCK_MONOTONIC) the current period
+	 * was scheduled to start
+	 */
+	uint64_t GetDeadlineNs() const {
+		return m_deadlineNs;
+	}
+
+	/**
+	 * Wake-up lateness (actual wake time minus scheduled period start) of
+	 * every period, in microseconds
+	 */
+	const TaskStats &GetWakeJitterStats() const {
+		return m_jitterStats;
+	}
+
+	/**
+	 * Total number of periods missed since the timer was created
+	 */
+	uint64_t GetMissedPeriods() const {
+		return m_missedPeriods.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Work out the next deadline given the current one.
+	 *
+	 * @param deadlineNs deadline of the period that just finished
+	 * @param nowNs current time
+	 * @param periodNs length of a period
+	 * @param policy what to do if periods were missed
+	 * @param missed filled with the number of periods missed
+	 *
+	 * @return deadline of the next period
+	 */
+	static uint64_t AdvanceDeadline(uint64_t deadlineNs, uint64_t nowNs,
+			uint64_t periodNs, MissedPeriodPolicy policy, uint32_t *missed);
+
+	/**
+	 * Get the current CLOCK_MONOTONIC time in nanoseconds
+	 */
+	static uint64_t GetMonotonicNs();
+
+private:
+	std::atomic<uint64_t> m_periodNs;
+	std::atomic<MissedPeriodPolicy> m_policy;
+	uint64_t m_deadlineNs;
+	bool m_started;
+	std::atomic<uint64_t> m_missedPeriods;
+	TaskStats m_jitterStats;
+};
+
+}
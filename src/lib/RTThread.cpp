@@ -0,0 +1,206 @@
+/*
+ * RTThread.cpp
+ */
+
+#include "lib/RTThread.h"
+#include "lib/Tracer.h"
+
+#include <alloca.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace frc973 {
+
+static constexpr int THREAD_NAME_LEN = 15;
+
+namespace {
+
+struct ThreadRecord {
+	char name[THREAD_NAME_LEN + 1];
+	pid_t tid;
+	int priority;
+	int cpu;
+};
+
+pthread_mutex_t threadsMutex = PTHREAD_MUTEX_INITIALIZER;
+ThreadRecord threads[RTThread::MAX_THREADS];
+int numThreads = 0;
+
+/**
+ * Touch |bytes| of stack below the caller so those pages are mapped (and
+ * locked, after LockAllMemory) before the thread starts its real work
+ */
+void __attribute__((noinline)) PrefaultStack(size_t bytes) {
+	volatile char *stack = (volatile char*) alloca(bytes);
+
+	for (size_t i = 0; i < bytes; i += 1024) {
+		stack[i] = 0;
+	}
+}
+
+void RememberThread(const RTThreadConfig &config) {
+	pid_t tid = RTThread::GetThreadId();
+
+	pthread_mutex_lock(&threadsMutex);
+	int slot = 0;
+	while (slot < numThreads && threads[slot].tid != tid) {
+		slot++;
+	}
+	if (slot < RTThread::MAX_THREADS) {
+		strncpy(threads[slot].name, config.name, THREAD_NAME_LEN);
+		threads[slot].name[THREAD_NAME_LEN] = '\0';
+		threads[slot].tid = tid;
+		threads[slot].priority = config.priority;
+		threads[slot].cpu = config.cpu;
+		if (slot == numThreads) {
+			numThreads++;
+		}
+	}
+	pthread_mutex_unlock(&threadsMutex);
+}
+
+}
+
+bool RTThread::Configure(const RTThreadConfig &config) {
+	bool success = true;
+	char name[THREAD_NAME_LEN + 1];
+	int ret;
+
+	strncpy(name, config.name, THREAD_NAME_LEN);
+	name[THREAD_NAME_LEN] = '\0';
+	pthread_setname_np(pthread_self(), name);
+	Tracer::SetThreadName(config.name);
+
+	if (config.cpu >= 0) {
+		cpu_set_t cpus;
+
+		CPU_ZERO(&cpus);
+		CPU_SET(config.cpu, &cpus);
+		ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if (ret != 0) {
+			fprintf(stderr, "RTThread %s: could not pin to cpu %d: %s\n",
+					name, config.cpu, strerror(ret));
+			success = false;
+		}
+	}
+
+	if (config.priority > 0) {
+		struct sched_param param;
+
+		param.sched_priority = config.priority;
+		ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (ret != 0) {
+			fprintf(stderr, "RTThread %s: could not set FIFO priority %d: "
+					"%s\n", name, config.priority, strerror(ret));
+			success = false;
+		}
+	}
+
+	if (config.prefaultStackBytes > 0) {
+		PrefaultStack(config.prefaultStackBytes);
+	}
+
+	RememberThread(config);
+
+	return success;
+}
+
+bool RTThread::LockAllMemory() {
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		fprintf(stderr, "RTThread: mlockall failed: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+pid_t RTThread::GetThreadId() {
+	return syscall(SYS_gettid);
+}
+
+bool RTThread::GetThreadStats(pid_t tid, ThreadStats *out) {
+	char path[64];
+	char line[256];
+	FILE *file;
+
+	memset(out, 0, sizeof(*out));
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/status", (int) tid);
+	file = fopen(path, "r");
+	if (file == NULL) {
+		return false;
+	}
+	while (fgets(line, sizeof(line), file) != NULL) {
+		unsigned long long val;
+
+		if (sscanf(line, "voluntary_ctxt_switches: %llu", &val) == 1) {
+			out->voluntarySwitches = val;
+		}
+		else if (sscanf(line, "nonvoluntary_ctxt_switches: %llu",
+					&val) == 1) {
+			out->involuntarySwitches = val;
+		}
+	}
+	fclose(file);
+
+	/* fault counts are fields 10 and 12 of stat; the command name (field
+	 * 2) may contain spaces so start after its closing paren */
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int) tid);
+	file = fopen(path, "r");
+	if (file == NULL) {
+		return false;
+	}
+	bool parsed = false;
+	if (fgets(line, sizeof(line), file) != NULL) {
+		char *rest = strrchr(line, ')');
+		unsigned long long minflt, majflt;
+
+		if (rest != NULL && sscanf(rest + 1,
+					" %*c %*d %*d %*d %*d %*d %*u %llu %*u %llu",
+					&minflt, &majflt) == 2) {
+			out->minorFaults = minflt;
+			out->majorFaults = majflt;
+			parsed = true;
+		}
+	}
+	fclose(file);
+
+	return parsed;
+}
+
+void RTThread::PrintThreadReport() {
+	ThreadRecord snapshot[MAX_THREADS];
+	int count;
+
+	pthread_mutex_lock(&threadsMutex);
+	count = numThreads;
+	memcpy(snapshot, threads, sizeof(ThreadRecord) * count);
+	pthread_mutex_unlock(&threadsMutex);
+
+	printf("%-16s %6s %4s %4s %10s %10s %8s %8s\n",
+			"thread", "tid", "prio", "cpu", "vol csw", "invol csw",
+			"minflt", "majflt");
+	for (int i = 0; i < count; i++) {
+		ThreadStats stats;
+
+		if (!GetThreadStats(snapshot[i].tid, &stats)) {
+			printf("%-16s %6d (exited)\n", snapshot[i].name,
+					(int) snapshot[i].tid);
+			continue;
+		}
+		printf("%-16s %6d %4d %4d %10llu %10llu %8llu %8llu\n",
+				snapshot[i].name, (int) snapshot[i].tid,
+				snapshot[i].priority, snapshot[i].cpu,
+				(unsigned long long) stats.voluntarySwitches,
+				(unsigned long long) stats.involuntarySwitches,
+				(unsigned long long) stats.minorFaults,
+				(unsigned long long) stats.majorFaults);
+	}
+}
+
+}
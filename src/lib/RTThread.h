@@ -0,0 +1,89 @@
+/*
+ * RTThread.h
+ *
+ * RTThread - one place to set up the real-time behavior of every thread
+ * the robot starts, and to see afterwards how well that worked.
+ *
+ * Each thread describes what it wants in an RTThreadConfig (name, FIFO
+ * priority, CPU, how much stack to fault in up front) and calls
+ * RTThread::Configure with it as the first thing it does.  Configured
+ * threads are remembered so PrintThreadReport can show how often each one
+ * was preempted (involuntary context switches) and how many page faults
+ * it took, straight from /proc.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+namespace frc973 {
+
+struct RTThreadConfig {
+	const char *name;			/* up to 15 characters show up in top/ps */
+	int priority;				/* SCHED_FIFO priority 1-99, 0 for normal */
+	int cpu;					/* CPU to pin the thread to, -1 for any */
+	size_t prefaultStackBytes;	/* stack to touch so it never faults later */
+};
+
+class RTThread {
+public:
+	/**
+	 * Most threads Configure keeps track of for reporting
+	 */
+	static constexpr int MAX_THREADS = 32;
+
+	/**
+	 * Context switch and page fault counts of one thread
+	 */
+	struct ThreadStats {
+		uint64_t voluntarySwitches;
+		uint64_t involuntarySwitches;
+		uint64_t minorFaults;
+		uint64_t majorFaults;
+	};
+
+	/**
+	 * Apply |config| to the calling thread and remember the thread for
+	 * PrintThreadReport.  Anything that can't be applied (usually for
+	 * lack of permission) is reported on stderr and skipped.
+	 *
+	 * @param config how the thread should be set up
+	 *
+	 * @return true if every setting was applied
+	 */
+	static bool Configure(const RTThreadConfig &config);
+
+	/**
+	 * Lock every page the process has now and will have later into RAM
+	 * so no real-time thread ever waits on a page fault.
+	 *
+	 * @return true if the memory was locked
+	 */
+	static bool LockAllMemory();
+
+	/**
+	 * Read the context switch and page fault counts of a thread of this
+	 * process from /proc.
+	 *
+	 * @param tid kernel thread id (as returned by GetThreadId)
+	 * @param out filled with the counts
+	 *
+	 * @return true if the counts could be read
+	 */
+	static bool GetThreadStats(pid_t tid, ThreadStats *out);
+
+	/**
+	 * Get the kernel thread id of the calling thread
+	 */
+	static pid_t GetThreadId();
+
+	/**
+	 * Print the scheduling setup and context switch / page fault counts
+	 * of every thread that has been configured.
+	 */
+	static void PrintThreadReport();
+};
+
+}
@@ -6,6 +6,8 @@
 #include <unistd.h>
 
 #include "lib/util/Util.h"
+#include "lib/PeriodicTimer.h"
+#include "lib/Tracer.h"
 #include "WPILib.h"
 
 namespace frc973 {
@@ -18,9 +20,13 @@ uint32_t swapTheBytes(uint32_t dword) {
  * Constructor initializes gyroscope, starts a thread to continually
  * update values, and then returns.
  */
-SPIGyro::SPIGyro(): mutex(PTHREAD_MUTEX_INITIALIZER),
+SPIGyro::SPIGyro(const RTThreadConfig &threadConfig):
+    threadConfig(threadConfig),
     gyro(new SPI(SPI::kOnboardCS0)),
-    timer()
+    timer(),
+    angle(0.0),
+    reading(GyroReading{0.0, 0.0}),
+    angleZero(0.0)
 {
     run_ = true;
 
@@ -47,10 +53,7 @@ SPIGyro::SPIGyro(): mutex(PTHREAD_MUTEX_INITIALIZER),
  */
 double SPIGyro::GetDegrees()
 {
-    pthread_mutex_lock(&mutex);
-    double ret = angle;
-    pthread_mutex_unlock(&mutex);
-    return ret;
+    return reading.Read().angle - angleZero.load(std::memory_order_relaxed);
 }
 
 /*
@@ -58,20 +61,28 @@ double SPIGyro::GetDegrees()
  */
 double SPIGyro::GetDegreesPerSec()
 {
-    pthread_mutex_lock(&mutex);
-    double ret = angularMomentum;
-    pthread_mutex_unlock(&mutex);
-    return ret;
+    return reading.Read().angularMomentum;
 }
 
 /*
- * Sets the current gyro heading to zero
+ * Returns the time (from GetUsecTime) of the latest reading
+ */
+uint64_t SPIGyro::GetReadingTimeUs()
+{
+    uint64_t timeUs;
+    GyroReading latest;
+
+    reading.Read(&latest, &timeUs);
+    return timeUs;
+}
+
+/*
+ * Sets the current gyro heading to zero.  The gyro thread owns the
+ * running angle, so rather than clearing it remember where it was.
  */
 void SPIGyro::Reset()
 {
-    pthread_mutex_lock(&mutex);
-    angle = 0;
-    pthread_mutex_unlock(&mutex);
+    angleZero.store(reading.Read().angle, std::memory_order_relaxed);
 }
 
 
@@ -92,9 +103,9 @@ void SPIGyro::ZeroAngle()
 	}
 	zero_offset /= static_cast<double>(num_samples);
 
-	pthread_mutex_lock(&mutex);
 	angle = 0;
-	pthread_mutex_unlock(&mutex);
+	angleZero.store(0.0, std::memory_order_relaxed);
+	reading.Publish(GyroReading{angle, reading.Read().angularMomentum});
 
 	printf("Total zero offset: %f\n", zero_offset);
 }
@@ -115,6 +126,8 @@ void* SPIGyro::Run(void *p)
 {
 	SPIGyro *inst = (SPIGyro *) p;
 
+    RTThread::Configure(inst->threadConfig);
+
     inst->timer.Reset();
     inst->timer.Start();
 
@@ -129,10 +142,11 @@ void* SPIGyro::Run(void *p)
     printf("Gyro ID: %u\n", inst->ReadPartID());
 
     int cyc = 0;
+    PeriodicTimer period(1000000000ULL / kReadingRate);
 
+    period.Reset();
     while (inst->run_) {
-        inst->timer.Reset();
-        inst->timer.Start();
+        Tracer::Begin("Gyro update", "gyro");
 
         inst->CollectZeroData();
 
@@ -147,11 +161,10 @@ void* SPIGyro::Run(void *p)
 			//printf("angle is %f, momentum is %f\n", inst->GetDegrees(), inst->GetDegreesPerSec());
 		}
 
-        //Wait till the next 1/kReadingRate us period to make next reading
-        usleep((unsigned int) 
-				(((static_cast<double>(1.0) / static_cast<double>(inst->kReadingRate))
-						 - inst->timer.Get())
-				 * static_cast<double>(1e6)));
+        Tracer::End("Gyro update", "gyro");
+
+        //Wait till the next 1/kReadingRate period to make next reading
+        period.WaitForNextPeriod();
     }
     return NULL;
 }
@@ -256,12 +269,10 @@ void SPIGyro::UpdateReading() {
 			ExtractAngle(result) / (double) kReadingRate;
 		new_angle += zero_offset;
 
-		pthread_mutex_lock(&mutex);
 		angle += new_angle;
-		angularMomentum = new_angle;
+		reading.Publish(GyroReading{angle, new_angle});
 
 		//lastCall = now;
-		pthread_mutex_unlock(&mutex);
     }
 }
 
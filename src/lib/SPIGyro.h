@@ -1,7 +1,9 @@
 #pragma once
 
-#include <pthread.h>
+#include <atomic>
 #include "WPILib.h"
+#include "lib/RTThread.h"
+#include "lib/util/Mailbox.h"
 
 
 #ifndef M_PI
@@ -13,16 +15,20 @@ using namespace frc;
 namespace frc973 {
 
 /*
- * Task that continually checks the gyro and serves that data out
+ * Task that continually checks the gyro and serves that data out.  Each
+ * reading is published to a Mailbox so callers on other threads get the
+ * newest one without ever waiting on the gyro thread.
  */
 
 class SPIGyro {
     public:
         /*
          * Constructor initializes gyroscope, starts a thread to continually
-         * update values, and then returns.
+         * update values, and then returns.  |threadConfig| sets up the
+         * real-time behavior of that thread.
          */
-        SPIGyro();
+        SPIGyro(const RTThreadConfig &threadConfig =
+                {"spi gyro", 0, -1, 0});
 
         /*
          * Returns the latest angle reading from the gyro.
@@ -34,6 +40,11 @@ class SPIGyro {
          */
         double GetDegreesPerSec();
 
+        /*
+         * Returns the time (from GetUsecTime) of the latest reading
+         */
+        uint64_t GetReadingTimeUs();
+
         /*
          * Sets the current gyro heading to zero
          */
@@ -132,12 +143,17 @@ class SPIGyro {
         // Readings per second.
         static const int kReadingRate = 200;
 
-        pthread_mutex_t mutex;
+        struct GyroReading {
+            double angle;               // since the gyro thread last zeroed
+            double angularMomentum;
+        };
+
+        RTThreadConfig threadConfig;
         SPI *gyro;
         Timer timer;
-        double angle;
-        double angularMomentum;
-        long timeLastUpdate;
+        double angle;                   // owned by the gyro thread
+        Mailbox<GyroReading> reading;
+        std::atomic<double> angleZero;  // reading.angle at the last Reset
         bool run_;
         double zero_offset;	//used for zeroing the gyro
 
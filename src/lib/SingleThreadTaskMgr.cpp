@@ -21,12 +21,17 @@ SingleThreadTaskMgr::SingleThreadTaskMgr(
         bool warnSlow
 	): m_thread()
 	 , m_mutex(PTHREAD_MUTEX_INITIALIZER)
-	 , m_loopPeriodSec(loopPeriod)
+	 , m_timer(loopPeriod * Constants::USEC_PER_SEC * 1000.0)
+	 , m_schedulingMode(SchedulingMode::AbsoluteDeadline)
 	 , m_actuallyRunning(false)
 	 , m_shouldBeRunning(false)
 	 , m_stateProvider(stateProvider)
      , m_warnSlow(warnSlow)
+	 , m_threadConfig{"task mgr", 0, -1, 0}
+	 , m_mode(MODE_DISABLED)
+	 , m_modeStarted(false)
 {
+	this->SetCycleOverrunThreshold(loopPeriod * Constants::USEC_PER_SEC);
 }
 
 SingleThreadTaskMgr::~SingleThreadTaskMgr() {
@@ -37,100 +42,122 @@ void SingleThreadTaskMgr::Start(void) {
 	pthread_mutex_lock(&m_mutex);
 	if (!m_shouldBeRunning) {
 		m_shouldBeRunning = true;
+		m_modeStarted = false;
 
-		pthread_create(&m_thread, NULL, RunTasks, this);
+		if (!VirtualClock::IsEnabled()) {
+			pthread_create(&m_thread, NULL, RunTasks, this);
+		}
 	}
 	pthread_mutex_unlock(&m_mutex);
 }
 
 void SingleThreadTaskMgr::Stop(void) {
-	pthread_mutex_lock(&m_mutex);
 	m_shouldBeRunning = false;
-	pthread_mutex_unlock(&m_mutex);
 }
 
 double SingleThreadTaskMgr::GetLoopPeriodSec() {
-	double period;
+	return m_timer.GetPeriodNs() * Constants::SEC_PER_USEC / 1000.0;
+}
 
-	pthread_mutex_lock(&m_mutex);
-	period = m_loopPeriodSec;
-	pthread_mutex_unlock(&m_mutex);
+void SingleThreadTaskMgr::SetLoopPeriod(double periodSec) {
+	m_timer.SetPeriodNs(periodSec * Constants::USEC_PER_SEC * 1000.0);
 
-	return period;
+	this->SetCycleOverrunThreshold(periodSec * Constants::USEC_PER_SEC);
 }
 
-void SingleThreadTaskMgr::SetLoopPeriod(double periodSec) {
-	pthread_mutex_lock(&m_mutex);
-	m_loopPeriodSec = periodSec;
-	pthread_mutex_unlock(&m_mutex);
+bool SingleThreadTaskMgr::RegisterTaskPeriod(const char *taskName,
+		CoopTask *task, uint32_t flags, double periodSec) {
+	double divisor = periodSec / GetLoopPeriodSec();
+
+	return RegisterTask(taskName, task, flags,
+			divisor < 1.0 ? 1 : (uint32_t) (divisor + 0.5));
 }
 
 bool SingleThreadTaskMgr::IsRunning() {
-	bool isRunning;
+	return m_shouldBeRunning;
+}
+
+void SingleThreadTaskMgr::WaitForNextPeriod(uint64_t periodStartUs) {
+	if (GetSchedulingMode() == SchedulingMode::AbsoluteDeadline) {
+		uint32_t missed = m_timer.WaitForNextPeriod();
+
+		if (missed != 0 && m_warnSlow) {
+			printf("TaskRunner (%fhz) taking too long.  "
+					"Missed %u periods\n", GetLoopFrequency(), missed);
+		}
+		return;
+	}
+
+	uint64_t timeSliceUsedUs = GetUsecTime() - periodStartUs;
+	uint64_t timeSliceAllotedUs = m_timer.GetPeriodNs() / 1000;
+
+	/* compare before subtracting... both are unsigned */
+	if (timeSliceUsedUs < timeSliceAllotedUs) {
+		usleep(timeSliceAllotedUs - timeSliceUsedUs);
+	}
+	else {
+		if (m_warnSlow) {
+			printf("TaskRunner (%fhz) taking too long.  "
+					"Time alloted for period: %llu us; time used %llu us\n",
+					GetLoopFrequency(),
+					(unsigned long long) timeSliceAllotedUs,
+					(unsigned long long) timeSliceUsedUs);
+		}
+		usleep(0);
+	}
+}
+
+void SingleThreadTaskMgr::RunCycle(RobotMode mode) {
+	if (!m_modeStarted) {
+		TaskStartModeAll(mode);
+		m_modeStarted = true;
+	}
+	else if (mode != m_mode) {
+		TaskStopModeAll(m_mode);
+		TaskStartModeAll(mode);
+	}
+	m_mode = mode;
+
+	TaskPrePeriodicAll(mode);
+	TaskPeriodicAll(mode);
+	TaskPostPeriodicAll(mode);
+}
+
+void SingleThreadTaskMgr::StepCycle(RobotMode mode) {
+	if (!m_shouldBeRunning) {
+		return;
+	}
+
+	uint64_t cycleStartUs = GetUsecTime();
 
 	pthread_mutex_lock(&m_mutex);
-	isRunning = m_shouldBeRunning;
+	RunCycle(mode);
 	pthread_mutex_unlock(&m_mutex);
 
-	return isRunning;
+	EndCycle(GetUsecTime() - cycleStartUs);
 }
 
 void* SingleThreadTaskMgr::RunTasks(void *p) {
 	SingleThreadTaskMgr *inst = (SingleThreadTaskMgr*) p;
-	bool keepRunning = true;
-	uint64_t timeSliceStartTimeUs = GetUsecTime();
+
+	RTThread::Configure(inst->m_threadConfig);
 
 	pthread_mutex_lock(&inst->m_mutex);
 	inst->m_actuallyRunning = true;
-	RobotMode state = GetRobotMode(inst->m_stateProvider);
-	inst->TaskStartModeAll(state);
 	pthread_mutex_unlock(&inst->m_mutex);
 
-	while (keepRunning) {
-		pthread_mutex_lock(&inst->m_mutex);
-
-		RobotMode nextState = GetRobotMode(inst->m_stateProvider);
+	inst->m_timer.Reset();
 
-		if (state != nextState) {
-			inst->TaskStopModeAll(state);
-			inst->TaskStartModeAll(nextState);
-			state = nextState;
-		}
-
-		inst->TaskPrePeriodicAll(state);
-		inst->TaskPeriodicAll(state);
-		inst->TaskPostPeriodicAll(state);
+	while (inst->m_shouldBeRunning) {
+		uint64_t timeSliceStartTimeUs = GetUsecTime();
 
+		pthread_mutex_lock(&inst->m_mutex);
+		inst->RunCycle(GetRobotMode(inst->m_stateProvider));
 		pthread_mutex_unlock(&inst->m_mutex);
 
-		uint64_t timeSliceUsedUs =
-				GetUsecTime() - timeSliceStartTimeUs;
+		inst->EndCycle(GetUsecTime() - timeSliceStartTimeUs);
 
-		uint64_t timeSliceAllotedUs =
-				inst->GetLoopPeriodMs() * 1000.0;
-
-		uint64_t timeSliceRemainingUs =
-				timeSliceAllotedUs - timeSliceUsedUs;
-
-		if (timeSliceUsedUs <= timeSliceAllotedUs) {
-			usleep(timeSliceRemainingUs);
-		}
-		else if(inst->m_warnSlow) {
-			printf("TaskRunner (%fhz) taking too long.  "\
-					"Time alloted for period: %llu us; time used %llu us",
-					inst->GetLoopFrequency(), timeSliceAllotedUs,
-					timeSliceUsedUs);
-            usleep(0);
-		}
-        else {
-            usleep(0);
-        }
-
-		timeSliceStartTimeUs += timeSliceAllotedUs;
-
-		pthread_mutex_lock(&inst->m_mutex);
-		keepRunning = inst->m_shouldBeRunning;
-		pthread_mutex_unlock(&inst->m_mutex);
+		inst->WaitForNextPeriod(timeSliceStartTimeUs);
 	}
 
 	pthread_mutex_lock(&inst->m_mutex);
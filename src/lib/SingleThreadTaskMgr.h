@@ -9,7 +9,11 @@
 
 #include "pthread.h"
 #include "TaskMgr.h"
+#include "PeriodicTimer.h"
+#include "RTThread.h"
+#include "LockstepRunner.h"
 #include <stdio.h>
+#include <atomic>
 #include "WPILib.h"
 using namespace frc;
 
@@ -18,8 +22,21 @@ namespace frc973 {
 static constexpr double DEFAULT_FREQUENCY = 200.0;
 static constexpr double DEFAULT_PERIOD = (1.0 / (DEFAULT_FREQUENCY));
 
-class SingleThreadTaskMgr: public TaskMgr {
+class SingleThreadTaskMgr: public TaskMgr, public LockstepLoop {
 public:
+	/**
+	 * How the thread waits between periods.
+	 *
+	 * RelativeSleep sleeps for whatever is left of the period after the
+	 * tasks ran (the old behavior).  AbsoluteDeadline sleeps until the
+	 * absolute start of the next period on CLOCK_MONOTONIC so the loop
+	 * never drifts, and applies the missed period policy on overruns.
+	 */
+	enum SchedulingMode {
+		RelativeSleep,
+		AbsoluteDeadline
+	};
+
 	/**
 	 * Initialize a Single Threaded Task Manager.  The SingleThreadTaskMgr
 	 * creates its own pthread in which to run all of its registeredCoopTasks.
@@ -38,7 +55,9 @@ public:
 	virtual ~SingleThreadTaskMgr();
 
 	/**
-	 * Start running registered CoopTasks until Stop is called (non-blocking)
+	 * Start running registered CoopTasks until Stop is called (non-blocking).
+	 * While the VirtualClock is enabled no thread is started; the tasks
+	 * run only when a LockstepRunner steps them.
 	 */
 	void Start(void);
 
@@ -93,45 +112,111 @@ public:
 		return 1.0 / this->GetLoopPeriodSec();
 	}
 
+	/**
+	 * Register a task whose periodic callbacks should run at a slower
+	 * period than this thread's loop.  The period is rounded to the
+	 * nearest whole number of loop periods.
+	 *
+	 * @param taskName name of the task (for debug purposes)
+	 * @param task the task to register
+	 * @param flags which callbacks to call for the task
+	 * @param periodSec how often (in seconds) to run the periodic callbacks
+	 *
+	 * @return true if the task was registered
+	 */
+	bool RegisterTaskPeriod(const char *taskName, CoopTask *task,
+			uint32_t flags, double periodSec);
+
 	/**
 	 * Check whether the Task Manager is running
 	 */
 	bool IsRunning();
 
 	/**
-	 * Try to set this thread to run as high priority using realtime FIFO
-	 * scheduling algorithm.
+	 * LockstepLoop: one loop period
 	 */
-	void SetHighPriority() {
-		int max = sched_get_priority_max(SCHED_FIFO);
-		int min = sched_get_priority_min(SCHED_FIFO);
-		printf("Setting thread max priority... %d\n", max);
+	uint64_t GetLockstepPeriodUs() override {
+		return m_timer.GetPeriodNs() / 1000;
+	}
 
-		struct sched_param param;
-		param.sched_priority = min + 1;
+	/**
+	 * LockstepLoop: run one cycle of the registered tasks in |mode| on
+	 * the calling thread (only while started)
+	 */
+	void StepCycle(RobotMode mode) override;
 
-		printf("setting the origonal thread down\n");
+	/**
+	 * Choose how the thread waits between periods (defaults to
+	 * AbsoluteDeadline).  Takes effect on the next period.
+	 */
+	void SetSchedulingMode(SchedulingMode mode) {
+		m_schedulingMode.store(mode, std::memory_order_relaxed);
+	}
 
-		int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
-		printf("setting thread returned status of %d\n", ret);
+	SchedulingMode GetSchedulingMode() const {
+		return m_schedulingMode.load(std::memory_order_relaxed);
+	}
 
-		param.sched_priority = max - 1;
-		printf("setting new thread up\n");
-		ret = pthread_setschedparam(m_thread, SCHED_FIFO, &param);
+	/**
+	 * Choose whether periods missed because of an overrun are run back to
+	 * back or dropped (AbsoluteDeadline mode only, defaults to SkipMissed)
+	 */
+	void SetMissedPeriodPolicy(PeriodicTimer::MissedPeriodPolicy policy) {
+		m_timer.SetMissedPeriodPolicy(policy);
+	}
 
-		printf("setting thread returned status of %d\n", ret);
+	/**
+	 * Wake-up lateness of each period in microseconds (AbsoluteDeadline
+	 * mode only).  Safe to read from any thread.
+	 */
+	const TaskStats &GetWakeJitterStats() const {
+		return m_timer.GetWakeJitterStats();
+	}
 
+	/**
+	 * Total number of periods dropped or run late because of overruns
+	 */
+	uint64_t GetMissedPeriods() const {
+		return m_timer.GetMissedPeriods();
+	}
+
+	/**
+	 * Set the real-time setup (priority, CPU...) of the thread that runs
+	 * the tasks.  Must be called before Start.
+	 */
+	void SetThreadConfig(const RTThreadConfig &config) {
+		m_threadConfig = config;
 	}
 private:
 	static void *RunTasks(void*);
 
+	/**
+	 * Sleep until the next period should start according to the current
+	 * scheduling mode
+	 *
+	 * @param periodStartUs time (from GetUsecTime) the finished period
+	 * 		started, used in RelativeSleep mode
+	 */
+	void WaitForNextPeriod(uint64_t periodStartUs);
+
+	/**
+	 * Run the tasks for one period in |mode|, stopping the previous mode
+	 * and starting the new one first if the mode changed.  Caller holds
+	 * m_mutex and records the cycle time.
+	 */
+	void RunCycle(RobotMode mode);
+
 	pthread_t m_thread;
 	pthread_mutex_t	m_mutex;
-	double m_loopPeriodSec;
+	PeriodicTimer m_timer;
+	std::atomic<SchedulingMode> m_schedulingMode;
 	bool m_actuallyRunning;
-	bool m_shouldBeRunning;
+	std::atomic<bool> m_shouldBeRunning;
 	RobotStateInterface &m_stateProvider;
     bool m_warnSlow;
+	RTThreadConfig m_threadConfig;
+	RobotMode m_mode;
+	bool m_modeStarted;
 };
 
 }
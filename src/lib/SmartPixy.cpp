@@ -1,4 +1,5 @@
 #include "lib/SmartPixy.h"
+#include "lib/logging/DeferredLog.h"
 #include "unistd.h"
 #include "stdlib.h"
 
@@ -29,11 +30,11 @@ void Pixy::Block::print()
 {
 	if (signature > PIXY_MAX_SIGNATURE) // color code! (CC)
 	{
-        printf("CC block! sig: 0x%x (%d decimal) x: %d y: %d width: %d height: %d angle %d\n",
+        DebugPrintf("CC block! sig: 0x%x (%d decimal) x: %d y: %d width: %d height: %d angle %d\n",
                signature, signature, x, y, width, height, angle);
 	}
 	else // regular block.  Note, angle is always zero, so no need to print
-        printf("sig: 0x%x x: %d y: %d width: %d height: %d\n",
+        DebugPrintf("sig: 0x%x x: %d y: %d width: %d height: %d\n",
                signature, x, y, width, height); //prints out data to console instead of smartDashboard -> check on the side of the driver station, check +print and click view console
 }
 
@@ -64,13 +65,13 @@ bool Pixy::getStart()
 		else if (w==PIXY_START_WORDX)
 		{
             //when byte recieved was 0x55aa instead of otherway around, the code syncs the byte
-		  printf("Pixy: reorder");
+		  WarningPrintf("Pixy: reorder");
 		  getByte(); // resync
 		}
 		lastw = w;
         if (i++ == 100) {
             usleep(5 * 1000);
-            printf("done 100 iterations waiting for the start\n");
+            WarningPrintf("done 100 iterations waiting for the start\n");
             i = 0;
         }
 	}
@@ -159,7 +160,7 @@ uint16_t Pixy::getBlocks(uint16_t maxBlocks)
 		}
 		else
 		{
-			printf("Pixy: cs error %d\n", ++num_cs_errors);
+			WarningPrintf("Pixy: cs error %d\n", ++num_cs_errors);
 		}
 
 		w = getWord(); //when this is start of the frame
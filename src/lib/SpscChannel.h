@@ -0,0 +1,254 @@
+/*
+ * SpscChannel.h
+ *
+ * SpscRing - fixed size ring buffer passing values from exactly one
+ * producer thread to exactly one consumer thread without locks.
+ *
+ * All the storage is inside the object so nothing is allocated after
+ * construction.  Send and Recv are wait-free: each is a couple of loads,
+ * a copy and one release store, and neither side can be held up by the
+ * other being preempted (which is what makes a mutexed queue a priority
+ * inversion hazard between a sensor thread and the control loop).  The
+ * producer and consumer indices sit on their own cache lines, and each
+ * side keeps a private copy of the other's index so it only touches the
+ * shared line when the ring looks full (or empty).
+ *
+ * BlockingSpscChannel adds a Recv that sleeps on a futex while the ring
+ * is empty.  A Send only makes a syscall when the consumer is actually
+ * asleep.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <type_traits>
+
+namespace frc973 {
+
+static constexpr size_t SPSC_CACHE_LINE = 64;
+
+template <typename T, size_t CAPACITY>
+class SpscRing {
+	static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0,
+			"SpscRing capacity must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value,
+			"SpscRing can only hold trivially copyable types");
+public:
+	SpscRing() : m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0) {}
+
+	/**
+	 * Add a value.  Producer thread only.
+	 *
+	 * @return false (and drop the value) if the ring is full
+	 */
+	bool Send(const T &value) {
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail - m_cachedHead == CAPACITY) {
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+			if (tail - m_cachedHead == CAPACITY) {
+				return false;
+			}
+		}
+
+		m_slots[tail & MASK] = value;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Take the oldest value.  Consumer thread only.
+	 *
+	 * @return false if the ring is empty
+	 */
+	bool Recv(T *out) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+
+		if (head == m_cachedTail) {
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if (head == m_cachedTail) {
+				return false;
+			}
+		}
+
+		*out = m_slots[head & MASK];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Take up to |max| of the oldest values in one go.  Consumer thread
+	 * only.  Cheaper than calling Recv in a loop since the indices are
+	 * each touched once.
+	 *
+	 * @return number of values copied into |out|
+	 */
+	size_t RecvBatch(T *out, size_t max) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t count;
+
+		m_cachedTail = m_tail.load(std::memory_order_acquire);
+		count = m_cachedTail - head;
+		if (count > max) {
+			count = max;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			out[i] = m_slots[(head + i) & MASK];
+		}
+		m_head.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	/**
+	 * Hand every queued value to |func| in order and drop them.  Consumer
+	 * thread only.
+	 *
+	 * @return number of values drained
+	 */
+	template <typename Func>
+	size_t Drain(Func func) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t tail = m_tail.load(std::memory_order_acquire);
+
+		for (size_t i = head; i != tail; i++) {
+			func(m_slots[i & MASK]);
+		}
+		m_cachedTail = tail;
+		m_head.store(tail, std::memory_order_release);
+		return tail - head;
+	}
+
+	/**
+	 * Number of values queued.  Exact from either end's own thread,
+	 * approximate from anywhere else.
+	 */
+	size_t Size() const {
+		return m_tail.load(std::memory_order_acquire) -
+			m_head.load(std::memory_order_acquire);
+	}
+
+	bool Empty() const {
+		return Size() == 0;
+	}
+
+	static constexpr size_t Capacity() {
+		return CAPACITY;
+	}
+
+private:
+	static constexpr size_t MASK = CAPACITY - 1;
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing &operator=(const SpscRing&) = delete;
+
+	/* consumer's line */
+	alignas(SPSC_CACHE_LINE) std::atomic<size_t> m_head;
+	size_t m_cachedTail;
+
+	/* producer's line */
+	alignas(SPSC_CACHE_LINE) std::atomic<size_t> m_tail;
+	size_t m_cachedHead;
+
+	alignas(SPSC_CACHE_LINE) T m_slots[CAPACITY];
+};
+
+template <typename T, size_t CAPACITY>
+class BlockingSpscChannel {
+public:
+	BlockingSpscChannel() : m_ring(), m_sequence(0), m_sleeping(0) {}
+
+	/**
+	 * Add a value and wake the consumer if it is waiting.  Producer
+	 * thread only.  Never blocks.
+	 *
+	 * @return false (and drop the value) if the channel is full
+	 */
+	bool Send(const T &value) {
+		if (!m_ring.Send(value)) {
+			return false;
+		}
+		m_sequence.fetch_add(1, std::memory_order_seq_cst);
+		if (m_sleeping.load(std::memory_order_seq_cst) != 0) {
+			Futex(FUTEX_WAKE_PRIVATE, 1, nullptr);
+		}
+		return true;
+	}
+
+	/**
+	 * Take the oldest value without waiting.  Consumer thread only.
+	 */
+	bool TryRecv(T *out) {
+		return m_ring.Recv(out);
+	}
+
+	/**
+	 * Take the oldest value, sleeping until one arrives.  Consumer
+	 * thread only.
+	 *
+	 * @param timeoutUs give up after this long, 0 to wait forever
+	 *
+	 * @return false if the timeout passed with nothing to take
+	 */
+	bool Recv(T *out, uint64_t timeoutUs = 0) {
+		struct timespec timeout;
+
+		timeout.tv_sec = timeoutUs / 1000000;
+		timeout.tv_nsec = (timeoutUs % 1000000) * 1000;
+
+		while (!m_ring.Recv(out)) {
+			uint32_t seq = m_sequence.load(std::memory_order_seq_cst);
+
+			m_sleeping.store(1, std::memory_order_seq_cst);
+			/* a send between the failed Recv and here bumped |m_sequence|,
+			 * so the futex won't sleep on a stale value */
+			if (m_ring.Empty()) {
+				long ret = Futex(FUTEX_WAIT_PRIVATE, seq,
+						timeoutUs != 0 ? &timeout : nullptr);
+				if (ret != 0 && errno == ETIMEDOUT) {
+					m_sleeping.store(0, std::memory_order_relaxed);
+					return m_ring.Recv(out);
+				}
+			}
+			m_sleeping.store(0, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	template <typename Func>
+	size_t Drain(Func func) {
+		return m_ring.Drain(func);
+	}
+
+	size_t RecvBatch(T *out, size_t max) {
+		return m_ring.RecvBatch(out, max);
+	}
+
+	size_t Size() const {
+		return m_ring.Size();
+	}
+
+private:
+	long Futex(int op, uint32_t val, const struct timespec *timeout) {
+		static_assert(sizeof(m_sequence) == sizeof(uint32_t),
+				"futex word must be 32 bits");
+		return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_sequence),
+				op, val, timeout, nullptr, 0);
+	}
+
+	BlockingSpscChannel(const BlockingSpscChannel&) = delete;
+	BlockingSpscChannel &operator=(const BlockingSpscChannel&) = delete;
+
+	SpscRing<T, CAPACITY> m_ring;
+	alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> m_sequence;
+	std::atomic<uint32_t> m_sleeping;
+};
+
+}
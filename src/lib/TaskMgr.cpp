@@ -6,170 +6,628 @@
  */
 
 #include "string.h"
+#include "stdio.h"
 #include "TaskMgr.h"
 #include "CoopTask.h"
+#include "Tracer.h"
 #include "WPILib.h"
 
-static constexpr bool ENABLE_PROFILING = false;
-
 namespace frc973 {
 
+const char *taskPhaseNames[] = {
+	"StartMode", "StopMode", "PrePeriodic", "Periodic", "PostPeriodic"
+};
+
+/* returned when someone asks for the stats of a task that doesn't exist */
+static const TaskStats emptyStats;
+
+/* flag a task registers with to get called in each phase */
+static const uint32_t phaseFlags[NUM_TASK_PHASES] = {
+	TASK_START_MODE, TASK_STOP_MODE, TASK_PRE_PERIODIC, TASK_PERIODIC,
+	TASK_POST_PERIODIC
+};
+
 TaskMgr::TaskMgr(
 	void
-	): m_numTasks(0)
+	): m_registryMutex(PTHREAD_MUTEX_INITIALIZER)
+	 , m_entries()
+	 , m_entriesHaveHoles(false)
+	 , m_taskLookup()
+	 , m_retiredEntries()
+	 , m_numTasks(0)
+	 , m_dispatchDirty(true)
+	 , m_taskOverrunUs(DEFAULT_TASK_OVERRUN_US)
+	 , m_cycleCount(0)
+	 , m_degradationLevel(0)
+	 , m_cyclesUnderBudget(0)
+	 , m_totalSkips(0)
+	 , m_executor(nullptr)
 {
 }
 
 TaskMgr::~TaskMgr() {
+	delete m_executor;
+
+	for (unsigned int i = 0; i < m_entries.size(); i++) {
+		delete m_entries[i];
+	}
+	for (unsigned int i = 0; i < m_retiredEntries.size(); i++) {
+		delete m_retiredEntries[i];
+	}
 }
 
 
-bool TaskMgr::RegisterTask(const char *taskName, CoopTask *task, uint32_t flags) {
-	bool success = false;
-	int index;
+bool TaskMgr::RegisterTask(const char *taskName, CoopTask *task, uint32_t flags,
+		uint32_t rateDivisor) {
+	TaskEntry *entry;
 
-	index = this->FindTask(task);
-	if (index != -1) {
+	pthread_mutex_lock(&m_registryMutex);
+	entry = this->FindTask(task);
+	if (entry != nullptr) {
 		//If the task is already registered, just add to the existing flags
-		m_taskFlags[index] |= flags;
-		success = true;
+		entry->flags |= flags;
 	}
-	else if (m_numTasks < MAX_NUM_TASKS) {
-		strncpy(m_taskNames[m_numTasks], taskName, MAX_TASK_NAME_LEN);
-		m_tasks[m_numTasks] = task;
-		m_taskFlags[m_numTasks] = flags;
+	else {
+		entry = new TaskEntry();
+		strncpy(entry->name, taskName, MAX_TASK_NAME_LEN);
+		entry->name[MAX_TASK_NAME_LEN] = '\0';
+		entry->task = task;
+		entry->flags = flags;
+		if (rateDivisor == 0) {
+			rateDivisor = 1;
+		}
+		entry->rateOffset = PickRateOffset(rateDivisor);
+		entry->rateDivisor = rateDivisor;
+		entry->reads = 0;
+		entry->writes = 0;
+		entry->hasResources = false;
+		entry->budgetUs = 0;
+		entry->penaltyCycles = 0;
+		entry->decidedCycle = 0;
+		entry->runThisCycle = true;
+		entry->skips = 0;
+		entry->traceName = Tracer::InternName(entry->name);
+		for (int phase = 0; phase < NUM_TASK_PHASES; phase++) {
+			entry->stats[phase].SetOverrunThreshold(m_taskOverrunUs);
+		}
+
+		entry->slot = m_entries.size();
+		m_entries.push_back(entry);
+		m_taskLookup[task] = entry;
 		m_numTasks++;
-		success = true;
 	}
+	m_dispatchDirty = true;
+	pthread_mutex_unlock(&m_registryMutex);
 
-    fprintf(stderr, "Task %s registered to %p with result %d (1 is go0d)\n",
-            taskName, this, success);
+    fprintf(stderr, "Task %s registered to %p\n", taskName, this);
 
-	return success;
+	return true;
 }
 
 bool TaskMgr::UnregisterTask(CoopTask *task) {
-	bool success = false;
-	int taskIndex, j;
+	TaskEntry *entry;
+
+	pthread_mutex_lock(&m_registryMutex);
+	entry = this->FindTask(task);
+	if (entry != nullptr) {
+		//Leave a hole; the entry is kept until the manager goes away
+		m_entries[entry->slot] = nullptr;
+		m_entriesHaveHoles = true;
+		m_taskLookup.erase(task);
+		m_retiredEntries.push_back(entry);
+		m_numTasks--;
+		m_dispatchDirty = true;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return entry != nullptr;
+}
+
+bool TaskMgr::SetTaskResources(CoopTask *task, uint32_t reads,
+		uint32_t writes) {
+	TaskEntry *entry;
+
+	pthread_mutex_lock(&m_registryMutex);
+	entry = this->FindTask(task);
+	if (entry != nullptr) {
+		entry->reads = reads;
+		entry->writes = writes;
+		entry->hasResources = true;
+		m_dispatchDirty = true;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return entry != nullptr;
+}
+
+bool TaskMgr::SetTaskBudget(CoopTask *task, uint32_t budgetUs) {
+	TaskEntry *entry;
 
-	taskIndex = this->FindTask(task);
-	if (taskIndex != -1) {
-		//Shift tasks to replace the removed one
-		for (j = taskIndex + 1; j < m_numTasks; j++) {
-			strcpy(m_taskNames[j - 1], m_taskNames[j]);
-			m_tasks[j - 1] = m_tasks[j];
-			m_taskFlags[j - 1] = m_taskFlags[j];
+	pthread_mutex_lock(&m_registryMutex);
+	entry = this->FindTask(task);
+	if (entry != nullptr) {
+		entry->budgetUs = budgetUs;
+		for (int phase = 0; phase < NUM_TASK_PHASES; phase++) {
+			entry->stats[phase].SetOverrunThreshold(
+					budgetUs != 0 ? budgetUs : m_taskOverrunUs);
 		}
+	}
+	pthread_mutex_unlock(&m_registryMutex);
 
-		//clear out the last task in the list
-		m_numTasks--;
-		m_taskNames[m_numTasks][0] = '\0';
-		m_tasks[m_numTasks] = NULL;
-		m_taskFlags[m_numTasks] = 0;
+	return entry != nullptr;
+}
 
-		success = true;
+void TaskMgr::SetExecutionMode(ExecutionMode mode, int numThreads,
+		const RTThreadConfig &workerConfig) {
+	delete m_executor;
+	m_executor = nullptr;
+
+	if (mode == ParallelExecution && numThreads > 1) {
+		m_executor = new ParallelTaskExecutor(numThreads, workerConfig);
+		m_dispatchDirty = true;
 	}
+}
 
-	return success;
+void TaskMgr::CompactEntries() const {
+	if (!m_entriesHaveHoles) {
+		return;
+	}
+
+	int next = 0;
+	for (unsigned int i = 0; i < m_entries.size(); i++) {
+		if (m_entries[i] != nullptr) {
+			m_entries[i]->slot = next;
+			m_entries[next++] = m_entries[i];
+		}
+	}
+	m_entries.resize(next);
+	m_entriesHaveHoles = false;
 }
 
-void TaskMgr::TaskStartModeAll(RobotMode mode) {
-    uint64_t startTime, endTime;
+void TaskMgr::RefreshDispatchLists() {
+	if (!m_dispatchDirty.load(std::memory_order_acquire)) {
+		return;
+	}
 
-	for (int i = 0; i < m_numTasks; i++) {
-		if (m_taskFlags[i] & TASK_START_MODE) {
-            startTime = GetUsecTime();
-			m_tasks[i]->TaskStartMode(mode);
-            endTime = GetUsecTime();
+	pthread_mutex_lock(&m_registryMutex);
+	m_dispatchDirty = false;
+	CompactEntries();
 
-            if (ENABLE_PROFILING) {
-                printf("TaskStartMode(%d) for %s took %llu us\n",
-                       mode, m_taskNames[i], endTime - startTime);
-            }
+	for (int phase = 0; phase < NUM_TASK_PHASES; phase++) {
+		m_dispatch[phase].clear();
+		for (unsigned int i = 0; i < m_entries.size(); i++) {
+			if (m_entries[i]->flags & phaseFlags[phase]) {
+				m_dispatch[phase].push_back(m_entries[i]);
+			}
 		}
 	}
+
+	if (m_executor != nullptr) {
+		BuildPhaseGraphs();
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+}
+
+void TaskMgr::TaskStartModeAll(RobotMode mode) {
+	TraceSpan span(taskPhaseNames[PHASE_START_MODE], "phase");
+
+	RefreshDispatchLists();
+
+	std::vector<TaskEntry*> &tasks = m_dispatch[PHASE_START_MODE];
+	for (unsigned int i = 0; i < tasks.size(); i++) {
+		RunTask(tasks[i], PHASE_START_MODE, mode);
+	}
 }
 
 void TaskMgr::TaskStopModeAll(RobotMode mode) {
-    uint64_t startTime, endTime;
+	TraceSpan span(taskPhaseNames[PHASE_STOP_MODE], "phase");
 
-	//stop tasks in the reverse order they were started in
-	for (int i = m_numTasks - 1; i >= 0; i--) {
-		if (m_taskFlags[i] & TASK_STOP_MODE) {
-            startTime = GetUsecTime();
-			m_tasks[i]->TaskStopMode(mode);
-            endTime = GetUsecTime();
+	RefreshDispatchLists();
 
-            if (ENABLE_PROFILING) {
-                printf("TaskStopMode(%d) for %s took %llu us\n",
-                       mode, m_taskNames[i], endTime - startTime);
-            }
-		}
+	//stop tasks in the reverse order they were started in
+	std::vector<TaskEntry*> &tasks = m_dispatch[PHASE_STOP_MODE];
+	for (int i = tasks.size() - 1; i >= 0; i--) {
+		RunTask(tasks[i], PHASE_STOP_MODE, mode);
 	}
 }
 
 void TaskMgr::TaskPrePeriodicAll(RobotMode mode) {
-    uint64_t startTime, endTime;
+	RunPeriodicPhase(PHASE_PRE_PERIODIC, mode);
+}
+
+void TaskMgr::TaskPeriodicAll(RobotMode mode) {
+	RunPeriodicPhase(PHASE_PERIODIC, mode);
+}
+
+void TaskMgr::TaskPostPeriodicAll(RobotMode mode) {
+	RunPeriodicPhase(PHASE_POST_PERIODIC, mode);
+}
+
+void TaskMgr::RunPeriodicPhase(TaskPhase phase, RobotMode mode) {
+	TraceSpan span(taskPhaseNames[phase], "phase");
 
-	for (int i = 0; i < m_numTasks; i++) {
-		if (m_taskFlags[i] & TASK_PRE_PERIODIC) {
-            startTime = GetUsecTime();
-			m_tasks[i]->TaskPrePeriodic(mode);
-            endTime = GetUsecTime();
+	RefreshDispatchLists();
 
-            if (ENABLE_PROFILING) {
-                printf("TaskPrePeriodicAll(%d) for %s took %llu us\n",
-                       mode, m_taskNames[i], endTime - startTime);
-            }
+	if (m_executor == nullptr) {
+		std::vector<TaskEntry*> &tasks = m_dispatch[phase];
+		for (unsigned int i = 0; i < tasks.size(); i++) {
+			if (IsTaskDue(tasks[i]) && ShouldRunTask(tasks[i])) {
+				RunTask(tasks[i], phase, mode);
+			}
 		}
+		return;
 	}
+
+	PhaseRun run = {this, phase, mode};
+	m_executor->Run(m_phaseGraphs[phase], RunPhaseNode, &run);
 }
 
-void TaskMgr::TaskPeriodicAll(RobotMode mode) {
-    uint64_t startTime, endTime;
+void TaskMgr::RunPhaseNode(void *ctx, int node) {
+	PhaseRun *run = static_cast<PhaseRun*>(ctx);
+	TaskMgr *mgr = run->mgr;
+	TaskEntry *entry = mgr->m_dispatch[run->phase][node];
+
+	/* tasks that aren't due stay in the graph so the edges through them
+	 * still order the tasks around them */
+	if (mgr->IsTaskDue(entry) && mgr->ShouldRunTask(entry)) {
+		mgr->RunTask(entry, run->phase, run->mode);
+	}
+}
+
+bool TaskMgr::ShouldRunTask(TaskEntry *entry) {
+	if (!(entry->flags & TASK_BEST_EFFORT)) {
+		return true;
+	}
+
+	int level = m_degradationLevel.load(std::memory_order_relaxed);
+	bool run;
+
+	/* a task in several phases serves its penalty (and gets counted as
+	 * skipped) once a cycle, not once a phase */
+	if (entry->decidedCycle == m_cycleCount + 1) {
+		return entry->runThisCycle;
+	}
+
+	if (entry->penaltyCycles > 0) {
+		entry->penaltyCycles--;
+		run = false;
+	}
+	else if (level >= MAX_DEGRADATION_LEVEL) {
+		run = false;
+	}
+	else {
+		/* count only the cycles the task is due on, so decimation stacks
+		 * on top of the rate divisor */
+		run = (m_cycleCount / entry->rateDivisor) % (1 << level) == 0;
+	}
+
+	if (!run) {
+		entry->skips.fetch_add(1, std::memory_order_relaxed);
+		m_totalSkips.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	entry->decidedCycle = m_cycleCount + 1;
+	entry->runThisCycle = run;
+	return run;
+}
 
-	for (int i = 0; i < m_numTasks; i++) {
-		if (m_taskFlags[i] & TASK_PERIODIC) {
-            startTime = GetUsecTime();
-			m_tasks[i]->TaskPeriodic(mode);
-            endTime = GetUsecTime();
+void TaskMgr::EndCycle(uint32_t cycleUs) {
+	uint32_t periodUs = m_cycleStats.GetOverrunThreshold();
+	int level = m_degradationLevel.load(std::memory_order_relaxed);
 
-            if (ENABLE_PROFILING) {
-                printf("TaskPeriodicAll(%d) for %s took %llu us\n",
-                       mode, m_taskNames[i], endTime - startTime);
-            }
+	m_cycleStats.Record(cycleUs);
+	m_cycleCount++;
+
+	if (periodUs == 0) {
+		return;
+	}
+
+	if (cycleUs > periodUs) {
+		m_cyclesUnderBudget = 0;
+		if (level < MAX_DEGRADATION_LEVEL) {
+			m_degradationLevel.store(level + 1, std::memory_order_relaxed);
+		}
+	}
+	else if (cycleUs < periodUs - periodUs / 4) {
+		if (++m_cyclesUnderBudget >= DEGRADATION_RECOVERY_CYCLES &&
+				level > 0) {
+			m_degradationLevel.store(level - 1, std::memory_order_relaxed);
+			m_cyclesUnderBudget = 0;
 		}
 	}
+	else {
+		/* close to the limit, hold the current level */
+		m_cyclesUnderBudget = 0;
+	}
 }
 
-void TaskMgr::TaskPostPeriodicAll(RobotMode mode) {
-    uint64_t startTime, endTime;
+void TaskMgr::BuildPhaseGraphs() {
+	for (int phase = PHASE_PRE_PERIODIC; phase <= PHASE_POST_PERIODIC;
+			phase++) {
+		std::vector<TaskEntry*> &tasks = m_dispatch[phase];
+		TaskGraph &graph = m_phaseGraphs[phase];
+
+		/* graph node n is the task at m_dispatch[phase][n]; a task waits
+		 * for every earlier task it conflicts with */
+		graph.Clear();
+		for (unsigned int i = 0; i < tasks.size(); i++) {
+			int node = graph.AddNode();
+
+			for (int prev = 0; prev < node; prev++) {
+				if (TasksConflict(tasks[prev], tasks[i])) {
+					graph.AddEdge(prev, node);
+				}
+			}
+		}
+	}
+}
+
+bool TaskMgr::TasksConflict(const TaskEntry *a, const TaskEntry *b) {
+	if (!a->hasResources || !b->hasResources) {
+		return true;
+	}
+
+	return (a->writes & (b->reads | b->writes)) || (b->writes & a->reads);
+}
+
+void TaskMgr::RunTask(TaskEntry *entry, TaskPhase phase, RobotMode mode) {
+	CoopTask *task = entry->task;
+	uint64_t startTime = GetUsecTime();
+
+	Tracer::Begin(entry->traceName, taskPhaseNames[phase]);
+	switch (phase) {
+	case PHASE_START_MODE:
+		task->TaskStartMode(mode);
+		break;
+	case PHASE_STOP_MODE:
+		task->TaskStopMode(mode);
+		break;
+	case PHASE_PRE_PERIODIC:
+		task->TaskPrePeriodic(mode);
+		break;
+	case PHASE_PERIODIC:
+		task->TaskPeriodic(mode);
+		break;
+	case PHASE_POST_PERIODIC:
+		task->TaskPostPeriodic(mode);
+		break;
+	default:
+		break;
+	}
+	Tracer::End(entry->traceName, taskPhaseNames[phase]);
+
+	uint32_t elapsedUs = GetUsecTime() - startTime;
+	entry->stats[phase].Record(elapsedUs);
+
+	/* a best-effort task over budget sits out enough of its next due
+	 * cycles to bring its average back down to the budget */
+	if ((entry->flags & TASK_BEST_EFFORT) && entry->budgetUs != 0 &&
+			elapsedUs > entry->budgetUs) {
+		entry->penaltyCycles += (elapsedUs - 1) / entry->budgetUs;
+	}
+}
+
+TaskMgr::TaskEntry *TaskMgr::GetEntry(int index) const {
+	CompactEntries();
+	if (index >= 0 && index < (int) m_entries.size()) {
+		return m_entries[index];
+	}
+	return nullptr;
+}
+
+/* Everything below is read under the registry lock.  Names, tasks, rate
+ * divisors and stats never change once an entry exists and entries are
+ * never freed before the manager, so those can be handed out as is. */
+
+const char *TaskMgr::GetTaskName(int index) const {
+	const char *name = "";
+
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = GetEntry(index);
+	if (entry != nullptr) {
+		name = entry->name;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return name;
+}
+
+CoopTask *TaskMgr::GetTask(int index) const {
+	CoopTask *task = nullptr;
+
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = GetEntry(index);
+	if (entry != nullptr) {
+		task = entry->task;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return task;
+}
+
+uint32_t TaskMgr::GetTaskFlags(int index) const {
+	uint32_t flags = 0;
+
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = GetEntry(index);
+	if (entry != nullptr) {
+		flags = entry->flags;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return flags;
+}
+
+uint32_t TaskMgr::GetTaskSkips(int index) const {
+	uint32_t skips = 0;
+
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = GetEntry(index);
+	if (entry != nullptr) {
+		skips = entry->skips.load(std::memory_order_relaxed);
+	}
+	pthread_mutex_unlock(&m_registryMutex);
 
-	for (int i = 0; i < m_numTasks; i++) {
-		if (m_taskFlags[i] & TASK_POST_PERIODIC) {
-            startTime = GetUsecTime();
-			m_tasks[i]->TaskPostPeriodic(mode);
-            endTime = GetUsecTime();
+	return skips;
+}
+
+uint32_t TaskMgr::GetTaskRateDivisor(int index) const {
+	uint32_t rateDivisor = 1;
+
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = GetEntry(index);
+	if (entry != nullptr) {
+		rateDivisor = entry->rateDivisor;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return rateDivisor;
+}
+
+const TaskStats &TaskMgr::GetTaskStats(int index, TaskPhase phase) const {
+	const TaskStats *stats = &emptyStats;
+
+	if (phase < 0 || phase >= NUM_TASK_PHASES) {
+		return emptyStats;
+	}
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = GetEntry(index);
+	if (entry != nullptr) {
+		stats = &entry->stats[phase];
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return *stats;
+}
+
+const TaskStats *TaskMgr::GetTaskStats(CoopTask *task, TaskPhase phase) {
+	const TaskStats *stats = nullptr;
+
+	if (phase < 0 || phase >= NUM_TASK_PHASES) {
+		return nullptr;
+	}
+	pthread_mutex_lock(&m_registryMutex);
+	TaskEntry *entry = this->FindTask(task);
+	if (entry != nullptr) {
+		stats = &entry->stats[phase];
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	return stats;
+}
 
-            if (ENABLE_PROFILING) {
-                printf("TaskPostPeriodicAll(%d) for %s took %llu us\n",
-                       mode, m_taskNames[i], endTime - startTime);
-            }
+void TaskMgr::SetTaskOverrunThreshold(uint32_t thresholdUs) {
+	pthread_mutex_lock(&m_registryMutex);
+	m_taskOverrunUs = thresholdUs;
+	for (unsigned int i = 0; i < m_entries.size(); i++) {
+		if (m_entries[i] == nullptr || m_entries[i]->budgetUs != 0) {
+			continue;
+		}
+		for (int phase = 0; phase < NUM_TASK_PHASES; phase++) {
+			m_entries[i]->stats[phase].SetOverrunThreshold(thresholdUs);
+		}
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+}
+
+void TaskMgr::ResetTaskStats() {
+	pthread_mutex_lock(&m_registryMutex);
+	for (unsigned int i = 0; i < m_entries.size(); i++) {
+		if (m_entries[i] == nullptr) {
+			continue;
+		}
+		for (int phase = 0; phase < NUM_TASK_PHASES; phase++) {
+			m_entries[i]->stats[phase].Reset();
+		}
+		m_entries[i]->skips = 0;
+	}
+	pthread_mutex_unlock(&m_registryMutex);
+	m_cycleStats.Reset();
+}
+
+void TaskMgr::PrintTaskStats() {
+	TaskStats::Snapshot snap;
+
+	printf("%-24s %-12s %8s %6s %8s %6s %6s %6s %6s %6s\n",
+			"task", "phase", "count", "min", "mean", "p50", "p99", "max",
+			"ovrrun", "skips");
+	pthread_mutex_lock(&m_registryMutex);
+	CompactEntries();
+	for (unsigned int i = 0; i < m_entries.size(); i++) {
+		for (int phase = 0; phase < NUM_TASK_PHASES; phase++) {
+			m_entries[i]->stats[phase].GetSnapshot(&snap);
+			if (snap.count == 0) {
+				continue;
+			}
+			printf("%-24s %-12s %8llu %6u %8.1lf %6u %6u %6u %6u %6u\n",
+					m_entries[i]->name, taskPhaseNames[phase],
+					(unsigned long long) snap.count, snap.minUs, snap.meanUs,
+					snap.p50Us, snap.p99Us, snap.maxUs, snap.overruns,
+					m_entries[i]->skips.load(std::memory_order_relaxed));
 		}
 	}
+	pthread_mutex_unlock(&m_registryMutex);
+
+	m_cycleStats.GetSnapshot(&snap);
+	printf("%-24s %-12s %8llu %6u %8.1lf %6u %6u %6u %6u\n",
+			"(cycle)", "", (unsigned long long) snap.count, snap.minUs,
+			snap.meanUs, snap.p50Us, snap.p99Us, snap.maxUs, snap.overruns);
+	printf("degradation level %d, %llu best-effort calls skipped\n",
+			GetDegradationLevel(), (unsigned long long) GetTotalSkips());
 }
 
-int TaskMgr::FindTask(CoopTask *task) {
-	int index = -1;
+uint32_t TaskMgr::PickRateOffset(uint32_t rateDivisor) const {
+	uint32_t bestOffset = 0;
+	double bestLoad = -1.0;
+
+	if (rateDivisor <= 1) {
+		return 0;
+	}
+
+	/* For each candidate offset, add up how often each slow task already
+	 * registered would run on the same cycle as the new one.  Tasks that
+	 * run every cycle collide with every offset equally so skip them. */
+	for (uint32_t offset = 0; offset < rateDivisor; offset++) {
+		double load = 0.0;
+
+		for (unsigned int i = 0; i < m_entries.size(); i++) {
+			if (m_entries[i] == nullptr) {
+				continue;
+			}
+
+			uint32_t divisor = m_entries[i]->rateDivisor;
+			uint32_t collisions = 0;
+
+			if (divisor <= 1) {
+				continue;
+			}
+
+			for (uint32_t t = offset; t < rateDivisor * divisor;
+					t += rateDivisor) {
+				if (t % divisor == m_entries[i]->rateOffset) {
+					collisions++;
+				}
+			}
+			load += ((double) collisions) / divisor;
+		}
 
-	for (int i = 0; i < m_numTasks; i++) {
-		if (m_tasks[i] == task) {
-			index = i;
-			break;
+		if (bestLoad < 0.0 || load < bestLoad) {
+			bestLoad = load;
+			bestOffset = offset;
 		}
 	}
 
-	return index;
+	return bestOffset;
+}
+
+TaskMgr::TaskEntry *TaskMgr::FindTask(CoopTask *task) const {
+	std::unordered_map<CoopTask*, TaskEntry*>::const_iterator it =
+		m_taskLookup.find(task);
+
+	if (it == m_taskLookup.end()) {
+		return nullptr;
+	}
+	return it->second;
 }
 
 }
@@ -16,9 +16,14 @@
 #pragma once
 
 #include "stdint.h"
+#include <pthread.h>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 #include "util/Util.h"
+#include "TaskStats.h"
+#include "ParallelTaskExecutor.h"
 
-#define MAX_NUM_TASKS			32
 #define MAX_TASK_NAME_LEN		31
 
 #define TASK_START_MODE			0x00000001
@@ -27,36 +32,91 @@
 #define TASK_PERIODIC			0x00000008
 #define TASK_POST_PERIODIC		0x00000010
 
+/**
+ * Criticality class: tasks registered with TASK_BEST_EFFORT (logging,
+ * dashboard, lights...) get decimated and then skipped when the loop
+ * can't keep up.  Tasks without it are critical and always run.
+ */
+#define TASK_BEST_EFFORT		0x00000100
+
+/**
+ * A task that takes longer than this in a single call is counted as an
+ * overrun in its stats (see TaskMgr::SetTaskOverrunThreshold)
+ */
+#define DEFAULT_TASK_OVERRUN_US	2000
+
+/**
+ * Number of threads (including the loop thread) tasks are spread over in
+ * parallel execution mode; the RIO has two cores
+ */
+#define DEFAULT_TASK_THREADS	2
+
+/**
+ * Each overrunning cycle raises the degradation level by one; at level n
+ * best-effort tasks run only every 2^n-th time they are due and at the
+ * max level they don't run at all.  The level drops one step after this
+ * many cycles in a row finish comfortably inside the loop period.
+ */
+#define MAX_DEGRADATION_LEVEL			4
+#define DEGRADATION_RECOVERY_CYCLES		50
+
 using namespace frc;
 
 namespace frc973 {
 
 class CoopTask;
 
+/**
+ * Index of each callback a task may be registered for; used to look up
+ * the timing stats for that callback.
+ */
+enum TaskPhase {
+	PHASE_START_MODE,
+	PHASE_STOP_MODE,
+	PHASE_PRE_PERIODIC,
+	PHASE_PERIODIC,
+	PHASE_POST_PERIODIC,
+	NUM_TASK_PHASES
+};
+extern const char *taskPhaseNames[];
+
 class TaskMgr {
 protected:
 	TaskMgr();
 public:
 	virtual ~TaskMgr();
 
+	enum ExecutionMode {
+		SerialExecution,	/* run every task on the loop thread in order */
+		ParallelExecution	/* run independent tasks in a phase at once */
+	};
+
 	/**
 	 * Register CoopTask object.  If the task is already registered, the flags
 	 * 		passed here are added to those flags for which the task was already
-	 * 		registered.  If the task registry is already full, return  false.
+	 * 		registered.
 	 *
 	 * @param taskName Specifies the name of the task being registered (for
 	 * 		debug purposes)
 	 * @param task Specifies the task to be registered
 	 * @param flags Specifies which callbacks should be called for the given
-	 * 		task
+	 * 		task, plus TASK_BEST_EFFORT if the task may be skipped when the
+	 * 		loop runs late
+	 * @param rateDivisor Run the periodic callbacks of this task only
+	 * 		every rateDivisor-th cycle (1 means every cycle).  Slow tasks are
+	 * 		spread over different cycles so they don't all run on the same
+	 * 		one.  Start and stop mode callbacks always run.  Ignored if the
+	 * 		task is already registered.
 	 *
 	 * @return Returns true if the task was successfully registered.  False
 	 * 		otherwise.
 	 */
-	bool RegisterTask(const char *taskName, CoopTask *task, uint32_t flags);
+	bool RegisterTask(const char *taskName, CoopTask *task, uint32_t flags,
+			uint32_t rateDivisor = 1);
 
 	/**
-	 * Function to unregister CoopTask
+	 * Function to unregister CoopTask.  Takes constant time; the task
+	 * 		stops being called from the next phase on.
 	 *
 	 * @param task Specifies the CoopTask to unregister
 	 *
@@ -65,7 +125,201 @@ public:
 	 */
 	bool UnregisterTask(CoopTask *task);
 
+	/**
+	 * Declare which shared resources a task touches so it can run
+	 * alongside other tasks in parallel execution mode.  Each bit of
+	 * |reads| and |writes| stands for one resource (a subsystem, a sensor,
+	 * the lights...); what each bit means is up to the robot.  Two tasks
+	 * in the same phase may run at the same time only if neither writes
+	 * anything the other reads or writes.  Tasks that never declare their
+	 * resources are assumed to touch everything and always run on their
+	 * own, in registration order.
+	 *
+	 * @param task Specifies a registered task
+	 * @param reads Bitmask of resources the task reads
+	 * @param writes Bitmask of resources the task writes
+	 *
+	 * @return Returns true if the task is registered, false otherwise
+	 */
+	bool SetTaskResources(CoopTask *task, uint32_t reads, uint32_t writes);
+
+	/**
+	 * Choose between running tasks one after another on the loop thread
+	 * (the default) or spreading independent tasks over a pool of threads.
+	 * Either way every task in a phase finishes before the next phase
+	 * starts, tasks with conflicting resources keep their registration
+	 * order, and start/stop mode callbacks always run serially.  Must be
+	 * called from the loop thread (or before the loop starts).
+	 *
+	 * @param mode Serial or parallel execution
+	 * @param numThreads Number of threads, including the loop thread, to
+	 * 		run tasks on in parallel mode
+	 * @param workerConfig Real-time setup of the extra threads
+	 */
+	void SetExecutionMode(ExecutionMode mode,
+			int numThreads = DEFAULT_TASK_THREADS,
+			const RTThreadConfig &workerConfig = {"task worker", 0, -1, 0});
+
+	/**
+	 * Give a task a CPU budget for each callback.  Calls running over the
+	 * budget count as overruns in the task's stats (in place of the
+	 * manager-wide threshold).  A best-effort task that runs over its
+	 * budget is also made to sit out cycles until its average is back
+	 * under budget.
+	 *
+	 * @param task Specifies a registered task
+	 * @param budgetUs Budget per call in microseconds, 0 for none
+	 *
+	 * @return Returns true if the task is registered, false otherwise
+	 */
+	bool SetTaskBudget(CoopTask *task, uint32_t budgetUs);
+
+	/**
+	 * Get the number of callbacks of the task at the given index that were
+	 * skipped to save time
+	 *
+	 * @param index of the task, from 0 to GetNumTasks() - 1
+	 */
+	uint32_t GetTaskSkips(int index) const;
+
+	/**
+	 * Get how far best-effort tasks are currently being cut back, from 0
+	 * (not at all) to MAX_DEGRADATION_LEVEL (not run)
+	 */
+	int GetDegradationLevel() const {
+		return m_degradationLevel.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Get the total number of task callbacks skipped to save time
+	 */
+	uint64_t GetTotalSkips() const {
+		return m_totalSkips.load(std::memory_order_relaxed);
+	}
+
+	ExecutionMode GetExecutionMode() const {
+		return m_executor == nullptr ? SerialExecution : ParallelExecution;
+	}
+
+	/**
+	 * Get the number of tasks currently registered.  Together with
+	 * GetTaskName and GetTaskStats this lets another thread (or the logger)
+	 * walk the timing stats of every task without stopping the loop.
+	 *
+	 * The names and stats handed out stay valid for as long as the
+	 * manager exists, even if the task is unregistered meanwhile (its
+	 * stats just stop changing), so a reader may look them up once and
+	 * keep the pointer.
+	 */
+	int GetNumTasks() const {
+		return m_numTasks;
+	}
+
+	/**
+	 * Get the name the task at the given index was registered with
+	 *
+	 * @param index of the task, from 0 to GetNumTasks() - 1
+	 */
+	const char *GetTaskName(int index) const;
+
+	/**
+	 * Get the task at the given index
+	 *
+	 * @param index of the task, from 0 to GetNumTasks() - 1
+	 */
+	CoopTask *GetTask(int index) const;
+
+	/**
+	 * Get the flags the task at the given index was registered with
+	 *
+	 * @param index of the task, from 0 to GetNumTasks() - 1
+	 */
+	uint32_t GetTaskFlags(int index) const;
+
+	/**
+	 * Get the timing stats for one callback of one task
+	 *
+	 * @param index of the task, from 0 to GetNumTasks() - 1
+	 * @param phase callback to get the stats for
+	 *
+	 * @return stats for the given task and phase
+	 */
+	const TaskStats &GetTaskStats(int index, TaskPhase phase) const;
+
+	/**
+	 * Get the rate divisor the task at the given index was registered with
+	 *
+	 * @param index of the task, from 0 to GetNumTasks() - 1
+	 */
+	uint32_t GetTaskRateDivisor(int index) const;
+
+	/**
+	 * Get the number of cycles run so far
+	 */
+	uint32_t GetCycleCount() const {
+		return m_cycleCount;
+	}
+
+	/**
+	 * Get the timing stats for one callback of the given task
+	 *
+	 * @param task to look up
+	 * @param phase callback to get the stats for
+	 *
+	 * @return stats for the task, or nullptr if the task is not registered.
+	 * 		Valid for as long as the manager exists.
+	 */
+	const TaskStats *GetTaskStats(CoopTask *task, TaskPhase phase);
+
+	/**
+	 * Get the timing stats for whole cycles (pre-periodic through
+	 * post-periodic) as reported by the subclass running the loop.  The
+	 * overrun count here is the number of cycles that ran over the loop
+	 * period.
+	 */
+	const TaskStats &GetCycleStats() const {
+		return m_cycleStats;
+	}
+
+	/**
+	 * Set the time a single task callback may take before it is counted
+	 * as an overrun in its stats.
+	 *
+	 * @param thresholdUs overrun threshold in microseconds, 0 to disable
+	 */
+	void SetTaskOverrunThreshold(uint32_t thresholdUs);
+
+	/**
+	 * Forget all task and cycle timing samples collected so far.
+	 */
+	void ResetTaskStats();
+
+	/**
+	 * Print a table of timing stats for every registered task to stdout.
+	 */
+	void PrintTaskStats();
+
 protected:
+	/**
+	 * Finish a cycle: record how long it took, raise or lower the
+	 * degradation level depending on whether it overran, and move on to
+	 * the next cycle for rate-divided tasks.  Subclasses running the loop call this
+	 * once a cycle after the post-periodic callbacks.
+	 *
+	 * @param cycleUs time (in microseconds) used by the cycle
+	 */
+	void EndCycle(uint32_t cycleUs);
+
+	/**
+	 * Set the loop period so cycles taking longer than it are counted as
+	 * overruns in the cycle stats.
+	 *
+	 * @param periodUs loop period in microseconds
+	 */
+	void SetCycleOverrunThreshold(uint32_t periodUs) {
+		m_cycleStats.SetOverrunThreshold(periodUs);
+	}
+
 	/**
 	 * Calls the TaskStartMode method of all CoopTask objects registered with
 	 * 		the TASK_START_MODE flag
@@ -108,18 +362,143 @@ protected:
 
 private:
 	/**
-	 * Returns the index of the given task int he register tasks list
+	 * Everything the manager knows about one registered task.  Entries are
+	 * allocated once when the task is registered and never move or get
+	 * freed before the manager, so dispatch lists and the stats readers
+	 * on other threads can hold on to them.
+	 */
+	struct TaskEntry {
+		char		name[MAX_TASK_NAME_LEN + 1];
+		CoopTask   *task;
+		uint32_t	flags;
+		uint32_t	rateDivisor;
+		uint32_t	rateOffset;
+		uint32_t	reads;
+		uint32_t	writes;
+		bool		hasResources;
+		uint32_t	budgetUs;
+		uint32_t	penaltyCycles;	/* due cycles to sit out for overbudget */
+		uint32_t	decidedCycle;	/* cycle runThisCycle is for, plus one */
+		bool		runThisCycle;
+		std::atomic<uint32_t> skips;
+		int			slot;		/* position in m_entries */
+		const char *traceName;	/* name, interned for the Tracer */
+		TaskStats	stats[NUM_TASK_PHASES];
+	};
+
+	/**
+	 * Look up the entry of a registered task
 	 *
 	 * @param Task to look up
 	 *
-	 * @return If found, the task index is returned.  Otherwise it returns -1
+	 * @return The entry of the task if it is registered, nullptr otherwise
+	 */
+	TaskEntry *FindTask(CoopTask *task) const;
+
+	/**
+	 * Get the entry of the task at the given index in registration order.
+	 * Caller must hold m_registryMutex.
+	 *
+	 * @return The entry, or nullptr if the index is out of range
+	 */
+	TaskEntry *GetEntry(int index) const;
+
+	/**
+	 * Squeeze the holes left by unregistered tasks out of m_entries.
+	 * Caller must hold m_registryMutex.
+	 */
+	void CompactEntries() const;
+
+	/**
+	 * Rebuild the per-phase dispatch lists (and parallel graphs) if the
+	 * registry changed.  Only called from the thread running the phases.
+	 */
+	void RefreshDispatchLists();
+
+	/**
+	 * Run one callback of the given task, timing it into that task's stats
+	 */
+	void RunTask(TaskEntry *entry, TaskPhase phase, RobotMode mode);
+
+	/**
+	 * Check whether the periodic callbacks of the given task should run
+	 * this cycle
+	 */
+	bool IsTaskDue(const TaskEntry *entry) const {
+		return m_cycleCount % entry->rateDivisor == entry->rateOffset;
+	}
+
+	/**
+	 * Check whether a due task should really run this cycle given the
+	 * degradation level and its budget, counting it as skipped if not.
+	 * Decided on the first phase the task is in each cycle; its other
+	 * phases that cycle go the same way.
+	 */
+	bool ShouldRunTask(TaskEntry *entry);
+
+	/**
+	 * Run one of the periodic phases, serially or on the executor
+	 */
+	void RunPeriodicPhase(TaskPhase phase, RobotMode mode);
+
+	/**
+	 * Rebuild the dependency graphs of the periodic phases from the
+	 * dispatch lists and declared resources
 	 */
-	int FindTask(CoopTask *task);
+	void BuildPhaseGraphs();
 
+	/**
+	 * Check whether two tasks may run at the same time
+	 */
+	static bool TasksConflict(const TaskEntry *a, const TaskEntry *b);
+
+	/**
+	 * Executor callback running one node of a phase graph
+	 */
+	static void RunPhaseNode(void *ctx, int node);
+
+	/**
+	 * What RunPhaseNode needs to know about the phase being run
+	 */
+	struct PhaseRun {
+		TaskMgr *mgr;
+		TaskPhase phase;
+		RobotMode mode;
+	};
+
+	/**
+	 * Pick the cycle offset for a new task with the given rate divisor
+	 * that collides least with the slow tasks already registered
+	 */
+	uint32_t PickRateOffset(uint32_t rateDivisor) const;
+
+	/* registry: every task in registration order (with holes where tasks
+	 * were unregistered until the next compaction) plus a lookup table */
+	mutable pthread_mutex_t m_registryMutex;
+	mutable std::vector<TaskEntry*> m_entries;
+	mutable bool m_entriesHaveHoles;
+	std::unordered_map<CoopTask*, TaskEntry*> m_taskLookup;
+
+	/* entries of unregistered tasks.  Readers on other threads may still
+	 * hold their names and stats, so they're only freed with the manager
+	 * (tasks are unregistered a handful of times in a run, if at all) */
+	std::vector<TaskEntry*> m_retiredEntries;
 	int			m_numTasks;
-	char	    m_taskNames[MAX_NUM_TASKS][MAX_TASK_NAME_LEN + 1];
-	CoopTask   *m_tasks[MAX_NUM_TASKS];
-	uint32_t	m_taskFlags[MAX_NUM_TASKS];
+
+	/* tasks registered for each phase, in the order they are called */
+	std::vector<TaskEntry*> m_dispatch[NUM_TASK_PHASES];
+	std::atomic<bool> m_dispatchDirty;
+
+	TaskStats	m_cycleStats;
+	uint32_t	m_taskOverrunUs;
+	uint32_t	m_cycleCount;
+
+	std::atomic<int> m_degradationLevel;
+	uint32_t	m_cyclesUnderBudget;
+	std::atomic<uint64_t> m_totalSkips;
+
+	ParallelTaskExecutor *m_executor;
+	TaskGraph	m_phaseGraphs[NUM_TASK_PHASES];
 };
 
 }
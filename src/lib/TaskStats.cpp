@@ -0,0 +1,177 @@
+/*
+ * TaskStats.cpp
+ */
+
+#include "lib/TaskStats.h"
+
+namespace frc973 {
+
+TaskStats::TaskStats()
+	 : m_count(0)
+	 , m_sumUs(0)
+	 , m_lastUs(0)
+	 , m_minUs(UINT32_MAX)
+	 , m_maxUs(0)
+	 , m_overruns(0)
+	 , m_overrunThresholdUs(0)
+{
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		m_buckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * There is only ever one writer, so plain load/store pairs are enough
+ * here and are much cheaper than read-modify-write on the RIO's ARM core.
+ */
+void TaskStats::Record(uint32_t elapsedUs) {
+	int bucket = BucketFor(elapsedUs);
+
+	m_buckets[bucket].store(
+			m_buckets[bucket].load(std::memory_order_relaxed) + 1,
+			std::memory_order_relaxed);
+	m_sumUs.store(m_sumUs.load(std::memory_order_relaxed) + elapsedUs,
+			std::memory_order_relaxed);
+	m_lastUs.store(elapsedUs, std::memory_order_relaxed);
+
+	if (elapsedUs < m_minUs.load(std::memory_order_relaxed)) {
+		m_minUs.store(elapsedUs, std::memory_order_relaxed);
+	}
+	if (elapsedUs > m_maxUs.load(std::memory_order_relaxed)) {
+		m_maxUs.store(elapsedUs, std::memory_order_relaxed);
+	}
+
+	uint32_t threshold = m_overrunThresholdUs.load(std::memory_order_relaxed);
+	if (threshold != 0 && elapsedUs > threshold) {
+		m_overruns.store(m_overruns.load(std::memory_order_relaxed) + 1,
+				std::memory_order_relaxed);
+	}
+
+	/* publish the count last so readers never see more samples than
+	 * have been put in buckets */
+	m_count.store(m_count.load(std::memory_order_relaxed) + 1,
+			std::memory_order_release);
+}
+
+void TaskStats::Reset() {
+	m_count.store(0, std::memory_order_relaxed);
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		m_buckets[i].store(0, std::memory_order_relaxed);
+	}
+	m_sumUs.store(0, std::memory_order_relaxed);
+	m_lastUs.store(0, std::memory_order_relaxed);
+	m_minUs.store(UINT32_MAX, std::memory_order_relaxed);
+	m_maxUs.store(0, std::memory_order_relaxed);
+	m_overruns.store(0, std::memory_order_relaxed);
+}
+
+void TaskStats::GetSnapshot(Snapshot *out) const {
+	uint32_t buckets[NUM_BUCKETS];
+	uint64_t bucketTotal = 0;
+
+	out->count = m_count.load(std::memory_order_acquire);
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+		bucketTotal += buckets[i];
+	}
+
+	out->lastUs = m_lastUs.load(std::memory_order_relaxed);
+	out->maxUs = m_maxUs.load(std::memory_order_relaxed);
+	out->overruns = m_overruns.load(std::memory_order_relaxed);
+
+	if (out->count == 0 || bucketTotal == 0) {
+		out->minUs = 0;
+		out->meanUs = 0.0;
+		out->p50Us = 0;
+		out->p99Us = 0;
+		return;
+	}
+
+	out->minUs = m_minUs.load(std::memory_order_relaxed);
+	out->meanUs = ((double) m_sumUs.load(std::memory_order_relaxed)) /
+		((double) out->count);
+
+	/* percentiles are reported as the top of the bucket they fall in,
+	 * clamped to the largest sample actually seen */
+	uint64_t p50Rank = (bucketTotal + 1) / 2;
+	uint64_t p99Rank = (bucketTotal * 99 + 99) / 100;
+	uint64_t seen = 0;
+	bool havePercentile50 = false;
+
+	out->p50Us = out->maxUs;
+	out->p99Us = out->maxUs;
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		seen += buckets[i];
+		if (!havePercentile50 && seen >= p50Rank) {
+			out->p50Us = BucketUpperBound(i);
+			havePercentile50 = true;
+		}
+		if (seen >= p99Rank) {
+			out->p99Us = BucketUpperBound(i);
+			break;
+		}
+	}
+
+	if (out->p50Us > out->maxUs) {
+		out->p50Us = out->maxUs;
+	}
+	if (out->p99Us > out->maxUs) {
+		out->p99Us = out->maxUs;
+	}
+	if (out->p50Us < out->minUs) {
+		out->p50Us = out->minUs;
+	}
+	if (out->p99Us < out->minUs) {
+		out->p99Us = out->minUs;
+	}
+}
+
+void TaskStats::CopyFrom(const TaskStats &other) {
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		m_buckets[i].store(other.m_buckets[i].load(std::memory_order_relaxed),
+				std::memory_order_relaxed);
+	}
+	m_sumUs.store(other.m_sumUs.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	m_lastUs.store(other.m_lastUs.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	m_minUs.store(other.m_minUs.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	m_maxUs.store(other.m_maxUs.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	m_overruns.store(other.m_overruns.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	m_overrunThresholdUs.store(
+			other.m_overrunThresholdUs.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	m_count.store(other.m_count.load(std::memory_order_acquire),
+			std::memory_order_release);
+}
+
+int TaskStats::BucketFor(uint32_t us) {
+	if (us < 4) {
+		return us;
+	}
+
+	int msb = 31 - __builtin_clz(us);
+	int sub = (us >> (msb - 2)) & 3;
+	int bucket = 4 + (msb - 2) * 4 + sub;
+
+	if (bucket >= NUM_BUCKETS) {
+		return NUM_BUCKETS - 1;
+	}
+	return bucket;
+}
+
+uint32_t TaskStats::BucketUpperBound(int bucket) {
+	if (bucket < 4) {
+		return bucket;
+	}
+
+	int octave = (bucket - 4) / 4;
+	int sub = (bucket - 4) % 4;
+
+	return ((uint32_t) (4 + sub + 1) << octave) - 1;
+}
+
+}
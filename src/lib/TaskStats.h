@@ -0,0 +1,135 @@
+/*
+ * TaskStats.h
+ *
+ * TaskStats - fixed-size latency histogram for one task (or one loop).
+ *
+ * Samples are recorded in microseconds into log-linear buckets (four
+ * buckets per power of two, so any percentile read back is within 25% of
+ * the real value).  All storage lives inside the object and every counter
+ * is an atomic, so a TaskStats can be read at any time from another thread
+ * without taking a lock and without ever blocking the thread that records.
+ *
+ * Only one thread may call Record at a time (the TaskMgr thread that runs
+ * the task).  Readers get a slightly fuzzy but never corrupt view.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+namespace frc973 {
+
+class TaskStats {
+public:
+	/**
+	 * Number of histogram buckets.  The first four buckets hold 0-3us
+	 * exactly, after that each power of two is split into four buckets.
+	 * Anything above ~131ms lands in the last bucket.
+	 */
+	static constexpr int NUM_BUCKETS = 64;
+
+	/**
+	 * Plain-old-data copy of the stats, safe to pass around and print
+	 */
+	struct Snapshot {
+		uint64_t count;
+		uint32_t lastUs;
+		uint32_t minUs;
+		uint32_t maxUs;
+		double meanUs;
+		uint32_t p50Us;
+		uint32_t p99Us;
+		uint32_t overruns;
+	};
+
+	TaskStats();
+
+	/**
+	 * Add one sample.  If the sample is larger than the overrun threshold
+	 * (and the threshold is not zero) the overrun counter is incremented.
+	 *
+	 * @param elapsedUs time (in microseconds) taken by the call
+	 */
+	void Record(uint32_t elapsedUs);
+
+	/**
+	 * Forget all samples and overruns (the threshold is kept).
+	 */
+	void Reset();
+
+	/**
+	 * Set the time after which a sample counts as an overrun.
+	 *
+	 * @param thresholdUs overrun threshold in microseconds, 0 to disable
+	 */
+	void SetOverrunThreshold(uint32_t thresholdUs) {
+		m_overrunThresholdUs.store(thresholdUs, std::memory_order_relaxed);
+	}
+
+	uint32_t GetOverrunThreshold() const {
+		return m_overrunThresholdUs.load(std::memory_order_relaxed);
+	}
+
+	uint64_t GetCount() const {
+		return m_count.load(std::memory_order_relaxed);
+	}
+
+	uint32_t GetOverruns() const {
+		return m_overruns.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Total of all samples, for working out the mean over a window from
+	 * two reads of this and GetCount
+	 */
+	uint64_t GetSumUs() const {
+		return m_sumUs.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Most recent sample, without working out the whole snapshot
+	 */
+	uint32_t GetLastUs() const {
+		return m_lastUs.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Fill |out| with the current min/mean/max/percentiles.  May be called
+	 * from any thread.
+	 *
+	 * @param out snapshot to fill
+	 */
+	void GetSnapshot(Snapshot *out) const;
+
+	/**
+	 * Copy all samples from |other| into this (used when the owning
+	 * registry moves a task around).
+	 */
+	void CopyFrom(const TaskStats &other);
+
+	/**
+	 * Map a sample to its histogram bucket
+	 */
+	static int BucketFor(uint32_t us);
+
+	/**
+	 * Largest sample that would land in the given bucket
+	 */
+	static uint32_t BucketUpperBound(int bucket);
+
+private:
+	TaskStats(const TaskStats&) = delete;
+	TaskStats &operator=(const TaskStats&) = delete;
+
+	std::atomic<uint32_t> m_buckets[NUM_BUCKETS];
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_sumUs;
+	std::atomic<uint32_t> m_lastUs;
+	std::atomic<uint32_t> m_minUs;
+	std::atomic<uint32_t> m_maxUs;
+	std::atomic<uint32_t> m_overruns;
+	std::atomic<uint32_t> m_overrunThresholdUs;
+};
+
+}
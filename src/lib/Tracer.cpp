@@ -0,0 +1,304 @@
+/*
+ * Tracer.cpp
+ */
+
+#include "lib/Tracer.h"
+#include "lib/util/Util.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace frc973 {
+
+namespace {
+
+/**
+ * One event in a thread's ring.  The fields are atomics so a flush can
+ * copy a slot the thread is overwriting without a data race; it throws
+ * such a slot away afterwards.
+ */
+struct TraceEvent {
+	std::atomic<uint64_t> timeUs;
+	std::atomic<const char*> name;
+	std::atomic<const char*> category;
+	std::atomic<uint32_t> type;
+};
+
+struct ThreadRing {
+	char threadName[32];
+	uint32_t size;					/* a power of two */
+	TraceEvent *events;
+	std::atomic<uint64_t> head;		/* events ever recorded */
+	std::atomic<uint64_t> started;	/* the same, plus one being recorded */
+};
+
+/* a copy of one event, taken by a flush */
+struct EventCopy {
+	uint64_t timeUs;
+	const char *name;
+	const char *category;
+	uint32_t type;
+};
+
+/* rings and interned names are never freed; a thread that exits leaves
+ * its events behind for the next flush */
+pthread_mutex_t registryMutex = PTHREAD_MUTEX_INITIALIZER;
+std::vector<ThreadRing*> rings;
+std::vector<char*> internedNames;
+std::atomic<uint32_t> ringSize(Tracer::DEFAULT_EVENTS_PER_THREAD);
+
+/* set while a WriteChromeTraceAsync thread is running */
+std::atomic<bool> asyncWriting(false);
+
+thread_local ThreadRing *threadRing = nullptr;
+thread_local char threadName[32] = "";
+
+ThreadRing *NewRing() {
+	ThreadRing *ring = new ThreadRing();
+	uint32_t size = 1;
+
+	while (size < ringSize.load(std::memory_order_relaxed)) {
+		size <<= 1;
+	}
+	ring->size = size;
+	ring->events = new TraceEvent[size];
+	ring->head.store(0, std::memory_order_relaxed);
+	ring->started.store(0, std::memory_order_relaxed);
+
+	pthread_mutex_lock(&registryMutex);
+	if (threadName[0] != '\0') {
+		strcpy(ring->threadName, threadName);
+	}
+	else {
+		snprintf(ring->threadName, sizeof(ring->threadName), "thread %u",
+				(unsigned) rings.size());
+	}
+	rings.push_back(ring);
+	pthread_mutex_unlock(&registryMutex);
+	return ring;
+}
+
+/**
+ * Copy out every event in |ring| that wasn't overwritten while copying
+ */
+void CopyRing(ThreadRing *ring, std::vector<EventCopy> *out) {
+	uint64_t head = ring->head.load(std::memory_order_acquire);
+	uint64_t start = head > ring->size ? head - ring->size : 0;
+	size_t first = out->size();
+
+	for (uint64_t i = start; i < head; i++) {
+		TraceEvent &event = ring->events[i & (ring->size - 1)];
+		EventCopy copy;
+
+		copy.timeUs = event.timeUs.load(std::memory_order_relaxed);
+		copy.name = event.name.load(std::memory_order_relaxed);
+		copy.category = event.category.load(std::memory_order_relaxed);
+		copy.type = event.type.load(std::memory_order_relaxed);
+		out->push_back(copy);
+	}
+
+	/* event i's slot gets reused by event i + size, and the thread may
+	 * have started on that one while we copied */
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t started = ring->started.load(std::memory_order_relaxed);
+	if (started > start + ring->size) {
+		uint64_t overwritten = started - ring->size - start;
+
+		if (overwritten > out->size() - first) {
+			overwritten = out->size() - first;
+		}
+		out->erase(out->begin() + first, out->begin() + first + overwritten);
+	}
+}
+
+void WriteJsonString(FILE *out, const char *str) {
+	fputc('"', out);
+	for (; *str != '\0'; str++) {
+		if (*str == '"' || *str == '\\') {
+			fputc('\\', out);
+		}
+		if ((unsigned char) *str >= ' ') {
+			fputc(*str, out);
+		}
+	}
+	fputc('"', out);
+}
+
+/**
+ * Body of a WriteChromeTraceAsync thread; |p| is a malloc'd copy of the
+ * path
+ */
+void *AsyncWriterMain(void *p) {
+	char *path = static_cast<char*>(p);
+
+	/* named but not registered with RTThread, which would keep a slot
+	 * for every one of these short-lived threads */
+	pthread_setname_np(pthread_self(), "trace writer");
+	Tracer::SetThreadName("trace writer");
+	Tracer::WriteChromeTrace(path);
+	free(path);
+	asyncWriting.store(false, std::memory_order_release);
+	return NULL;
+}
+
+}
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+void Tracer::Enable(uint32_t eventsPerThread) {
+	ringSize.store(eventsPerThread < 2 ? 2 : eventsPerThread,
+			std::memory_order_relaxed);
+	s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Disable() {
+	s_enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::Clear() {
+	pthread_mutex_lock(&registryMutex);
+	for (ThreadRing *ring : rings) {
+		ring->head.store(0, std::memory_order_relaxed);
+		ring->started.store(0, std::memory_order_relaxed);
+	}
+	pthread_mutex_unlock(&registryMutex);
+}
+
+void Tracer::SetThreadName(const char *name) {
+	strncpy(threadName, name, sizeof(threadName) - 1);
+	threadName[sizeof(threadName) - 1] = '\0';
+	if (threadRing != nullptr) {
+		pthread_mutex_lock(&registryMutex);
+		strcpy(threadRing->threadName, threadName);
+		pthread_mutex_unlock(&registryMutex);
+	}
+}
+
+const char *Tracer::InternName(const char *name) {
+	const char *interned = nullptr;
+
+	pthread_mutex_lock(&registryMutex);
+	for (char *existing : internedNames) {
+		if (strcmp(existing, name) == 0) {
+			interned = existing;
+			break;
+		}
+	}
+	if (interned == nullptr) {
+		internedNames.push_back(strdup(name));
+		interned = internedNames.back();
+	}
+	pthread_mutex_unlock(&registryMutex);
+	return interned;
+}
+
+void Tracer::Record(EventType type, const char *name, const char *category) {
+	ThreadRing *ring = threadRing;
+
+	if (ring == nullptr) {
+		/* the only time a thread allocates for tracing */
+		ring = threadRing = NewRing();
+	}
+
+	uint64_t i = ring->head.load(std::memory_order_relaxed);
+	TraceEvent &event = ring->events[i & (ring->size - 1)];
+
+	/* a flush that sees any of this event also sees it started (see
+	 * CopyRing) */
+	ring->started.store(i + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	event.timeUs.store(GetUsecTime(), std::memory_order_relaxed);
+	event.name.store(name, std::memory_order_relaxed);
+	event.category.store(category, std::memory_order_relaxed);
+	event.type.store(type, std::memory_order_relaxed);
+	ring->head.store(i + 1, std::memory_order_release);
+}
+
+bool Tracer::WriteChromeTrace(const char *path) {
+	static const char *phases[] = {"B", "E", "i"};
+	std::vector<ThreadRing*> snapshot;
+	std::vector<EventCopy> events;
+	FILE *out = fopen(path, "w");
+	bool first = true;
+
+	if (out == NULL) {
+		fprintf(stderr, "Tracer: could not open %s: %s\n", path,
+				strerror(errno));
+		return false;
+	}
+
+	pthread_mutex_lock(&registryMutex);
+	snapshot = rings;
+	pthread_mutex_unlock(&registryMutex);
+
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (unsigned int tid = 0; tid < snapshot.size(); tid++) {
+		char name[sizeof(snapshot[tid]->threadName)];
+
+		pthread_mutex_lock(&registryMutex);
+		strcpy(name, snapshot[tid]->threadName);
+		pthread_mutex_unlock(&registryMutex);
+
+		fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+				"\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", tid);
+		WriteJsonString(out, name);
+		fprintf(out, "}}");
+		first = false;
+
+		events.clear();
+		CopyRing(snapshot[tid], &events);
+		for (const EventCopy &event : events) {
+			fprintf(out, ",\n{\"name\":");
+			WriteJsonString(out, event.name);
+			fprintf(out, ",\"cat\":");
+			WriteJsonString(out, event.category);
+			fprintf(out, ",\"ph\":\"%s\",\"ts\":%llu,\"pid\":1,\"tid\":%u%s}",
+					phases[event.type], (unsigned long long) event.timeUs, tid,
+					event.type == EVENT_INSTANT ? ",\"s\":\"g\"" : "");
+		}
+	}
+	fprintf(out, "\n]}\n");
+
+	if (fclose(out) != 0) {
+		fprintf(stderr, "Tracer: could not write %s\n", path);
+		return false;
+	}
+	return true;
+}
+
+bool Tracer::WriteChromeTraceAsync(const char *path) {
+	pthread_attr_t attr;
+	pthread_t thread;
+	char *copy;
+	int err;
+
+	if (asyncWriting.exchange(true, std::memory_order_acquire)) {
+		fprintf(stderr, "Tracer: still writing the last trace, skipping %s\n",
+				path);
+		return false;
+	}
+
+	copy = strdup(path);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	err = pthread_create(&thread, &attr, AsyncWriterMain, copy);
+	pthread_attr_destroy(&attr);
+	if (err != 0) {
+		fprintf(stderr, "Tracer: could not start writer for %s: %s\n",
+				path, strerror(err));
+		free(copy);
+		asyncWriting.store(false, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+bool Tracer::IsWriting() {
+	return asyncWriting.load(std::memory_order_acquire);
+}
+
+}
@@ -0,0 +1,159 @@
+/*
+ * Tracer.h
+ *
+ * Tracer - records when things happen on every thread of the robot so
+ * they can be looked at on one timeline, in chrome://tracing or the
+ * Perfetto UI (both open Chrome's JSON trace format).
+ *
+ * Each thread records into a ring of its own, allocated the first time it
+ * records anything while tracing is enabled, so recording never takes a
+ * lock and never waits on another thread: an event is a few relaxed
+ * stores and one release store.  When a ring fills up the oldest events
+ * are overwritten, so a trace always holds the most recent stretch of
+ * time.  WriteChromeTrace copies every ring out (from any thread, without
+ * stopping the ones recording) and writes them to a file;
+ * WriteChromeTraceAsync does the same on a thread of its own.
+ *
+ * While tracing is disabled recording an event is one relaxed load.
+ *
+ * Names and categories are kept by pointer, so they have to outlive the
+ * trace: use string literals, or pass anything else through InternName.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace frc973 {
+
+class Tracer {
+public:
+	/**
+	 * Events each thread's ring holds by default
+	 */
+	static constexpr uint32_t DEFAULT_EVENTS_PER_THREAD = 8192;
+
+	/**
+	 * Start recording.  Rings already allocated keep their size.
+	 *
+	 * @param eventsPerThread size of the ring of each thread that starts
+	 *     recording from now on (rounded up to a power of two)
+	 */
+	static void Enable(uint32_t eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+
+	/**
+	 * Stop recording.  What has been recorded stays until Clear.
+	 */
+	static void Disable();
+
+	static bool IsEnabled() {
+		return s_enabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Forget every event recorded so far.  Only call this while no thread
+	 * is recording (tracing disabled).
+	 */
+	static void Clear();
+
+	/**
+	 * Name the calling thread on the timeline.  RTThread::Configure does
+	 * this for every thread it sets up.
+	 */
+	static void SetThreadName(const char *name);
+
+	/**
+	 * Get a copy of |name| that lives as long as the program, the same
+	 * pointer every time for the same name
+	 */
+	static const char *InternName(const char *name);
+
+	/**
+	 * Start a span on the calling thread.  Spans on one thread nest.
+	 */
+	static void Begin(const char *name, const char *category) {
+		if (IsEnabled()) {
+			Record(EVENT_BEGIN, name, category);
+		}
+	}
+
+	/**
+	 * End the innermost span on the calling thread
+	 */
+	static void End(const char *name, const char *category) {
+		if (IsEnabled()) {
+			Record(EVENT_END, name, category);
+		}
+	}
+
+	/**
+	 * Mark a moment on the calling thread
+	 */
+	static void Instant(const char *name, const char *category) {
+		if (IsEnabled()) {
+			Record(EVENT_INSTANT, name, category);
+		}
+	}
+
+	/**
+	 * Write everything recorded so far, from every thread, as a Chrome
+	 * JSON trace.  Threads may keep recording meanwhile.
+	 *
+	 * @return false if |path| couldn't be written
+	 */
+	static bool WriteChromeTrace(const char *path);
+
+	/**
+	 * WriteChromeTrace on a normal priority thread of its own, so the
+	 * caller doesn't wait on the disk.  One write runs at a time.
+	 *
+	 * @return false if a write is still running or the thread couldn't
+	 *     be started
+	 */
+	static bool WriteChromeTraceAsync(const char *path);
+
+	/**
+	 * Whether a write started by WriteChromeTraceAsync is still running
+	 */
+	static bool IsWriting();
+
+private:
+	enum EventType {
+		EVENT_BEGIN,
+		EVENT_END,
+		EVENT_INSTANT
+	};
+
+	static void Record(EventType type, const char *name,
+			const char *category);
+
+	static std::atomic<bool> s_enabled;
+};
+
+/**
+ * Traces a span from construction to the end of the scope
+ */
+class TraceSpan {
+public:
+	TraceSpan(const char *name, const char *category)
+		 : m_name(name)
+		 , m_category(category)
+	{
+		Tracer::Begin(name, category);
+	}
+
+	~TraceSpan() {
+		Tracer::End(m_name, m_category);
+	}
+
+private:
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan &operator=(const TraceSpan&) = delete;
+
+	const char *m_name;
+	const char *m_category;
+};
+
+}
@@ -1,11 +1,8 @@
-#include <cstdarg>
 #include "WrapDash.h"
 #include "WPILib.h"
 
 #include <stdio.h>
 
-#define DBSTRING_MAX_LENGTH		30
-
 namespace frc973 {
 
 const char *positionStrings[] = {
@@ -21,15 +18,8 @@ const char *positionStrings[] = {
 		"DB/String 9",
 };
 
-void DBStringPrintf(DBStringPos position, const char *formatstring, ...) {
-	char msg[DBSTRING_MAX_LENGTH + 1];
-	va_list args;
-
-	va_start(args, formatstring);
-	vsnprintf(msg, DBSTRING_MAX_LENGTH - 1, formatstring, args);
-	va_end(args);
-
-	SmartDashboard::PutString(positionStrings[position], msg);
+void PutDBString(void *ctx, DBStringPos position, const char *text) {
+	SmartDashboard::PutString(positionStrings[position], text);
 }
 
 }
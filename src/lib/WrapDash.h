@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "lib/logging/DeferredLog.h"
+
 namespace frc973 {
 
 enum DBStringPos {
@@ -24,9 +26,41 @@ enum DBStringPos {
 	DB_LINE9
 };
 
+static constexpr int DB_NUM_LINES = DB_LINE9 + 1;
+static constexpr int DBSTRING_MAX_LENGTH = 30;
+
+/**
+ * Replace what |position| shows with |record| once it's formatted.
+ * DBStringPrintf calls this; it's defined with DashboardPublisher.
+ */
+void SetDBString(DBStringPos position, const DeferredLogRecord &record);
+
+/**
+ * Use printf-like syntax to print to the smart dash debug string place.
+ *
+ * Only the format and arguments are copied here (as with DebugPrintf);
+ * DashboardPublisher formats the line and sends it later, off the control
+ * loop, and only if it changed.  The last call for a line before the
+ * publisher runs wins.
+ */
+template <typename... Args>
+void DBStringPrintf(DBStringPos position, const char *formatstring,
+		Args... args) {
+	DeferredLogRecord record;
+
+	DeferredLog::MakeRecord(&record, DLOG_INFO, formatstring, args...);
+	SetDBString(position, record);
+}
+
 /**
- * Use printf-like syntax to print to the smart dash debug string place
+ * Send |text| to the smart dash debug string at |position| right away.
+ * This is what DashboardPublisher sends lines with on the robot.
  */
-void DBStringPrintf(DBStringPos position, const char *formatstring, ...);
+void PutDBString(void *ctx, DBStringPos position, const char *text);
 
 }
+
+/* checks the format string as with DebugPrintf (see DeferredLog.h) */
+#define DBStringPrintf(position, ...) \
+	((void) sizeof(::frc973::DeferredLog::CheckFormat(__VA_ARGS__)), \
+	 ::frc973::DBStringPrintf(position, __VA_ARGS__))
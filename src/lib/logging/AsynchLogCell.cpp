@@ -2,16 +2,14 @@
 
 namespace frc973 {
 
-AsynchLogCell::AsynchLogCell(char *name, AsynchLogCellListener *listener,
+AsynchLogCell::AsynchLogCell(const char *name, AsynchLogCellListener *listener,
 	unsigned int size):
 		LogCell(name, size),
 		m_listener(listener) {
 }
 
-const char *AsynchLogCell::GetContent() {
+void AsynchLogCell::UpdateContent() {
 	m_listener->NotifyAsynchLogCellListener(this);
-
-	return m_buffer;
 }
 
 }
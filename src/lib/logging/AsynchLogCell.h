@@ -2,8 +2,8 @@
  * AsynchLogCell.h
  *
  * Defines an asynchronous extension to the LogCell class.
- * When AsynchLogCell.GetContent is called, the AsynchLogCell
- * calls a callback to generate that content.
+ * When the spreadsheet is about to read an AsynchLogCell, the
+ * AsynchLogCell calls a callback to generate that content.
  *
  * This is in contrast with the standard LogCell which returns
  * whatever was last written to it.
@@ -30,17 +30,18 @@ public:
 	 * Construct an AsynchLogCell, given the name of the column to log,
 	 * and the listener to notify when content is requested.
 	 *
-	 * When GetContent is called, listener->NofityAsynchLogCellListener(this)
+	 * Before the cell is read, listener->NofityAsynchLogCellListener(this)
 	 * gets called to generate the content to return.
 	 */
-	AsynchLogCell(char *name, AsynchLogCellListener *listener,
+	AsynchLogCell(const char *name, AsynchLogCellListener *listener,
 			unsigned int size = DEFAULT_MAX_LOG_CELL_SIZE);
 
 	/**
-	 * Call listener->NotifyAsynchLogCellListener(this) to get the
-	 * contents to be logged and return those contents.
+	 * Call listener->NotifyAsynchLogCellListener(this) to fill in the
+	 * contents to be logged.  Called without the cell lock held so the
+	 * listener may use LogPrintf and friends.
 	 */
-	virtual const char *GetContent();
+	void UpdateContent() override;
 private:
 	AsynchLogCellListener *m_listener;
 };
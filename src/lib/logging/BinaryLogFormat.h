@@ -0,0 +1,220 @@
+/*
+ * BinaryLogFormat.h
+ *
+ * Layout of the binary log files LogSpreadsheet writes in
+ * LOG_FORMAT_BINARY mode.  Shared by the robot code that writes them and
+ * the host tools that read them, so keep it free of WPILib.
+ *
+ * A file is a header describing the columns followed by rows:
+ *
+ *     BinaryLogHeader
+ *     BinaryLogColumn + name bytes      (numColumns times)
+ *     row, row, row...                  (BinaryLogRecordHeader::size each)
+ *
+ * and each row is
+ *
+ *     BinaryLogRecordHeader
+ *     presence bitmap                   ((numColumns + 7) / 8 bytes)
+ *     a slot per present column         (BinaryLogColumn::slotSize bytes)
+ *
+ * A column whose bit is clear in the presence bitmap was empty or wasn't
+ * sampled that row (see LogSampling), and takes no space in it.  The
+ * exception is a row of BinaryLogHeader::recordSize bytes, which has
+ * every slot in place whether present or not; that is also the layout
+ * rows have in memory.  Text slots hold a NUL padded string; numeric slots
+ * hold the raw value in the robot's byte order (little endian on the
+ * roboRIO and on any host we'd convert on).
+ *
+ * Version 1 files had no row size and always stored every slot.
+ *
+ * LOG_FORMAT_COMPRESSED files have the same header and columns (with
+ * BINARY_LOG_COMPRESSED_MAGIC as the magic) followed by blocks instead of
+ * rows:
+ *
+ *     BinaryLogBlockHeader
+ *     compressedSize bytes              (see LogCompression.h)
+ *
+ * each holding numRows rows with every slot in place (the compressor
+ * takes care of the empty ones).  A block is only useful whole, so
+ * a reader stops at a block cut short by the robot losing power, and can
+ * skip a damaged one by looking for the next BINARY_LOG_BLOCK_SYNC.
+ *
+ * Next to each binary or compressed log the writer keeps an index,
+ * <log file>.idx, so a reader can go straight to a time or mode without
+ * reading the rows before it:
+ *
+ *     LogIndexHeader
+ *     LogIndexEntry, LogIndexEntry...
+ *
+ * There is an entry for the first row of the file, for every row where
+ * the mode changed and for the first row of every second in between.
+ * Each gives the byte offset of its row (or, in a compressed log, of the
+ * block starting with it), and that row has every on-change column in
+ * it, so reading can start there.  A torn last entry is ignored.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lib/util/NumberFormat.h"
+
+namespace frc973 {
+
+/* "973L" */
+static constexpr uint32_t BINARY_LOG_MAGIC = 0x4c333739;
+static constexpr uint16_t BINARY_LOG_VERSION = 2;
+
+/* first word of every row, so a reader can resync after a torn write */
+static constexpr uint32_t BINARY_LOG_ROW_SYNC = 0x57303739;
+
+/* "973Z", the magic of a compressed log */
+static constexpr uint32_t BINARY_LOG_COMPRESSED_MAGIC = 0x5a333739;
+
+/* first word of every block of a compressed log */
+static constexpr uint32_t BINARY_LOG_BLOCK_SYNC = 0x42333739;
+
+/**
+ * When a column is written.  Stored as one byte in the schema.
+ */
+enum LogSampling {
+	LOG_SAMPLE_EVERY_ROW = 0,	/* every row */
+	LOG_SAMPLE_EVERY_NTH = 1,	/* every Nth row, empty in between */
+	LOG_SAMPLE_ON_CHANGE = 2,	/* only rows where the value changed */
+	LOG_SAMPLE_EVENT = 3		/* only rows logged to since the last row */
+};
+
+/**
+ * What a column holds.  Stored as one byte in the schema.
+ */
+enum LogCellType {
+	LOG_CELL_TEXT = 0,			/* NUL padded string, slot is the cell size */
+	LOG_CELL_DOUBLE = 1,		/* double, printed "%lf" */
+	LOG_CELL_INT = 2			/* int32_t, printed "%d" (enums too) */
+};
+
+struct BinaryLogHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t numColumns;
+	uint32_t headerSize;		/* bytes from the start of the file to row 0 */
+	uint32_t recordSize;		/* bytes in each row */
+	uint64_t startTimeUs;		/* FPGA time the file was opened */
+};
+
+struct BinaryLogColumn {
+	uint8_t type;				/* a LogCellType */
+	uint8_t flags;				/* the cell's LOG_CELL_FLAG_* bits */
+	uint16_t slotSize;			/* bytes this column takes in each row */
+	uint16_t nameLen;			/* bytes of name following (no NUL) */
+	uint8_t sampling;			/* a LogSampling */
+	uint8_t decimals;			/* digits after the point doubles are
+								 * printed with; 0 in older files, which
+								 * printed 6 */
+};
+
+struct BinaryLogRecordHeader {
+	uint32_t sync;				/* BINARY_LOG_ROW_SYNC */
+	uint32_t row;				/* rows written before this one */
+	uint64_t timeUs;			/* when the row was taken */
+	uint8_t mode;				/* RobotMode the row was taken in */
+	uint8_t reserved[3];
+	uint32_t size;				/* bytes in this row, header included */
+};
+
+struct BinaryLogBlockHeader {
+	uint32_t sync;				/* BINARY_LOG_BLOCK_SYNC */
+	uint32_t firstRow;			/* row number of the first row in the block */
+	uint32_t numRows;
+	uint32_t rawSize;			/* numRows * recordSize */
+	uint32_t compressedSize;	/* bytes following this header */
+	uint32_t checksum;			/* LogBlockChecksum of those bytes */
+};
+
+/* "973I", the magic of a log's index */
+static constexpr uint32_t LOG_INDEX_MAGIC = 0x49333739;
+static constexpr uint16_t LOG_INDEX_VERSION = 1;
+
+/**
+ * Why a row got an index entry
+ */
+enum LogIndexReason {
+	LOG_INDEX_FILE_START = 0,	/* first row of a file continuing the last */
+	LOG_INDEX_MODE = 1,			/* the robot changed mode (or the log began) */
+	LOG_INDEX_SECOND = 2		/* a second since the last entry */
+};
+
+struct LogIndexHeader {
+	uint32_t magic;				/* LOG_INDEX_MAGIC */
+	uint16_t version;
+	uint16_t reserved;
+	uint64_t startTimeUs;		/* the log's startTimeUs */
+};
+
+struct LogIndexEntry {
+	uint64_t timeUs;			/* the row's timeUs */
+	uint64_t modeStartUs;		/* timeUs of the row the mode began on */
+	uint64_t offset;			/* bytes from the start of the log file */
+	uint32_t row;				/* the row's row number */
+	uint8_t mode;
+	uint8_t reason;				/* a LogIndexReason */
+	uint16_t reserved;
+};
+
+static_assert(sizeof(BinaryLogHeader) == 24, "binary log header layout");
+static_assert(sizeof(BinaryLogColumn) == 8, "binary log column layout");
+static_assert(sizeof(BinaryLogRecordHeader) == 24,
+		"binary log record layout");
+static_assert(sizeof(BinaryLogBlockHeader) == 24, "binary log block layout");
+static_assert(sizeof(LogIndexHeader) == 16, "log index header layout");
+static_assert(sizeof(LogIndexEntry) == 32, "log index entry layout");
+
+/**
+ * Bytes a column of |type| takes in a row, given the cell's text size
+ */
+inline uint16_t BinaryLogSlotSize(LogCellType type, uint32_t textSize) {
+	switch (type) {
+		case LOG_CELL_DOUBLE:
+			return sizeof(double);
+		case LOG_CELL_INT:
+			return sizeof(int32_t);
+		default:
+			return textSize;
+	}
+}
+
+/**
+ * Format one slot the way the CSV writer prints it (doubles with
+ * |decimals| digits after the point as "%.*f" would, ints as "%d", text
+ * as is).  Used by the log writer thread and the host tools so both print
+ * exactly the same thing.
+ *
+ * @param decimals a BinaryLogColumn::decimals
+ *
+ * @return length of the formatted text
+ */
+inline int FormatBinaryLogSlot(LogCellType type, const uint8_t *slot,
+		uint16_t slotSize, uint8_t decimals, char *buf, size_t size) {
+	switch (type) {
+		case LOG_CELL_DOUBLE: {
+			double val;
+			memcpy(&val, slot, sizeof(val));
+			return FormatFixed(val, decimals == 0 ?
+					FORMAT_DEFAULT_DECIMALS : decimals, buf, size);
+		}
+		case LOG_CELL_INT: {
+			int32_t val;
+			memcpy(&val, slot, sizeof(val));
+			return FormatInt(val, buf, size);
+		}
+		default: {
+			const char *text = (const char*) slot;
+			return snprintf(buf, size, "%.*s",
+					(int) strnlen(text, slotSize), text);
+		}
+	}
+}
+
+}
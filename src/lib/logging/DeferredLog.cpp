@@ -0,0 +1,499 @@
+/*
+ * DeferredLog.cpp
+ */
+
+#include "lib/logging/DeferredLog.h"
+#include "lib/SpscChannel.h"
+#include "lib/util/NumberFormat.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <vector>
+
+namespace frc973 {
+
+namespace {
+
+typedef SpscRing<DeferredLogRecord, DeferredLog::RING_RECORDS> RecordRing;
+
+/* rings are never freed; a thread that exits leaves its records behind for
+ * the next flush */
+pthread_mutex_t registryMutex = PTHREAD_MUTEX_INITIALIZER;
+std::vector<RecordRing*> rings;
+
+thread_local RecordRing *threadRing = nullptr;
+
+/* only one thread drains the rings at a time, as SpscRing requires */
+pthread_mutex_t flushMutex = PTHREAD_MUTEX_INITIALIZER;
+FILE *output = nullptr;
+
+pthread_mutex_t writerMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t writerCond = PTHREAD_COND_INITIALIZER;
+pthread_t writerThread;
+bool writerRunning = false;
+bool writerStop = false;
+RTThreadConfig writerConfig;
+uint32_t writerPeriodMs = DeferredLog::DEFAULT_PERIOD_MS;
+
+/**
+ * Hands out a record's arguments in order, converted to whatever the
+ * conversion reading them expects
+ */
+class ArgReader {
+public:
+	explicit ArgReader(const DeferredLogRecord &record)
+		 : m_record(record)
+		 , m_next(0)
+	{
+	}
+
+	bool HasNext() const {
+		return m_next < m_record.numArgs;
+	}
+
+	long long NextSigned() {
+		const DeferredLogRecord::Arg &arg = m_record.args[m_next];
+
+		switch (m_record.types[m_next++]) {
+			case DeferredLogRecord::ARG_UINT:
+				return (int32_t) arg.u;
+			case DeferredLogRecord::ARG_ULONG:
+				return (long long) arg.u;
+			case DeferredLogRecord::ARG_DOUBLE:
+				return (long long) arg.d;
+			case DeferredLogRecord::ARG_INT:
+			case DeferredLogRecord::ARG_LONG:
+				return arg.i;
+			default:
+				return 0;
+		}
+	}
+
+	unsigned long long NextUnsigned() {
+		const DeferredLogRecord::Arg &arg = m_record.args[m_next];
+
+		switch (m_record.types[m_next++]) {
+			case DeferredLogRecord::ARG_INT:
+				return (uint32_t) arg.i;
+			case DeferredLogRecord::ARG_LONG:
+				return (unsigned long long) arg.i;
+			case DeferredLogRecord::ARG_DOUBLE:
+				return (unsigned long long) arg.d;
+			case DeferredLogRecord::ARG_UINT:
+			case DeferredLogRecord::ARG_ULONG:
+				return arg.u;
+			default:
+				return 0;
+		}
+	}
+
+	double NextDouble() {
+		const DeferredLogRecord::Arg &arg = m_record.args[m_next];
+
+		switch (m_record.types[m_next++]) {
+			case DeferredLogRecord::ARG_INT:
+			case DeferredLogRecord::ARG_LONG:
+				return arg.i;
+			case DeferredLogRecord::ARG_UINT:
+			case DeferredLogRecord::ARG_ULONG:
+				return arg.u;
+			case DeferredLogRecord::ARG_DOUBLE:
+				return arg.d;
+			default:
+				return 0.0;
+		}
+	}
+
+	const char *NextString() {
+		const DeferredLogRecord::Arg &arg = m_record.args[m_next];
+
+		if (m_record.types[m_next++] == DeferredLogRecord::ARG_STRING) {
+			return m_record.text + arg.u;
+		}
+		return "(?)";
+	}
+
+	const void *NextPointer() {
+		const DeferredLogRecord::Arg &arg = m_record.args[m_next];
+
+		if (m_record.types[m_next++] == DeferredLogRecord::ARG_POINTER) {
+			return arg.p;
+		}
+		return nullptr;
+	}
+
+private:
+	const DeferredLogRecord &m_record;
+	int m_next;
+};
+
+/**
+ * One printf conversion, up to (not including) its length modifier and
+ * conversion letter
+ */
+struct Conversion {
+	char spec[32];		/* flags, width and precision as printf takes them */
+	size_t len;
+	bool flags;
+	int width;			/* 0 if not given */
+	int precision;		/* -1 if not given */
+};
+
+/**
+ * Parse the flags, width and precision of the conversion at |*format|
+ * (just past the '%') into |conv|, taking any '*' from |args|.  Leaves
+ * room at the end of conv->spec for "ll" and the conversion letter.
+ */
+void ParseConversion(const char **format, ArgReader *args, Conversion *conv) {
+	const char *p = *format;
+	const size_t size = sizeof(conv->spec) - 4;
+	size_t len = 0;
+
+	conv->spec[len++] = '%';
+	conv->flags = false;
+	conv->width = 0;
+	conv->precision = -1;
+	while (*p != '\0' && strchr("-+ #0", *p) != nullptr) {
+		if (len < size) {
+			conv->spec[len++] = *p;
+		}
+		conv->flags = true;
+		p++;
+	}
+	for (int field = 0; field < 2; field++) {
+		int value = 0;
+
+		if (field == 1) {
+			if (*p != '.') {
+				break;
+			}
+			if (len < size) {
+				conv->spec[len++] = *p;
+			}
+			p++;
+		}
+		if (*p == '*') {
+			value = args->HasNext() ? (int) args->NextSigned() : 0;
+			int n = snprintf(conv->spec + len, size - len, "%d", value);
+
+			if (n > 0 && (size_t) n < size - len) {
+				len += n;
+			}
+			p++;
+		}
+		while (isdigit((unsigned char) *p)) {
+			if (len < size) {
+				conv->spec[len++] = *p;
+			}
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		if (field == 0) {
+			conv->width = value;
+		}
+		else {
+			conv->precision = value < 0 ? -1 : value;
+		}
+	}
+	if (conv->width < 0) {
+		/* a negative '*' width means left justified */
+		conv->flags = true;
+	}
+
+	/* the length modifier only described the argument the caller passed;
+	 * what it turned into is known now */
+	while (*p != '\0' && strchr("hlLqjzt", *p) != nullptr) {
+		p++;
+	}
+	*format = p;
+	conv->len = len;
+}
+
+/**
+ * Write |text| right justified in |width| columns, as snprintf would
+ *
+ * @return length of the whole text, even if it was cut off
+ */
+int AppendPadded(const char *text, int len, int width, char *buf,
+		size_t size) {
+	int pad = width > len ? width - len : 0;
+
+	for (int i = 0; i < pad && (size_t) i + 1 < size; i++) {
+		buf[i] = ' ';
+	}
+	if ((size_t) pad + 1 < size) {
+		size_t copy = (size_t) len < size - pad ? len : size - pad - 1;
+
+		memcpy(buf + pad, text, copy);
+		buf[pad + copy] = '\0';
+	}
+	else if (size > 0) {
+		buf[size - 1] = '\0';
+	}
+	return pad + len;
+}
+
+RecordRing *NewRing() {
+	void *mem;
+	RecordRing *ring;
+
+	/* plain new only promises 16 byte alignment before C++17, and the
+	 * ring's indices each want a cache line of their own */
+	if (posix_memalign(&mem, alignof(RecordRing), sizeof(RecordRing)) != 0) {
+		return nullptr;
+	}
+	ring = new (mem) RecordRing();
+
+	pthread_mutex_lock(&registryMutex);
+	rings.push_back(ring);
+	pthread_mutex_unlock(&registryMutex);
+	return ring;
+}
+
+void *WriterMain(void *) {
+	struct timespec deadline;
+
+	RTThread::Configure(writerConfig);
+
+	pthread_mutex_lock(&writerMutex);
+	while (!writerStop) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += writerPeriodMs / 1000;
+		deadline.tv_nsec += (writerPeriodMs % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		while (!writerStop && pthread_cond_timedwait(&writerCond,
+					&writerMutex, &deadline) != ETIMEDOUT) {
+		}
+		pthread_mutex_unlock(&writerMutex);
+
+		DeferredLog::Flush();
+
+		pthread_mutex_lock(&writerMutex);
+	}
+	pthread_mutex_unlock(&writerMutex);
+	return NULL;
+}
+
+}
+
+std::atomic<int> DeferredLog::s_level(DLOG_DEBUG);
+std::atomic<uint64_t> DeferredLog::s_dropped(0);
+
+void DeferredLog::SetOutput(FILE *out) {
+	pthread_mutex_lock(&flushMutex);
+	output = out;
+	pthread_mutex_unlock(&flushMutex);
+}
+
+bool DeferredLog::Start(const RTThreadConfig &threadConfig,
+		uint32_t periodMs) {
+	pthread_condattr_t attr;
+	bool started;
+
+	pthread_mutex_lock(&writerMutex);
+	if (writerRunning) {
+		pthread_mutex_unlock(&writerMutex);
+		return false;
+	}
+	writerConfig = threadConfig;
+	writerPeriodMs = periodMs < 1 ? 1 : periodMs;
+	writerStop = false;
+
+	/* the writer waits against CLOCK_MONOTONIC */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_destroy(&writerCond);
+	pthread_cond_init(&writerCond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	started = pthread_create(&writerThread, NULL, WriterMain, NULL) == 0;
+	writerRunning = started;
+	pthread_mutex_unlock(&writerMutex);
+
+	if (!started) {
+		fprintf(stderr, "DeferredLog: could not start writer thread\n");
+	}
+	return started;
+}
+
+void DeferredLog::Stop() {
+	pthread_mutex_lock(&writerMutex);
+	if (!writerRunning) {
+		pthread_mutex_unlock(&writerMutex);
+		Flush();
+		return;
+	}
+	writerStop = true;
+	pthread_cond_signal(&writerCond);
+	pthread_mutex_unlock(&writerMutex);
+
+	pthread_join(writerThread, NULL);
+	pthread_mutex_lock(&writerMutex);
+	writerRunning = false;
+	pthread_mutex_unlock(&writerMutex);
+	Flush();
+}
+
+uint32_t DeferredLog::Flush() {
+	std::vector<RecordRing*> snapshot;
+	char line[MAX_LINE];
+	uint32_t written = 0;
+
+	pthread_mutex_lock(&registryMutex);
+	snapshot = rings;
+	pthread_mutex_unlock(&registryMutex);
+
+	pthread_mutex_lock(&flushMutex);
+	FILE *out = output != nullptr ? output : stdout;
+
+	for (RecordRing *ring : snapshot) {
+		written += ring->Drain([&](const DeferredLogRecord &record) {
+			Format(record, line, sizeof(line));
+			fputs(line, out);
+		});
+	}
+	if (written != 0) {
+		fflush(out);
+	}
+	pthread_mutex_unlock(&flushMutex);
+	return written;
+}
+
+size_t DeferredLog::Format(const DeferredLogRecord &record, char *buf,
+		size_t size) {
+	ArgReader args(record);
+	const char *p = record.format;
+	size_t len = 0;
+
+	if (size == 0) {
+		return 0;
+	}
+
+	while (*p != '\0' && len + 1 < size) {
+		Conversion conv;
+		char *spec = conv.spec;
+		size_t specLen;
+		int n;
+
+		if (*p != '%') {
+			buf[len++] = *p++;
+			continue;
+		}
+		p++;
+		if (*p == '%') {
+			buf[len++] = *p++;
+			continue;
+		}
+
+		ParseConversion(&p, &args, &conv);
+		specLen = conv.len;
+		char conversion = *p;
+		if (conversion == '\0') {
+			break;
+		}
+		p++;
+		if (!args.HasNext()) {
+			/* fewer arguments than the format wants; printf would have
+			 * printed garbage */
+			n = snprintf(buf + len, size - len, "%%%c", conversion);
+		}
+		else if (!conv.flags && ((strchr("di", conversion) != nullptr &&
+					conv.precision < 0) || conversion == 'f')) {
+			/* the plain %d and %.Nf nearly every caller uses, without
+			 * snprintf */
+			char number[MAX_LINE];
+
+			if (conversion == 'f') {
+				n = FormatFixed(args.NextDouble(), conv.precision, number,
+						sizeof(number));
+			}
+			else {
+				n = FormatInt(args.NextSigned(), number, sizeof(number));
+			}
+			if (n >= (int) sizeof(number)) {
+				n = sizeof(number) - 1;
+			}
+			n = AppendPadded(number, n, conv.width, buf + len, size - len);
+		}
+		else if (strchr("di", conversion) != nullptr) {
+			strcpy(spec + specLen, "lld");
+			n = snprintf(buf + len, size - len, spec, args.NextSigned());
+		}
+		else if (strchr("ouxX", conversion) != nullptr) {
+			spec[specLen++] = 'l';
+			spec[specLen++] = 'l';
+			spec[specLen++] = conversion;
+			spec[specLen] = '\0';
+			n = snprintf(buf + len, size - len, spec, args.NextUnsigned());
+		}
+		else if (strchr("fFeEgGaA", conversion) != nullptr) {
+			spec[specLen++] = conversion;
+			spec[specLen] = '\0';
+			n = snprintf(buf + len, size - len, spec, args.NextDouble());
+		}
+		else if (conversion == 'c') {
+			strcpy(spec + specLen, "c");
+			n = snprintf(buf + len, size - len, spec,
+					(int) args.NextSigned());
+		}
+		else if (conversion == 's') {
+			strcpy(spec + specLen, "s");
+			n = snprintf(buf + len, size - len, spec, args.NextString());
+		}
+		else if (conversion == 'p') {
+			strcpy(spec + specLen, "p");
+			n = snprintf(buf + len, size - len, spec, args.NextPointer());
+		}
+		else {
+			/* %n and anything unknown print as written */
+			n = snprintf(buf + len, size - len, "%%%c", conversion);
+		}
+
+		if (n > 0) {
+			len += (size_t) n < size - len ? n : size - len - 1;
+		}
+	}
+	buf[len] = '\0';
+	return len;
+}
+
+void DeferredLog::Submit(const DeferredLogRecord &record) {
+	RecordRing *ring = threadRing;
+
+	if (ring == nullptr) {
+		/* the only time a thread allocates for logging */
+		ring = threadRing = NewRing();
+	}
+	if (ring == nullptr || !ring->Send(record)) {
+		s_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void DeferredLog::CaptureString(DeferredLogRecord *record, const char *str) {
+	size_t offset = record->textUsed;
+	size_t room = DeferredLogRecord::TEXT_BYTES - offset;
+
+	if (room == 0) {
+		/* out of room; point at the end of the last string instead */
+		offset = DeferredLogRecord::TEXT_BYTES - 1;
+	}
+	else {
+		size_t len = str != nullptr ? strnlen(str, room - 1) : 0;
+
+		memcpy(record->text + offset, str != nullptr ? str : "", len);
+		record->text[offset + len] = '\0';
+		record->textUsed += len + 1;
+	}
+	record->types[record->numArgs] = DeferredLogRecord::ARG_STRING;
+	record->args[record->numArgs].u = offset;
+}
+
+}
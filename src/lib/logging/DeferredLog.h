@@ -0,0 +1,294 @@
+/*
+ * DeferredLog.h
+ *
+ * DeferredLog - printf for code on a real-time thread, with the formatting
+ * and the write to stdout (a blocking write to netconsole on the RIO)
+ * done later on a background thread.
+ *
+ * A call like
+ *
+ *     DebugPrintf("trap drive d %lf a %lf\n", m_dist, m_angle);
+ *
+ * checks the severity first, and if it's being logged copies the format
+ * pointer and the raw argument values into a record in the calling
+ * thread's own SpscRing (allocated the first time the thread logs).  That
+ * is all the caller pays for: no formatting, no lock, no syscall.  The
+ * writer thread started with Start drains every ring periodically, formats
+ * the records with the usual printf conversions and writes them out.  Lines
+ * from one thread come out in order; lines from different threads may
+ * interleave differently than they were logged.
+ *
+ * The format is kept by pointer, so it has to be a string literal.  String
+ * arguments are copied (up to TEXT_BYTES per call).  Records that don't fit
+ * in a full ring are counted and dropped rather than waited for.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <type_traits>
+
+#include "lib/RTThread.h"
+
+namespace frc973 {
+
+enum DeferredLogLevel {
+	DLOG_ERROR,
+	DLOG_WARNING,
+	DLOG_INFO,
+	DLOG_DEBUG
+};
+
+/**
+ * One call's format and arguments, as captured on the calling thread
+ */
+struct DeferredLogRecord {
+	static constexpr int MAX_ARGS = 8;
+	static constexpr int TEXT_BYTES = 48;
+
+	enum ArgType : uint8_t {
+		ARG_INT,		/* up to 32 bits, as printf would promote them */
+		ARG_UINT,
+		ARG_LONG,		/* 64 bits */
+		ARG_ULONG,
+		ARG_DOUBLE,
+		ARG_STRING,		/* offset of a copy in text */
+		ARG_POINTER
+	};
+
+	union Arg {
+		int64_t i;
+		uint64_t u;
+		double d;
+		const void *p;
+	};
+
+	const char *format;
+	uint8_t level;
+	uint8_t numArgs;
+	uint8_t textUsed;
+	uint8_t types[MAX_ARGS];
+	Arg args[MAX_ARGS];
+	char text[TEXT_BYTES];
+};
+
+class DeferredLog {
+public:
+	/**
+	 * Records each thread's ring holds
+	 */
+	static constexpr size_t RING_RECORDS = 256;
+
+	/**
+	 * How often the writer thread drains the rings by default
+	 */
+	static constexpr uint32_t DEFAULT_PERIOD_MS = 50;
+
+	/**
+	 * Longest line written; anything past it is cut off
+	 */
+	static constexpr size_t MAX_LINE = 512;
+
+	/**
+	 * Capture messages of |level| and more severe ones from now on
+	 */
+	static void SetLevel(DeferredLogLevel level) {
+		s_level.store(level, std::memory_order_relaxed);
+	}
+
+	static DeferredLogLevel GetLevel() {
+		return static_cast<DeferredLogLevel>(
+				s_level.load(std::memory_order_relaxed));
+	}
+
+	static bool IsEnabled(DeferredLogLevel level) {
+		return level <= s_level.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Where formatted lines go (stdout until this is called).  Set it
+	 * before Start.
+	 */
+	static void SetOutput(FILE *out);
+
+	/**
+	 * Start the writer thread
+	 *
+	 * @param threadConfig real-time setup of the writer thread
+	 * @param periodMs how often the writer drains the rings
+	 *
+	 * @return false if the thread couldn't be started (or already was)
+	 */
+	static bool Start(const RTThreadConfig &threadConfig,
+			uint32_t periodMs = DEFAULT_PERIOD_MS);
+
+	/**
+	 * Stop the writer thread, then write whatever it left behind
+	 */
+	static void Stop();
+
+	/**
+	 * Format and write every record queued so far, from any thread.  The
+	 * writer thread calls this every period; anyone else may too.
+	 *
+	 * @return number of lines written
+	 */
+	static uint32_t Flush();
+
+	/**
+	 * Number of records dropped because a ring was full
+	 */
+	static uint64_t GetDropped() {
+		return s_dropped.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Format |record| the way printf would have formatted the call it was
+	 * captured from
+	 *
+	 * @return length of the formatted text (cut off to fit in |size|)
+	 */
+	static size_t Format(const DeferredLogRecord &record, char *buf,
+			size_t size);
+
+	/**
+	 * Capture a printf-style message at |level| unless that level is
+	 * filtered out
+	 */
+	template <typename... Args>
+	static void Printf(DeferredLogLevel level, const char *format,
+			Args... args) {
+		if (!IsEnabled(level)) {
+			return;
+		}
+
+		DeferredLogRecord record;
+
+		MakeRecord(&record, level, format, args...);
+		Submit(record);
+	}
+
+	/**
+	 * Never defined or called.  The printf-style macros below mention it
+	 * where it isn't evaluated, so the compiler checks their format
+	 * strings and arguments just as it does printf's.
+	 */
+	static int CheckFormat(const char *format, ...)
+		__attribute__((format(printf, 1, 2)));
+
+	/**
+	 * Capture a printf-style message into |record| to be formatted later
+	 * by whoever holds on to it (see DBStringPrintf)
+	 */
+	template <typename... Args>
+	static void MakeRecord(DeferredLogRecord *record, DeferredLogLevel level,
+			const char *format, Args... args) {
+		record->format = format;
+		record->level = level;
+		record->numArgs = 0;
+		record->textUsed = 0;
+		Capture(record, args...);
+	}
+
+private:
+	static void Submit(const DeferredLogRecord &record);
+	static void CaptureString(DeferredLogRecord *record, const char *str);
+
+	static void Capture(DeferredLogRecord *record) {}
+
+	template <typename T, typename... Rest>
+	static void Capture(DeferredLogRecord *record, T arg, Rest... rest) {
+		if (record->numArgs < DeferredLogRecord::MAX_ARGS) {
+			Pack(record, arg);
+			record->numArgs++;
+		}
+		Capture(record, rest...);
+	}
+
+	template <typename T>
+	static typename std::enable_if<std::is_integral<T>::value ||
+			std::is_enum<T>::value>::type
+	Pack(DeferredLogRecord *record, T arg) {
+		DeferredLogRecord::Arg &value = record->args[record->numArgs];
+		bool isSigned = std::is_signed<T>::value || std::is_enum<T>::value;
+
+		if (sizeof(T) <= sizeof(int32_t)) {
+			record->types[record->numArgs] = isSigned ?
+				DeferredLogRecord::ARG_INT : DeferredLogRecord::ARG_UINT;
+		}
+		else {
+			record->types[record->numArgs] = isSigned ?
+				DeferredLogRecord::ARG_LONG : DeferredLogRecord::ARG_ULONG;
+		}
+		if (isSigned) {
+			value.i = static_cast<int64_t>(arg);
+		}
+		else {
+			value.u = static_cast<uint64_t>(arg);
+		}
+	}
+
+	template <typename T>
+	static typename std::enable_if<std::is_floating_point<T>::value>::type
+	Pack(DeferredLogRecord *record, T arg) {
+		record->types[record->numArgs] = DeferredLogRecord::ARG_DOUBLE;
+		record->args[record->numArgs].d = arg;
+	}
+
+	template <typename T>
+	static void Pack(DeferredLogRecord *record, T *arg) {
+		if (std::is_same<typename std::remove_cv<T>::type, char>::value) {
+			CaptureString(record, reinterpret_cast<const char*>(arg));
+		}
+		else {
+			record->types[record->numArgs] = DeferredLogRecord::ARG_POINTER;
+			record->args[record->numArgs].p = arg;
+		}
+	}
+
+	static std::atomic<int> s_level;
+	static std::atomic<uint64_t> s_dropped;
+};
+
+/**
+ * Drop-in replacements for printf at each severity
+ */
+template <typename... Args>
+void ErrorPrintf(const char *format, Args... args) {
+	DeferredLog::Printf(DLOG_ERROR, format, args...);
+}
+
+template <typename... Args>
+void WarningPrintf(const char *format, Args... args) {
+	DeferredLog::Printf(DLOG_WARNING, format, args...);
+}
+
+template <typename... Args>
+void InfoPrintf(const char *format, Args... args) {
+	DeferredLog::Printf(DLOG_INFO, format, args...);
+}
+
+template <typename... Args>
+void DebugPrintf(const char *format, Args... args) {
+	DeferredLog::Printf(DLOG_DEBUG, format, args...);
+}
+
+}
+
+/* the templates above can't be checked against their format strings, so
+ * every call goes through DeferredLog::CheckFormat first */
+#define ErrorPrintf(...) \
+	((void) sizeof(::frc973::DeferredLog::CheckFormat(__VA_ARGS__)), \
+	 ::frc973::ErrorPrintf(__VA_ARGS__))
+#define WarningPrintf(...) \
+	((void) sizeof(::frc973::DeferredLog::CheckFormat(__VA_ARGS__)), \
+	 ::frc973::WarningPrintf(__VA_ARGS__))
+#define InfoPrintf(...) \
+	((void) sizeof(::frc973::DeferredLog::CheckFormat(__VA_ARGS__)), \
+	 ::frc973::InfoPrintf(__VA_ARGS__))
+#define DebugPrintf(...) \
+	((void) sizeof(::frc973::DeferredLog::CheckFormat(__VA_ARGS__)), \
+	 ::frc973::DebugPrintf(__VA_ARGS__))
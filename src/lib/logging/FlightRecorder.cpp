@@ -0,0 +1,580 @@
+/*
+ * FlightRecorder.cpp
+ */
+
+#include "lib/logging/FlightRecorder.h"
+#include "lib/logging/BinaryLogFormat.h"
+#include "lib/util/Util.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <exception>
+
+namespace frc973 {
+
+namespace {
+
+/* flag a task registers with to get called in each phase */
+const uint32_t phaseFlags[NUM_TASK_PHASES] = {
+	TASK_START_MODE, TASK_STOP_MODE,
+	TASK_PRE_PERIODIC, TASK_PERIODIC, TASK_POST_PERIODIC
+};
+
+/* how long the writer sleeps before looking for a dump anyway */
+const uint32_t WRITER_POLL_MS = 100;
+
+FlightRecorder *terminateRecorder = nullptr;
+std::terminate_handler previousTerminate = nullptr;
+
+void DumpAndTerminate() {
+	if (terminateRecorder != nullptr) {
+		terminateRecorder->DumpNow(FLIGHT_TRIGGER_EXCEPTION);
+	}
+	if (previousTerminate != nullptr) {
+		previousTerminate();
+	}
+	abort();
+}
+
+bool WriteAll(int fd, const void *data, size_t size) {
+	const uint8_t *pos = (const uint8_t*) data;
+
+	while (size > 0) {
+		ssize_t ret = write(fd, pos, size);
+
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret <= 0) {
+			return false;
+		}
+		pos += ret;
+		size -= ret;
+	}
+	return true;
+}
+
+}
+
+FlightRecorder::FlightRecorder(TaskMgr *scheduler, LogSpreadsheet *logger,
+		uint32_t historyRows, uint32_t postTriggerRows,
+		const RTThreadConfig &writerConfig)
+	 : m_scheduler(scheduler)
+	 , m_logger(logger)
+	 , m_ringRows(historyRows + postTriggerRows)
+	 , m_postTriggerRows(postTriggerRows)
+	 , m_writerConfig(writerConfig)
+	 , m_columns()
+	 , m_recordSize(0)
+	 , m_initialized(false)
+	 , m_active(0)
+	 , m_rowNum(0)
+	 , m_pendingTriggers(0)
+	 , m_autoTriggers(FLIGHT_TRIGGER_DEFAULT)
+	 , m_dumpTriggers(0)
+	 , m_dumpStarted(false)
+	 , m_postRowsLeft(0)
+	 , m_brownoutCell(nullptr)
+	 , m_brownoutVolts(0.0)
+	 , m_brownedOut(false)
+	 , m_lastOverruns(0)
+	 , m_sawMode(false)
+	 , m_frozen(false)
+	 , m_threadRunning(false)
+	 , m_stop(false)
+	 , m_writing(-1)
+	 , m_writingTriggers(0)
+	 , m_numDumps(0)
+	 , m_droppedDumps(0)
+{
+	pthread_condattr_t attr;
+
+	if (m_ringRows < 1) {
+		m_ringRows = 1;
+	}
+	SetDirectory("/home/lvuser");
+	m_lastFileName[0] = '\0';
+	m_rings[0].rows = 0;
+	m_rings[1].rows = 0;
+
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&m_cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+FlightRecorder::~FlightRecorder() {
+	if (terminateRecorder == this) {
+		terminateRecorder = nullptr;
+	}
+	if (m_threadRunning) {
+		/* anything handed over is still written */
+		pthread_mutex_lock(&m_mutex);
+		m_stop = true;
+		pthread_cond_broadcast(&m_cond);
+		pthread_mutex_unlock(&m_mutex);
+		pthread_join(m_thread, NULL);
+	}
+	for (Column &column : m_columns) {
+		delete[] column.name;
+	}
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void FlightRecorder::SetDirectory(const char *directory) {
+	if (m_initialized) {
+		printf("You can't change the flight recorder directory after it has been initialized\n");
+		return;
+	}
+	strncpy(m_directory, directory, sizeof(m_directory) - 1);
+	m_directory[sizeof(m_directory) - 1] = '\0';
+}
+
+void FlightRecorder::SetBrownoutTrigger(LogCell *cell, double volts) {
+	if (m_initialized) {
+		printf("You can't change the brownout trigger after the flight recorder has been initialized\n");
+		return;
+	}
+	m_brownoutCell = cell;
+	m_brownoutVolts = volts;
+}
+
+void FlightRecorder::AddColumn(ColumnSource source, const char *name,
+		LogCellType type) {
+	Column column;
+
+	column.source = source;
+	column.cell = nullptr;
+	column.task = nullptr;
+	column.phase = PHASE_PERIODIC;
+	column.stats = nullptr;
+	column.name = new char[strlen(name) + 1];
+	strcpy(column.name, name);
+	column.type = type;
+	column.decimals = 0;
+	column.slotSize = BinaryLogSlotSize(type, 0);
+	column.offset = 0;
+	m_columns.push_back(column);
+}
+
+void FlightRecorder::Initialize() {
+	char name[64];
+
+	if (m_initialized) {
+		printf("You can only initialize a flight recorder once\n");
+		return;
+	}
+
+	for (int i = 0; i < m_logger->GetNumCells(); i++) {
+		LogCell *cell = m_logger->GetCell(i);
+
+		/* text cells have a single reader, and that's the spreadsheet */
+		if (cell->GetType() == LOG_CELL_TEXT) {
+			continue;
+		}
+		AddColumn(SOURCE_CELL, cell->GetName(), cell->GetType());
+		m_columns.back().cell = cell;
+		m_columns.back().decimals = cell->GetDecimals();
+	}
+
+	/* mode start/stop only happen a handful of times a match so only the
+	 * per-cycle callbacks get a column */
+	for (int i = 0; i < m_scheduler->GetNumTasks(); i++) {
+		for (int phase = PHASE_PRE_PERIODIC; phase < NUM_TASK_PHASES;
+				phase++) {
+			if (!(m_scheduler->GetTaskFlags(i) & phaseFlags[phase])) {
+				continue;
+			}
+			snprintf(name, sizeof(name), "%s %s us",
+					m_scheduler->GetTaskName(i), taskPhaseNames[phase]);
+			AddColumn(SOURCE_TASK, name, LOG_CELL_INT);
+			/* task stats live as long as the manager, so they're looked
+			 * up once rather than every row */
+			m_columns.back().task = m_scheduler->GetTask(i);
+			m_columns.back().phase = (TaskPhase) phase;
+			m_columns.back().stats = m_scheduler->GetTaskStats(
+					m_columns.back().task, (TaskPhase) phase);
+		}
+	}
+	AddColumn(SOURCE_CYCLE_TIME, "Cycle time us", LOG_CELL_INT);
+	m_columns.back().stats = &m_scheduler->GetCycleStats();
+	AddColumn(SOURCE_CYCLE_OVERRUNS, "Cycle overruns", LOG_CELL_INT);
+	AddColumn(SOURCE_TRIGGER, "Flight trigger", LOG_CELL_INT);
+
+	m_recordSize = sizeof(BinaryLogRecordHeader) + (m_columns.size() + 7) / 8;
+	for (Column &column : m_columns) {
+		column.offset = m_recordSize;
+		m_recordSize += column.slotSize;
+	}
+
+	m_rings[0].data.assign((size_t) m_ringRows * m_recordSize, 0);
+	m_rings[1].data.assign((size_t) m_ringRows * m_recordSize, 0);
+	m_lastOverruns = m_scheduler->GetCycleStats().GetOverruns();
+
+	m_stop = false;
+	if (pthread_create(&m_thread, NULL, WriterMain, this) == 0) {
+		m_threadRunning = true;
+	}
+	else {
+		fprintf(stderr, "FlightRecorder: couldn't start the writer thread, only DumpNow will work\n");
+	}
+
+	m_initialized.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::Trigger(uint32_t reasons) {
+	m_pendingTriggers.fetch_or(reasons, std::memory_order_relaxed);
+}
+
+void FlightRecorder::TaskStartMode(RobotMode mode) {
+	/* the first call is just the thread starting */
+	if (m_sawMode && (m_autoTriggers.load(std::memory_order_relaxed) &
+				FLIGHT_TRIGGER_MODE_CHANGE)) {
+		Trigger(FLIGHT_TRIGGER_MODE_CHANGE);
+	}
+	m_sawMode = true;
+}
+
+void FlightRecorder::TaskPeriodic(RobotMode mode) {
+	uint32_t autoTriggers, reasons, overruns;
+
+	if (!m_initialized.load(std::memory_order_acquire) ||
+			m_frozen.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	autoTriggers = m_autoTriggers.load(std::memory_order_relaxed);
+	reasons = m_pendingTriggers.exchange(0, std::memory_order_relaxed);
+
+	overruns = m_scheduler->GetCycleStats().GetOverruns();
+	if (overruns != m_lastOverruns) {
+		if (autoTriggers & FLIGHT_TRIGGER_OVERRUN) {
+			reasons |= FLIGHT_TRIGGER_OVERRUN;
+		}
+		m_lastOverruns = overruns;
+	}
+
+	if (m_brownoutCell != nullptr) {
+		uint8_t slot[sizeof(double)];
+		double volts;
+
+		if (m_brownoutCell->CopyValue(slot, false)) {
+			if (m_brownoutCell->GetType() == LOG_CELL_DOUBLE) {
+				memcpy(&volts, slot, sizeof(volts));
+			}
+			else {
+				int32_t val;
+				memcpy(&val, slot, sizeof(val));
+				volts = val;
+			}
+
+			if (volts < m_brownoutVolts && !m_brownedOut) {
+				if (autoTriggers & FLIGHT_TRIGGER_BROWNOUT) {
+					reasons |= FLIGHT_TRIGGER_BROWNOUT;
+				}
+				m_brownedOut = true;
+			}
+			else if (volts >= m_brownoutVolts) {
+				m_brownedOut = false;
+			}
+		}
+	}
+
+	RecordRow(mode, reasons);
+
+	m_dumpTriggers |= reasons;
+	if (m_dumpTriggers == 0) {
+		return;
+	}
+	if (!m_dumpStarted) {
+		m_dumpStarted = true;
+		m_postRowsLeft = m_postTriggerRows;
+	}
+	else if (m_postRowsLeft > 0) {
+		m_postRowsLeft--;
+	}
+	if (m_postRowsLeft == 0) {
+		FinishDump();
+	}
+}
+
+void FlightRecorder::RecordRow(RobotMode mode, uint32_t reasons) {
+	Ring &ring = m_rings[m_active];
+	uint32_t rows = ring.rows.load(std::memory_order_relaxed);
+	uint8_t *row = &ring.data[(size_t) (rows % m_ringRows) * m_recordSize];
+	BinaryLogRecordHeader *header = (BinaryLogRecordHeader*) row;
+	uint8_t *presence = row + sizeof(BinaryLogRecordHeader);
+
+	/* not a row until it's all there, in case DumpNow reads it */
+	header->sync = 0;
+	header->row = m_rowNum++;
+	header->timeUs = GetUsecTime();
+	header->mode = mode;
+	memset(header->reserved, 0, sizeof(header->reserved));
+	header->size = m_recordSize;
+	memset(presence, 0, (m_columns.size() + 7) / 8);
+
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		const Column &column = m_columns[i];
+		uint8_t *slot = row + column.offset;
+		const TaskStats *stats = column.stats;
+		bool present = false;
+		int32_t val = 0;
+
+		switch (column.source) {
+			case SOURCE_CELL:
+				present = column.cell->CopyValue(slot, false);
+				break;
+			case SOURCE_TASK:
+			case SOURCE_CYCLE_TIME:
+				break;
+			case SOURCE_CYCLE_OVERRUNS:
+				val = m_scheduler->GetCycleStats().GetOverruns();
+				present = true;
+				break;
+			case SOURCE_TRIGGER:
+				val = reasons;
+				present = reasons != 0;
+				break;
+		}
+		if (stats != nullptr && stats->GetCount() != 0) {
+			val = stats->GetLastUs();
+			present = true;
+		}
+
+		if (column.source != SOURCE_CELL) {
+			memcpy(slot, &val, sizeof(val));
+		}
+		if (present) {
+			presence[i / 8] |= 1 << (i % 8);
+		}
+	}
+
+	header->sync = BINARY_LOG_ROW_SYNC;
+	ring.rows.store(rows + 1, std::memory_order_release);
+}
+
+void FlightRecorder::FinishDump() {
+	if (m_writing.load(std::memory_order_acquire) >= 0) {
+		/* the writer still has the other ring; keep recording into this
+		 * one and try again with the next trigger */
+		m_droppedDumps.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		Ring &ring = m_rings[m_active];
+		Ring &older = m_rings[m_active ^ 1];
+		uint32_t rows = ring.rows.load(std::memory_order_relaxed);
+		int handed = m_active;
+
+		if (rows < m_ringRows && older.rows.load(std::memory_order_relaxed) != 0) {
+			/* not a full ring since the last switch: carry these rows on
+			 * from the end of the other ring, which holds the ones before
+			 * them, and hand that over instead */
+			uint32_t olderRows = older.rows.load(std::memory_order_relaxed);
+
+			for (uint32_t i = 0; i < rows; i++) {
+				memcpy(&older.data[(size_t) ((olderRows + i) % m_ringRows) *
+						m_recordSize], &ring.data[(size_t) i * m_recordSize],
+						m_recordSize);
+			}
+			older.rows.store(olderRows + rows, std::memory_order_release);
+			ring.rows.store(0, std::memory_order_relaxed);
+			handed = m_active ^ 1;
+		}
+
+		m_writingTriggers = m_dumpTriggers;
+		m_writing.store(handed, std::memory_order_release);
+
+		/* the writer looks every WRITER_POLL_MS anyway, so never wait on
+		 * it for the lock */
+		if (pthread_mutex_trylock(&m_mutex) == 0) {
+			pthread_cond_broadcast(&m_cond);
+			pthread_mutex_unlock(&m_mutex);
+		}
+
+		if (handed == m_active) {
+			m_active ^= 1;
+			m_rings[m_active].rows.store(0, std::memory_order_relaxed);
+		}
+	}
+	m_dumpTriggers = 0;
+	m_dumpStarted = false;
+}
+
+bool FlightRecorder::DumpNow(uint32_t reasons) {
+	char fileName[sizeof(m_lastFileName)];
+
+	if (!m_initialized.load(std::memory_order_acquire)) {
+		return false;
+	}
+	m_frozen.store(true, std::memory_order_relaxed);
+
+	/* the other ring holds the rows before the last switch */
+	if (!WriteDump(&m_rings[m_active ^ 1], m_rings[m_active], reasons,
+				fileName, sizeof(fileName))) {
+		m_droppedDumps.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	strcpy(m_lastFileName, fileName);
+	m_numDumps.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void FlightRecorder::DumpOnTerminate(FlightRecorder *recorder) {
+	if (terminateRecorder == nullptr) {
+		previousTerminate = std::set_terminate(DumpAndTerminate);
+	}
+	terminateRecorder = recorder;
+}
+
+void FlightRecorder::WaitForDumps() {
+	pthread_mutex_lock(&m_mutex);
+	while (m_threadRunning && m_writing.load(std::memory_order_acquire) >= 0) {
+		pthread_cond_wait(&m_cond, &m_mutex);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+const uint8_t *FlightRecorder::GetRow(const Ring &ring, uint32_t row) const {
+	return &ring.data[(size_t) (row % m_ringRows) * m_recordSize];
+}
+
+bool FlightRecorder::WriteRows(int fd, const Ring &ring, uint32_t count) const {
+	uint32_t rows = ring.rows.load(std::memory_order_acquire);
+	uint32_t first = (rows - count) % m_ringRows;
+	uint32_t tailRows = m_ringRows - first < count ? m_ringRows - first : count;
+
+	/* oldest first: the end of the ring, then the start of it */
+	return WriteAll(fd, GetRow(ring, first), (size_t) tailRows * m_recordSize) &&
+		WriteAll(fd, &ring.data[0], (size_t) (count - tailRows) * m_recordSize);
+}
+
+bool FlightRecorder::WriteDump(const Ring *older, const Ring &ring,
+		uint32_t reasons, char *fileName, size_t size) {
+	uint32_t rows = ring.rows.load(std::memory_order_acquire);
+	uint32_t count = rows < m_ringRows ? rows : m_ringRows;
+	uint32_t olderRows = older != nullptr ?
+		older->rows.load(std::memory_order_acquire) : 0;
+	uint32_t olderCount = olderRows < m_ringRows - count ?
+		olderRows : m_ringRows - count;
+	const BinaryLogRecordHeader *oldest, *newest;
+	BinaryLogHeader header;
+	uint32_t headerSize = sizeof(BinaryLogHeader);
+	bool ok;
+	int fd;
+
+	if (count + olderCount == 0) {
+		return false;
+	}
+	oldest = (const BinaryLogRecordHeader*) (olderCount != 0 ?
+		GetRow(*older, olderRows - olderCount) : GetRow(ring, rows - count));
+	newest = (const BinaryLogRecordHeader*) (count != 0 ?
+		GetRow(ring, rows - 1) : GetRow(*older, olderRows - 1));
+
+	snprintf(fileName, size, "%s/log-flight-%llu.bin", m_directory,
+			(unsigned long long) newest->timeUs);
+	fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Could not open file `%s` for writing.  Errno %d (%s)\n",
+				fileName, errno, strerror(errno));
+		return false;
+	}
+
+	for (const Column &column : m_columns) {
+		headerSize += sizeof(BinaryLogColumn) + strlen(column.name);
+	}
+	header.magic = BINARY_LOG_MAGIC;
+	header.version = BINARY_LOG_VERSION;
+	header.numColumns = m_columns.size();
+	header.headerSize = headerSize;
+	header.recordSize = m_recordSize;
+	header.startTimeUs = oldest->timeUs;
+	ok = WriteAll(fd, &header, sizeof(header));
+
+	for (const Column &column : m_columns) {
+		BinaryLogColumn desc;
+
+		desc.type = column.type;
+		desc.flags = 0;
+		desc.slotSize = column.slotSize;
+		desc.nameLen = strlen(column.name);
+		desc.sampling = LOG_SAMPLE_EVERY_ROW;
+		desc.decimals = column.decimals;
+		ok = ok && WriteAll(fd, &desc, sizeof(desc)) &&
+			WriteAll(fd, column.name, desc.nameLen);
+	}
+
+	ok = ok && (olderCount == 0 || WriteRows(fd, *older, olderCount)) &&
+		WriteRows(fd, ring, count);
+
+	fdatasync(fd);
+	close(fd);
+	if (!ok) {
+		fprintf(stderr, "FlightRecorder: write to `%s` failed: %s\n",
+				fileName, strerror(errno));
+		return false;
+	}
+	fprintf(stderr, "FlightRecorder: wrote %u rows to %s (triggers 0x%x)\n",
+			olderCount + count, fileName, reasons);
+	return true;
+}
+
+void *FlightRecorder::WriterMain(void *p) {
+	FlightRecorder *recorder = static_cast<FlightRecorder*>(p);
+
+	RTThread::Configure(recorder->m_writerConfig);
+	recorder->WriterLoop();
+	return NULL;
+}
+
+void FlightRecorder::WriterLoop() {
+	struct timespec deadline;
+
+	pthread_mutex_lock(&m_mutex);
+	for (;;) {
+		char fileName[sizeof(m_lastFileName)];
+		int ring;
+		bool written;
+
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_nsec += WRITER_POLL_MS * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+
+		ring = m_writing.load(std::memory_order_acquire);
+		if (ring < 0 && m_stop) {
+			break;
+		}
+		if (ring < 0) {
+			pthread_cond_timedwait(&m_cond, &m_mutex, &deadline);
+			continue;
+		}
+		pthread_mutex_unlock(&m_mutex);
+
+		written = WriteDump(nullptr, m_rings[ring], m_writingTriggers,
+				fileName, sizeof(fileName));
+
+		pthread_mutex_lock(&m_mutex);
+		if (written) {
+			strcpy(m_lastFileName, fileName);
+			m_numDumps.fetch_add(1, std::memory_order_relaxed);
+		}
+		else {
+			m_droppedDumps.fetch_add(1, std::memory_order_relaxed);
+		}
+		m_writing.store(-1, std::memory_order_release);
+		pthread_cond_broadcast(&m_cond);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+}
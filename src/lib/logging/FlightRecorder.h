@@ -0,0 +1,308 @@
+/*
+ * FlightRecorder.h
+ *
+ * FlightRecorder - keeps the last few seconds of every numeric LogCell
+ * and of the task timing in RAM, sampled faster than the log, and writes
+ * them out only when something worth a post-mortem happens.
+ *
+ * Run it as a periodic task on a thread of its own (at 200Hz, say).  Each
+ * period it copies the raw value of every LOG_CELL_DOUBLE and LOG_CELL_INT
+ * cell registered with the LogSpreadsheet, plus the last time taken by
+ * every per-cycle callback of the watched TaskMgr and by its whole cycle,
+ * into a ring of rows laid out as in BinaryLogFormat.h.  Numeric cells are
+ * plain atomic reads, so nothing the loop does waits on the recorder.
+ * Text cells are left out; only the spreadsheet may read those.
+ *
+ * A trigger (a brownout, an uncaught exception, a mode change, a driver
+ * button or, if asked for, a cycle overrun) lets the recorder carry on for a few more
+ * rows and then hands the whole ring, history before the trigger
+ * included, to a low priority writer thread.  Recording goes on in a
+ * second ring meanwhile, so the dump costs the recorder no copying.  A
+ * dump handed over before that ring has filled copies its rows onto the
+ * end of the first ring, once written, to keep the history from before
+ * the switch.  Triggers coming in before a dump is handed over are
+ * folded into it.  A dump finishing while the writer is still busy with
+ * the last one is dropped and counted.
+ *
+ * Each dump is an ordinary binary log, <directory>/log-flight-<time>.bin,
+ * so logtocsv and logquery read it and the log disk budget covers it.
+ * The "Flight trigger" column holds the FlightTrigger bits on the row
+ * each trigger came in.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "lib/CoopTask.h"
+#include "lib/TaskMgr.h"
+#include "lib/RTThread.h"
+#include "lib/logging/LogSpreadsheet.h"
+
+namespace frc973 {
+
+/**
+ * Why a dump was written.  A dump can have more than one.
+ */
+enum FlightTrigger {
+	FLIGHT_TRIGGER_BROWNOUT = 1,		/* voltage fell below the threshold */
+	FLIGHT_TRIGGER_EXCEPTION = 2,		/* std::terminate was called */
+	FLIGHT_TRIGGER_MODE_CHANGE = 4,		/* the robot changed mode */
+	FLIGHT_TRIGGER_BUTTON = 8,			/* somebody asked for one */
+	FLIGHT_TRIGGER_OVERRUN = 16			/* the watched loop overran */
+};
+
+static constexpr uint32_t FLIGHT_TRIGGER_ALL = 0x1f;
+
+/**
+ * Triggers checked unless SetAutoTriggers says otherwise.  Overruns are
+ * left out: a loop that keeps overrunning would fill the disk with a dump
+ * every ring's worth of rows.
+ */
+static constexpr uint32_t FLIGHT_TRIGGER_DEFAULT =
+	FLIGHT_TRIGGER_ALL & ~FLIGHT_TRIGGER_OVERRUN;
+
+class FlightRecorder : public CoopTask {
+public:
+	/**
+	 * Create a recorder.  Nothing is recorded until Initialize.
+	 *
+	 * @param scheduler task manager whose task timing is recorded and
+	 *     whose cycle overruns trigger a dump
+	 * @param logger spreadsheet whose numeric cells are recorded
+	 * @param historyRows rows kept from before a trigger
+	 * @param postTriggerRows rows recorded after a trigger before the dump
+	 *     is written
+	 * @param writerConfig real-time setup of the thread writing dumps
+	 */
+	FlightRecorder(TaskMgr *scheduler, LogSpreadsheet *logger,
+			uint32_t historyRows, uint32_t postTriggerRows,
+			const RTThreadConfig &writerConfig = {"flight writer", 0, -1, 0});
+	virtual ~FlightRecorder();
+
+	/**
+	 * Choose the directory dumps go in (/home/lvuser by default).  Must be
+	 * called before Initialize.
+	 */
+	void SetDirectory(const char *directory);
+
+	/**
+	 * Trigger a dump when |cell| (a numeric cell registered with the
+	 * spreadsheet, usually the battery voltage) falls below |volts|.  It
+	 * triggers again only after going back above it.  Must be called
+	 * before Initialize.
+	 */
+	void SetBrownoutTrigger(LogCell *cell, double volts);
+
+	/**
+	 * Choose which of the triggers the recorder checks for itself
+	 * (FLIGHT_TRIGGER_BROWNOUT, _MODE_CHANGE and _OVERRUN bits;
+	 * FLIGHT_TRIGGER_DEFAULT, all but overruns, by default).  Trigger
+	 * always works.
+	 */
+	void SetAutoTriggers(uint32_t triggers) {
+		m_autoTriggers.store(triggers, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Lay out the rows, allocate both rings and start the writer thread.
+	 * Call after every cell and task has been registered (after
+	 * LogSpreadsheet::InitializeTable is fine).
+	 */
+	void Initialize();
+
+	/**
+	 * Ask for a dump.  Safe from any thread; never blocks.
+	 *
+	 * @param reasons FlightTrigger bits
+	 */
+	void Trigger(uint32_t reasons);
+
+	/**
+	 * Write the ring being recorded into right away, on the calling
+	 * thread, and stop recording.  For when the process is about to die
+	 * and a dump handed to the writer thread would never be written.
+	 *
+	 * @return false if the dump couldn't be written
+	 */
+	bool DumpNow(uint32_t reasons);
+
+	/**
+	 * Make |recorder| DumpNow with FLIGHT_TRIGGER_EXCEPTION if the process
+	 * terminates because of an uncaught exception (or anything else that
+	 * calls std::terminate).  The terminate handler in place before is
+	 * called afterwards.
+	 */
+	static void DumpOnTerminate(FlightRecorder *recorder);
+
+	/**
+	 * Wait until every dump handed to the writer thread so far is
+	 * written
+	 */
+	void WaitForDumps();
+
+	/**
+	 * Dumps written so far
+	 */
+	uint32_t GetNumDumps() const {
+		return m_numDumps.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Dumps lost because the writer was still busy with the last one, or
+	 * because the file couldn't be written
+	 */
+	uint32_t GetDroppedDumps() const {
+		return m_droppedDumps.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Path of the last dump written, or an empty string.  Only
+	 * meaningful once WaitForDumps has returned.
+	 */
+	const char *GetLastDumpFileName() const {
+		return m_lastFileName;
+	}
+
+	/**
+	 * Bytes in each recorded row (see BinaryLogFormat.h)
+	 */
+	uint32_t GetRecordSize() const {
+		return m_recordSize;
+	}
+
+	void TaskStartMode(RobotMode mode) override;
+
+	/**
+	 * Record a row and check the triggers
+	 */
+	void TaskPeriodic(RobotMode mode) override;
+
+private:
+	/**
+	 * Where a recorded column's value comes from
+	 */
+	enum ColumnSource {
+		SOURCE_CELL,
+		SOURCE_TASK,
+		SOURCE_CYCLE_TIME,
+		SOURCE_CYCLE_OVERRUNS,
+		SOURCE_TRIGGER
+	};
+
+	struct Column {
+		ColumnSource source;
+		LogCell *cell;
+		CoopTask *task;
+		TaskPhase phase;
+		const TaskStats *stats;	/* SOURCE_TASK and SOURCE_CYCLE_TIME */
+		char *name;				/* owned */
+		LogCellType type;
+		uint8_t decimals;
+		uint16_t slotSize;
+		uint32_t offset;
+	};
+
+	/**
+	 * One of the two rings.  |rows| counts every row written into it
+	 * since it was last emptied; the newest is at (rows - 1) % ringRows.
+	 */
+	struct Ring {
+		std::vector<uint8_t> data;
+		std::atomic<uint32_t> rows;
+	};
+
+	void AddColumn(ColumnSource source, const char *name, LogCellType type);
+
+	/**
+	 * Fill in the next row of the ring being recorded into
+	 */
+	void RecordRow(RobotMode mode, uint32_t reasons);
+
+	/**
+	 * Hand the ring being recorded into to the writer thread and switch
+	 * to the other one, or count the dump as dropped if the writer is
+	 * still busy.  A ring that hasn't filled since the last switch is
+	 * first carried on from the end of the other one, which is handed
+	 * over in its place.
+	 */
+	void FinishDump();
+
+	/**
+	 * Row |row| of |ring|, counted as |rows| counts them
+	 */
+	const uint8_t *GetRow(const Ring &ring, uint32_t row) const;
+
+	/**
+	 * Write the newest |count| rows of |ring| to |fd|, oldest first
+	 */
+	bool WriteRows(int fd, const Ring &ring, uint32_t count) const;
+
+	/**
+	 * Write the rows of |ring| out as a binary log, after as many of the
+	 * newest rows of |older|, if given, as still fit in a ring
+	 *
+	 * @param reasons FlightTrigger bits, for the console
+	 * @param fileName filled with the path written
+	 */
+	bool WriteDump(const Ring *older, const Ring &ring, uint32_t reasons,
+			char *fileName, size_t size);
+
+	static void *WriterMain(void *p);
+	void WriterLoop();
+
+	FlightRecorder(const FlightRecorder&) = delete;
+	FlightRecorder &operator=(const FlightRecorder&) = delete;
+
+	TaskMgr *m_scheduler;
+	LogSpreadsheet *m_logger;
+	uint32_t m_ringRows;
+	uint32_t m_postTriggerRows;
+	RTThreadConfig m_writerConfig;
+	char m_directory[64];
+
+	std::vector<Column> m_columns;
+	uint32_t m_recordSize;
+	std::atomic<bool> m_initialized;
+
+	Ring m_rings[2];
+	int m_active;
+	uint32_t m_rowNum;
+
+	/* triggers asked for but not yet in a row, and those in the dump
+	 * being recorded.  The dump is started on the row a trigger comes
+	 * in and handed over m_postRowsLeft rows later. */
+	std::atomic<uint32_t> m_pendingTriggers;
+	std::atomic<uint32_t> m_autoTriggers;
+	uint32_t m_dumpTriggers;
+	bool m_dumpStarted;
+	uint32_t m_postRowsLeft;
+
+	LogCell *m_brownoutCell;
+	double m_brownoutVolts;
+	bool m_brownedOut;
+	uint32_t m_lastOverruns;
+	bool m_sawMode;
+
+	/* set by DumpNow so the recorder leaves the ring alone */
+	std::atomic<bool> m_frozen;
+
+	/* ring waiting for (or being written by) the writer thread, -1 for
+	 * none, and why it's being written */
+	pthread_t m_thread;
+	bool m_threadRunning;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	bool m_stop;
+	std::atomic<int> m_writing;
+	uint32_t m_writingTriggers;
+
+	std::atomic<uint32_t> m_numDumps;
+	std::atomic<uint32_t> m_droppedDumps;
+	char m_lastFileName[160];
+};
+
+}
@@ -0,0 +1,204 @@
+/*
+ * LogCompression.cpp
+ */
+
+#include "lib/logging/LogCompression.h"
+
+#include <string.h>
+
+namespace frc973 {
+
+namespace {
+
+/* a match has to be at least this long to be worth a sequence */
+constexpr size_t LZ_MIN_MATCH = 4;
+constexpr size_t LZ_MAX_OFFSET = 65535;
+
+inline uint32_t Read32(const uint8_t *p) {
+	uint32_t val;
+	memcpy(&val, p, sizeof(val));
+	return val;
+}
+
+inline uint32_t Hash(uint32_t val) {
+	return (val * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+ * Write the part of a length that doesn't fit in its nibble
+ */
+inline uint8_t *WriteLength(uint8_t *op, size_t len) {
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = len;
+	return op;
+}
+
+/**
+ * Read the part of a length that didn't fit in its nibble
+ *
+ * @return false if the input ran out first
+ */
+inline bool ReadLength(const uint8_t **ip, const uint8_t *end, size_t *len) {
+	uint8_t b;
+
+	do {
+		if (*ip >= end) {
+			return false;
+		}
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/**
+ * Write one sequence: a token, |numLiterals| literal bytes and, unless
+ * this is the last sequence, a match of |matchLen| bytes |offset| back
+ */
+uint8_t *WriteSequence(uint8_t *op, const uint8_t *literals,
+		size_t numLiterals, size_t offset, size_t matchLen, bool last) {
+	uint8_t *token = op++;
+	size_t matchCode = last ? 0 : matchLen - LZ_MIN_MATCH;
+
+	*token = (numLiterals < 15 ? numLiterals : 15) << 4;
+	if (numLiterals >= 15) {
+		op = WriteLength(op, numLiterals - 15);
+	}
+	memcpy(op, literals, numLiterals);
+	op += numLiterals;
+
+	if (!last) {
+		*token |= matchCode < 15 ? matchCode : 15;
+		*op++ = offset & 0xff;
+		*op++ = offset >> 8;
+		if (matchCode >= 15) {
+			op = WriteLength(op, matchCode - 15);
+		}
+	}
+	return op;
+}
+
+}
+
+void LogRowsEncode(const uint8_t *rows, uint32_t numRows,
+		uint32_t recordSize, uint8_t *out) {
+	for (uint32_t b = 0; b < recordSize; b++) {
+		uint8_t prev = 0;
+
+		for (uint32_t r = 0; r < numRows; r++) {
+			uint8_t cur = rows[r * recordSize + b];
+
+			*out++ = cur ^ prev;
+			prev = cur;
+		}
+	}
+}
+
+void LogRowsDecode(const uint8_t *in, uint32_t numRows,
+		uint32_t recordSize, uint8_t *rows) {
+	for (uint32_t b = 0; b < recordSize; b++) {
+		uint8_t prev = 0;
+
+		for (uint32_t r = 0; r < numRows; r++) {
+			prev ^= *in++;
+			rows[r * recordSize + b] = prev;
+		}
+	}
+}
+
+size_t LzCompress(const uint8_t *in, size_t size, uint8_t *out,
+		uint32_t *hashTable) {
+	uint8_t *op = out;
+	size_t anchor = 0;
+	size_t ip = 0;
+
+	memset(hashTable, 0, LZ_HASH_ENTRIES * sizeof(uint32_t));
+
+	while (ip + LZ_MIN_MATCH <= size) {
+		uint32_t val = Read32(in + ip);
+		uint32_t *entry = &hashTable[Hash(val)];
+		size_t ref = *entry;
+		size_t len;
+
+		*entry = ip;
+		if (ref >= ip || ip - ref > LZ_MAX_OFFSET || Read32(in + ref) != val) {
+			ip++;
+			continue;
+		}
+
+		len = LZ_MIN_MATCH;
+		while (ip + len < size && in[ref + len] == in[ip + len]) {
+			len++;
+		}
+
+		op = WriteSequence(op, in + anchor, ip - anchor, ip - ref, len, false);
+		ip += len;
+		anchor = ip;
+	}
+
+	op = WriteSequence(op, in + anchor, size - anchor, 0, 0, true);
+	return op - out;
+}
+
+long LzDecompress(const uint8_t *in, size_t size, uint8_t *out,
+		size_t outSize) {
+	const uint8_t *ip = in;
+	const uint8_t *end = in + size;
+	size_t op = 0;
+
+	while (ip < end) {
+		uint8_t token = *ip++;
+		size_t numLiterals = token >> 4;
+		size_t matchLen = token & 15;
+		size_t offset;
+
+		if (numLiterals == 15 && !ReadLength(&ip, end, &numLiterals)) {
+			return -1;
+		}
+		if (numLiterals > (size_t) (end - ip) || numLiterals > outSize - op) {
+			return -1;
+		}
+		memcpy(out + op, ip, numLiterals);
+		ip += numLiterals;
+		op += numLiterals;
+
+		/* the last sequence is just literals */
+		if (ip == end) {
+			return op;
+		}
+
+		if (end - ip < 2) {
+			return -1;
+		}
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (matchLen == 15 && !ReadLength(&ip, end, &matchLen)) {
+			return -1;
+		}
+		matchLen += LZ_MIN_MATCH;
+		if (offset == 0 || offset > op || matchLen > outSize - op) {
+			return -1;
+		}
+
+		/* byte at a time, since a match can overlap what it's copying */
+		for (size_t i = 0; i < matchLen; i++) {
+			out[op + i] = out[op + i - offset];
+		}
+		op += matchLen;
+	}
+	return -1;
+}
+
+uint32_t LogBlockChecksum(const uint8_t *data, size_t size) {
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * LogCompression.h
+ *
+ * Block compression for binary logs (LOG_FORMAT_COMPRESSED), shared by
+ * the log writer on the robot and the host tools.  Free of WPILib.
+ *
+ * A block of rows is compressed in two steps:
+ *
+ *   1. Each row is XORed with the row before it, and the result is
+ *      transposed so byte 0 of every row comes first, then byte 1 of
+ *      every row, and so on.  Columns that didn't change turn into runs
+ *      of zeros, and a slowly changing double only differs from the last
+ *      row in its low mantissa bytes, so its sign/exponent bytes become
+ *      zeros too.
+ *   2. The result goes through a small LZ77 codec in the style of LZ4
+ *      (byte aligned sequences, 64K window, no entropy coding), which
+ *      squeezes those runs down to a few bytes.
+ *
+ * Every block starts from scratch (the first row is XORed with zeros and
+ * the LZ window is empty), so any block can be decoded on its own.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace frc973 {
+
+/**
+ * Entries in the hash table LzCompress needs
+ */
+static constexpr int LZ_HASH_BITS = 12;
+static constexpr int LZ_HASH_ENTRIES = 1 << LZ_HASH_BITS;
+
+/**
+ * XOR each of |numRows| rows of |recordSize| bytes with the row before it
+ * and write them out transposed.  |out| must hold numRows * recordSize
+ * bytes.
+ */
+void LogRowsEncode(const uint8_t *rows, uint32_t numRows,
+		uint32_t recordSize, uint8_t *out);
+
+/**
+ * Undo LogRowsEncode
+ */
+void LogRowsDecode(const uint8_t *in, uint32_t numRows,
+		uint32_t recordSize, uint8_t *rows);
+
+/**
+ * Most bytes LzCompress can produce from |size| bytes
+ */
+inline size_t LzCompressBound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+/**
+ * Compress |size| bytes of |in| into |out|, which must hold
+ * LzCompressBound(size) bytes.
+ *
+ * @param hashTable scratch space of LZ_HASH_ENTRIES entries, so nothing
+ *     is allocated here
+ *
+ * @return compressed size
+ */
+size_t LzCompress(const uint8_t *in, size_t size, uint8_t *out,
+		uint32_t *hashTable);
+
+/**
+ * Decompress |size| bytes of |in| into |out|.  Never reads or writes out
+ * of bounds, even on corrupt input.
+ *
+ * @return decompressed size, or -1 if |in| is corrupt or would decompress
+ *     to more than |outSize| bytes
+ */
+long LzDecompress(const uint8_t *in, size_t size, uint8_t *out,
+		size_t outSize);
+
+/**
+ * Checksum stored with each block (32 bit FNV-1a)
+ */
+uint32_t LogBlockChecksum(const uint8_t *data, size_t size);
+
+}
@@ -7,6 +7,8 @@
 
 #include "lib/logging/LogSpreadsheet.h"
 #include "lib/CoopTask.h"
+#include "lib/util/Util.h"
+#include "lib/util/NumberFormat.h"
 
 #include "WPILib.h"
 
@@ -18,21 +20,54 @@
 
 namespace frc973 {
 
+std::atomic<uint32_t> LogCell::s_rejectedWrites(0);
+
 LogCell::LogCell(const char *name,
 	uint32_t size,
 	uint32_t flags):
-		m_buffer(new char[size]),
 		m_name(name),
 		m_buffSize(size),
 		m_flags(flags),
-		m_mutex(){
-	pthread_mutex_init(&m_mutex, NULL);
-	this->ClearCell();
+		m_type(LOG_CELL_TEXT),
+		m_decimals(FORMAT_DEFAULT_DECIMALS),
+		m_reportedRejected(false),
+		m_value(0),
+		m_writes(0),
+		m_clearedWrites(0),
+		m_text(new char[3 * size]),
+		m_textIndex(1),
+		m_backIndex(0),
+		m_frontIndex(2),
+		m_frontUnread(false) {
+	for (int i = 0; i < 3; i++) {
+		TextBuffer(i)[0] = '\0';
+	}
+}
+
+LogCell::LogCell(const char *name,
+	LogCellType type,
+	uint32_t flags):
+		m_name(name),
+		m_buffSize(DEFAULT_MAX_LOG_CELL_SIZE),
+		m_flags(flags),
+		m_type(type),
+		m_decimals(FORMAT_DEFAULT_DECIMALS),
+		m_reportedRejected(false),
+		m_value(0),
+		m_writes(0),
+		m_clearedWrites(0),
+		m_text(new char[3 * DEFAULT_MAX_LOG_CELL_SIZE]),
+		m_textIndex(1),
+		m_backIndex(0),
+		m_frontIndex(2),
+		m_frontUnread(false) {
+	for (int i = 0; i < 3; i++) {
+		TextBuffer(i)[0] = '\0';
+	}
 }
 
 LogCell::~LogCell() {
-	pthread_mutex_destroy(&m_mutex);
-	delete[] m_buffer;
+	delete[] m_text;
 }
 
 void LogCell::LogText(const char *text) {
@@ -40,11 +75,46 @@ void LogCell::LogText(const char *text) {
 }
 
 void LogCell::LogInt(int val) {
-	this->LogPrintf("%d", val);
+	switch (m_type) {
+		case LOG_CELL_INT:
+			PublishValue((uint32_t) val);
+			break;
+		case LOG_CELL_DOUBLE:
+			LogDouble(val);
+			break;
+		default:
+			FormatInt(val, TextBuffer(m_backIndex), m_buffSize);
+			PublishText();
+			break;
+	}
 }
 
 void LogCell::LogDouble(double val) {
-	this->LogPrintf("%lf", val);
+	uint64_t bits;
+
+	switch (m_type) {
+		case LOG_CELL_DOUBLE:
+			memcpy(&bits, &val, sizeof(bits));
+			PublishValue(bits);
+			break;
+		case LOG_CELL_INT:
+			LogInt((int) val);
+			break;
+		default:
+			FormatFixed(val, m_decimals, TextBuffer(m_backIndex), m_buffSize);
+			PublishText();
+			break;
+	}
+}
+
+void LogCell::SetDecimals(int decimals) {
+	if (decimals < 1) {
+		decimals = 1;
+	}
+	else if (decimals > FORMAT_MAX_FAST_DECIMALS) {
+		decimals = FORMAT_MAX_FAST_DECIMALS;
+	}
+	m_decimals = decimals;
 }
 
 /**
@@ -53,43 +123,151 @@ void LogCell::LogDouble(double val) {
  */
 void LogCell::LogPrintf(const char *formatstr, ...) {
 	va_list args;
-	va_start (args, formatstr);
 
-	AcquireLock();
-	vsnprintf(m_buffer, m_buffSize, formatstr, args);
-	ReleaseLock();
+	if (m_type != LOG_CELL_TEXT) {
+		/* the row has no room for text here; say so rather than
+		 * quietly logging nothing */
+		s_rejectedWrites.fetch_add(1, std::memory_order_relaxed);
+		if (!m_reportedRejected) {
+			fprintf(stderr, "LogCell %s: numeric cell given text (\"%s\"), "
+					"logged as empty\n", m_name, formatstr);
+			m_reportedRejected = true;
+		}
+		ClearCell();
+		return;
+	}
 
+	va_start (args, formatstr);
+	vsnprintf(TextBuffer(m_backIndex), m_buffSize, formatstr, args);
 	va_end (args);
+
+	PublishText();
+}
+
+void LogCell::PublishValue(uint64_t bits) {
+	m_value.store(bits, std::memory_order_relaxed);
+	m_writes.fetch_add(1, std::memory_order_release);
+}
+
+void LogCell::PublishText() {
+	m_backIndex = m_textIndex.exchange(m_backIndex | TEXT_FRESH,
+			std::memory_order_acq_rel) & ~TEXT_FRESH;
 }
 
 const char* LogCell::GetName() {
 	return m_name;
 }
 
+const char *LogCell::ReadText(bool consume) {
+	if (m_textIndex.load(std::memory_order_relaxed) & TEXT_FRESH) {
+		m_frontIndex = m_textIndex.exchange(m_frontIndex,
+				std::memory_order_acq_rel) & ~TEXT_FRESH;
+		m_frontUnread = true;
+	}
+	if (consume && !m_frontUnread) {
+		return "";
+	}
+	return TextBuffer(m_frontIndex);
+}
+
 const char *LogCell::GetContent() {
-	return m_buffer;
+	char *front;
+	uint64_t bits;
+	double d;
+
+	if (m_type == LOG_CELL_TEXT) {
+		return ReadText(ClearOnRead());
+	}
+
+	/* numeric cells never publish text, so the front buffer is free for
+	 * the reader to format into */
+	front = TextBuffer(m_frontIndex);
+	front[0] = '\0';
+	if (m_writes.load(std::memory_order_acquire) !=
+			m_clearedWrites.load(std::memory_order_relaxed)) {
+		bits = m_value.load(std::memory_order_relaxed);
+		if (m_type == LOG_CELL_DOUBLE) {
+			memcpy(&d, &bits, sizeof(d));
+			FormatFixed(d, m_decimals, front, m_buffSize);
+		}
+		else {
+			FormatInt((int32_t) bits, front, m_buffSize);
+		}
+	}
+	return front;
+}
+
+bool LogCell::CopyValue(void *slot, bool consume) {
+	uint32_t writes, cleared;
+	uint64_t bits;
+	int32_t i;
+	const char *text;
+
+	if (m_type == LOG_CELL_TEXT) {
+		text = ReadText(consume);
+		strncpy((char*) slot, text, m_buffSize);
+		if (consume) {
+			m_frontUnread = false;
+		}
+		return text[0] != '\0';
+	}
+
+	writes = m_writes.load(std::memory_order_acquire);
+	cleared = m_clearedWrites.load(std::memory_order_relaxed);
+	bits = m_value.load(std::memory_order_relaxed);
+	if (m_type == LOG_CELL_DOUBLE) {
+		memcpy(slot, &bits, sizeof(double));
+	}
+	else {
+		i = (int32_t) bits;
+		memcpy(slot, &i, sizeof(int32_t));
+	}
+
+	if (writes == cleared) {
+		return false;
+	}
+	if (consume) {
+		/* if the writer cleared the cell meanwhile, its clear wins */
+		m_clearedWrites.compare_exchange_strong(cleared, writes,
+				std::memory_order_relaxed);
+	}
+	return true;
 }
 
 void LogCell::ClearCell() {
-	m_buffer[0] = '\0';
+	if (m_type == LOG_CELL_TEXT) {
+		TextBuffer(m_backIndex)[0] = '\0';
+		PublishText();
+	}
+	else {
+		m_clearedWrites.store(m_writes.load(std::memory_order_relaxed),
+				std::memory_order_relaxed);
+	}
 }
 
-LogSpreadsheet::LogSpreadsheet(TaskMgr *scheduler):
+LogSpreadsheet::LogSpreadsheet(TaskMgr *scheduler,
+		const RTThreadConfig &writerConfig):
 		m_cells(),
-		m_oFile(NULL),
+		m_sampling(),
+		m_lastValues(),
+		m_haveLastValue(),
+		m_writer(writerConfig),
 		m_scheduler(scheduler),
 		m_initialized(false),
-		m_mode(RobotMode::MODE_DISABLED)
+		m_mode(RobotMode::MODE_DISABLED),
+		m_format(LOG_FORMAT_CSV),
+		m_numRows(0)
 {
+	SetLogDirectory("/home/lvuser");
+	m_fileName[0] = '\0';
 	fprintf(stderr, "Starting logger\n");
-	this->m_scheduler->RegisterTask("Logger", this, TASK_POST_PERIODIC);
+	this->m_scheduler->RegisterTask("Logger", this,
+			TASK_POST_PERIODIC | TASK_BEST_EFFORT);
 }
 
 LogSpreadsheet::~LogSpreadsheet() {
-	if (m_initialized)
-		m_oFile->close();
-
 	this->m_scheduler->UnregisterTask(this);
+	m_writer.Close();
 }
 
 void LogSpreadsheet::TaskPostPeriodic(RobotMode mode) {
@@ -101,57 +279,159 @@ void LogSpreadsheet::TaskPostPeriodic(RobotMode mode) {
 	WriteRow();
 }
 
-void LogSpreadsheet::RegisterCell(LogCell *cell) {
+void LogSpreadsheet::SetFormat(LogFormat format) {
 	if (m_initialized) {
-		printf("You can't add a column after the table has already been initialized: %s\n",
-				cell->GetName());
+		printf("You can't change the log format after the table has been initialized\n");
+		return;
 	}
-	else {
-		m_cells.push_back(cell);
+	m_format = format;
+}
+
+void LogSpreadsheet::SetLogDirectory(const char *directory) {
+	if (m_initialized) {
+		printf("You can't change the log directory after the table has been initialized\n");
+		return;
 	}
+	strncpy(m_directory, directory, sizeof(m_directory) - 1);
+	m_directory[sizeof(m_directory) - 1] = '\0';
 }
 
-void LogSpreadsheet::InitializeTable() {
+void LogSpreadsheet::SetBuffering(uint32_t ringRows, uint32_t batchRows,
+		uint32_t batchMs) {
 	if (m_initialized) {
-		printf("You can only initialize a table once\n");
+		printf("You can't change log buffering after the table has been initialized\n");
 		return;
 	}
+	m_writer.SetBuffering(ringRows, batchRows, batchMs);
+}
 
-    char buffer[81];
+void LogSpreadsheet::SetSegments(uint64_t segmentBytes,
+		uint64_t diskBudgetBytes, bool rotateOnModeChange,
+		uint32_t checkpointMs) {
+	if (m_initialized) {
+		printf("You can't change log segments after the table has been initialized\n");
+		return;
+	}
+	m_writer.SetSegments(segmentBytes, diskBudgetBytes, rotateOnModeChange,
+			checkpointMs);
+}
 
+void LogSpreadsheet::RegisterCell(LogCell *cell, LogSampling sampling,
+		uint32_t period) {
+	ColumnSampling column;
 
-    snprintf(buffer, sizeof(buffer) - 1,
-             "/home/lvuser/log-%llu.txt", GetFPGATime());
+	if (m_initialized) {
+		printf("You can't add a column after the table has already been initialized: %s\n",
+				cell->GetName());
+		return;
+	}
 
-	m_oFile = new std::ofstream(buffer);
+	column.sampling = cell->ClearOnRead() ? LOG_SAMPLE_EVENT : sampling;
+	column.period = period < 1 ? 1 : period;
+	m_cells.push_back(cell);
+	m_sampling.push_back(column);
+}
 
-	if (m_oFile->fail()) {
-		fprintf(stderr, "Could not open file `%s` for writing.  Errno %d (%s)\n",
-               buffer, errno, strerror(errno));
+void LogSpreadsheet::InitializeTable() {
+	std::vector<LogWriter::Column> columns(m_cells.size());
+	char name[32];
+
+	if (m_initialized) {
+		printf("You can only initialize a table once\n");
 		return;
 	}
 
-	for (std::vector<LogCell*>::iterator it = m_cells.begin();
-			it != m_cells.end(); ++it) {
-		*m_oFile << "\"" << (*it)->GetName() << "\",";
+	snprintf(name, sizeof(name), "log-%llu",
+			(unsigned long long) GetFPGATime());
+	LogWriter::GetSegmentFileName(m_fileName, sizeof(m_fileName),
+			m_directory, name, m_format, 0);
+
+	for (unsigned int i = 0; i < m_cells.size(); i++) {
+		columns[i].name = m_cells[i]->GetName();
+		columns[i].type = m_cells[i]->GetType();
+		columns[i].flags = m_cells[i]->GetFlags();
+		columns[i].slotSize = BinaryLogSlotSize(m_cells[i]->GetType(),
+				m_cells[i]->GetSize());
+		columns[i].sampling = m_sampling[i].sampling;
+		columns[i].decimals = m_cells[i]->GetDecimals();
 	}
-	*m_oFile << std::endl;
+
+	if (!m_writer.Open(m_directory, name, m_format, columns,
+				GetFPGATime())) {
+		return;
+	}
+	m_lastValues.assign(m_writer.GetRecordSize(), 0);
+	m_haveLastValue.assign(m_cells.size(), false);
 
 	m_initialized = true;
 }
 
 void LogSpreadsheet::WriteRow() {
-	for (std::vector<LogCell*>::iterator it = m_cells.begin();
-			it != m_cells.end(); ++it) {
-		(*it)->AcquireLock();
-		*m_oFile << "\"" << (*it)->GetContent() << "\",";
+	uint8_t *row = m_writer.BeginRow();
+	BinaryLogRecordHeader *header;
+	uint8_t *presence;
+	uint8_t *cleared;
+	uint32_t rowNum = m_numRows++;
+
+	if (row == nullptr) {
+		/* writer is behind.  Clear-on-read cells aren't read, so their
+		 * values make it into the next row that isn't dropped */
+		return;
+	}
+
+	header = (BinaryLogRecordHeader*) row;
+	presence = row + sizeof(BinaryLogRecordHeader);
+	cleared = m_writer.GetClearedBitmap(row);
+
+	header->sync = BINARY_LOG_ROW_SYNC;
+	header->row = rowNum;
+	header->timeUs = GetUsecTime();
+	header->mode = m_mode;
+	memset(header->reserved, 0, sizeof(header->reserved));
+	header->size = m_writer.GetRecordSize();
+	memset(presence, 0, (m_cells.size() + 7) / 8);
+	memset(cleared, 0, (m_cells.size() + 7) / 8);
+
+	for (unsigned int i = 0; i < m_cells.size(); i++) {
+		LogCell *cell = m_cells[i];
+		const ColumnSampling &column = m_sampling[i];
+		uint32_t offset = m_writer.GetSlotOffset(i);
+		bool present;
+
+		if (column.sampling == LOG_SAMPLE_EVERY_NTH &&
+				rowNum % column.period != 0) {
+			continue;
+		}
 
-		if ((*it)->ClearOnRead()) {
-			(*it)->ClearCell();
+		cell->UpdateContent();
+		present = cell->CopyValue(row + offset,
+				column.sampling == LOG_SAMPLE_EVENT);
+
+		if (present && column.sampling == LOG_SAMPLE_ON_CHANGE) {
+			uint32_t size = BinaryLogSlotSize(cell->GetType(), cell->GetSize());
+
+			if (m_haveLastValue[i] && rowNum % ON_CHANGE_REFRESH_ROWS != 0 &&
+					memcmp(&m_lastValues[offset], row + offset, size) == 0) {
+				present = false;
+			}
+			else {
+				memcpy(&m_lastValues[offset], row + offset, size);
+				m_haveLastValue[i] = true;
+			}
+		}
+		else if (!present && column.sampling == LOG_SAMPLE_ON_CHANGE &&
+				m_haveLastValue[i]) {
+			/* emptied; don't let the writer carry the old value on */
+			cleared[i / 8] |= 1 << (i % 8);
+			m_haveLastValue[i] = false;
+		}
+
+		if (present) {
+			presence[i / 8] |= 1 << (i % 8);
 		}
-		(*it)->ReleaseLock();
 	}
-	*m_oFile << std::endl;
+
+	m_writer.CommitRow();
 }
 
 }
@@ -7,19 +7,35 @@
  * is called, so if you wanted you could create a TaskManager and log at
  * whatever frequency you want.
  *
+ * Cells can be typed (see LogCellType).  A typed cell stores the raw number
+ * it was given; in LOG_FORMAT_BINARY mode rows are fixed size records
+ * (BinaryLogFormat.h) and logging a number costs a memcpy.
+ *
+ * Cells take no locks.  A numeric cell keeps its value in an atomic word
+ * and a text cell keeps its text in a triple buffer, so a subsystem
+ * logging a value and the logger reading it never wait on each other and
+ * the logger never sees half of one value and half of another.  There is
+ * no ordering between cells: a row may hold one cell's value from this
+ * cycle and another's from the last.
+ *
+ * Writing a row only copies each cell into a ring owned by a LogWriter.
+ * Formatting (for CSV) and all file I/O happen on the writer's thread, so
+ * the loop never waits on the disk; if the writer falls too far behind,
+ * rows are dropped and counted (GetDroppedRows) instead.
+ *
  *  Created on: Nov 24, 2015
  *      Author: Andrew
  */
 
 #pragma once
 
-#include <iostream>
-#include <fstream>
 #include <vector>
 
 #include "../TaskMgr.h"
 #include "../CoopTask.h"
-#include <pthread.h>
+#include "lib/logging/BinaryLogFormat.h"
+#include "lib/logging/LogWriter.h"
+#include <atomic>
 
 namespace frc973 {
 
@@ -31,6 +47,9 @@ constexpr uint32_t LOG_CELL_FLAG_CLEAR_ON_READ = 1;
  * Represents a column in the spreadsheet.  For the column to be printed,
  * you must register the instance of a LogCell in the LogSpreadsheet
  * using LogSpreadsheet.RegisterCell
+ *
+ * Only one thread should log to a given cell, and only the spreadsheet
+ * reads it (GetContent, CopyValue).
  */
 class LogCell {
 public:
@@ -43,6 +62,13 @@ public:
 			uint32_t size = DEFAULT_MAX_LOG_CELL_SIZE,
 			uint32_t flags = 0);
 
+	/**
+	 * Instantiate a typed LogCell.  A LOG_CELL_DOUBLE or LOG_CELL_INT cell
+	 * keeps the raw value passed to LogDouble/LogInt and is written to
+	 * binary logs as that number.
+	 */
+	LogCell(const char *name, LogCellType type, uint32_t flags = 0);
+
 	/**
 	 * Destroy the LogCell instance, freeing up the memory allocated
 	 * for the cell contents
@@ -71,23 +97,81 @@ public:
 	void LogDouble(double val);
 
 	/**
-	 * Log a String using printf-style syntax
+	 * Log a String using printf-style syntax.  Numeric cells only log
+	 * numbers: on a numeric cell the text is rejected, the cell logs as
+	 * empty, the write is counted (GetRejectedWrites) and the first one
+	 * to each cell is reported on stderr.
 	 *
 	 * @param formatstr containing text and printf-style %directives
 	 * @param var_arg list of arguments to be printed
 	 */
 	void LogPrintf(const char *formatstr, ...);
 
+	/**
+	 * Text writes rejected by numeric cells so far, over all cells
+	 */
+	static uint32_t GetRejectedWrites() {
+		return s_rejectedWrites.load(std::memory_order_relaxed);
+	}
+
 	/**
 	 * Return the name of this cell
 	 */
 	const char* GetName();
 
 	/**
-	 * Get the contents of the string
+	 * Get the contents of the string.  Numeric cells are formatted here.
+	 * Reader side only; the text stays valid until the next read.
 	 */
 	virtual const char *GetContent();
 
+	/**
+	 * Copy the cell's value into a binary log slot of
+	 * BinaryLogSlotSize(GetType(), GetSize()) bytes.  Reader side only.
+	 *
+	 * @param consume if set, the cell reads as empty afterwards until
+	 *     something new is logged to it
+	 *
+	 * @return false if the cell is empty
+	 */
+	bool CopyValue(void *slot, bool consume);
+
+	/**
+	 * Copy the value, consuming it if the cell is clear-on-read
+	 */
+	bool CopyValue(void *slot) {
+		return CopyValue(slot, ClearOnRead());
+	}
+
+	LogCellType GetType() const {
+		return m_type;
+	}
+
+	uint32_t GetSize() const {
+		return m_buffSize;
+	}
+
+	uint32_t GetFlags() const {
+		return m_flags;
+	}
+
+	/**
+	 * Choose how many digits after the point (1 to 9) doubles logged to
+	 * this cell are written with, in text and binary logs alike.  The
+	 * default is 6, like "%lf".  Call it before the table is initialized.
+	 */
+	void SetDecimals(int decimals);
+
+	int GetDecimals() const {
+		return m_decimals;
+	}
+
+	/**
+	 * Called by the spreadsheet right before the cell is read.  Cells
+	 * that generate their content on demand override this.
+	 */
+	virtual void UpdateContent() {}
+
 	/**
 	 * Clear the cell so its contents are empty.
 	 */
@@ -102,22 +186,56 @@ public:
 		return m_flags & LOG_CELL_FLAG_CLEAR_ON_READ;
 	}
 
-	void AcquireLock() {
-		pthread_mutex_lock(&m_mutex);
-	}
+private:
+	/* m_textIndex holds the index of the middle text buffer, plus this
+	 * bit if the writer has filled it since the reader last took it */
+	static constexpr uint8_t TEXT_FRESH = 4;
 
-	void ReleaseLock() {
-		pthread_mutex_unlock(&m_mutex);
+	char *TextBuffer(uint8_t index) {
+		return &m_text[index * m_buffSize];
 	}
 
-protected:
-	char *m_buffer;
+	/**
+	 * Hand the back buffer (just filled in by the writer) to the reader
+	 */
+	void PublishText();
+
+	/**
+	 * Take the newest text from the writer, if there is any
+	 *
+	 * @param consume return "" unless there's been new text since the
+	 *     last consuming read
+	 */
+	const char *ReadText(bool consume);
+
+	/**
+	 * Store a number's bits and mark the cell as written
+	 */
+	void PublishValue(uint64_t bits);
 
-private:
 	const char *m_name;
 	const int m_buffSize;
 	const uint32_t m_flags;
-	pthread_mutex_t m_mutex;
+	const LogCellType m_type;
+	uint8_t m_decimals;
+	bool m_reportedRejected;
+
+	static std::atomic<uint32_t> s_rejectedWrites;
+
+	/* numeric cells: the value's bits (a double, or an int32_t in the low
+	 * word), bumped count of writes, and the count as of the last clear */
+	std::atomic<uint64_t> m_value;
+	std::atomic<uint32_t> m_writes;
+	std::atomic<uint32_t> m_clearedWrites;
+
+	/* text cells: three buffers of m_buffSize.  The writer owns the back
+	 * one, the reader owns the front one, and they swap through the
+	 * middle, so neither ever waits */
+	char *m_text;
+	std::atomic<uint8_t> m_textIndex;
+	uint8_t m_backIndex;
+	uint8_t m_frontIndex;
+	bool m_frontUnread;
 };
 
 /**
@@ -131,10 +249,56 @@ public:
 	 * be calling us.
 	 *
 	 * @param scheduler the Task Manager to register this with
+	 * @param writerConfig real-time setup of the thread writing the file
 	 */
-	explicit LogSpreadsheet(TaskMgr *scheduler);
+	explicit LogSpreadsheet(TaskMgr *scheduler,
+			const RTThreadConfig &writerConfig = {"log writer", 0, -1, 0});
 	virtual ~LogSpreadsheet();
 
+	/**
+	 * Choose between CSV, binary and compressed binary output.  Must be
+	 * called before InitializeTable.  Binary logs can be turned back into
+	 * CSV on a host with the logtocsv tool (and compressed ones into
+	 * plain binary with logdecompress).
+	 */
+	void SetFormat(LogFormat format);
+
+	/**
+	 * Choose the directory log files go in (/home/lvuser by default).
+	 * Must be called before InitializeTable.
+	 */
+	void SetLogDirectory(const char *directory);
+
+	/**
+	 * Size the writer's ring and choose how often it writes (see
+	 * LogWriter::SetBuffering).  Must be called before InitializeTable.
+	 */
+	void SetBuffering(uint32_t ringRows, uint32_t batchRows, uint32_t batchMs);
+
+	/**
+	 * Choose when the log starts a new segment file and how much space the
+	 * logs may take (see LogWriter::SetSegments).  Must be called before
+	 * InitializeTable.
+	 */
+	void SetSegments(uint64_t segmentBytes, uint64_t diskBudgetBytes,
+			bool rotateOnModeChange, uint32_t checkpointMs);
+
+	/**
+	 * Rows dropped because the writer thread fell behind
+	 */
+	uint64_t GetDroppedRows() const {
+		return m_writer.GetDroppedRows();
+	}
+
+	/**
+	 * Get the path of the first segment of the log, or an empty string
+	 * before InitializeTable.  Later segments have the same name with the
+	 * number at the end counting up.
+	 */
+	const char *GetFileName() const {
+		return m_fileName;
+	}
+
 	/**
 	 * Initialize the table... open the file, write the column headers, etc.
 	 */
@@ -152,25 +316,71 @@ public:
 	 * in GetValue.  You cannot register more columns after the header of
 	 * the file has already been written.
 	 *
+	 * A column that isn't sampled in a row is left out of it, so slow or
+	 * rarely changing columns cost next to nothing.  On-change columns
+	 * are read every row but only written when the value differs from
+	 * the last one written (and every ON_CHANGE_REFRESH_ROWS rows, so a
+	 * reader that missed a block still picks them up).
+	 *
 	 * @param cell to register
-	 * @param boolean says whether to clear the cell after reading it
+	 * @param sampling when to write the column.  Clear-on-read cells are
+	 *     always LOG_SAMPLE_EVENT.
+	 * @param period for LOG_SAMPLE_EVERY_NTH, write every |period| rows
 	 */
-	void RegisterCell(LogCell *cell);
+	void RegisterCell(LogCell *cell,
+			LogSampling sampling = LOG_SAMPLE_EVERY_ROW, uint32_t period = 1);
+
+	/**
+	 * Get the number of cells registered so far
+	 */
+	int GetNumCells() const {
+		return m_cells.size();
+	}
+
+	/**
+	 * Get a registered cell, in column order
+	 *
+	 * @param index of the cell, from 0 to GetNumCells() - 1
+	 */
+	LogCell *GetCell(int index) const {
+		return m_cells[index];
+	}
+
+	/**
+	 * Rows between forced writes of an on-change column
+	 */
+	static constexpr uint32_t ON_CHANGE_REFRESH_ROWS = 250;
 private:
+	struct ColumnSampling {
+		LogSampling sampling;
+		uint32_t period;
+	};
+
 	/**
-	 * Write a in the table...
+	 * Write a row in the table...
 	 *
-	 * For each registered column, use GetValue to figure ouw what goes
-	 * in that column then write some coma-seperated, quote-enclosed
-	 * values with a line break at the end.
+	 * Copy each registered cell into the next free row of the writer's
+	 * ring and hand it over.  The writer thread formats and writes it.
 	 */
 	void WriteRow();
 
 	std::vector<LogCell*> m_cells;
-	std::ofstream *m_oFile;
+	std::vector<ColumnSampling> m_sampling;
+
+	/* on-change columns: the last value written, laid out as in a row */
+	std::vector<uint8_t> m_lastValues;
+	std::vector<uint8_t> m_haveLastValue;
+	LogWriter m_writer;
 	TaskMgr *m_scheduler;
 	bool m_initialized;
 	RobotMode m_mode;
+
+	LogFormat m_format;
+	char m_directory[64];
+	char m_fileName[160];
+
+	/* rows taken so far, including any the writer had to drop */
+	uint32_t m_numRows;
 };
 
 }
@@ -0,0 +1,863 @@
+/*
+ * LogWriter.cpp
+ */
+
+#include "lib/logging/LogWriter.h"
+#include "lib/logging/LogCompression.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace frc973 {
+
+namespace {
+
+uint64_t GetMonotonicMs() {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000ULL + now.tv_nsec / 1000000;
+}
+
+const char *GetExtension(LogFormat format) {
+	switch (format) {
+		case LOG_FORMAT_BINARY:
+			return "bin";
+		case LOG_FORMAT_COMPRESSED:
+			return "binz";
+		default:
+			return "txt";
+	}
+}
+
+/**
+ * Whether |name| is a log file (ours or an older one) the disk budget
+ * covers
+ */
+bool IsLogFile(const char *name) {
+	const char *ext = strrchr(name, '.');
+
+	return strncmp(name, "log-", 4) == 0 && ext != nullptr &&
+		(strcmp(ext, ".txt") == 0 || strcmp(ext, ".bin") == 0 ||
+		 strcmp(ext, ".binz") == 0);
+}
+
+/**
+ * Whether |name| is the index of a log file (<log>.idx)
+ */
+bool IsLogIndex(const char *name) {
+	char base[NAME_MAX + 1];
+	size_t len = strlen(name);
+
+	if (len <= 4 || len > NAME_MAX || strcmp(name + len - 4, ".idx") != 0) {
+		return false;
+	}
+	memcpy(base, name, len - 4);
+	base[len - 4] = '\0';
+	return IsLogFile(base);
+}
+
+}
+
+LogWriter::LogWriter(const RTThreadConfig &threadConfig)
+	 : m_threadConfig(threadConfig)
+	 , m_format(LOG_FORMAT_CSV)
+	 , m_fd(-1)
+	 , m_segmentIndex(0)
+	 , m_segmentBytes(0)
+	 , m_segmentRows(0)
+	 , m_segmentLimit(DEFAULT_SEGMENT_BYTES)
+	 , m_diskBudget(DEFAULT_DISK_BUDGET_BYTES)
+	 , m_rotateOnModeChange(true)
+	 , m_checkpointMs(DEFAULT_CHECKPOINT_MS)
+	 , m_lastCheckpointMs(0)
+	 , m_lastMode(-1)
+	 , m_indexFd(-1)
+	 , m_indexBatch()
+	 , m_modeStartUs(0)
+	 , m_lastIndexUs(0)
+	 , m_columns()
+	 , m_recordSize(0)
+	 , m_ringStride(0)
+	 , m_ringRows(DEFAULT_RING_ROWS)
+	 , m_batchRows(DEFAULT_BATCH_ROWS)
+	 , m_batchMs(DEFAULT_BATCH_MS)
+	 , m_ring()
+	 , m_head(0)
+	 , m_tail(0)
+	 , m_batch()
+	 , m_blockRows()
+	 , m_blockEncoded()
+	 , m_lzTable()
+	 , m_blockCount(0)
+	 , m_thread()
+	 , m_threadRunning(false)
+	 , m_stop(false)
+	 , m_droppedRows(0)
+	 , m_writtenRows(0)
+	 , m_lostBytes(0)
+	 , m_numSegments(0)
+	 , m_reportedError(false)
+	 , m_segmentFailed(false)
+{
+	pthread_condattr_t attr;
+
+	m_directory[0] = '\0';
+	m_name[0] = '\0';
+	m_fileName[0] = '\0';
+
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&m_cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+LogWriter::~LogWriter() {
+	Close();
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void LogWriter::SetBuffering(uint32_t ringRows, uint32_t batchRows,
+		uint32_t batchMs) {
+	if (IsOpen()) {
+		fprintf(stderr, "LogWriter: can't change buffering once open\n");
+		return;
+	}
+	m_ringRows = ringRows < 2 ? 2 : ringRows;
+	m_batchRows = batchRows < 1 ? 1 : batchRows;
+	m_batchMs = batchMs;
+}
+
+void LogWriter::SetSegments(uint64_t segmentBytes, uint64_t diskBudgetBytes,
+		bool rotateOnModeChange, uint32_t checkpointMs) {
+	if (IsOpen()) {
+		fprintf(stderr, "LogWriter: can't change segments once open\n");
+		return;
+	}
+	m_segmentLimit = segmentBytes;
+	m_diskBudget = diskBudgetBytes;
+	m_rotateOnModeChange = rotateOnModeChange;
+	m_checkpointMs = checkpointMs;
+}
+
+void LogWriter::GetSegmentFileName(char *buf, size_t size,
+		const char *directory, const char *name, LogFormat format,
+		uint32_t index) {
+	snprintf(buf, size, "%s/%s-%03u.%s", directory, name, index,
+			GetExtension(format));
+}
+
+bool LogWriter::Open(const char *directory, const char *name,
+		LogFormat format, const std::vector<Column> &columns,
+		uint64_t startTimeUs) {
+	if (IsOpen()) {
+		fprintf(stderr, "LogWriter: %s is already open\n", m_fileName);
+		return false;
+	}
+
+	snprintf(m_directory, sizeof(m_directory), "%s", directory);
+	snprintf(m_name, sizeof(m_name), "%s", name);
+	m_format = format;
+	m_columns.resize(columns.size());
+	m_recordSize = sizeof(BinaryLogRecordHeader) + (columns.size() + 7) / 8;
+	for (unsigned int i = 0; i < columns.size(); i++) {
+		m_columns[i].column = columns[i];
+		m_columns[i].offset = m_recordSize;
+		m_columns[i].lastCsv.clear();
+		if (format == LOG_FORMAT_CSV &&
+				columns[i].sampling == LOG_SAMPLE_ON_CHANGE) {
+			m_columns[i].lastCsv.reserve(columns[i].slotSize + 64);
+		}
+		m_recordSize += columns[i].slotSize;
+	}
+	m_ringStride = m_recordSize + (columns.size() + 7) / 8;
+
+	/* everything either thread will need is allocated here, up front */
+	m_ring.assign((size_t) m_ringRows * m_ringStride, 0);
+	m_head.store(0);
+	m_tail.store(0);
+	m_batch.clear();
+	m_batch.reserve((size_t) m_batchRows * m_recordSize * 2);
+	m_onChangeValues.assign(m_recordSize, 0);
+	m_haveOnChangeValue.assign(m_columns.size(), false);
+	m_firstRow.assign(m_recordSize, 0);
+	m_indexBatch.clear();
+	m_indexBatch.reserve(16);
+	if (m_format == LOG_FORMAT_COMPRESSED) {
+		m_blockRows.assign((size_t) m_batchRows * m_recordSize, 0);
+		m_blockEncoded.assign(m_blockRows.size(), 0);
+		m_lzTable.assign(LZ_HASH_ENTRIES, 0);
+		m_blockCount = 0;
+	}
+	m_droppedRows.store(0);
+	m_writtenRows.store(0);
+	m_lostBytes.store(0);
+	m_numSegments.store(0);
+	m_reportedError = false;
+	m_segmentFailed = false;
+	m_lastMode = -1;
+
+	if (!OpenSegment(0, startTimeUs)) {
+		return false;
+	}
+
+	m_stop = false;
+	if (pthread_create(&m_thread, NULL, WriterMain, this) == 0) {
+		m_threadRunning = true;
+	}
+	else {
+		fprintf(stderr, "LogWriter: could not start writer thread, "
+				"rows will queue until Close\n");
+	}
+	return true;
+}
+
+void LogWriter::Close() {
+	if (!IsOpen()) {
+		return;
+	}
+
+	if (m_threadRunning) {
+		pthread_mutex_lock(&m_mutex);
+		m_stop = true;
+		pthread_cond_signal(&m_cond);
+		pthread_mutex_unlock(&m_mutex);
+		pthread_join(m_thread, NULL);
+		m_threadRunning = false;
+	}
+
+	/* the thread has stopped, so pick up anything committed since */
+	DrainRing();
+	FlushBatch();
+	CloseSegment();
+}
+
+bool LogWriter::OpenSegment(uint32_t index, uint64_t startTimeUs) {
+	char fileName[sizeof(m_fileName)];
+	int fd, dirFd;
+
+	GetSegmentFileName(fileName, sizeof(fileName), m_directory, m_name,
+			m_format, index);
+	fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		/* maybe there's no room for it: make some the way a failed write
+		 * does and try once more */
+		int err = errno;
+
+		if (EnforceDiskBudget(err == ENOSPC ? 0 : m_diskBudget, 1)) {
+			fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+					0644);
+		}
+		else {
+			errno = err;
+		}
+	}
+	if (fd < 0) {
+		fprintf(stderr, "Could not open file `%s` for writing.  Errno %d (%s)\n",
+				fileName, errno, strerror(errno));
+		return false;
+	}
+
+	/* reserve the whole segment now so appending never has to hunt for
+	 * space.  Not every filesystem can; that's fine */
+	fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, m_segmentLimit);
+
+	/* make the new name itself survive a power cut */
+	dirFd = open(m_directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirFd >= 0) {
+		fsync(dirFd);
+		close(dirFd);
+	}
+
+	CloseSegment();
+	m_fd = fd;
+	memcpy(m_fileName, fileName, sizeof(m_fileName));
+	if (m_format != LOG_FORMAT_CSV) {
+		OpenIndex(startTimeUs);
+	}
+	m_segmentIndex = index;
+	m_segmentBytes = 0;
+	m_segmentRows = 0;
+	m_numSegments.fetch_add(1, std::memory_order_relaxed);
+
+	if (m_format == LOG_FORMAT_CSV) {
+		AppendCsvHeader();
+	}
+	else {
+		AppendBinaryHeader(startTimeUs);
+	}
+	FlushBatch();
+
+	EnforceDiskBudget(m_diskBudget);
+	return true;
+}
+
+void LogWriter::CloseSegment() {
+	if (m_fd < 0) {
+		return;
+	}
+	if (ftruncate(m_fd, m_segmentBytes) != 0) {
+		/* the reserved space just stays reserved */
+	}
+	fdatasync(m_fd);
+	close(m_fd);
+	m_fd = -1;
+
+	if (m_indexFd >= 0) {
+		fdatasync(m_indexFd);
+		close(m_indexFd);
+		m_indexFd = -1;
+	}
+}
+
+void LogWriter::OpenIndex(uint64_t startTimeUs) {
+	char fileName[sizeof(m_fileName) + 4];
+	LogIndexHeader header;
+
+	snprintf(fileName, sizeof(fileName), "%s.idx", m_fileName);
+	m_indexFd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+			0644);
+	if (m_indexFd < 0) {
+		/* the log is still readable, just not as quickly */
+		fprintf(stderr, "Could not open file `%s` for writing.  Errno %d (%s)\n",
+				fileName, errno, strerror(errno));
+		return;
+	}
+
+	header.magic = LOG_INDEX_MAGIC;
+	header.version = LOG_INDEX_VERSION;
+	header.reserved = 0;
+	header.startTimeUs = startTimeUs;
+	if (write(m_indexFd, &header, sizeof(header)) != sizeof(header)) {
+		close(m_indexFd);
+		m_indexFd = -1;
+	}
+}
+
+void LogWriter::RotateSegment(uint64_t startTimeUs) {
+	if (m_blockCount != 0) {
+		AppendBlock();
+	}
+	FlushBatch();
+	if (!OpenSegment(m_segmentIndex + 1, startTimeUs)) {
+		fprintf(stderr, "LogWriter: could not start a new segment, "
+				"carrying on in %s\n", m_fileName);
+		m_segmentFailed = true;
+	}
+	m_lastCheckpointMs = GetMonotonicMs();
+}
+
+void LogWriter::Checkpoint(bool force) {
+	uint64_t now = GetMonotonicMs();
+
+	if (force || now - m_lastCheckpointMs >= m_checkpointMs) {
+		fdatasync(m_fd);
+		if (m_indexFd >= 0) {
+			fdatasync(m_indexFd);
+		}
+		m_lastCheckpointMs = now;
+	}
+}
+
+bool LogWriter::EnforceDiskBudget(uint64_t budget, unsigned int maxDeletes) {
+	struct LogFile {
+		char name[NAME_MAX + 1];
+		uint64_t size;
+		time_t mtime;
+	};
+	std::vector<LogFile> files;
+	std::vector<LogFile> indexes;
+	uint64_t total = 0;
+	bool deleted = false;
+	const char *slash = strrchr(m_fileName, '/');
+	const char *current = slash != NULL ? slash + 1 : m_fileName;
+	DIR *dir = opendir(m_directory);
+	struct dirent *entry;
+
+	if (dir == NULL) {
+		return false;
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		char path[sizeof(m_directory) + NAME_MAX + 2];
+		struct stat st;
+		LogFile file;
+
+		bool index = IsLogIndex(entry->d_name);
+
+		if (!index && !IsLogFile(entry->d_name)) {
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/%s", m_directory, entry->d_name);
+		if (stat(path, &st) != 0) {
+			continue;
+		}
+		strcpy(file.name, entry->d_name);
+		/* the space reserved past the end of a segment is in use too */
+		file.size = std::max((uint64_t) st.st_size,
+				(uint64_t) st.st_blocks * 512);
+		file.mtime = st.st_mtime;
+		if (index) {
+			indexes.push_back(file);
+			continue;
+		}
+		total += file.size;
+		if (strcmp(entry->d_name, current) == 0) {
+			continue;
+		}
+		files.push_back(file);
+	}
+	closedir(dir);
+
+	/* an index goes with its log: it counts toward the budget and is freed
+	 * along with it.  One whose log is gone is just taking up space. */
+	for (const LogFile &index : indexes) {
+		size_t baseLen = strlen(index.name) - 4;
+		bool found = false;
+
+		if (strncmp(index.name, current, baseLen) == 0 &&
+				current[baseLen] == '\0') {
+			total += index.size;
+			continue;
+		}
+		for (LogFile &file : files) {
+			if (strncmp(index.name, file.name, baseLen) == 0 &&
+					file.name[baseLen] == '\0') {
+				file.size += index.size;
+				total += index.size;
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			char path[sizeof(m_directory) + NAME_MAX + 2];
+
+			snprintf(path, sizeof(path), "%s/%s", m_directory, index.name);
+			unlink(path);
+		}
+	}
+
+	/* oldest first.  FPGA time starts over every boot, so go by when the
+	 * files were written rather than by name */
+	std::sort(files.begin(), files.end(),
+			[](const LogFile &a, const LogFile &b) {
+				return a.mtime != b.mtime ? a.mtime < b.mtime :
+					strcmp(a.name, b.name) < 0;
+			});
+
+	for (const LogFile &file : files) {
+		char path[sizeof(m_directory) + NAME_MAX + 6];
+
+		if (total <= budget || maxDeletes == 0) {
+			break;
+		}
+		snprintf(path, sizeof(path), "%s/%s", m_directory, file.name);
+		if (unlink(path) == 0) {
+			total -= file.size;
+			deleted = true;
+			maxDeletes--;
+		}
+		strcat(path, ".idx");
+		unlink(path);
+	}
+	return deleted;
+}
+
+uint8_t *LogWriter::BeginRow() {
+	uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+	if (tail - m_head.load(std::memory_order_acquire) >= m_ringRows) {
+		m_droppedRows.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	return &m_ring[(size_t) (tail % m_ringRows) * m_ringStride];
+}
+
+void LogWriter::CommitRow() {
+	uint32_t tail = m_tail.load(std::memory_order_relaxed) + 1;
+
+	m_tail.store(tail, std::memory_order_release);
+
+	/* nudge the writer once a batch is ready.  If it holds the mutex it's
+	 * awake already, so don't wait for it */
+	if (tail - m_head.load(std::memory_order_relaxed) >= m_batchRows &&
+			pthread_mutex_trylock(&m_mutex) == 0) {
+		pthread_cond_signal(&m_cond);
+		pthread_mutex_unlock(&m_mutex);
+	}
+}
+
+void *LogWriter::WriterMain(void *p) {
+	LogWriter *writer = static_cast<LogWriter*>(p);
+
+	RTThread::Configure(writer->m_threadConfig);
+	writer->WriterLoop();
+	return NULL;
+}
+
+void LogWriter::WriterLoop() {
+	struct timespec deadline;
+
+	pthread_mutex_lock(&m_mutex);
+	while (!m_stop) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += m_batchMs / 1000;
+		deadline.tv_nsec += (m_batchMs % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+
+		while (!m_stop && m_tail.load(std::memory_order_acquire) -
+					m_head.load(std::memory_order_relaxed) < m_batchRows) {
+			if (pthread_cond_timedwait(&m_cond, &m_mutex,
+						&deadline) == ETIMEDOUT) {
+				break;
+			}
+		}
+		if (m_stop) {
+			break;
+		}
+		pthread_mutex_unlock(&m_mutex);
+
+		if (DrainRing() != 0) {
+			FlushBatch();
+		}
+		Checkpoint(false);
+
+		pthread_mutex_lock(&m_mutex);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+uint32_t LogWriter::DrainRing() {
+	uint32_t head = m_head.load(std::memory_order_relaxed);
+	uint32_t tail = m_tail.load(std::memory_order_acquire);
+
+	for (uint32_t i = head; i != tail; i++) {
+		const uint8_t *row = &m_ring[(size_t) (i % m_ringRows) * m_ringStride];
+		const BinaryLogRecordHeader *header =
+			(const BinaryLogRecordHeader*) row;
+		int reason;
+
+		if (!m_segmentFailed && ((m_rotateOnModeChange && m_lastMode >= 0 &&
+					header->mode != m_lastMode) ||
+				m_segmentBytes + m_batch.size() +
+					(size_t) m_blockCount * m_recordSize >= m_segmentLimit)) {
+			RotateSegment(header->timeUs);
+		}
+		reason = GetIndexReason(header);
+		if (reason == LOG_INDEX_MODE) {
+			m_modeStartUs = header->timeUs;
+		}
+		if (reason >= 0 && m_blockCount != 0) {
+			/* an indexed row has to start a block */
+			AppendBlock();
+		}
+		row = CarryOnChange(row, reason >= 0);
+		if (reason >= 0) {
+			AppendIndexEntry(header, reason);
+		}
+		m_lastMode = header->mode;
+		m_segmentRows++;
+
+		if (m_format == LOG_FORMAT_BINARY) {
+			AppendSparseRow(row);
+		}
+		else if (m_format == LOG_FORMAT_COMPRESSED) {
+			AppendBlockRow(row);
+		}
+		else {
+			AppendCsvRow(row);
+		}
+		/* hand each slot back as soon as it's copied out */
+		m_head.store(i + 1, std::memory_order_release);
+	}
+
+	/* don't hold rows back for a later block, or they'd be lost if the
+	 * power goes before then */
+	if (m_blockCount != 0) {
+		AppendBlock();
+	}
+
+	m_writtenRows.fetch_add(tail - head, std::memory_order_relaxed);
+	return tail - head;
+}
+
+int LogWriter::GetIndexReason(const BinaryLogRecordHeader *row) const {
+	if (m_lastMode < 0 || row->mode != m_lastMode) {
+		return LOG_INDEX_MODE;
+	}
+	if (m_segmentRows == 0) {
+		return LOG_INDEX_FILE_START;
+	}
+	if (row->timeUs - m_lastIndexUs >= 1000000) {
+		return LOG_INDEX_SECOND;
+	}
+	return -1;
+}
+
+void LogWriter::AppendIndexEntry(const BinaryLogRecordHeader *row,
+		int reason) {
+	LogIndexEntry entry;
+
+	m_lastIndexUs = row->timeUs;
+	if (m_indexFd < 0) {
+		return;
+	}
+
+	entry.timeUs = row->timeUs;
+	entry.modeStartUs = m_modeStartUs;
+	entry.offset = m_segmentBytes + m_batch.size();
+	entry.row = row->row;
+	entry.mode = row->mode;
+	entry.reason = reason;
+	entry.reserved = 0;
+	m_indexBatch.push_back(entry);
+}
+
+const uint8_t *LogWriter::CarryOnChange(const uint8_t *row, bool fill) {
+	const uint8_t *presence = row + sizeof(BinaryLogRecordHeader);
+	const uint8_t *cleared = row + m_recordSize;
+	bool copied = false;
+
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		const ColumnLayout &layout = m_columns[i];
+		uint32_t offset = layout.offset;
+
+		if (layout.column.sampling != LOG_SAMPLE_ON_CHANGE) {
+			continue;
+		}
+		if ((presence[i / 8] >> (i % 8)) & 1) {
+			memcpy(&m_onChangeValues[offset], row + offset,
+					layout.column.slotSize);
+			m_haveOnChangeValue[i] = true;
+		}
+		else if ((cleared[i / 8] >> (i % 8)) & 1) {
+			m_haveOnChangeValue[i] = false;
+			m_columns[i].lastCsv.clear();
+		}
+		else if (fill && m_haveOnChangeValue[i]) {
+			/* reading can start at an indexed row (or a new segment), so
+			 * it has to stand on its own */
+			if (!copied) {
+				memcpy(&m_firstRow[0], row, m_recordSize);
+				copied = true;
+			}
+			memcpy(&m_firstRow[offset], &m_onChangeValues[offset],
+					layout.column.slotSize);
+			m_firstRow[sizeof(BinaryLogRecordHeader) + i / 8] |= 1 << (i % 8);
+		}
+	}
+	return copied ? &m_firstRow[0] : row;
+}
+
+void LogWriter::AppendCsvHeader() {
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		const char *name = m_columns[i].column.name;
+
+		m_batch.push_back('"');
+		m_batch.insert(m_batch.end(), name, name + strlen(name));
+		m_batch.push_back('"');
+		m_batch.push_back(',');
+	}
+	m_batch.push_back('\n');
+}
+
+void LogWriter::AppendCsvRow(const uint8_t *row) {
+	const uint8_t *presence = row + sizeof(BinaryLogRecordHeader);
+	char cell[256];
+
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		ColumnLayout &layout = m_columns[i];
+		bool onChange = layout.column.sampling == LOG_SAMPLE_ON_CHANGE;
+		int len = 0;
+
+		m_batch.push_back('"');
+		if ((presence[i / 8] >> (i % 8)) & 1) {
+			len = FormatBinaryLogSlot(layout.column.type, row + layout.offset,
+					layout.column.slotSize, layout.column.decimals, cell,
+					sizeof(cell));
+			if (len >= (int) sizeof(cell)) {
+				len = sizeof(cell) - 1;
+			}
+			m_batch.insert(m_batch.end(), cell, cell + len);
+			if (onChange) {
+				layout.lastCsv.assign(cell, len);
+			}
+		}
+		else if (onChange) {
+			m_batch.insert(m_batch.end(), layout.lastCsv.begin(),
+					layout.lastCsv.end());
+		}
+		m_batch.push_back('"');
+		m_batch.push_back(',');
+	}
+	m_batch.push_back('\n');
+}
+
+void LogWriter::AppendSparseRow(const uint8_t *row) {
+	const uint8_t *presence = row + sizeof(BinaryLogRecordHeader);
+	size_t start = m_batch.size();
+	uint32_t size = sizeof(BinaryLogRecordHeader) + (m_columns.size() + 7) / 8;
+
+	m_batch.insert(m_batch.end(), row, row + size);
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		const ColumnLayout &layout = m_columns[i];
+
+		if ((presence[i / 8] >> (i % 8)) & 1) {
+			m_batch.insert(m_batch.end(), row + layout.offset,
+					row + layout.offset + layout.column.slotSize);
+			size += layout.column.slotSize;
+		}
+	}
+	memcpy(&m_batch[start + offsetof(BinaryLogRecordHeader, size)], &size,
+			sizeof(size));
+}
+
+void LogWriter::AppendBlockRow(const uint8_t *row) {
+	uint8_t *dest = &m_blockRows[(size_t) m_blockCount * m_recordSize];
+	const uint8_t *presence = row + sizeof(BinaryLogRecordHeader);
+
+	memcpy(dest, row, m_recordSize);
+
+	/* an empty slot holds whatever the ring had there.  Repeat the row
+	 * before instead, which XORs away to nothing */
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		const ColumnLayout &layout = m_columns[i];
+
+		if (((presence[i / 8] >> (i % 8)) & 1) == 0) {
+			if (m_blockCount == 0) {
+				memset(dest + layout.offset, 0, layout.column.slotSize);
+			}
+			else {
+				memcpy(dest + layout.offset,
+						dest - m_recordSize + layout.offset,
+						layout.column.slotSize);
+			}
+		}
+	}
+
+	if (++m_blockCount == m_batchRows) {
+		AppendBlock();
+	}
+}
+
+void LogWriter::AppendBinaryHeader(uint64_t startTimeUs) {
+	BinaryLogHeader header;
+	uint32_t headerSize = sizeof(BinaryLogHeader);
+
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		headerSize += sizeof(BinaryLogColumn) +
+			strlen(m_columns[i].column.name);
+	}
+
+	header.magic = m_format == LOG_FORMAT_COMPRESSED ?
+		BINARY_LOG_COMPRESSED_MAGIC : BINARY_LOG_MAGIC;
+	header.version = BINARY_LOG_VERSION;
+	header.numColumns = m_columns.size();
+	header.headerSize = headerSize;
+	header.recordSize = m_recordSize;
+	header.startTimeUs = startTimeUs;
+	m_batch.insert(m_batch.end(), (const char*) &header,
+			(const char*) &header + sizeof(header));
+
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		const Column &col = m_columns[i].column;
+		BinaryLogColumn column;
+
+		column.type = col.type;
+		column.flags = col.flags;
+		column.slotSize = col.slotSize;
+		column.nameLen = strlen(col.name);
+		column.sampling = col.sampling;
+		column.decimals = col.decimals;
+		m_batch.insert(m_batch.end(), (const char*) &column,
+				(const char*) &column + sizeof(column));
+		m_batch.insert(m_batch.end(), col.name, col.name + column.nameLen);
+	}
+}
+
+void LogWriter::AppendBlock() {
+	BinaryLogBlockHeader header;
+	size_t rawSize = (size_t) m_blockCount * m_recordSize;
+	size_t start = m_batch.size();
+	uint8_t *payload;
+
+	LogRowsEncode(&m_blockRows[0], m_blockCount, m_recordSize,
+			&m_blockEncoded[0]);
+
+	m_batch.resize(start + sizeof(header) + LzCompressBound(rawSize));
+	payload = (uint8_t*) &m_batch[start + sizeof(header)];
+
+	header.sync = BINARY_LOG_BLOCK_SYNC;
+	memcpy(&header.firstRow,
+			&m_blockRows[offsetof(BinaryLogRecordHeader, row)],
+			sizeof(header.firstRow));
+	header.numRows = m_blockCount;
+	header.rawSize = rawSize;
+	header.compressedSize = LzCompress(&m_blockEncoded[0], rawSize, payload,
+			&m_lzTable[0]);
+	header.checksum = LogBlockChecksum(payload, header.compressedSize);
+	memcpy(&m_batch[start], &header, sizeof(header));
+
+	m_batch.resize(start + sizeof(header) + header.compressedSize);
+	m_blockCount = 0;
+}
+
+void LogWriter::FlushBatch() {
+	size_t written = 0;
+
+	while (written < m_batch.size()) {
+		ssize_t ret = write(m_fd, &m_batch[written], m_batch.size() - written);
+
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret < 0 && errno == ENOSPC && EnforceDiskBudget(0, 1)) {
+			/* deleted the oldest log, try again.  Only as many old logs
+			 * go as it takes to make room. */
+			continue;
+		}
+		if (ret <= 0) {
+			if (!m_reportedError) {
+				fprintf(stderr, "LogWriter: write failed: %s\n",
+						strerror(errno));
+				m_reportedError = true;
+			}
+			m_lostBytes.fetch_add(m_batch.size() - written,
+					std::memory_order_relaxed);
+			break;
+		}
+		written += ret;
+	}
+	m_segmentBytes += written;
+	m_batch.clear();
+
+	/* after the rows, so an entry never points past what's in the file.
+	 * Entries for rows that didn't make it go with them. */
+	m_indexBatch.erase(std::remove_if(m_indexBatch.begin(),
+				m_indexBatch.end(), [this](const LogIndexEntry &entry) {
+					return entry.offset >= m_segmentBytes;
+				}), m_indexBatch.end());
+	if (m_indexFd >= 0 && !m_indexBatch.empty()) {
+		size_t size = m_indexBatch.size() * sizeof(LogIndexEntry);
+
+		if (write(m_indexFd, m_indexBatch.data(), size) != (ssize_t) size) {
+			/* readers ignore a torn entry, and can do without the rest */
+		}
+		m_indexBatch.clear();
+	}
+}
+
+}
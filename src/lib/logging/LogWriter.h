@@ -0,0 +1,387 @@
+/*
+ * LogWriter.h
+ *
+ * LogWriter - gets log rows from the robot loop onto disk without the
+ * robot loop ever touching the disk.
+ *
+ * The loop side (LogSpreadsheet) copies each row's cell values into a
+ * slot of a ring allocated up front and moves on.  A low priority writer
+ * thread drains the ring, formats the rows (for CSV) and writes them out
+ * in batches, every so many rows or every so many milliseconds, whichever
+ * comes first.  If the writer falls behind far enough for the ring to
+ * fill up, new rows are dropped and counted rather than waiting for it.
+ *
+ * The log goes to a series of segment files, each complete in itself
+ * (header and all), named <name>-000.<ext>, <name>-001.<ext>...  A new
+ * segment is started when the current one reaches its size cap or the
+ * robot changes mode, and the oldest logs in the directory are deleted to
+ * keep them all under a disk budget.  Space for each segment is reserved
+ * up front where the filesystem allows, and the writer makes what it has
+ * written durable every so often (a checkpoint), so a brownout loses at
+ * most the rows since then; the readers ignore a torn last row or block.
+ * Running out of space is handled by deleting old logs, and failing that
+ * by dropping rows, never by blocking.
+ *
+ * Binary segments get an index (<segment>.idx, see BinaryLogFormat.h)
+ * written along with them.  An indexed row starts a new block in
+ * LOG_FORMAT_COMPRESSED and carries every on-change value, so a reader can
+ * start at any entry.
+ *
+ * Rows are laid out as in BinaryLogFormat.h whatever the output format,
+ * with every slot in place.  Binary files only get the present slots of
+ * each row; CSV files get "" for an empty cell, except that on-change
+ * columns repeat the last value written until the cell is cleared.  In
+ * LOG_FORMAT_COMPRESSED each write is cut into blocks of at most a batch
+ * of rows, compressed on the writer thread (see LogCompression.h).
+ */
+
+#pragma once
+
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "lib/logging/BinaryLogFormat.h"
+#include "lib/RTThread.h"
+
+namespace frc973 {
+
+/**
+ * How a LogSpreadsheet writes its rows
+ */
+enum LogFormat {
+	LOG_FORMAT_CSV,				/* quoted text, readable by the old tools */
+	LOG_FORMAT_BINARY,			/* fixed size records, see BinaryLogFormat.h */
+	LOG_FORMAT_COMPRESSED		/* binary records in compressed blocks */
+};
+
+class LogWriter {
+public:
+	/**
+	 * Rows the ring holds by default (ten seconds of a 50Hz loop)
+	 */
+	static constexpr uint32_t DEFAULT_RING_ROWS = 512;
+
+	/**
+	 * By default write whenever this many rows are waiting...
+	 */
+	static constexpr uint32_t DEFAULT_BATCH_ROWS = 25;
+
+	/**
+	 * ...or this long after the last write, whichever is first
+	 */
+	static constexpr uint32_t DEFAULT_BATCH_MS = 500;
+
+	/**
+	 * Default size cap of one segment
+	 */
+	static constexpr uint64_t DEFAULT_SEGMENT_BYTES = 16 * 1024 * 1024;
+
+	/**
+	 * Default limit on all the logs in the directory together
+	 */
+	static constexpr uint64_t DEFAULT_DISK_BUDGET_BYTES = 256 * 1024 * 1024;
+
+	/**
+	 * Default time between checkpoints
+	 */
+	static constexpr uint32_t DEFAULT_CHECKPOINT_MS = 1000;
+
+	/**
+	 * Description of one column, in row order
+	 */
+	struct Column {
+		const char *name;
+		LogCellType type;
+		uint32_t flags;
+		uint16_t slotSize;
+		LogSampling sampling;
+		uint8_t decimals;			/* see BinaryLogColumn */
+	};
+
+	explicit LogWriter(const RTThreadConfig &threadConfig);
+	virtual ~LogWriter();
+
+	/**
+	 * Size the ring and choose when to write.  Must be called before Open.
+	 *
+	 * @param ringRows rows that can be waiting before new ones get dropped
+	 * @param batchRows write once this many rows are waiting
+	 * @param batchMs write at least this often if there's anything waiting
+	 */
+	void SetBuffering(uint32_t ringRows, uint32_t batchRows, uint32_t batchMs);
+
+	/**
+	 * Choose when to start a new segment and how much space the logs may
+	 * take.  Must be called before Open.
+	 *
+	 * @param segmentBytes start a new segment once this many bytes are in
+	 *     the current one
+	 * @param diskBudgetBytes delete the oldest logs in the directory once
+	 *     they add up to more than this
+	 * @param rotateOnModeChange also start a new segment when the robot
+	 *     changes mode
+	 * @param checkpointMs make the file durable at least this often
+	 */
+	void SetSegments(uint64_t segmentBytes, uint64_t diskBudgetBytes,
+			bool rotateOnModeChange, uint32_t checkpointMs);
+
+	/**
+	 * Create the first segment in |directory|, write the header for
+	 * |columns| and start the writer thread.
+	 *
+	 * @param name segment files are called <name>-NNN.<ext>
+	 *
+	 * @return false if the file couldn't be created
+	 */
+	bool Open(const char *directory, const char *name, LogFormat format,
+			const std::vector<Column> &columns, uint64_t startTimeUs);
+
+	/**
+	 * Build the path of segment |index|
+	 */
+	static void GetSegmentFileName(char *buf, size_t size,
+			const char *directory, const char *name, LogFormat format,
+			uint32_t index);
+
+	/**
+	 * Stop the writer thread after it has written everything committed
+	 * so far, and close the file
+	 */
+	void Close();
+
+	bool IsOpen() const {
+		return m_fd >= 0;
+	}
+
+	/**
+	 * Bytes in each row (see BinaryLogFormat.h)
+	 */
+	uint32_t GetRecordSize() const {
+		return m_recordSize;
+	}
+
+	/**
+	 * Where |column|'s slot starts within a row
+	 */
+	uint32_t GetSlotOffset(int column) const {
+		return m_columns[column].offset;
+	}
+
+	/**
+	 * Get the next free row in the ring to fill in.  Loop side only.
+	 *
+	 * @return the row, or nullptr (and count a dropped row) if the ring
+	 *     is full
+	 */
+	uint8_t *BeginRow();
+
+	/**
+	 * Bitmap (laid out like the presence bitmap) just past |row| in the
+	 * ring, where the loop marks on-change columns whose cell has been
+	 * cleared since they were last present.  It never reaches the file;
+	 * it only stops CSV files and indexed rows carrying the old value.
+	 */
+	uint8_t *GetClearedBitmap(uint8_t *row) const {
+		return row + m_recordSize;
+	}
+
+	/**
+	 * Hand the row from BeginRow to the writer thread.  Never blocks.
+	 */
+	void CommitRow();
+
+	/**
+	 * Rows dropped because the ring was full
+	 */
+	uint64_t GetDroppedRows() const {
+		return m_droppedRows.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Rows that have made it to the file
+	 */
+	uint64_t GetWrittenRows() const {
+		return m_writtenRows.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Bytes thrown away because they couldn't be written, even after
+	 * deleting old logs to make room
+	 */
+	uint64_t GetLostBytes() const {
+		return m_lostBytes.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Number of segments started so far
+	 */
+	uint32_t GetNumSegments() const {
+		return m_numSegments.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct ColumnLayout {
+		Column column;
+		uint32_t offset;
+		std::string lastCsv;		/* on-change columns in CSV files */
+	};
+
+	static void *WriterMain(void *p);
+	void WriterLoop();
+
+	/**
+	 * Move every committed row from the ring into the batch buffer
+	 *
+	 * @return number of rows moved
+	 */
+	uint32_t DrainRing();
+	/**
+	 * Remember the on-change values in |row|, and if |fill| fill in the
+	 * ones it's missing
+	 *
+	 * @return |row|, or a filled in copy of it
+	 */
+	const uint8_t *CarryOnChange(const uint8_t *row, bool fill);
+
+	/**
+	 * @return the LogIndexReason |row| needs an index entry for, or -1 if
+	 *     it doesn't need one
+	 */
+	int GetIndexReason(const BinaryLogRecordHeader *row) const;
+
+	/**
+	 * Add an index entry for |row|, which is about to go on the end of the
+	 * batch buffer
+	 */
+	void AppendIndexEntry(const BinaryLogRecordHeader *row, int reason);
+	void AppendCsvRow(const uint8_t *row);
+	void AppendSparseRow(const uint8_t *row);
+	void AppendBlockRow(const uint8_t *row);
+	void AppendCsvHeader();
+	void AppendBinaryHeader(uint64_t startTimeUs);
+
+	/**
+	 * Compress the rows gathered in m_blockRows into one block on the end
+	 * of the batch buffer
+	 */
+	void AppendBlock();
+	void FlushBatch();
+
+	/**
+	 * Write out everything pending, close the current segment and start
+	 * the next one.  If the next one can't be created the rest of the log
+	 * goes on the end of the current one.
+	 */
+	void RotateSegment(uint64_t startTimeUs);
+
+	/**
+	 * Create segment |index| and write its header
+	 *
+	 * @return false (leaving the current segment open) if it couldn't be
+	 *     created
+	 */
+	bool OpenSegment(uint32_t index, uint64_t startTimeUs);
+
+	/**
+	 * Give back the space reserved past the end of the current segment,
+	 * make it durable and close it
+	 */
+	void CloseSegment();
+
+	/**
+	 * Create the index for the segment just opened
+	 */
+	void OpenIndex(uint64_t startTimeUs);
+
+	/**
+	 * Make what's been written so far durable if it's time to
+	 */
+	void Checkpoint(bool force);
+
+	/**
+	 * Delete the oldest logs (never the current segment) while the logs
+	 * in the directory and their indexes take up more than |budget| bytes
+	 * of disk, the current segment's reservation included.  Indexes whose
+	 * log is gone are deleted too.
+	 *
+	 * @param maxDeletes stop after deleting this many
+	 *
+	 * @return true if anything was deleted
+	 */
+	bool EnforceDiskBudget(uint64_t budget, unsigned int maxDeletes = UINT_MAX);
+
+	LogWriter(const LogWriter&) = delete;
+	LogWriter &operator=(const LogWriter&) = delete;
+
+	RTThreadConfig m_threadConfig;
+	LogFormat m_format;
+	int m_fd;
+
+	char m_directory[64];
+	char m_name[64];
+	char m_fileName[160];
+	uint32_t m_segmentIndex;
+	uint64_t m_segmentBytes;
+	uint32_t m_segmentRows;
+	uint64_t m_segmentLimit;
+	uint64_t m_diskBudget;
+	bool m_rotateOnModeChange;
+	uint32_t m_checkpointMs;
+	uint64_t m_lastCheckpointMs;
+	int m_lastMode;
+
+	/* index of the current segment (-1 for CSV, which has none) */
+	int m_indexFd;
+	std::vector<LogIndexEntry> m_indexBatch;
+	uint64_t m_modeStartUs;
+	uint64_t m_lastIndexUs;
+
+	std::vector<ColumnLayout> m_columns;
+	uint32_t m_recordSize;
+	uint32_t m_ringStride;			/* a row and its cleared bitmap */
+
+	/* on-change columns: the last value written, laid out as in a row, and
+	 * room for a copy of a segment's first row to fill them in */
+	std::vector<uint8_t> m_onChangeValues;
+	std::vector<uint8_t> m_haveOnChangeValue;
+	std::vector<uint8_t> m_firstRow;
+
+	uint32_t m_ringRows;
+	uint32_t m_batchRows;
+	uint32_t m_batchMs;
+
+	/* rows [m_head, m_tail) are committed and waiting for the writer */
+	std::vector<uint8_t> m_ring;
+	std::atomic<uint32_t> m_head;
+	std::atomic<uint32_t> m_tail;
+
+	/* only touched by the writer thread (and Open/Close) */
+	std::vector<char> m_batch;
+
+	/* compressed format: rows waiting to become a block, the same rows
+	 * after LogRowsEncode, and the LZ hash table */
+	std::vector<uint8_t> m_blockRows;
+	std::vector<uint8_t> m_blockEncoded;
+	std::vector<uint32_t> m_lzTable;
+	uint32_t m_blockCount;
+
+	pthread_t m_thread;
+	bool m_threadRunning;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	bool m_stop;
+
+	std::atomic<uint64_t> m_droppedRows;
+	std::atomic<uint64_t> m_writtenRows;
+	std::atomic<uint64_t> m_lostBytes;
+	std::atomic<uint32_t> m_numSegments;
+	bool m_reportedError;
+	bool m_segmentFailed;			/* stay in the current segment */
+};
+
+}
@@ -0,0 +1,115 @@
+/*
+ * TaskStatsLogger.cpp
+ */
+
+#include "lib/logging/TaskStatsLogger.h"
+
+#include <stdio.h>
+
+namespace frc973 {
+
+static const uint32_t phaseFlags[NUM_TASK_PHASES] = {
+	TASK_START_MODE, TASK_STOP_MODE,
+	TASK_PRE_PERIODIC, TASK_PERIODIC, TASK_POST_PERIODIC
+};
+
+TaskStatsLogger::StatsCell::StatsCell(const char *name, Source source,
+		TaskMgr *scheduler, const TaskStats *stats)
+	 : LogCell(m_nameBuf, LOG_CELL_INT)
+	 , m_source(source)
+	 , m_scheduler(scheduler)
+	 , m_stats(stats)
+	 , m_lastCount(0)
+	 , m_lastSumUs(0)
+{
+	snprintf(m_nameBuf, sizeof(m_nameBuf), "%s", name);
+	if (m_stats != nullptr) {
+		m_lastCount = m_stats->GetCount();
+		m_lastSumUs = m_stats->GetSumUs();
+	}
+	else if (m_source == SOURCE_SKIPS) {
+		m_lastCount = m_scheduler->GetTotalSkips();
+	}
+}
+
+void TaskStatsLogger::StatsCell::UpdateContent() {
+	uint64_t count, sumUs;
+
+	switch (m_source) {
+		case SOURCE_MEAN_US:
+			count = m_stats->GetCount();
+			sumUs = m_stats->GetSumUs();
+			if (count < m_lastCount) {
+				/* the stats were reset */
+				m_lastCount = 0;
+				m_lastSumUs = 0;
+			}
+			if (count == m_lastCount) {
+				ClearCell();
+			}
+			else {
+				LogInt((sumUs - m_lastSumUs) / (count - m_lastCount));
+			}
+			m_lastCount = count;
+			m_lastSumUs = sumUs;
+			break;
+		case SOURCE_OVERRUNS:
+			count = m_stats->GetOverruns();
+			LogInt(count >= m_lastCount ? count - m_lastCount : count);
+			m_lastCount = count;
+			break;
+		case SOURCE_SKIPS:
+			count = m_scheduler->GetTotalSkips();
+			LogInt(count - m_lastCount);
+			m_lastCount = count;
+			break;
+		case SOURCE_DEGRADATION:
+			LogInt(m_scheduler->GetDegradationLevel());
+			break;
+	}
+}
+
+TaskStatsLogger::TaskStatsLogger(TaskMgr *scheduler, LogSpreadsheet *logger)
+	 : m_cells()
+{
+	char name[64];
+
+	/* mode start/stop only happen a handful of times a match so only the
+	 * per-cycle callbacks get a column */
+	for (int i = 0; i < scheduler->GetNumTasks(); i++) {
+		for (int phase = PHASE_PRE_PERIODIC; phase < NUM_TASK_PHASES;
+				phase++) {
+			if (!(scheduler->GetTaskFlags(i) & phaseFlags[phase])) {
+				continue;
+			}
+
+			snprintf(name, sizeof(name), "%s %s avg us",
+					scheduler->GetTaskName(i), taskPhaseNames[phase]);
+			m_cells.push_back(new StatsCell(name, StatsCell::SOURCE_MEAN_US,
+					scheduler, &scheduler->GetTaskStats(i, (TaskPhase) phase)));
+		}
+	}
+
+	/* the flight recorder has its own "Cycle time us" and "Cycle overruns",
+	 * so these names differ */
+	m_cells.push_back(new StatsCell("Cycle avg us",
+			StatsCell::SOURCE_MEAN_US, scheduler, &scheduler->GetCycleStats()));
+	m_cells.push_back(new StatsCell("Cycle overruns in row",
+			StatsCell::SOURCE_OVERRUNS, scheduler, &scheduler->GetCycleStats()));
+	m_cells.push_back(new StatsCell("Task skips in row",
+			StatsCell::SOURCE_SKIPS, scheduler, nullptr));
+	m_cells.push_back(new StatsCell("Task degradation",
+			StatsCell::SOURCE_DEGRADATION, scheduler, nullptr));
+
+	for (StatsCell *cell : m_cells) {
+		logger->RegisterCell(cell);
+	}
+}
+
+TaskStatsLogger::~TaskStatsLogger() {
+	for (StatsCell *cell : m_cells) {
+		delete cell;
+	}
+}
+
+}
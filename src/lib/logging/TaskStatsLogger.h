@@ -0,0 +1,68 @@
+/*
+ * TaskStatsLogger.h
+ *
+ * Adds a column to the LogSpreadsheet for every callback of every task
+ * registered with a TaskMgr (plus one for the whole cycle) so task timing
+ * shows up in the log next to everything else.  Each cell is an integer:
+ * the mean time in microseconds the callback took over the cycles since
+ * the last row, empty if it didn't run.  Two more columns count the cycle
+ * overruns and the best-effort callbacks skipped since the last row, and
+ * one holds the degradation level.  Since-boot percentiles are printed by
+ * TaskMgr::PrintTaskStats instead.
+ *
+ * Construct this after all of the tasks have been registered and before
+ * LogSpreadsheet::InitializeTable is called.
+ */
+
+#pragma once
+
+#include "lib/logging/LogSpreadsheet.h"
+#include "lib/TaskMgr.h"
+#include <vector>
+
+namespace frc973 {
+
+class TaskStatsLogger {
+public:
+	/**
+	 * Register a column for each (task, callback) pair currently registered
+	 * with |scheduler|.
+	 *
+	 * @param scheduler task manager whose tasks should be logged
+	 * @param logger spreadsheet to add the columns to
+	 */
+	TaskStatsLogger(TaskMgr *scheduler, LogSpreadsheet *logger);
+	virtual ~TaskStatsLogger();
+
+private:
+	/**
+	 * Integer cell filled in right before the spreadsheet reads it.  The
+	 * stats it reads are looked up once, when it's made.
+	 */
+	class StatsCell : public LogCell {
+	public:
+		enum Source {
+			SOURCE_MEAN_US,			/* mean of |stats| since the last row */
+			SOURCE_OVERRUNS,		/* overruns of |stats| since the last row */
+			SOURCE_SKIPS,			/* callbacks skipped since the last row */
+			SOURCE_DEGRADATION		/* current degradation level */
+		};
+
+		StatsCell(const char *name, Source source, TaskMgr *scheduler,
+				const TaskStats *stats);
+
+		void UpdateContent() override;
+
+	private:
+		char m_nameBuf[64];
+		Source m_source;
+		TaskMgr *m_scheduler;
+		const TaskStats *m_stats;
+		uint64_t m_lastCount;
+		uint64_t m_lastSumUs;
+	};
+
+	std::vector<StatsCell*> m_cells;
+};
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Mailbox.h
+ *
+ * Mailbox - holds the most recent sample a sensor thread has produced,
+ * stamped with when it was produced, for any other thread to pick up.
+ *
+ * There is no queue: each Publish replaces the previous sample.  The
+ * producer never blocks and readers never take a lock; they always get
+ * the newest complete sample (see SeqLock), so a control loop reading a
+ * sensor several times a cycle can't be held up by the sensor thread.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "lib/util/SeqLock.h"
+#include "lib/util/Util.h"
+
+namespace frc973 {
+
+template <typename T>
+class Mailbox {
+public:
+	Mailbox() : m_sample() {}
+
+	explicit Mailbox(const T &initial) : m_sample() {
+		Publish(initial);
+	}
+
+	/**
+	 * Replace the held sample, stamped with the current time.  Only one
+	 * thread may publish.
+	 */
+	void Publish(const T &value) {
+		Publish(value, GetUsecTime());
+	}
+
+	void Publish(const T &value, uint64_t timeUs) {
+		Sample sample;
+
+		sample.value = value;
+		sample.timeUs = timeUs;
+		m_sample.Write(sample);
+	}
+
+	/**
+	 * Copy out the newest sample.  May be called from any thread.
+	 *
+	 * @param out filled with the sample, or a default T if none has been
+	 *     published yet
+	 * @param timeUs if not null, filled with when the sample was published
+	 *
+	 * @return false if nothing has been published yet
+	 */
+	bool Read(T *out, uint64_t *timeUs = nullptr) const {
+		Sample sample;
+		uint32_t version = m_sample.Read(&sample);
+
+		*out = sample.value;
+		if (timeUs != nullptr) {
+			*timeUs = sample.timeUs;
+		}
+		return version != 0;
+	}
+
+	T Read() const {
+		T value;
+		Read(&value);
+		return value;
+	}
+
+	/**
+	 * Time since the newest sample was published, in microseconds
+	 */
+	uint64_t GetAgeUs() const {
+		return GetUsecTime() - m_sample.Read().timeUs;
+	}
+
+	/**
+	 * Number of samples published so far.  A reader can compare this
+	 * between calls to tell whether anything new has arrived.
+	 */
+	uint32_t GetVersion() const {
+		return m_sample.GetVersion();
+	}
+
+private:
+	struct Sample {
+		T value;
+		uint64_t timeUs;
+	};
+
+	Mailbox(const Mailbox&) = delete;
+	Mailbox &operator=(const Mailbox&) = delete;
+
+	SeqLock<Sample> m_sample;
+};
+
+}
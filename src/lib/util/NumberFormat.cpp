@@ -0,0 +1,217 @@
+/*
+ * NumberFormat.cpp
+ */
+
+#include "lib/util/NumberFormat.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace frc973 {
+
+namespace {
+
+const char DIGIT_PAIRS[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+const uint32_t POWERS_OF_TEN[FORMAT_MAX_FAST_DECIMALS + 1] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000
+};
+
+/* long enough for a sign, 20 digits, a point and 9 decimals */
+const int MAX_FAST_LENGTH = 32;
+
+/**
+ * Write the digits of |val| so they end right before |end|, two at a
+ * time.  64 bit division is a library call on the RIO, so most of the
+ * work is done in 32 bits.
+ *
+ * @return where the digits start
+ */
+char *WriteDigits(uint64_t val, char *end) {
+	while (val > UINT32_MAX) {
+		uint32_t low = val % 100;
+
+		val /= 100;
+		end -= 2;
+		memcpy(end, DIGIT_PAIRS + low * 2, 2);
+	}
+
+	uint32_t small = (uint32_t) val;
+	while (small >= 100) {
+		uint32_t low = small % 100;
+
+		small /= 100;
+		end -= 2;
+		memcpy(end, DIGIT_PAIRS + low * 2, 2);
+	}
+	if (small >= 10) {
+		end -= 2;
+		memcpy(end, DIGIT_PAIRS + small * 2, 2);
+	}
+	else {
+		*--end = '0' + small;
+	}
+	return end;
+}
+
+/**
+ * Copy |len| bytes of text to |buf| the way snprintf would: cut off to
+ * fit and NUL terminated
+ */
+int CopyOut(const char *text, int len, char *buf, size_t size) {
+	if (size > 0) {
+		size_t copy = (size_t) len < size ? len : size - 1;
+
+		memcpy(buf, text, copy);
+		buf[copy] = '\0';
+	}
+	return len;
+}
+
+/**
+ * Round |m| * |scale| / 2^|shift| to the nearest integer, ties to even.
+ *
+ * @return false if the result doesn't fit in 64 bits
+ */
+bool ScaleAndRound(uint64_t m, uint32_t scale, int shift, uint64_t *out) {
+	/* the product is at most 53 + 30 bits, so it takes two words */
+	uint64_t lowProduct = (m & UINT32_MAX) * scale;
+	uint64_t midProduct = (m >> 32) * scale + (lowProduct >> 32);
+	uint64_t hi = midProduct >> 32;
+	uint64_t lo = (midProduct << 32) | (lowProduct & UINT32_MAX);
+	uint64_t q, remHi, remLo, halfHi, halfLo;
+
+	if (shift >= 128) {
+		/* less than a half */
+		*out = 0;
+		return true;
+	}
+	if (shift == 0) {
+		*out = lo;
+		return hi == 0;
+	}
+	if (shift < 64) {
+		if ((hi >> shift) != 0) {
+			return false;
+		}
+		q = (lo >> shift) | (hi << (64 - shift));
+		remHi = 0;
+		remLo = lo & ((1ULL << shift) - 1);
+		halfHi = 0;
+		halfLo = 1ULL << (shift - 1);
+	}
+	else {
+		q = shift == 64 ? hi : hi >> (shift - 64);
+		remHi = shift == 64 ? 0 : hi & ((1ULL << (shift - 64)) - 1);
+		remLo = lo;
+		halfHi = shift == 64 ? 0 : 1ULL << (shift - 65);
+		halfLo = shift == 64 ? 1ULL << 63 : 0;
+	}
+
+	if (remHi > halfHi || (remHi == halfHi && remLo > halfLo) ||
+			(remHi == halfHi && remLo == halfLo && (q & 1) != 0)) {
+		if (q == UINT64_MAX) {
+			return false;
+		}
+		q++;
+	}
+	*out = q;
+	return true;
+}
+
+}
+
+int FormatInt(int64_t val, char *buf, size_t size) {
+	char text[MAX_FAST_LENGTH];
+	char *end = text + sizeof(text);
+	char *start;
+
+	if (val < 0) {
+		/* negate unsigned so INT64_MIN works */
+		start = WriteDigits(0 - (uint64_t) val, end);
+		*--start = '-';
+	}
+	else {
+		start = WriteDigits(val, end);
+	}
+	return CopyOut(start, end - start, buf, size);
+}
+
+int FormatUnsigned(uint64_t val, char *buf, size_t size) {
+	char text[MAX_FAST_LENGTH];
+	char *end = text + sizeof(text);
+	char *start = WriteDigits(val, end);
+
+	return CopyOut(start, end - start, buf, size);
+}
+
+int FormatFixed(double val, int decimals, char *buf, size_t size) {
+	uint64_t bits, m, scaled;
+	int exponent;
+	bool fast;
+
+	if (decimals < 0) {
+		decimals = FORMAT_DEFAULT_DECIMALS;
+	}
+	memcpy(&bits, &val, sizeof(bits));
+	exponent = (bits >> 52) & 0x7ff;
+	m = bits & ((1ULL << 52) - 1);
+
+	/* infinities and NaNs */
+	fast = exponent != 0x7ff && decimals <= FORMAT_MAX_FAST_DECIMALS;
+
+	/* val = m * 2^exponent from here on */
+	if (exponent == 0) {
+		exponent = -1074;
+	}
+	else {
+		m |= 1ULL << 52;
+		exponent -= 1075;
+	}
+
+	uint32_t scale = fast ? POWERS_OF_TEN[decimals] : 1;
+	if (fast && exponent >= 0) {
+		/* m has 53 bits, so m << 11 and up are too big anyway */
+		fast = exponent < 11 && (m << exponent) <= UINT64_MAX / scale;
+		scaled = fast ? (m << exponent) * scale : 0;
+	}
+	else if (fast) {
+		fast = ScaleAndRound(m, scale, -exponent, &scaled);
+	}
+	if (!fast) {
+		return snprintf(buf, size, "%.*f", decimals, val);
+	}
+
+	char text[MAX_FAST_LENGTH];
+	char *end = text + sizeof(text);
+	char *start = end;
+
+	if (decimals > 0) {
+		uint32_t fraction = scaled % scale;
+
+		/* the decimals, zero padded */
+		start = WriteDigits(fraction, end);
+		while (start > end - decimals) {
+			*--start = '0';
+		}
+		*--start = '.';
+	}
+	start = WriteDigits(scaled / scale, start);
+	if (bits >> 63) {
+		*--start = '-';
+	}
+	return CopyOut(start, end - start, buf, size);
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+ * NumberFormat.h
+ *
+ * Number to text conversions for the places that write a lot of numbers
+ * (log cells, the CSV writer, dashboard lines), without going through
+ * snprintf.
+ *
+ * The results are exactly what snprintf("%lld") and snprintf("%.*f") give
+ * in the C locale, including the rounding of doubles (the exact binary
+ * value, ties to even), so switching a caller over changes no output.
+ * Nothing allocates or looks at the locale.  Doubles too big for the fast
+ * path (more than about 1e13 at six decimals), infinities and NaNs are
+ * handed to snprintf.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace frc973 {
+
+/**
+ * Most digits after the point FormatFixed writes without snprintf
+ */
+static constexpr int FORMAT_MAX_FAST_DECIMALS = 9;
+
+/**
+ * Digits after the point "%lf" writes
+ */
+static constexpr int FORMAT_DEFAULT_DECIMALS = 6;
+
+/**
+ * Write |val| in decimal, as snprintf("%lld") would.  Like snprintf, the
+ * text is cut off to fit in |size| and always NUL terminated.
+ *
+ * @return length of the whole text, even if it was cut off
+ */
+int FormatInt(int64_t val, char *buf, size_t size);
+
+/**
+ * Write |val| in decimal, as snprintf("%llu") would
+ *
+ * @return length of the whole text, even if it was cut off
+ */
+int FormatUnsigned(uint64_t val, char *buf, size_t size);
+
+/**
+ * Write |val| with |decimals| digits after the point, as
+ * snprintf("%.*f", decimals, val) would
+ *
+ * @return length of the whole text, even if it was cut off
+ */
+int FormatFixed(double val, int decimals, char *buf, size_t size);
+
+}
@@ -0,0 +1,108 @@
+/*
+ * SeqLock.h
+ *
+ * SeqLock - lets one thread publish a small plain-old-data value that any
+ * number of other threads can read without taking a lock.
+ *
+ * The writer bumps a sequence number to odd, copies the value in and bumps
+ * it back to even.  Readers copy the value out and retry if the sequence
+ * number was odd or changed while they were copying, so a reader can
+ * never see half of one write and half of another, and the writer never
+ * waits on a reader.  A read only retries if it overlaps a write, which
+ * for a value written once a cycle almost never happens.
+ *
+ * The value is kept in atomic words (rather than copied with a plain
+ * memcpy) so overlapping reads and writes are not a data race.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+namespace frc973 {
+
+template <typename T>
+class SeqLock {
+	static_assert(std::is_trivially_copyable<T>::value,
+			"SeqLock can only hold trivially copyable types");
+public:
+	SeqLock() : m_sequence(0) {
+		T empty = T();
+		Write(empty);
+		m_sequence.store(0, std::memory_order_relaxed);
+	}
+
+	explicit SeqLock(const T &initial) : m_sequence(0) {
+		Write(initial);
+		m_sequence.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Publish a new value.  Only one thread may write at a time.
+	 */
+	void Write(const T &value) {
+		uint32_t words[NUM_WORDS];
+		uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+
+		words[NUM_WORDS - 1] = 0;
+		memcpy(words, &value, sizeof(T));
+
+		m_sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (int i = 0; i < NUM_WORDS; i++) {
+			m_words[i].store(words[i], std::memory_order_relaxed);
+		}
+		m_sequence.store(seq + 2, std::memory_order_release);
+	}
+
+	/**
+	 * Copy out the latest value.  May be called from any thread.
+	 *
+	 * @param out filled with the value
+	 *
+	 * @return the version of the value read (number of writes so far)
+	 */
+	uint32_t Read(T *out) const {
+		uint32_t words[NUM_WORDS];
+		uint32_t before, after;
+
+		do {
+			before = m_sequence.load(std::memory_order_acquire);
+			for (int i = 0; i < NUM_WORDS; i++) {
+				words[i] = m_words[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = m_sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) != 0 || before != after);
+
+		memcpy(out, words, sizeof(T));
+		return before / 2;
+	}
+
+	T Read() const {
+		T value;
+		Read(&value);
+		return value;
+	}
+
+	/**
+	 * Get the number of values written so far
+	 */
+	uint32_t GetVersion() const {
+		return m_sequence.load(std::memory_order_acquire) / 2;
+	}
+
+private:
+	static constexpr int NUM_WORDS = (sizeof(T) + 3) / 4;
+
+	SeqLock(const SeqLock&) = delete;
+	SeqLock &operator=(const SeqLock&) = delete;
+
+	std::atomic<uint32_t> m_sequence;
+	std::atomic<uint32_t> m_words[NUM_WORDS];
+};
+
+}
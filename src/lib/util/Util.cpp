@@ -4,7 +4,7 @@
 
 namespace frc973 {
 
-const char *robotModes[] = {"Disabled", "Auto", "TeleOp"};
+const char *robotModes[] = {"Disabled", "Auto", "TeleOp", "Test"};
 
 const char *GetRobotModeString() {
 	return robotModes[GetRobotMode()];
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <math.h>
 #include "WPILib.h"
+#include "lib/util/VirtualClock.h"
 using namespace frc;
 
 namespace frc973 {
@@ -83,8 +84,12 @@ inline double magnitude(double x,double y) {
 	return sqrt(pow(x, 2.0) + pow(y, 2.0));
 }
 
-/* Get the current timestamp in microseconds */
+/* Get the current timestamp in microseconds (virtual time while the
+ * VirtualClock is enabled) */
 inline uint64_t GetUsecTime() {
+	if (VirtualClock::IsEnabled()) {
+		return VirtualClock::GetTimeUs();
+	}
 	return GetFPGATime();
 }
 
@@ -0,0 +1,41 @@
+/*
+ * VirtualClock.cpp
+ */
+
+#include "lib/util/VirtualClock.h"
+
+#include <atomic>
+
+namespace frc973 {
+
+static std::atomic<bool> virtualClockEnabled(false);
+static std::atomic<uint64_t> virtualTimeUs(0);
+
+void VirtualClock::Enable(uint64_t startUs) {
+	virtualTimeUs.store(startUs, std::memory_order_release);
+	virtualClockEnabled.store(true, std::memory_order_release);
+}
+
+void VirtualClock::Disable() {
+	virtualClockEnabled.store(false, std::memory_order_release);
+}
+
+bool VirtualClock::IsEnabled() {
+	return virtualClockEnabled.load(std::memory_order_relaxed);
+}
+
+uint64_t VirtualClock::GetTimeUs() {
+	return virtualTimeUs.load(std::memory_order_acquire);
+}
+
+void VirtualClock::SetTimeUs(uint64_t nowUs) {
+	if (nowUs > virtualTimeUs.load(std::memory_order_relaxed)) {
+		virtualTimeUs.store(nowUs, std::memory_order_release);
+	}
+}
+
+void VirtualClock::AdvanceUs(uint64_t deltaUs) {
+	virtualTimeUs.fetch_add(deltaUs, std::memory_order_acq_rel);
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * VirtualClock.h
+ *
+ * VirtualClock - replaces the FPGA clock behind GetUsecTime with a clock
+ * that only moves when it is told to.
+ *
+ * While the virtual clock is enabled GetUsecTime (and so GetMsecTime,
+ * GetSecTime and every task's timing) returns the virtual time instead of
+ * the FPGA time.  LockstepRunner uses it to step the robot loop and task
+ * manager threads through a match deterministically and as fast as the
+ * CPU allows.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace frc973 {
+
+class VirtualClock {
+public:
+	/**
+	 * Switch GetUsecTime over to the virtual clock
+	 *
+	 * @param startUs virtual time to start at
+	 */
+	static void Enable(uint64_t startUs = 0);
+
+	/**
+	 * Switch GetUsecTime back to the FPGA clock
+	 */
+	static void Disable();
+
+	static bool IsEnabled();
+
+	/**
+	 * Get the current virtual time in microseconds
+	 */
+	static uint64_t GetTimeUs();
+
+	/**
+	 * Move the virtual clock to the given time.  The clock never goes
+	 * backwards; earlier times are ignored.
+	 */
+	static void SetTimeUs(uint64_t nowUs);
+
+	/**
+	 * Move the virtual clock forward by the given amount
+	 */
+	static void AdvanceUs(uint64_t deltaUs);
+};
+
+}
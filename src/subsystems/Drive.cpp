@@ -31,8 +31,7 @@ Drive::Drive(TaskMgr *scheduler, CANTalon *left, CANTalon *right,
             )
          : DriveBase(scheduler, this, this, nullptr)
          , m_austinGyro(gyro)
-         , m_angle(0.0)
-         , m_angleRate(0.0)
+         , m_state()
          , m_leftCommand(0.0)
          , m_rightCommand(0.0)
          , m_leftMotor(left)
@@ -43,17 +42,22 @@ Drive::Drive(TaskMgr *scheduler, CANTalon *left, CANTalon *right,
                  new BoilerPixyVisionDriveController(boilerPixy))
          , m_gearPixyDriveController(
                  new GearPixyVisionDriveController(gearPixy))
-         , m_angleLog(new LogCell("Angle"))
-         , m_angularRateLog(new LogCell("Angular Rate"))
-         , m_leftDistLog(new LogCell("Left Encoder Distance"))
-         , m_leftDistRateLog(new LogCell("Left Encoder Rate"))
-         , m_rightDistLog(new LogCell("Right Encoder Distance"))
-         , m_rightDistRateLog(new LogCell("Right Encoder Rate"))
-         , m_leftCommandLog(new LogCell("Left motor signal (pow or vel)"))
-         , m_rightCommandLog(new LogCell("Right motor signal (pow or vel)"))
-         , m_leftVoltageLog(new LogCell("Left motor voltage"))
-         , m_rightVoltageLog(new LogCell("Right motor voltage"))
-         , m_currentLog(new LogCell("Drive current"))
+         , m_angleLog(new LogCell("Angle", LOG_CELL_DOUBLE))
+         , m_angularRateLog(new LogCell("Angular Rate", LOG_CELL_DOUBLE))
+         , m_leftDistLog(new LogCell("Left Encoder Distance", LOG_CELL_DOUBLE))
+         , m_leftDistRateLog(new LogCell("Left Encoder Rate", LOG_CELL_DOUBLE))
+         , m_rightDistLog(new LogCell("Right Encoder Distance",
+                              LOG_CELL_DOUBLE))
+         , m_rightDistRateLog(new LogCell("Right Encoder Rate",
+                                  LOG_CELL_DOUBLE))
+         , m_leftCommandLog(new LogCell("Left motor signal (pow or vel)",
+                                LOG_CELL_DOUBLE))
+         , m_rightCommandLog(new LogCell("Right motor signal (pow or vel)",
+                                 LOG_CELL_DOUBLE))
+         , m_leftVoltageLog(new LogCell("Left motor voltage", LOG_CELL_DOUBLE))
+         , m_rightVoltageLog(new LogCell("Right motor voltage",
+                                 LOG_CELL_DOUBLE))
+         , m_currentLog(new LogCell("Drive current", LOG_CELL_DOUBLE))
 {
     fprintf(stderr, "Initializing Drive Subsystem %p\n", this);
     fprintf(stderr, "Survived fprintf yes its up to date\n");
@@ -84,23 +88,69 @@ Drive::Drive(TaskMgr *scheduler, CANTalon *left, CANTalon *right,
     }
     fprintf(stderr, "Enabled spreadsheets\n");
 
-    scheduler->RegisterTask("Drive", this, TASK_PERIODIC);
+    scheduler->RegisterTask("Drive", this,
+            TASK_PRE_PERIODIC | TASK_PERIODIC);
     fprintf(stderr, "Scheduled task\n");
 }
 
 /**
  *  Zeroes gyro, left drive pos, and right drive pos
+ *
+ *  Takes a fresh snapshot first so the zeros and everything read after
+ *  them this cycle agree.
  */
 void Drive::Zero() {
+    CaptureState();
+
+    DriveState state = m_state.Read();
+    m_gyroZero = state.gyroAngle;
+    m_leftPosZero = state.leftPos;
+    m_rightPosZero = state.rightPos;
+}
+
+/**
+ * Read every drive sensor once for this cycle
+ */
+void Drive::CaptureState() {
+    DriveState state;
+    DriveState prev = m_state.Read();
+
+    state.timeUs = GetUsecTime();
+    state.leftPos = m_leftMotor->GetPosition() * DRIVE_DIST_PER_REVOLUTION;
+    state.rightPos = -m_rightMotor->GetPosition() * DRIVE_DIST_PER_REVOLUTION;
+    state.leftRate = m_leftMotor->GetSpeed() * DRIVE_IPS_FROM_RPM;
+    state.rightRate = -m_rightMotor->GetSpeed() * DRIVE_IPS_FROM_RPM;
+    state.current = (Util::abs(m_rightMotor->GetOutputCurrent()) +
+            Util::abs(m_leftMotor->GetOutputCurrent())) / 2.0;
+
+    state.gyroAngle = prev.gyroAngle;
+    state.gyroRate = prev.gyroRate;
     if (m_austinGyro) {
-        m_gyroZero = m_austinGyro->GetAngle();
-    }
-    if (m_leftMotor) {
-        m_leftPosZero = m_leftMotor->GetPosition() * DRIVE_DIST_PER_REVOLUTION;
-    }
-    if (m_rightMotor) {
-        m_rightPosZero = -m_rightMotor->GetPosition() * DRIVE_DIST_PER_REVOLUTION;
+        //CTRE PigeonImu config
+        /*
+        double xyz_dps[4];
+        m_gyro->GetRawGyro(xyz_dps);
+        state.gyroRate = xyz_dps[2];
+        */
+
+        //Austin ADXRS450_Gyro config
+        state.gyroAngle = m_austinGyro->GetAngle();
+        double currRate = m_austinGyro->GetRate();
+        if (currRate != 0) {
+            state.gyroRate = currRate;
+        }
     }
+
+    m_state.Write(state);
+}
+
+/**
+ * Returns this cycle's snapshot of the raw drive sensors
+ *
+ * @return  sensor values (not zeroed) and when they were read
+ */
+Drive::DriveState Drive::GetState() const {
+    return m_state.Read();
 }
 
 /**
@@ -197,8 +247,7 @@ PIDDriveController *Drive::PIDTurn(double turn, RelativeTo relativity,
  * @return  Left Drive Distance reported in inches
  */
 double Drive::GetLeftDist() const {
-    return m_leftMotor->GetPosition() * DRIVE_DIST_PER_REVOLUTION -
-        m_leftPosZero;
+    return m_state.Read().leftPos - m_leftPosZero;
 }
 
 /**
@@ -207,8 +256,7 @@ double Drive::GetLeftDist() const {
  * @return  Right Drive Distance reported in inches
  */
 double Drive::GetRightDist() const {
-    return -m_rightMotor->GetPosition() * DRIVE_DIST_PER_REVOLUTION -
-        m_rightPosZero;
+    return m_state.Read().rightPos - m_rightPosZero;
 }
 
 /**
@@ -217,7 +265,7 @@ double Drive::GetRightDist() const {
  * @return  Left Drive Rate or Speed reported in inches Reported in inches per second; As per manual 17.2.1, GetSpeed reports RPM
  */
 double Drive::GetLeftRate() const {
-    return m_leftMotor->GetSpeed() * DRIVE_IPS_FROM_RPM;
+    return m_state.Read().leftRate;
 }
 
 /**
@@ -226,7 +274,7 @@ double Drive::GetLeftRate() const {
  * @return  Right Drive Rate or Speed reported in inches Reported in inches per second; As per manual 17.2.1, GetSpeed reports RPM
  */
 double Drive::GetRightRate() const {
-    return -m_rightMotor->GetSpeed() * DRIVE_IPS_FROM_RPM;
+    return m_state.Read().rightRate;
 }
 
 /**
@@ -235,7 +283,9 @@ double Drive::GetRightRate() const {
  * @return  Average Drive Distance reported in inches
  */
 double Drive::GetDist() const {
-    return (GetLeftDist() + GetRightDist()) / 2.0;
+    DriveState state = m_state.Read();
+    return ((state.leftPos - m_leftPosZero) +
+            (state.rightPos - m_rightPosZero)) / 2.0;
 }
 
 /**
@@ -244,7 +294,8 @@ double Drive::GetDist() const {
  * @return  Average Drive Rate or Speed reported in inches Reported in inches per second; As per manual 17.2.1, GetSpeed reports RPM
  */
 double Drive::GetRate() const {
-    return (GetLeftRate() + GetRightRate()) / 2.0;
+    DriveState state = m_state.Read();
+    return (state.leftRate + state.rightRate) / 2.0;
 }
 
 /**
@@ -253,8 +304,7 @@ double Drive::GetRate() const {
  * @return  Avergage current reported in amperes
  */
 double Drive::GetDriveCurrent() const {
-    return (Util::abs(m_rightMotor->GetOutputCurrent()) +
-            Util::abs(m_leftMotor->GetOutputCurrent())) / 2.0;
+    return m_state.Read().current;
 }
 
 /**
@@ -263,7 +313,7 @@ double Drive::GetDriveCurrent() const {
  * @return  Current angle position with respect to initial position
  */
 double Drive::GetAngle() const {
-    return -(m_angle - m_gyroZero);
+    return -(m_state.Read().gyroAngle - m_gyroZero);
 }
 
 /**
@@ -272,7 +322,7 @@ double Drive::GetAngle() const {
  * @return  Current angular rate
  */
 double Drive::GetAngularRate() const {
-    return -m_angleRate;
+    return -m_state.Read().gyroRate;
 }
 
 /**
@@ -313,37 +363,27 @@ void Drive::SetDriveControlMode(CANSpeedController::ControlMode mode){
     m_controlMode = mode;
 }
 
+void Drive::TaskPrePeriodic(RobotMode mode) {
+    CaptureState();
+}
+
 void Drive::TaskPeriodic(RobotMode mode) {
-    m_angle = m_austinGyro->GetAngle();
-
-    //CTRE PigeonImu config
-    /*
-    double xyz_dps[4];
-    m_gyro->GetRawGyro(xyz_dps);
-    m_angleRate = xyz_dps[2];
-    */
-
-    //Austin ADXRS450_Gyro config
-    double currRate = m_austinGyro->GetRate();
-    if(currRate == 0){
-    }
-    else{
-      m_angleRate = currRate;
-    }
+    DriveState state = m_state.Read();
+    double angle = -(state.gyroAngle - m_gyroZero);
+    double leftDist = state.leftPos - m_leftPosZero;
+    double rightDist = state.rightPos - m_rightPosZero;
 
     DBStringPrintf(DB_LINE9, "l %2.1lf r %2.1lf g %2.1lf",
-            this->GetLeftDist(),
-            this->GetRightDist(),
-            this->GetAngle());
+            leftDist, rightDist, angle);
 
-    m_angleLog->LogDouble(GetAngle());
-    m_angularRateLog->LogDouble(GetAngularRate());
+    m_angleLog->LogDouble(angle);
+    m_angularRateLog->LogDouble(-state.gyroRate);
 
-    m_leftDistLog->LogDouble(GetLeftDist());
-    m_leftDistRateLog->LogDouble(GetLeftRate());
+    m_leftDistLog->LogDouble(leftDist);
+    m_leftDistRateLog->LogDouble(state.leftRate);
 
-    m_rightDistLog->LogDouble(GetRightDist());
-    m_rightDistRateLog->LogDouble(GetRightRate());
+    m_rightDistLog->LogDouble(rightDist);
+    m_rightDistRateLog->LogDouble(state.rightRate);
 
     if (m_controlMode == CANSpeedController::ControlMode::kSpeed) {
         m_leftCommandLog->LogDouble(m_leftCommand * DRIVE_IPS_FROM_RPM);
@@ -361,7 +401,7 @@ void Drive::TaskPeriodic(RobotMode mode) {
     m_leftVoltageLog->LogDouble(m_leftMotor->GetOutputVoltage());
     m_rightVoltageLog->LogDouble(m_rightMotor->GetOutputVoltage());
 
-    m_currentLog->LogDouble(GetDriveCurrent());
+    m_currentLog->LogDouble(state.current);
 }
 
 void Drive::SetBoilerJoystickTerm(double throttle, double turn) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lib/DriveBase.h"
+#include "lib/util/SeqLock.h"
 #include "RobotInfo.h"
 #include "WPILib.h"
 #include "CANTalon.h"
@@ -41,6 +42,11 @@ class SPIGyro;
  *  * DriveStateProvider... provides the controller with position/angle/speed etc
  *  * DrivecontrolSignalReceiver... translates controller output signal to motor
  *  		input signal
+ *
+ * The encoders and gyro are read once per cycle in TaskPrePeriodic and every
+ * DriveStateProvider getter is served from that snapshot, so controllers see
+ * one consistent sample per cycle and we don't go out on CAN for the same
+ * value over and over.
  */
 class Drive :
         public DriveBase,
@@ -48,6 +54,21 @@ class Drive :
         public DriveControlSignalReceiver
 {
 public:
+    /**
+     * Raw sensor values captured at the start of a cycle, before zeroing.
+     * Distances in inches, rates in inches/second, angles in degrees.
+     */
+    struct DriveState {
+        uint64_t timeUs;
+        double leftPos;
+        double rightPos;
+        double leftRate;
+        double rightRate;
+        double gyroAngle;
+        double gyroRate;
+        double current;
+    };
+
     Drive(TaskMgr *scheduler,
             CANTalon *left, CANTalon *right,
             CANTalon *spareTalon,
@@ -155,6 +176,11 @@ public:
 
     double GetDriveCurrent() const;
 
+    /**
+     * Get this cycle's sensor snapshot
+     */
+    DriveState GetState() const;
+
     /**
      * All angles given in degrees
      * All angular rates given in degrees/second
@@ -177,10 +203,17 @@ public:
     void SetDriveOutput(double left, double right) override;
 
 private:
+    void TaskPrePeriodic(RobotMode mode) override;
     void TaskPeriodic(RobotMode mode) override;
 
+    /**
+     * Read the encoders, gyro and current once and publish them as the
+     * snapshot every getter works from
+     */
+    void CaptureState();
+
     ADXRS450_Gyro *m_austinGyro;
-    double m_angle, m_angleRate;
+    SeqLock<DriveState> m_state;
     double m_gyroZero = 0.0;
 
     double m_leftCommand;
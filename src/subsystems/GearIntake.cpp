@@ -48,7 +48,7 @@ namespace frc973{
     this->SetGearIntakeState(GearIntakeState::grabbed);
     this->m_scheduler->RegisterTask("GearIntake", this, TASK_PERIODIC);
 
-    logger->RegisterCell(m_gearStateLog);
+    logger->RegisterCell(m_gearStateLog, LOG_SAMPLE_ON_CHANGE);
     logger->RegisterCell(m_gearCurrentLog);
     logger->RegisterCell(m_gearInputsLog);
   }
@@ -49,7 +49,7 @@ namespace frc973 {
         m_crankMotorB->SetCurrentLimit(40);
         m_crankMotor->Set(0.0);
 
-        logger->RegisterCell(m_hangStateLog);
+        logger->RegisterCell(m_hangStateLog, LOG_SAMPLE_ON_CHANGE);
         logger->RegisterCell(m_hangCurrentLog);
     }
 
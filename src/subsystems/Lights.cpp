@@ -11,7 +11,8 @@ namespace frc973{
     m_pixyLight(new Solenoid(BOILER_PIXY_LIGHT_SOL)),
     m_flashLight(new Solenoid(FLASH_LIGHT_SOL))
     {
-      m_scheduler->RegisterTask("Lights", this, TASK_PERIODIC);
+      m_scheduler->RegisterTask("Lights", this,
+              TASK_PERIODIC | TASK_BEST_EFFORT);
       m_pixyLight->Set(false);
     }
 
@@ -13,19 +13,20 @@ using namespace frc;
 
 namespace frc973 {
 
-PixyThread::PixyThread(RobotStateInterface &stateProvider) :
+PixyThread::PixyThread(RobotStateInterface &stateProvider,
+        const RTThreadConfig &threadConfig) :
     m_thread(new SingleThreadTaskMgr(stateProvider, 1/50.0, false)),
     m_pixy(new Pixy()),
     m_prevReading(0),
     m_offset(0.0),
-    m_prevReadingTime(0),
-    m_mutex(PTHREAD_MUTEX_INITIALIZER)
+    m_prevReadingTime(GetMsecTime()),
+    m_reading(PixyReading{0.0, m_prevReadingTime})
 {
+    m_thread->SetThreadConfig(threadConfig);
     m_thread->Start();
     fprintf(stderr, "gonna register the pixy task\n");
     m_thread->RegisterTask("Pixy", this, TASK_PERIODIC);
     fprintf(stderr, "registered the pixy task\n");
-    m_prevReadingTime = GetMsecTime();
 }
 
 PixyThread::~PixyThread() {
@@ -45,7 +46,6 @@ void PixyThread::TaskPeriodic(RobotMode mode) {
     int numBlocks = m_pixy->getBlocks(4);
     double currentRead = m_prevReading;
 
-	pthread_mutex_lock(&m_mutex);
     if (numBlocks >= 2){
         currentRead = (
                 (double) (m_pixy->blocks[0].x +
@@ -62,21 +62,15 @@ void PixyThread::TaskPeriodic(RobotMode mode) {
     printf("reading %lf\n", m_prevReading);
     printf("numBlocks %d\n", numBlocks);
     */
-	pthread_mutex_unlock(&m_mutex);
+    m_reading.Publish(PixyReading{m_prevReading, m_prevReadingTime});
 }
 
 double PixyThread::GetOffset() {
-	pthread_mutex_lock(&m_mutex);
-    double ret = -((m_prevReading / 319.0) - 0.5);
-	pthread_mutex_unlock(&m_mutex);
-    return ret;
+    return -((m_reading.Read().reading / 319.0) - 0.5);
 }
 
 bool PixyThread::GetDataFresh() {
-	pthread_mutex_lock(&m_mutex);
-    bool ret = GetMsecTime() - m_prevReadingTime < 50;
-	pthread_mutex_unlock(&m_mutex);
-    return ret;
+    return GetMsecTime() - m_reading.Read().readingTime < 50;
 }
 
 }
@@ -1,8 +1,9 @@
 #pragma once
 
-#include "pthread.h"
 #include "lib/TaskMgr.h"
 #include "lib/CoopTask.h"
+#include "lib/RTThread.h"
+#include "lib/util/Mailbox.h"
 #include "WPILib.h"
 
 using namespace frc;
@@ -18,7 +19,8 @@ class PixyThread : public CoopTask {
 public:
     static constexpr double GEAR_DEGREES_PER_PIXEL = 109.52;
 
-    explicit PixyThread(RobotStateInterface &stateProvider);
+    explicit PixyThread(RobotStateInterface &stateProvider,
+            const RTThreadConfig &threadConfig = {"gear pixy", 0, -1, 0});
     virtual ~PixyThread();
 
     void TaskPeriodic(RobotMode mode) override;
@@ -27,13 +29,18 @@ public:
 
     bool GetDataFresh();
 private:
+    /* what the pixy thread hands the rest of the robot each cycle */
+    struct PixyReading {
+        double reading;
+        uint32_t readingTime;   /* msec time blocks were last seen */
+    };
 
     SingleThreadTaskMgr *m_thread;
     Pixy *m_pixy;
     double m_prevReading;
     double m_offset;
     uint32_t m_prevReadingTime;
-	pthread_mutex_t	m_mutex;
+    Mailbox<PixyReading> m_reading;
 };
 
 }
@@ -97,8 +97,8 @@ Shooter::Shooter(TaskMgr *scheduler, LogSpreadsheet *logger,
     logger->RegisterCell(m_flywheelRate);
     logger->RegisterCell(m_flywheelPowLog);
     logger->RegisterCell(m_flywheelAmpsLog);
-    logger->RegisterCell(m_flywheelStateLog);
-    logger->RegisterCell(m_speedSetpoint);
+    logger->RegisterCell(m_flywheelStateLog, LOG_SAMPLE_ON_CHANGE);
+    logger->RegisterCell(m_speedSetpoint, LOG_SAMPLE_ON_CHANGE);
     logger->RegisterCell(m_conveyorLog);
     logger->RegisterCell(m_leftAgitatorLog);
     logger->RegisterCell(m_rightAgitatorLog);
@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/AutoSequencer.h"
+#include "lib/util/Util.h"
+#include "lib/util/VirtualClock.h"
+
+using namespace frc973;
+
+namespace {
+
+struct FakeRobot {
+    int driveStarts;
+    int intakeStarts;
+    bool driveOnTarget;
+    uint64_t lastDriveStartUs;
+};
+
+void StartDrive(void *ctx) {
+    FakeRobot *robot = static_cast<FakeRobot*>(ctx);
+    robot->driveStarts++;
+    robot->driveOnTarget = false;
+    robot->lastDriveStartUs = GetUsecTime();
+}
+
+bool DriveOnTarget(void *ctx) {
+    return static_cast<FakeRobot*>(ctx)->driveOnTarget;
+}
+
+void StartIntake(void *ctx) {
+    static_cast<FakeRobot*>(ctx)->intakeStarts++;
+}
+
+bool Never(void *ctx) {
+    return false;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(auto_sequencer_chains_in_same_cycle)
+{
+    VirtualClock::Enable(0);
+    FakeRobot robot = {0, 0, false, 0};
+    AutoSequencer seq(&robot);
+
+    seq.BeginSequence("routine");
+        seq.Do("drive 1", StartDrive, DriveOnTarget);
+        seq.Do("intake", StartIntake);
+        seq.Do("drive 2", StartDrive, DriveOnTarget);
+    seq.End();
+    seq.Start();
+
+    BOOST_CHECK(!seq.Update());
+    BOOST_CHECK(robot.driveStarts == 1);
+
+    /* done isn't asked on the cycle the command was issued */
+    robot.driveOnTarget = true;
+    VirtualClock::AdvanceUs(20000);
+    BOOST_CHECK(!seq.Update());
+
+    /* the instant intake command and the second drive start in the same
+     * cycle the first drive finished */
+    BOOST_CHECK(robot.intakeStarts == 1);
+    BOOST_CHECK(robot.driveStarts == 2);
+    BOOST_CHECK(robot.lastDriveStartUs == 20000);
+    BOOST_CHECK(seq.GetStepStartUs(3) == 20000);
+    BOOST_CHECK(seq.GetStepDurationUs(1) == 20000);
+
+    robot.driveOnTarget = true;
+    VirtualClock::AdvanceUs(20000);
+    BOOST_CHECK(seq.Update());
+    BOOST_CHECK(seq.IsDone());
+    BOOST_CHECK(seq.GetStepDurationUs(0) == 40000);
+
+    VirtualClock::Disable();
+}
+
+BOOST_AUTO_TEST_CASE(auto_sequencer_parallel_waits_and_timeouts)
+{
+    VirtualClock::Enable(0);
+    FakeRobot robot = {0, 0, false, 0};
+    AutoSequencer seq(&robot);
+
+    seq.BeginParallel("group");
+        seq.Wait("wait", 100);
+        seq.WaitUntil("stuck", Never, 60);
+    seq.End();
+    seq.Do("intake", StartIntake);
+    seq.Start();
+
+    BOOST_CHECK(!seq.Update());
+    VirtualClock::AdvanceUs(60000);
+    BOOST_CHECK(!seq.Update());
+    BOOST_CHECK(seq.GetStepStatus(2) == AutoSequencer::StepTimedOut);
+    BOOST_CHECK(seq.GetStepStatus(1) == AutoSequencer::StepRunning);
+    BOOST_CHECK(robot.intakeStarts == 0);
+
+    VirtualClock::AdvanceUs(40000);
+    BOOST_CHECK(seq.Update());
+    BOOST_CHECK(robot.intakeStarts == 1);
+    BOOST_CHECK(seq.GetStepStartUs(3) == 100000);
+
+    /* a rerun starts from the top again */
+    seq.Start();
+    BOOST_CHECK(!seq.Update());
+    BOOST_CHECK(seq.GetStepStatus(1) == AutoSequencer::StepRunning);
+
+    VirtualClock::Disable();
+}
+
+BOOST_AUTO_TEST_CASE(auto_sequencer_rejects_bad_routines)
+{
+    FakeRobot robot = {0, 0, false, 0};
+    AutoSequencer seq(&robot);
+
+    seq.BeginSequence("never ended");
+    seq.Start();
+    BOOST_CHECK(seq.HasError());
+    BOOST_CHECK(!seq.Update());
+
+    seq.Clear();
+    for (int i = 0; i <= AutoSequencer::MAX_AUTO_STEPS; i++) {
+        seq.Wait("filler", 1);
+    }
+    BOOST_CHECK(seq.HasError());
+}
@@ -0,0 +1,249 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/LogSpreadsheet.h"
+#include "BinaryLogReader.h"
+#include "TestHelpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace frc973;
+
+namespace {
+
+std::string ReadFile(const char *path) {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+/**
+ * What logtocsv would write for |reader|
+ */
+std::string ConvertToCsv(const BinaryLogReader &reader) {
+    char *buf = nullptr;
+    size_t size = 0;
+    FILE *out = open_memstream(&buf, &size);
+
+    BOOST_REQUIRE(out != nullptr);
+    reader.WriteCsv(out);
+    fclose(out);
+
+    std::string csv(buf, size);
+    free(buf);
+    return csv;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(binary_log_converts_to_same_csv)
+{
+    TempDir tmp("binlog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell angle("Angle", LOG_CELL_DOUBLE);
+    LogCell state("State", LOG_CELL_INT, LOG_CELL_FLAG_CLEAR_ON_READ);
+    LogCell text("Messages", 16, LOG_CELL_FLAG_CLEAR_ON_READ);
+    LogCell untyped("Untyped");
+    std::string csvName, binName;
+
+    {
+        /* the files are closed when the spreadsheets go away */
+        LogSpreadsheet csvLog(&mgr), binLog(&mgr);
+
+        csvLog.SetLogDirectory(dir);
+        binLog.SetLogDirectory(dir);
+        binLog.SetFormat(LOG_FORMAT_BINARY);
+        for (LogSpreadsheet *log : {&csvLog, &binLog}) {
+            log->RegisterCell(&angle);
+            log->RegisterCell(&state);
+            log->RegisterCell(&text);
+            log->RegisterCell(&untyped);
+            log->InitializeTable();
+        }
+
+        for (int row = 0; row < 5; row++) {
+            for (LogSpreadsheet *log : {&csvLog, &binLog}) {
+                angle.LogDouble(row * 1.25 - 2.0);
+                if (row % 2 == 0) {
+                    state.LogInt(row);
+                    text.LogPrintf("row %d", row);
+                }
+                untyped.LogDouble(row / 3.0);
+                log->TaskPostPeriodic(MODE_AUTO);
+            }
+        }
+
+        csvName = csvLog.GetFileName();
+        binName = binLog.GetFileName();
+    }
+
+    BinaryLogReader reader;
+    BOOST_REQUIRE(reader.Open(binName.c_str()));
+    BOOST_CHECK(reader.GetNumColumns() == 4);
+    BOOST_CHECK(reader.GetNumRows() == 5);
+    BOOST_CHECK(reader.GetColumnType(0) == LOG_CELL_DOUBLE);
+    BOOST_CHECK(reader.FindColumn("Messages") == 2);
+    BOOST_CHECK(reader.GetDouble(4, 0) == 3.0);
+    BOOST_CHECK(!reader.IsPresent(1, 1));
+    BOOST_CHECK(reader.GetRow(3)->mode == MODE_AUTO);
+    BOOST_CHECK(reader.IsRowValid(4));
+
+    BOOST_CHECK_EQUAL(ConvertToCsv(reader), ReadFile(csvName.c_str()));
+
+    reader.Close();
+}
+
+BOOST_AUTO_TEST_CASE(log_writer_drops_rows_when_ring_is_full)
+{
+    TempDir tmp("binlog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+    std::string binName;
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        /* the writer won't wake up by itself during the test, so only the
+         * first four rows fit */
+        log.SetLogDirectory(dir);
+        log.SetFormat(LOG_FORMAT_BINARY);
+        log.SetBuffering(4, 1000, 60 * 1000);
+        log.RegisterCell(&count);
+        log.InitializeTable();
+
+        for (int row = 0; row < 10; row++) {
+            count.LogInt(row);
+            log.TaskPostPeriodic(MODE_TELEOP);
+        }
+        BOOST_CHECK(log.GetDroppedRows() == 6);
+
+        binName = log.GetFileName();
+    }
+
+    BinaryLogReader reader;
+    BOOST_REQUIRE(reader.Open(binName.c_str()));
+    BOOST_REQUIRE(reader.GetNumRows() == 4);
+    BOOST_CHECK(reader.GetInt(3, 0) == 3);
+    BOOST_CHECK(reader.GetRow(3)->row == 3);
+
+    reader.Close();
+}
+
+BOOST_AUTO_TEST_CASE(sampled_columns_are_left_out_of_rows)
+{
+    TempDir tmp("binlog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell fast("Fast", LOG_CELL_DOUBLE);
+    LogCell slow("Slow", LOG_CELL_DOUBLE);
+    LogCell state("State", 32);
+    LogCell event("Event", LOG_CELL_INT);
+    std::string csvName, binName, denseName;
+
+    {
+        LogSpreadsheet csvLog(&mgr), binLog(&mgr), denseLog(&mgr);
+
+        csvLog.SetLogDirectory(dir);
+        binLog.SetLogDirectory(dir);
+        binLog.SetFormat(LOG_FORMAT_BINARY);
+        denseLog.SetLogDirectory(dir);
+        denseLog.SetFormat(LOG_FORMAT_COMPRESSED);
+        for (LogSpreadsheet *log : {&csvLog, &binLog, &denseLog}) {
+            log->RegisterCell(&fast);
+            log->RegisterCell(&slow, LOG_SAMPLE_EVERY_NTH, 4);
+            log->RegisterCell(&state, LOG_SAMPLE_ON_CHANGE);
+            log->RegisterCell(&event, LOG_SAMPLE_EVENT);
+            log->InitializeTable();
+        }
+
+        for (int row = 0; row < 20; row++) {
+            for (LogSpreadsheet *log : {&csvLog, &binLog, &denseLog}) {
+                fast.LogDouble(row);
+                slow.LogDouble(row * 2.0);
+                state.LogPrintf("state %d", row / 8);
+                if (row == 5) {
+                    event.LogInt(42);
+                }
+                log->TaskPostPeriodic(MODE_AUTO);
+            }
+        }
+
+        csvName = csvLog.GetFileName();
+        binName = binLog.GetFileName();
+        denseName = denseLog.GetFileName();
+    }
+
+    BinaryLogReader reader, dense;
+    BOOST_REQUIRE(reader.Open(binName.c_str()));
+    BOOST_REQUIRE(dense.Open(denseName.c_str()));
+    BOOST_REQUIRE(reader.GetNumRows() == 20);
+    BOOST_CHECK(reader.GetColumnSampling(2) == LOG_SAMPLE_ON_CHANGE);
+
+    /* every 4th row for slow, rows 0, 8 and 16 for state, row 5 for the
+     * event */
+    BOOST_CHECK(reader.IsPresent(8, 1) && !reader.IsPresent(9, 1));
+    BOOST_CHECK(reader.GetDouble(8, 1) == 16.0);
+    BOOST_CHECK(reader.IsPresent(8, 2) && !reader.IsPresent(9, 2));
+    BOOST_CHECK(reader.IsPresent(5, 3) && !reader.IsPresent(6, 3));
+
+    /* the empty slots take no room in the file */
+    struct stat st;
+    stat(binName.c_str(), &st);
+    BOOST_CHECK((uint64_t) st.st_size < reader.GetRow(0)->size * 20);
+
+    /* and every format reads back to the same CSV, on-change columns
+     * carried forward */
+    std::string csv = ReadFile(csvName.c_str());
+    BOOST_CHECK(csv.find("\"state 0\",\"\",\n") != std::string::npos);
+    BOOST_CHECK_EQUAL(ConvertToCsv(reader), csv);
+    BOOST_CHECK_EQUAL(ConvertToCsv(dense), csv);
+
+    reader.Close();
+    dense.Close();
+}
+
+BOOST_AUTO_TEST_CASE(csv_on_change_column_empties_when_cleared)
+{
+    TempDir tmp("binlog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell state("State", 16);
+    std::string csvName;
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.RegisterCell(&state, LOG_SAMPLE_ON_CHANGE);
+        log.InitializeTable();
+
+        for (int row = 0; row < 6; row++) {
+            if (row == 0) {
+                state.LogText("shooting");
+            }
+            else if (row == 2) {
+                state.ClearCell();
+            }
+            else if (row == 4) {
+                state.LogText("idle");
+            }
+            log.TaskPostPeriodic(MODE_TELEOP);
+        }
+        csvName = log.GetFileName();
+    }
+
+    BOOST_CHECK_EQUAL(ReadFile(csvName.c_str()),
+            "\"State\",\n\"shooting\",\n\"shooting\",\n\"\",\n\"\",\n"
+            "\"idle\",\n\"idle\",\n");
+}
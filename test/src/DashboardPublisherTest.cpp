@@ -0,0 +1,121 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/DashboardPublisher.h"
+#include "lib/util/VirtualClock.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace frc973;
+
+namespace {
+
+struct SentLine {
+    DBStringPos line;
+    std::string text;
+};
+
+void Capture(void *ctx, DBStringPos line, const char *text) {
+    static_cast<std::vector<SentLine>*>(ctx)->push_back({line, text});
+}
+
+/**
+ * A publisher that has already sent whatever earlier tests left in the
+ * lines
+ */
+class TestPublisher : public DashboardPublisher {
+public:
+    TestPublisher() : DashboardPublisher(Capture, &sent) {
+        Publish();
+        sent.clear();
+    }
+
+    std::vector<SentLine> sent;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(dashboard_sends_only_lines_that_changed)
+{
+    VirtualClock::Enable(0);
+    TestPublisher publisher;
+
+    DBStringPrintf(DB_LINE3, "p %2.2lf t %2.2lf", 1.0, -0.5);
+    DBStringPrintf(DB_LINE9, "l %2.1lf r %2.1lf", 3.25, 4.0);
+    BOOST_CHECK(publisher.Publish() == 2);
+    BOOST_REQUIRE(publisher.sent.size() == 2);
+    BOOST_CHECK(publisher.sent[0].line == DB_LINE3);
+    BOOST_CHECK_EQUAL(publisher.sent[0].text, "p 1.00 t -0.50");
+    BOOST_CHECK_EQUAL(publisher.sent[1].text, "l 3.2 r 4.0");
+
+    /* written again with the same text, and not written at all */
+    DBStringPrintf(DB_LINE3, "p %2.2lf t %2.2lf", 1.0, -0.5);
+    BOOST_CHECK(publisher.Publish() == 0);
+
+    /* only the last write before publishing goes out */
+    DBStringPrintf(DB_LINE3, "first %d", 1);
+    DBStringPrintf(DB_LINE3, "second %d", 2);
+    BOOST_CHECK(publisher.Publish() == 1);
+    BOOST_CHECK_EQUAL(publisher.sent.back().text, "second 2");
+
+    /* lines are cut off where they always were */
+    DBStringPrintf(DB_LINE0, "%s", "0123456789012345678901234567890123");
+    publisher.Publish();
+    BOOST_CHECK_EQUAL(publisher.sent.back().text,
+            "0123456789012345678901234567");
+
+    publisher.ResendAll();
+    BOOST_CHECK(publisher.Publish() == 3);
+    VirtualClock::Disable();
+}
+
+BOOST_AUTO_TEST_CASE(dashboard_rate_limits_each_line)
+{
+    VirtualClock::Enable(0);
+    TestPublisher publisher;
+
+    publisher.SetLineMinPeriod(DB_LINE7, 500);
+    DBStringPrintf(DB_LINE7, "x %d", 0);
+    DBStringPrintf(DB_LINE5, "s %d", 0);
+    BOOST_CHECK(publisher.Publish() == 2);
+
+    for (int i = 1; i <= 5; i++) {
+        VirtualClock::SetTimeUs(i * 100000);
+        DBStringPrintf(DB_LINE7, "x %d", i);
+        DBStringPrintf(DB_LINE5, "s %d", i);
+        publisher.Publish();
+    }
+
+    /* the limited line went out once more, with the newest text */
+    int line7 = 0;
+    for (const SentLine &sent : publisher.sent) {
+        line7 += sent.line == DB_LINE7;
+    }
+    BOOST_CHECK(line7 == 2);
+    BOOST_CHECK_EQUAL(publisher.sent.back().text, "x 5");
+    BOOST_CHECK(publisher.sent.size() == 2 + 5 + 1);
+    VirtualClock::Disable();
+}
+
+BOOST_AUTO_TEST_CASE(dashboard_lines_take_writers_on_many_threads)
+{
+    TestPublisher publisher;
+    std::vector<std::thread> writers;
+
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([t]() {
+            for (int i = 0; i < 10000; i++) {
+                DBStringPrintf(DB_LINE2, "thread %d i %d", t, i);
+            }
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+
+    publisher.Publish();
+    BOOST_REQUIRE(publisher.sent.size() == 1);
+    BOOST_CHECK(publisher.sent[0].text.find(" i 9999") !=
+            std::string::npos);
+}
@@ -0,0 +1,174 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/DeferredLog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+using namespace frc973;
+
+namespace {
+
+/**
+ * Everything flushed so far, read back from the output file
+ */
+std::string ReadOutput(FILE *out) {
+    std::string contents;
+    char buf[256];
+
+    fflush(out);
+    rewind(out);
+    while (fgets(buf, sizeof(buf), out) != nullptr) {
+        contents += buf;
+    }
+    return contents;
+}
+
+template <typename... Args>
+std::string Format(const char *format, Args... args) {
+    FILE *out = tmpfile();
+    std::string contents;
+
+    DeferredLog::Flush();
+    DeferredLog::SetOutput(out);
+    DebugPrintf(format, args...);
+    DeferredLog::Flush();
+    DeferredLog::SetOutput(nullptr);
+    contents = ReadOutput(out);
+    fclose(out);
+    return contents;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(deferred_log_formats_like_printf)
+{
+    uint16_t signature = 0xbeef;
+    bool halt = true;
+    char expected[256];
+
+    DeferredLog::SetLevel(DLOG_DEBUG);
+
+    snprintf(expected, sizeof(expected),
+            "d %lf a %lf vel %2.2lf start %d\n", 1.5, -90.25, 3.14159, halt);
+    BOOST_CHECK_EQUAL(Format("d %lf a %lf vel %2.2lf start %d\n",
+                1.5, -90.25, 3.14159, halt), expected);
+
+    snprintf(expected, sizeof(expected), "sig: 0x%x (%d decimal) y: %5d\n",
+            signature, signature, -12);
+    BOOST_CHECK_EQUAL(Format("sig: 0x%x (%d decimal) y: %5d\n",
+                signature, signature, -12), expected);
+
+    snprintf(expected, sizeof(expected), "%x %llu %-6s| %c %% %.*f %e",
+            -1, 1ULL << 40, "ab", 'z', 2, 0.125, 1e-9);
+    BOOST_CHECK_EQUAL(Format("%x %llu %-6s| %c %% %.*f %e",
+                -1, 1ULL << 40, "ab", 'z', 2, 0.125, 1e-9), expected);
+
+    /* a double where the format wanted an int still comes out sensibly */
+    BOOST_CHECK_EQUAL(Format("%d %f", 2.75, 3), "2 3.000000");
+}
+
+BOOST_AUTO_TEST_CASE(deferred_log_copies_strings_at_the_call)
+{
+    char name[16];
+    FILE *out = tmpfile();
+
+    DeferredLog::SetLevel(DLOG_DEBUG);
+    DeferredLog::Flush();
+    DeferredLog::SetOutput(out);
+
+    strcpy(name, "before");
+    InfoPrintf("name %s %s\n", name, "literal");
+    strcpy(name, "after");
+    BOOST_CHECK(DeferredLog::Flush() == 1);
+    BOOST_CHECK_EQUAL(ReadOutput(out), "name before literal\n");
+
+    DeferredLog::SetOutput(nullptr);
+    fclose(out);
+}
+
+BOOST_AUTO_TEST_CASE(deferred_log_filters_before_capture)
+{
+    FILE *out = tmpfile();
+
+    DeferredLog::Flush();
+    DeferredLog::SetOutput(out);
+    DeferredLog::SetLevel(DLOG_WARNING);
+
+    DebugPrintf("debug %d\n", 1);
+    InfoPrintf("info %d\n", 2);
+    WarningPrintf("warning %d\n", 3);
+    ErrorPrintf("error %d\n", 4);
+    BOOST_CHECK(DeferredLog::Flush() == 2);
+    BOOST_CHECK_EQUAL(ReadOutput(out), "warning 3\nerror 4\n");
+
+    DeferredLog::SetLevel(DLOG_DEBUG);
+    DeferredLog::SetOutput(nullptr);
+    fclose(out);
+}
+
+BOOST_AUTO_TEST_CASE(deferred_log_drops_when_ring_is_full)
+{
+    FILE *out = tmpfile();
+    uint64_t dropped = DeferredLog::GetDropped();
+
+    DeferredLog::SetLevel(DLOG_DEBUG);
+    DeferredLog::Flush();
+    DeferredLog::SetOutput(out);
+
+    for (size_t i = 0; i < DeferredLog::RING_RECORDS + 10; i++) {
+        DebugPrintf("line %u\n", (unsigned) i);
+    }
+    BOOST_CHECK(DeferredLog::GetDropped() - dropped == 10);
+    BOOST_CHECK(DeferredLog::Flush() == DeferredLog::RING_RECORDS);
+
+    /* the oldest lines are the ones kept */
+    std::string contents = ReadOutput(out);
+    BOOST_CHECK(contents.find("line 0\n") == 0);
+    BOOST_CHECK(contents.find("line 255\n") != std::string::npos);
+    BOOST_CHECK(contents.find("line 256\n") == std::string::npos);
+
+    DeferredLog::SetOutput(nullptr);
+    fclose(out);
+}
+
+BOOST_AUTO_TEST_CASE(deferred_log_writer_thread_drains_every_thread)
+{
+    FILE *out = tmpfile();
+    uint64_t dropped = DeferredLog::GetDropped();
+
+    DeferredLog::SetLevel(DLOG_DEBUG);
+    DeferredLog::Flush();
+    DeferredLog::SetOutput(out);
+    BOOST_REQUIRE(DeferredLog::Start({"deferred log", 0, -1, 0}, 1));
+
+    std::thread control([]() {
+        for (int i = 0; i < 1000; i++) {
+            DebugPrintf("control %d\n", i);
+        }
+    });
+    control.join();
+    InfoPrintf("main done\n");
+    DeferredLog::Stop();
+
+    std::string contents = ReadOutput(out);
+    int lines = 0;
+    int next = 0;
+    for (size_t pos = 0; (pos = contents.find("control ", pos)) !=
+            std::string::npos; pos++) {
+        int i = atoi(contents.c_str() + pos + strlen("control "));
+
+        /* lines of one thread stay in order, though some may be dropped */
+        BOOST_CHECK(i >= next);
+        next = i + 1;
+        lines++;
+    }
+    BOOST_CHECK(lines + DeferredLog::GetDropped() - dropped == 1000);
+    BOOST_CHECK(contents.find("main done\n") != std::string::npos);
+
+    DeferredLog::SetOutput(nullptr);
+    fclose(out);
+}
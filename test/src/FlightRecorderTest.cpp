@@ -0,0 +1,236 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/FlightRecorder.h"
+#include "lib/logging/LogSpreadsheet.h"
+#include "lib/util/VirtualClock.h"
+#include "BinaryLogReader.h"
+#include "TestHelpers.h"
+
+#include <stdlib.h>
+#include <string>
+
+using namespace frc973;
+
+namespace {
+
+/**
+ * Rows of |reader| where the trigger column is set
+ */
+std::string TriggerRows(const BinaryLogReader &reader, int countColumn) {
+    int trigger = reader.FindColumn("Flight trigger");
+    std::string rows;
+
+    for (uint64_t row = 0; row < reader.GetNumRows(); row++) {
+        if (reader.IsPresent(row, trigger)) {
+            rows += std::to_string(reader.GetInt(row, countColumn)) + ":" +
+                std::to_string(reader.GetInt(row, trigger)) + " ";
+        }
+    }
+    return rows;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(flight_recorder_dump_has_history)
+{
+    TempDir tmp("flight");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogSpreadsheet logger(&mgr);
+    LogCell volts("Voltage", LOG_CELL_DOUBLE);
+    LogCell count("Count", LOG_CELL_INT);
+    LogCell text("Messages", 16);
+    BinaryLogReader reader;
+
+    logger.RegisterCell(&volts);
+    logger.RegisterCell(&count);
+    logger.RegisterCell(&text);
+
+    VirtualClock::Enable(0);
+    {
+        FlightRecorder recorder(&mgr, &logger, 10, 5);
+
+        recorder.SetDirectory(dir);
+        recorder.Initialize();
+
+        for (int i = 0; i < 30; i++) {
+            VirtualClock::SetTimeUs(i * 5000);
+            volts.LogDouble(12.0 + i * 0.125);
+            count.LogInt(i);
+            text.LogText("not recorded");
+            if (i == 20) {
+                recorder.Trigger(FLIGHT_TRIGGER_BUTTON);
+            }
+            recorder.TaskPeriodic(RobotMode::MODE_TELEOP);
+        }
+        recorder.WaitForDumps();
+
+        BOOST_CHECK(recorder.GetNumDumps() == 1);
+        BOOST_CHECK(recorder.GetDroppedDumps() == 0);
+        BOOST_REQUIRE(reader.Open(recorder.GetLastDumpFileName()));
+    }
+    VirtualClock::Disable();
+
+    /* the last ten rows before the trigger and the five after it */
+    int countColumn = reader.FindColumn("Count");
+    int voltsColumn = reader.FindColumn("Voltage");
+    BOOST_REQUIRE(countColumn >= 0 && voltsColumn >= 0);
+    BOOST_CHECK(reader.FindColumn("Messages") < 0);
+    BOOST_CHECK(reader.FindColumn("Cycle time us") >= 0);
+    BOOST_CHECK(reader.FindColumn("Logger PostPeriodic us") >= 0);
+    BOOST_REQUIRE(reader.GetNumRows() == 15);
+    BOOST_CHECK(reader.GetInt(0, countColumn) == 11);
+    BOOST_CHECK(reader.GetInt(14, countColumn) == 25);
+    BOOST_CHECK(reader.GetDouble(14, voltsColumn) == 12.0 + 25 * 0.125);
+    BOOST_CHECK(reader.GetRow(14)->timeUs == 25 * 5000);
+    BOOST_CHECK(reader.GetRow(0)->mode == RobotMode::MODE_TELEOP);
+    BOOST_CHECK_EQUAL(TriggerRows(reader, countColumn), "20:8 ");
+}
+
+BOOST_AUTO_TEST_CASE(flight_recorder_automatic_triggers)
+{
+    TempDir tmp("flight");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogSpreadsheet logger(&mgr);
+    LogCell volts("Voltage", LOG_CELL_DOUBLE);
+    LogCell count("Count", LOG_CELL_INT);
+    std::string dumps[3];
+    BinaryLogReader reader;
+
+    logger.RegisterCell(&volts);
+    logger.RegisterCell(&count);
+    mgr.SetPeriodUs(20000);
+
+    VirtualClock::Enable(0);
+    {
+        FlightRecorder recorder(&mgr, &logger, 4, 2);
+
+        recorder.SetDirectory(dir);
+        recorder.SetBrownoutTrigger(&volts, 7.0);
+        recorder.SetAutoTriggers(FLIGHT_TRIGGER_ALL);
+        recorder.Initialize();
+        recorder.TaskStartMode(RobotMode::MODE_DISABLED);
+
+        for (int i = 0; i < 40; i++) {
+            VirtualClock::SetTimeUs(i * 5000);
+            /* browns out for three rows but only triggers once */
+            volts.LogDouble(i >= 10 && i < 13 ? 6.5 : 12.5);
+            count.LogInt(i);
+            mgr.FinishCycle(i == 20 ? 25000 : 15000);
+            if (i == 30) {
+                recorder.TaskStartMode(RobotMode::MODE_AUTO);
+            }
+            recorder.TaskPeriodic(i < 30 ? RobotMode::MODE_DISABLED :
+                    RobotMode::MODE_AUTO);
+
+            /* one dump at a time, to keep each file's name */
+            if (i == 12 || i == 22 || i == 32) {
+                recorder.WaitForDumps();
+                dumps[(i - 12) / 10] = recorder.GetLastDumpFileName();
+            }
+        }
+        BOOST_CHECK(recorder.GetNumDumps() == 3);
+    }
+    VirtualClock::Disable();
+
+    const char *expected[] = {"10:1 ", "20:16 ", "30:4 "};
+    for (int i = 0; i < 3; i++) {
+        BOOST_REQUIRE(reader.Open(dumps[i].c_str()));
+        int countColumn = reader.FindColumn("Count");
+        BOOST_CHECK(reader.GetNumRows() == 6);
+        BOOST_CHECK_EQUAL(TriggerRows(reader, countColumn), expected[i]);
+        reader.Close();
+    }
+
+    /* the overrun is in the cycle time of the row it triggered on */
+    BOOST_REQUIRE(reader.Open(dumps[1].c_str()));
+    BOOST_CHECK(reader.GetInt(3, reader.FindColumn("Count")) == 20);
+    BOOST_CHECK(reader.GetInt(3, reader.FindColumn("Cycle time us")) == 25000);
+    BOOST_CHECK(reader.GetInt(3, reader.FindColumn("Cycle overruns")) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(flight_recorder_dump_now)
+{
+    TempDir tmp("flight");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogSpreadsheet logger(&mgr);
+    LogCell count("Count", LOG_CELL_INT);
+    BinaryLogReader reader;
+
+    logger.RegisterCell(&count);
+
+    FlightRecorder recorder(&mgr, &logger, 8, 2);
+
+    recorder.SetDirectory(dir);
+    BOOST_CHECK(!recorder.DumpNow(FLIGHT_TRIGGER_EXCEPTION));
+    recorder.Initialize();
+    for (int i = 0; i < 5; i++) {
+        count.LogInt(i);
+        recorder.TaskPeriodic(RobotMode::MODE_AUTO);
+    }
+    BOOST_REQUIRE(recorder.DumpNow(FLIGHT_TRIGGER_EXCEPTION));
+
+    /* nothing more is recorded after a DumpNow */
+    count.LogInt(5);
+    recorder.TaskPeriodic(RobotMode::MODE_AUTO);
+
+    BOOST_REQUIRE(reader.Open(recorder.GetLastDumpFileName()));
+    BOOST_REQUIRE(reader.GetNumRows() == 5);
+    BOOST_CHECK(reader.GetInt(4, reader.FindColumn("Count")) == 4);
+    BOOST_CHECK(recorder.GetNumDumps() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(flight_recorder_dump_soon_after_another)
+{
+    TempDir tmp("flight");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogSpreadsheet logger(&mgr);
+    LogCell count("Count", LOG_CELL_INT);
+    std::string second;
+    BinaryLogReader reader;
+
+    logger.RegisterCell(&count);
+
+    FlightRecorder recorder(&mgr, &logger, 4, 2);
+
+    recorder.SetDirectory(dir);
+    recorder.Initialize();
+    for (int i = 0; i < 14; i++) {
+        count.LogInt(i);
+        if (i == 5 || i == 9) {
+            recorder.Trigger(FLIGHT_TRIGGER_BUTTON);
+        }
+        recorder.TaskPeriodic(RobotMode::MODE_AUTO);
+        if (i == 7 || i == 11) {
+            recorder.WaitForDumps();
+        }
+        if (i == 11) {
+            second = recorder.GetLastDumpFileName();
+        }
+    }
+    BOOST_CHECK(recorder.GetNumDumps() == 2);
+
+    /* the second dump doesn't wait for a new history; it has the rows
+     * from before the first one's */
+    BOOST_REQUIRE(reader.Open(second.c_str()));
+    int countColumn = reader.FindColumn("Count");
+    BOOST_REQUIRE(reader.GetNumRows() == 6);
+    BOOST_CHECK(reader.GetInt(0, countColumn) == 6);
+    BOOST_CHECK(reader.GetInt(5, countColumn) == 11);
+    BOOST_CHECK_EQUAL(TriggerRows(reader, countColumn), "9:8 ");
+    reader.Close();
+
+    /* so does a DumpNow */
+    BOOST_REQUIRE(recorder.DumpNow(FLIGHT_TRIGGER_EXCEPTION));
+    BOOST_REQUIRE(reader.Open(recorder.GetLastDumpFileName()));
+    BOOST_REQUIRE(reader.GetNumRows() == 6);
+    BOOST_CHECK(reader.GetInt(0, countColumn) == 8);
+    BOOST_CHECK(reader.GetInt(5, countColumn) == 13);
+}
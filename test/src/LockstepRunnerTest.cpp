@@ -0,0 +1,108 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/LockstepRunner.h"
+#include "lib/CoopMTRobot.h"
+#include "lib/SingleThreadTaskMgr.h"
+#include "lib/CoopTask.h"
+#include "lib/util/VirtualClock.h"
+
+using namespace frc973;
+
+namespace {
+
+class ClockTask : public CoopTask {
+public:
+    ClockTask() : numPeriodic(0), lastUs(0), numStarts(0),
+        lastMode(MODE_DISABLED) {}
+    void TaskStartMode(RobotMode mode) override {
+        numStarts++;
+        lastMode = mode;
+    }
+    void TaskPeriodic(RobotMode mode) override {
+        numPeriodic++;
+        lastUs = GetUsecTime();
+    }
+    int numPeriodic;
+    uint64_t lastUs;
+    int numStarts;
+    RobotMode lastMode;
+};
+
+class TestRobot : public CoopMTRobot {
+public:
+    TestRobot() : numDisabledStops(0), numAutoStarts(0), numAutoCycles(0) {}
+    void DisabledStop() override {
+        numDisabledStops++;
+    }
+    void AutonomousStart() override {
+        numAutoStarts++;
+    }
+    void AutonomousContinuous() override {
+        numAutoCycles++;
+    }
+    int numDisabledStops;
+    int numAutoStarts;
+    int numAutoCycles;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(lockstep_runs_an_auto_in_virtual_time)
+{
+    LockstepRunner runner(1000000);
+    TestRobot robot;
+    SingleThreadTaskMgr fastLoop(robot, 0.005);
+    ClockTask robotTask, fastTask;
+
+    BOOST_REQUIRE(VirtualClock::IsEnabled());
+
+    robot.RegisterTask("robot", &robotTask,
+            TASK_START_MODE | TASK_PERIODIC);
+    fastLoop.RegisterTask("fast", &fastTask, TASK_PERIODIC);
+    runner.AddLoop(&robot);
+    runner.AddLoop(&fastLoop);
+    fastLoop.Start();
+
+    /* a 15 second autonomous mode, stepped with no sleeping */
+    runner.SetMode(MODE_AUTO);
+    uint64_t cycles = runner.RunFor(15000000);
+
+    BOOST_CHECK(robotTask.numPeriodic == 750);
+    BOOST_CHECK(fastTask.numPeriodic == 3000);
+    BOOST_CHECK(cycles == 3750);
+    BOOST_CHECK(robotTask.numStarts == 1);
+    BOOST_CHECK(robotTask.lastMode == MODE_AUTO);
+    /* the first step starts auto without stopping a disabled mode that
+     * never started */
+    BOOST_CHECK(robot.numAutoStarts == 1);
+    BOOST_CHECK(robot.numAutoCycles == 750);
+    BOOST_CHECK(robot.numDisabledStops == 0);
+    /* each cycle sees the clock at its own deadline */
+    BOOST_CHECK(robotTask.lastUs == 1000000 + 749 * 20000);
+    BOOST_CHECK(fastTask.lastUs == 1000000 + 2999 * 5000);
+    BOOST_CHECK(GetUsecTime() == 16000000);
+
+    /* the clock doesn't move inside a cycle, so everything takes 0us */
+    TaskStats::Snapshot snap;
+    robot.GetTaskStats(&robotTask, PHASE_PERIODIC)->GetSnapshot(&snap);
+    BOOST_CHECK(snap.count == 750 && snap.maxUs == 0);
+    robot.GetCycleStats().GetSnapshot(&snap);
+    BOOST_CHECK(snap.count == 750 && snap.maxUs == 0);
+    fastLoop.GetCycleStats().GetSnapshot(&snap);
+    BOOST_CHECK(snap.count == 3000 && snap.maxUs == 0);
+
+    runner.SetMode(MODE_TELEOP);
+    runner.StepOnce();
+    BOOST_CHECK(robotTask.numStarts == 2);
+    BOOST_CHECK(robotTask.lastMode == MODE_TELEOP);
+    BOOST_CHECK(robotTask.lastUs == 16000000);
+}
+
+BOOST_AUTO_TEST_CASE(lockstep_runner_restores_real_clock)
+{
+    {
+        LockstepRunner runner;
+        BOOST_CHECK(VirtualClock::IsEnabled());
+    }
+    BOOST_CHECK(!VirtualClock::IsEnabled());
+}
@@ -0,0 +1,90 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/LogSpreadsheet.h"
+
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+using namespace frc973;
+
+BOOST_AUTO_TEST_CASE(log_cell_clear_on_read)
+{
+    LogCell text("Text", 16, LOG_CELL_FLAG_CLEAR_ON_READ);
+    LogCell sticky("Sticky", 16);
+    LogCell count("Count", LOG_CELL_INT, LOG_CELL_FLAG_CLEAR_ON_READ);
+    char slot[16];
+    int32_t val;
+
+    BOOST_CHECK(!text.CopyValue(slot));
+    BOOST_CHECK(!count.CopyValue(&val));
+
+    text.LogPrintf("hello %d", 7);
+    sticky.LogText("stays");
+    count.LogInt(-3);
+    BOOST_CHECK(text.CopyValue(slot));
+    BOOST_CHECK(strcmp(slot, "hello 7") == 0);
+    BOOST_CHECK(count.CopyValue(&val));
+    BOOST_CHECK(val == -3);
+    BOOST_CHECK(sticky.CopyValue(slot));
+
+    BOOST_CHECK(!text.CopyValue(slot));
+    BOOST_CHECK(slot[0] == '\0');
+    BOOST_CHECK(!count.CopyValue(&val));
+    BOOST_CHECK(sticky.CopyValue(slot));
+    BOOST_CHECK(strcmp(slot, "stays") == 0);
+
+    sticky.ClearCell();
+    BOOST_CHECK(!sticky.CopyValue(slot));
+
+    /* text on a numeric cell is rejected and counted */
+    uint32_t rejected = LogCell::GetRejectedWrites();
+    count.LogInt(4);
+    count.LogPrintf("four");
+    count.LogText("4");
+    BOOST_CHECK(!count.CopyValue(&val));
+    BOOST_CHECK(LogCell::GetRejectedWrites() == rejected + 2);
+}
+
+BOOST_AUTO_TEST_CASE(log_cell_reads_are_never_torn)
+{
+    LogCell text("Text", 24);
+    LogCell angle("Angle", LOG_CELL_DOUBLE);
+    std::atomic<bool> done(false);
+    int torn = 0;
+
+    std::thread writer([&]() {
+        for (int i = 0; i < 200000; i++) {
+            /* every character of one write is the same, and each double
+             * written has both words of the same pattern */
+            char c = 'a' + i % 26;
+            char line[24];
+
+            memset(line, c, sizeof(line) - 1 - i % 8);
+            line[sizeof(line) - 1 - i % 8] = '\0';
+            text.LogText(line);
+            angle.LogDouble(i % 2 == 0 ? 1.0e300 : -2.5e-300);
+        }
+        done = true;
+    });
+
+    while (!done) {
+        char slot[24];
+        double d;
+
+        if (text.CopyValue(slot)) {
+            for (size_t j = 1; j < strlen(slot); j++) {
+                if (slot[j] != slot[0]) {
+                    torn++;
+                    break;
+                }
+            }
+        }
+        if (angle.CopyValue(&d) && d != 1.0e300 && d != -2.5e-300) {
+            torn++;
+        }
+    }
+    writer.join();
+
+    BOOST_CHECK(torn == 0);
+}
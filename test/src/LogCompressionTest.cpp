@@ -0,0 +1,176 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/LogCompression.h"
+#include "lib/logging/LogSpreadsheet.h"
+#include "BinaryLogReader.h"
+#include "TestHelpers.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace frc973;
+
+namespace {
+
+std::vector<uint8_t> RoundTrip(const std::vector<uint8_t> &in) {
+    std::vector<uint8_t> compressed(LzCompressBound(in.size()));
+    std::vector<uint32_t> table(LZ_HASH_ENTRIES);
+    std::vector<uint8_t> out(in.size());
+    size_t size = LzCompress(in.data(), in.size(), compressed.data(),
+            table.data());
+
+    BOOST_REQUIRE(size <= compressed.size());
+    BOOST_REQUIRE(LzDecompress(compressed.data(), size, out.data(),
+                out.size()) == (long) in.size());
+    return out;
+}
+
+off_t FileSize(const std::string &path) {
+    struct stat st;
+    stat(path.c_str(), &st);
+    return st.st_size;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(lz_round_trips)
+{
+    std::vector<uint8_t> data;
+
+    BOOST_CHECK(RoundTrip(data) == data);
+
+    data.assign(100000, 0);
+    BOOST_CHECK(RoundTrip(data) == data);
+
+    srand(973);
+    for (size_t i = 0; i < data.size(); i++) {
+        /* random bytes with repeats mixed in */
+        data[i] = i > 300 && i % 7 < 3 ? data[i - 300] : rand();
+    }
+    BOOST_CHECK(RoundTrip(data) == data);
+
+    data.resize(3);
+    BOOST_CHECK(RoundTrip(data) == data);
+}
+
+BOOST_AUTO_TEST_CASE(lz_rejects_corrupt_input)
+{
+    std::vector<uint8_t> data(5000, 'x');
+    std::vector<uint8_t> compressed(LzCompressBound(data.size()));
+    std::vector<uint32_t> table(LZ_HASH_ENTRIES);
+    std::vector<uint8_t> out(data.size());
+    size_t size = LzCompress(data.data(), data.size(), compressed.data(),
+            table.data());
+
+    /* cut short, too small an output, and garbage never overrun */
+    BOOST_CHECK(LzDecompress(compressed.data(), size - 1, out.data(),
+                out.size()) != (long) data.size());
+    BOOST_CHECK(LzDecompress(compressed.data(), size, out.data(),
+                out.size() - 1) == -1);
+    srand(1);
+    for (int i = 0; i < 1000; i++) {
+        for (size_t j = 0; j < size; j++) {
+            compressed[j] = rand();
+        }
+        LzDecompress(compressed.data(), size, out.data(), out.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(row_transform_round_trips)
+{
+    uint8_t rows[5 * 7], encoded[5 * 7], decoded[5 * 7];
+
+    for (size_t i = 0; i < sizeof(rows); i++) {
+        rows[i] = i * 37;
+    }
+    LogRowsEncode(rows, 5, 7, encoded);
+    LogRowsDecode(encoded, 5, 7, decoded);
+    BOOST_CHECK(memcmp(rows, decoded, sizeof(rows)) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(compressed_log_is_smaller_and_survives_truncation)
+{
+    TempDir tmp("binlog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    std::vector<LogCell*> cells;
+    LogCell state("State", 32);
+    std::string binName, zName;
+
+    for (int i = 0; i < 30; i++) {
+        static char names[30][8];
+        snprintf(names[i], sizeof(names[i]), "col%d", i);
+        cells.push_back(new LogCell(names[i], LOG_CELL_DOUBLE));
+    }
+
+    {
+        LogSpreadsheet binLog(&mgr), zLog(&mgr);
+
+        binLog.SetLogDirectory(dir);
+        binLog.SetFormat(LOG_FORMAT_BINARY);
+        zLog.SetLogDirectory(dir);
+        zLog.SetFormat(LOG_FORMAT_COMPRESSED);
+        /* blocks of at most 100 rows */
+        zLog.SetBuffering(2000, 100, 60 * 1000);
+        binLog.SetBuffering(2000, 100, 60 * 1000);
+        for (LogSpreadsheet *log : {&binLog, &zLog}) {
+            for (LogCell *cell : cells) {
+                log->RegisterCell(cell);
+            }
+            log->RegisterCell(&state);
+            log->InitializeTable();
+        }
+
+        for (int row = 0; row < 1000; row++) {
+            /* a few columns move every row like sensors and setpoints
+             * do, the rest only now and then */
+            for (int i = 0; i < 30; i++) {
+                if (i < 6) {
+                    cells[i]->LogDouble(sin(row * 0.02 + i) * 10.0);
+                }
+                else {
+                    cells[i]->LogDouble((row / (50 + i)) * 0.5);
+                }
+            }
+            state.LogPrintf("state %d", row / 200);
+            binLog.TaskPostPeriodic(MODE_TELEOP);
+            zLog.TaskPostPeriodic(MODE_TELEOP);
+        }
+
+        binName = binLog.GetFileName();
+        zName = zLog.GetFileName();
+    }
+
+    off_t binSize = FileSize(binName), zSize = FileSize(zName);
+    BOOST_TEST_MESSAGE("binary " << binSize << " compressed " << zSize);
+    BOOST_CHECK(zSize * 5 < binSize);
+
+    BinaryLogReader bin, z;
+    BOOST_REQUIRE(bin.Open(binName.c_str()));
+    BOOST_REQUIRE(z.Open(zName.c_str()));
+    BOOST_CHECK(z.IsCompressed());
+    BOOST_REQUIRE(z.GetNumRows() == 1000);
+    BOOST_CHECK(memcmp(bin.GetRow(0), z.GetRow(0),
+                ((const uint8_t*) bin.GetRow(1) -
+                 (const uint8_t*) bin.GetRow(0)) * 1000) == 0);
+    z.Close();
+
+    /* power goes out halfway through writing the last block */
+    BOOST_REQUIRE(truncate(zName.c_str(), zSize - 10) == 0);
+    BOOST_REQUIRE(z.Open(zName.c_str()));
+    uint64_t rows = z.GetNumRows();
+    BOOST_CHECK(rows < 1000 && rows >= 900);
+    BOOST_CHECK(z.GetDouble(rows - 1, 3) == bin.GetDouble(rows - 1, 3));
+
+    bin.Close();
+    z.Close();
+    for (LogCell *cell : cells) {
+        delete cell;
+    }
+}
@@ -0,0 +1,166 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/LogSpreadsheet.h"
+#include "lib/util/VirtualClock.h"
+#include "BinaryLogReader.h"
+#include "TestHelpers.h"
+#include "LogIndex.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+using namespace frc973;
+
+namespace {
+
+/**
+ * Write 11s of log at 50Hz: 3s disabled, 6s auto, 2s teleop.  Count
+ * holds the row number.
+ */
+std::string WriteMatchLog(const char *dir, LogFormat format) {
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+    LogCell state("State", 32);
+    LogSpreadsheet log(&mgr);
+
+    VirtualClock::Enable(0);
+    log.SetLogDirectory(dir);
+    log.SetFormat(format);
+    log.SetBuffering(1024, LogWriter::DEFAULT_BATCH_ROWS,
+            LogWriter::DEFAULT_BATCH_MS);
+    log.SetSegments(LogWriter::DEFAULT_SEGMENT_BYTES,
+            LogWriter::DEFAULT_DISK_BUDGET_BYTES, false,
+            LogWriter::DEFAULT_CHECKPOINT_MS);
+    log.RegisterCell(&count);
+    log.RegisterCell(&state, LOG_SAMPLE_ON_CHANGE);
+    log.InitializeTable();
+
+    state.LogPrintf("ready");
+    for (int row = 0; row < 550; row++) {
+        VirtualClock::SetTimeUs(row * 20000);
+        count.LogInt(row);
+        log.TaskPostPeriodic(row < 150 ? MODE_DISABLED :
+                row < 450 ? MODE_AUTO : MODE_TELEOP);
+    }
+    VirtualClock::Disable();
+
+    return log.GetFileName();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(log_index_has_seconds_and_mode_changes)
+{
+    TempDir tmp("idxlog");
+    const char *dir = tmp.GetPath();
+    std::string name = WriteMatchLog(dir, LOG_FORMAT_BINARY);
+
+    LogIndex index;
+    BOOST_REQUIRE(index.Open(name.c_str()));
+
+    int modeChanges = 0;
+    for (size_t i = 0; i < index.GetNumEntries(); i++) {
+        const LogIndexEntry &entry = index.GetEntry(i);
+
+        if (entry.reason == LOG_INDEX_MODE) {
+            modeChanges++;
+            BOOST_CHECK(entry.modeStartUs == entry.timeUs);
+        }
+        if (i > 0) {
+            BOOST_CHECK(entry.offset > index.GetEntry(i - 1).offset);
+            BOOST_CHECK(entry.timeUs - index.GetEntry(i - 1).timeUs <=
+                    1000000);
+        }
+    }
+    BOOST_CHECK(modeChanges == 3);
+    BOOST_CHECK(index.GetEntry(0).reason == LOG_INDEX_MODE);
+    BOOST_CHECK(index.GetNumEntries() >= 11);
+
+    /* every entry points straight at its row */
+    BinaryLogReader reader;
+    const LogIndexEntry &auto1s = index.GetEntry(5);
+    BOOST_REQUIRE(reader.Open(name.c_str(), auto1s.offset,
+                index.GetEntry(6).offset));
+    BOOST_REQUIRE(reader.GetNumRows() > 0);
+    BOOST_CHECK(reader.GetRow(0)->row == auto1s.row);
+    BOOST_CHECK(reader.GetInt(0, 0) == (int32_t) auto1s.row);
+
+    reader.Close();
+}
+
+BOOST_AUTO_TEST_CASE(log_index_leaves_out_rows_that_were_not_written)
+{
+    TempDir tmp("idxlog");
+    const char *dir = tmp.GetPath();
+    struct rlimit saved, limit;
+
+    /* files can't grow past 8KB, so most of the rows fail to write */
+    getrlimit(RLIMIT_FSIZE, &saved);
+    limit = saved;
+    limit.rlim_cur = 8 * 1024;
+    signal(SIGXFSZ, SIG_IGN);
+    BOOST_REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    std::string name = WriteMatchLog(dir, LOG_FORMAT_BINARY);
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, SIG_DFL);
+
+    struct stat st;
+    BOOST_REQUIRE(stat(name.c_str(), &st) == 0);
+    BOOST_REQUIRE(st.st_size <= 8 * 1024);
+
+    LogIndex index;
+    BOOST_REQUIRE(index.Open(name.c_str()));
+    BOOST_CHECK(index.GetNumEntries() > 0);
+    for (size_t i = 0; i < index.GetNumEntries(); i++) {
+        BOOST_CHECK(index.GetEntry(i).offset < (uint64_t) st.st_size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(log_index_finds_rows_by_time_into_mode)
+{
+    TempDir tmp("idxlog");
+    const char *dir = tmp.GetPath();
+    std::string name = WriteMatchLog(dir, LOG_FORMAT_COMPRESSED);
+
+    LogIndex index;
+    BOOST_REQUIRE(index.Open(name.c_str()));
+
+    /* 3s to 5s into auto, which began 3s into the log */
+    std::vector<LogIndex::Range> ranges =
+        index.FindRanges(MODE_AUTO, 3000000, 5000000);
+    BOOST_REQUIRE(ranges.size() == 1);
+    BOOST_CHECK(ranges[0].modeStartUs == 3000000);
+
+    BinaryLogReader reader;
+    BOOST_REQUIRE(reader.Open(name.c_str(), ranges[0].begin, ranges[0].end));
+    BOOST_CHECK(reader.GetNumRows() < 200);
+
+    int found = 0;
+    for (uint64_t row = 0; row < reader.GetNumRows(); row++) {
+        const BinaryLogRecordHeader *header = reader.GetRow(row);
+        uint64_t sinceUs = header->timeUs - ranges[0].modeStartUs;
+
+        BOOST_CHECK(header->mode == MODE_AUTO);
+        if (sinceUs >= 3000000 && sinceUs <= 5000000) {
+            BOOST_CHECK(reader.GetInt(row, 0) == 300 + found);
+            found++;
+        }
+    }
+    BOOST_CHECK(found == 101);
+
+    /* reading started partway through, and the on-change column is still
+     * there */
+    char cell[64];
+    BOOST_CHECK(reader.IsPresent(0, 1));
+    reader.FormatCell(reader.GetNumRows() - 1, 1, cell, sizeof(cell));
+    BOOST_CHECK_EQUAL(cell, "ready");
+
+    /* nothing matches in a mode that never happened */
+    BOOST_CHECK(index.FindRanges(MODE_TEST, 0, UINT64_MAX).empty());
+
+    reader.Close();
+}
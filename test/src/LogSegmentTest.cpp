@@ -0,0 +1,311 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/logging/LogSpreadsheet.h"
+#include "BinaryLogReader.h"
+#include "TestHelpers.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace frc973;
+
+namespace {
+
+std::string ReadFile(const char *path) {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(log_rotates_on_mode_change)
+{
+    TempDir tmp("seglog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+    LogCell state("State", 32);
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.SetFormat(LOG_FORMAT_COMPRESSED);
+        log.RegisterCell(&count);
+        log.RegisterCell(&state, LOG_SAMPLE_ON_CHANGE);
+        log.InitializeTable();
+
+        state.LogPrintf("waiting");
+        for (int row = 0; row < 20; row++) {
+            count.LogInt(row);
+            log.TaskPostPeriodic(row < 12 ? MODE_DISABLED : MODE_AUTO);
+        }
+    }
+
+    std::vector<std::string> files = tmp.List();
+    BOOST_REQUIRE(files.size() == 2);
+    BOOST_CHECK(files[1].find("-001.binz") != std::string::npos);
+
+    BinaryLogReader first, second;
+    BOOST_REQUIRE(first.Open(files[0].c_str()));
+    BOOST_REQUIRE(second.Open(files[1].c_str()));
+    BOOST_CHECK(first.GetNumRows() == 12);
+    BOOST_REQUIRE(second.GetNumRows() == 8);
+    BOOST_CHECK(second.GetRow(0)->mode == MODE_AUTO);
+    BOOST_CHECK(second.GetInt(0, 0) == 12);
+
+    /* the on-change value didn't change, but the new segment still has it */
+    char cell[64];
+    BOOST_REQUIRE(second.IsPresent(0, 1));
+    second.FormatCell(0, 1, cell, sizeof(cell));
+    BOOST_CHECK_EQUAL(cell, "waiting");
+
+    first.Close();
+    second.Close();
+}
+
+BOOST_AUTO_TEST_CASE(log_rotates_at_segment_size)
+{
+    TempDir tmp("seglog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+    LogCell angle("Angle", LOG_CELL_DOUBLE);
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.SetFormat(LOG_FORMAT_BINARY);
+        log.SetSegments(2048, LogWriter::DEFAULT_DISK_BUDGET_BYTES, false,
+                LogWriter::DEFAULT_CHECKPOINT_MS);
+        log.RegisterCell(&count);
+        log.RegisterCell(&angle);
+        log.InitializeTable();
+
+        for (int row = 0; row < 200; row++) {
+            count.LogInt(row);
+            angle.LogDouble(row * 0.5);
+            log.TaskPostPeriodic(MODE_TELEOP);
+        }
+    }
+
+    std::vector<std::string> files = tmp.List();
+    BOOST_CHECK(files.size() > 2);
+
+    /* every segment is a log of its own, and none of the rows are lost */
+    uint64_t rows = 0;
+    for (const std::string &file : files) {
+        BinaryLogReader reader;
+        struct stat st;
+
+        BOOST_REQUIRE(reader.Open(file.c_str()));
+        BOOST_CHECK(reader.GetInt(0, 0) == (int32_t) rows);
+        rows += reader.GetNumRows();
+
+        /* the reserved space past the end was given back */
+        stat(file.c_str(), &st);
+        BOOST_CHECK(st.st_size <= 2048 + reader.GetRow(0)->size);
+    }
+    BOOST_CHECK(rows == 200);
+}
+
+BOOST_AUTO_TEST_CASE(log_stays_in_segment_it_cannot_leave)
+{
+    TempDir tmp("seglog");
+    const char *dir = tmp.GetPath();
+
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+    std::string name;
+    std::string errName = std::string(dir) + "/stderr.txt";
+    int savedStderr = dup(2);
+    int errFd = open(errName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    /* catch what the writer reports */
+    BOOST_REQUIRE(errFd >= 0);
+    fflush(stderr);
+    dup2(errFd, 2);
+    close(errFd);
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.SetFormat(LOG_FORMAT_BINARY);
+        log.SetSegments(1024, LogWriter::DEFAULT_DISK_BUDGET_BYTES, false,
+                LogWriter::DEFAULT_CHECKPOINT_MS);
+        log.RegisterCell(&count);
+        log.InitializeTable();
+
+        /* a directory where the next segment should go, so it can't be
+         * created */
+        name = log.GetFileName();
+        std::string next = name;
+        next.replace(next.rfind("-000."), 5, "-001.");
+        BOOST_REQUIRE(mkdir(next.c_str(), 0755) == 0);
+
+        for (int row = 0; row < 200; row++) {
+            count.LogInt(row);
+            log.TaskPostPeriodic(MODE_TELEOP);
+        }
+    }
+    fflush(stderr);
+    dup2(savedStderr, 2);
+    close(savedStderr);
+
+    /* every row went on the end of the first segment, and the failure
+     * was only tried (and reported) once */
+    BinaryLogReader reader;
+    BOOST_REQUIRE(reader.Open(name.c_str()));
+    BOOST_CHECK(reader.GetNumRows() == 200);
+    BOOST_CHECK(reader.GetInt(199, 0) == 199);
+    BOOST_CHECK(tmp.List().size() == 3);
+
+    std::string errors = ReadFile(errName.c_str());
+    BOOST_CHECK(errors.find("Could not open") != std::string::npos);
+    BOOST_CHECK(errors.find("Could not open") ==
+            errors.rfind("Could not open"));
+}
+
+BOOST_AUTO_TEST_CASE(old_logs_are_deleted_to_stay_under_budget)
+{
+    TempDir tmp("seglog");
+    const char *dir = tmp.GetPath();
+
+    std::string oldest = std::string(dir) + "/log-1-000.bin";
+    std::string older = std::string(dir) + "/log-2-000.txt";
+    std::string other = std::string(dir) + "/notes.txt";
+    struct utimbuf times;
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+
+    for (const std::string &name : {oldest, older, other}) {
+        FILE *file = fopen(name.c_str(), "w");
+        BOOST_REQUIRE(file != nullptr);
+        BOOST_REQUIRE(fseek(file, 40 * 1024 - 1, SEEK_SET) == 0);
+        fputc(0, file);
+        fclose(file);
+    }
+    times.actime = times.modtime = 1000;
+    utime(oldest.c_str(), &times);
+    times.actime = times.modtime = 2000;
+    utime(older.c_str(), &times);
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.SetSegments(8 * 1024, 64 * 1024, true,
+                LogWriter::DEFAULT_CHECKPOINT_MS);
+        log.RegisterCell(&count);
+        log.InitializeTable();
+        count.LogInt(1);
+        log.TaskPostPeriodic(MODE_DISABLED);
+    }
+
+    /* only the oldest log had to go, and never anything that isn't a log */
+    BOOST_CHECK(access(oldest.c_str(), F_OK) != 0);
+    BOOST_CHECK(access(older.c_str(), F_OK) == 0);
+    BOOST_CHECK(access(other.c_str(), F_OK) == 0);
+    BOOST_CHECK(tmp.List().size() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(reserved_space_counts_toward_budget)
+{
+    TempDir tmp("seglog");
+    const char *dir = tmp.GetPath();
+
+    std::string oldest = std::string(dir) + "/log-1-000.bin";
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+
+    /* fits in the budget next to the new log's rows, but not next to the
+     * whole segment it reserves */
+    FILE *file = fopen(oldest.c_str(), "w");
+    BOOST_REQUIRE(file != nullptr);
+    BOOST_REQUIRE(fseek(file, 20 * 1024 - 1, SEEK_SET) == 0);
+    fputc(0, file);
+    fclose(file);
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.SetFormat(LOG_FORMAT_BINARY);
+        log.SetSegments(32 * 1024, 48 * 1024, true,
+                LogWriter::DEFAULT_CHECKPOINT_MS);
+        log.RegisterCell(&count);
+        log.InitializeTable();
+
+        struct stat st;
+        BOOST_REQUIRE(stat(log.GetFileName(), &st) == 0);
+        if (st.st_blocks * 512 < 32 * 1024) {
+            BOOST_TEST_MESSAGE("no fallocate here, nothing to check");
+            return;
+        }
+        count.LogInt(1);
+        log.TaskPostPeriodic(MODE_DISABLED);
+    }
+
+    BOOST_CHECK(access(oldest.c_str(), F_OK) != 0);
+}
+
+BOOST_AUTO_TEST_CASE(log_indexes_count_toward_budget)
+{
+    TempDir tmp("seglog");
+    const char *dir = tmp.GetPath();
+
+    std::string oldest = std::string(dir) + "/log-1-000.bin";
+    std::string older = std::string(dir) + "/log-2-000.bin";
+    std::string olderIndex = older + ".idx";
+    std::string orphan = std::string(dir) + "/log-9-000.bin.idx";
+    struct utimbuf times;
+    TestTaskMgr mgr;
+    LogCell count("Count", LOG_CELL_INT);
+
+    /* the logs alone fit in the budget; with the index they don't */
+    for (const std::string &name : {oldest, older, olderIndex, orphan}) {
+        FILE *file = fopen(name.c_str(), "w");
+        BOOST_REQUIRE(file != nullptr);
+        BOOST_REQUIRE(fseek(file, (name == oldest || name == older ?
+                    20 : 30) * 1024 - 1, SEEK_SET) == 0);
+        fputc(0, file);
+        fclose(file);
+    }
+    times.actime = times.modtime = 1000;
+    utime(oldest.c_str(), &times);
+    times.actime = times.modtime = 2000;
+    utime(older.c_str(), &times);
+
+    {
+        LogSpreadsheet log(&mgr);
+
+        log.SetLogDirectory(dir);
+        log.SetFormat(LOG_FORMAT_BINARY);
+        log.SetSegments(8 * 1024, 64 * 1024, true,
+                LogWriter::DEFAULT_CHECKPOINT_MS);
+        log.RegisterCell(&count);
+        log.InitializeTable();
+        count.LogInt(1);
+        log.TaskPostPeriodic(MODE_DISABLED);
+    }
+
+    BOOST_CHECK(access(orphan.c_str(), F_OK) != 0);
+    BOOST_CHECK(access(oldest.c_str(), F_OK) != 0);
+    BOOST_CHECK(access(older.c_str(), F_OK) == 0);
+    BOOST_CHECK(access(olderIndex.c_str(), F_OK) == 0);
+}
@@ -0,0 +1,48 @@
+/*
+ * LoggedValues.h
+ *
+ * Made-up numbers shaped like the ones the robot logs, shared by the
+ * number formatting test and benchmark.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+namespace frc973 {
+
+/**
+ * Values like the ones the robot logs: sensor readings with a few
+ * decimals, angles, tiny errors, the odd huge or odd-looking one
+ */
+inline std::vector<double> LoggedValues(size_t count) {
+    std::mt19937_64 rng(973);
+    std::vector<double> values;
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t bits = rng();
+        double val;
+
+        switch (i % 4) {
+            case 0:
+                val = ((int64_t) (bits % 2000001) - 1000000) / 1000.0;
+                break;
+            case 1:
+                val = (int64_t) (bits >> 20) / (double) (1 << (bits % 30));
+                break;
+            case 2:
+                val = ((int64_t) (bits % 200001) - 100000) * 1e-9;
+                break;
+            default:
+                memcpy(&val, &bits, sizeof(val));
+                break;
+        }
+        values.push_back(val);
+    }
+    return values;
+}
+
+}
@@ -0,0 +1,39 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/util/Mailbox.h"
+#include "lib/util/VirtualClock.h"
+
+using namespace frc973;
+
+namespace {
+
+struct Reading {
+    double angle;
+    double rate;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(mailbox_holds_newest_stamped_sample)
+{
+    VirtualClock::Enable(1000);
+    Mailbox<Reading> mailbox;
+    Reading reading;
+    uint64_t timeUs;
+
+    BOOST_CHECK(!mailbox.Read(&reading));
+    BOOST_CHECK(reading.angle == 0.0);
+
+    mailbox.Publish(Reading{1.0, 2.0});
+    VirtualClock::AdvanceUs(5000);
+    mailbox.Publish(Reading{3.0, 4.0});
+    VirtualClock::AdvanceUs(2000);
+
+    BOOST_CHECK(mailbox.Read(&reading, &timeUs));
+    BOOST_CHECK(reading.angle == 3.0 && reading.rate == 4.0);
+    BOOST_CHECK(timeUs == 6000);
+    BOOST_CHECK(mailbox.GetAgeUs() == 2000);
+    BOOST_CHECK(mailbox.GetVersion() == 2);
+
+    VirtualClock::Disable();
+}
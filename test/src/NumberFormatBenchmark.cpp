@@ -0,0 +1,85 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/util/NumberFormat.h"
+#include "LoggedValues.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+using namespace frc973;
+
+namespace {
+
+/**
+ * What LogCell::LogPrintf does with a number
+ */
+int VFormat(char *buf, size_t size, const char *format, ...) {
+    va_list args;
+    int len;
+
+    va_start(args, format);
+    len = vsnprintf(buf, size, format, args);
+    va_end(args);
+    return len;
+}
+
+}
+
+/**
+ * Not a pass/fail test: prints how long formatting a logged double and
+ * int takes with vsnprintf (what LogCell::LogPrintf does) and with
+ * NumberFormat.  This file and NumberFormat.cpp are built with the robot
+ * code's flags (see CMakeLists.txt); run check on the RIO for the numbers
+ * that matter.
+ */
+BOOST_AUTO_TEST_CASE(format_benchmark)
+{
+    std::vector<double> values = LoggedValues(20000);
+    char buf[64];
+    size_t total = 0;
+
+    /* keep the huge ones (snprintf either way) out of it */
+    for (double &val : values) {
+        if (!(fabs(val) < 1e9)) {
+            val = 1.0 / val;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (double val : values) {
+        total += VFormat(buf, sizeof(buf), "%lf", val);
+    }
+    auto vsnprintfDone = std::chrono::steady_clock::now();
+    for (double val : values) {
+        total += FormatFixed(val, FORMAT_DEFAULT_DECIMALS, buf, sizeof(buf));
+    }
+    auto fixedDone = std::chrono::steady_clock::now();
+    for (double val : values) {
+        total += VFormat(buf, sizeof(buf), "%d", (int) val);
+    }
+    auto vsnprintfIntDone = std::chrono::steady_clock::now();
+    for (double val : values) {
+        total += FormatInt((int) val, buf, sizeof(buf));
+    }
+    auto intDone = std::chrono::steady_clock::now();
+
+    auto nsPerValue = [&](std::chrono::steady_clock::duration time) {
+        return std::chrono::duration<double, std::nano>(time).count() /
+            values.size();
+    };
+    double vsnprintfNs = nsPerValue(vsnprintfDone - start);
+    double fixedNs = nsPerValue(fixedDone - vsnprintfDone);
+    double vsnprintfIntNs = nsPerValue(vsnprintfIntDone - fixedDone);
+    double intNs = nsPerValue(intDone - vsnprintfIntDone);
+
+    printf("double: vsnprintf %.0lfns FormatFixed %.0lfns (%.1lfx)\n",
+            vsnprintfNs, fixedNs, vsnprintfNs / fixedNs);
+    printf("int:    vsnprintf %.0lfns FormatInt %.0lfns (%.1lfx)\n",
+            vsnprintfIntNs, intNs, vsnprintfIntNs / intNs);
+    BOOST_WARN(fixedNs < vsnprintfNs);
+    BOOST_WARN(intNs < vsnprintfIntNs);
+    BOOST_CHECK(total > 0);
+}
@@ -0,0 +1,84 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/util/NumberFormat.h"
+#include "lib/logging/LogSpreadsheet.h"
+#include "LoggedValues.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace frc973;
+
+BOOST_AUTO_TEST_CASE(format_fixed_matches_printf)
+{
+    std::vector<double> values = LoggedValues(200000);
+    const double edges[] = {0.0, -0.0, 0.5, 1.5, 2.5, -2.5, 0.125, 5e-7,
+        -5e-7, 1.0000005, 9.9999995, 123456789.0000005, 1e300, -1e-300,
+        INFINITY, -INFINITY, NAN};
+    char fast[400], slow[400];
+    int failures = 0;
+
+    values.insert(values.end(), edges, edges + sizeof(edges) / sizeof(edges[0]));
+    for (double val : values) {
+        for (int decimals = 0; decimals <= 10; decimals++) {
+            int fastLen = FormatFixed(val, decimals, fast, sizeof(fast));
+            int slowLen = snprintf(slow, sizeof(slow), "%.*f", decimals, val);
+
+            if (fastLen != slowLen || strcmp(fast, slow) != 0) {
+                failures++;
+            }
+        }
+    }
+    BOOST_CHECK(failures == 0);
+
+    /* cut off the way snprintf cuts off */
+    BOOST_CHECK(FormatFixed(3.14159, 6, fast, 4) == 8);
+    BOOST_CHECK_EQUAL(fast, "3.1");
+}
+
+BOOST_AUTO_TEST_CASE(format_int_matches_printf)
+{
+    std::mt19937_64 rng(973);
+    const int64_t edges[] = {0, -1, 9, 10, 99, 100, INT32_MIN, INT32_MAX,
+        UINT32_MAX, INT64_MIN, INT64_MAX};
+    char fast[32], slow[32];
+
+    for (int64_t val : edges) {
+        FormatInt(val, fast, sizeof(fast));
+        snprintf(slow, sizeof(slow), "%lld", (long long) val);
+        BOOST_CHECK_EQUAL(fast, slow);
+    }
+    for (int i = 0; i < 100000; i++) {
+        uint64_t bits = rng();
+        int64_t val = (int64_t) bits >> (bits % 64);
+
+        FormatInt(val, fast, sizeof(fast));
+        snprintf(slow, sizeof(slow), "%lld", (long long) val);
+        BOOST_REQUIRE_EQUAL(fast, slow);
+
+        FormatUnsigned(bits, fast, sizeof(fast));
+        snprintf(slow, sizeof(slow), "%llu", (unsigned long long) bits);
+        BOOST_REQUIRE_EQUAL(fast, slow);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(log_cell_decimals)
+{
+    LogCell text("Text", 32);
+    LogCell number("Number", LOG_CELL_DOUBLE);
+
+    text.LogDouble(2.0 / 3.0);
+    BOOST_CHECK_EQUAL(text.GetContent(), "0.666667");
+    text.SetDecimals(3);
+    text.LogDouble(-2.0 / 3.0);
+    BOOST_CHECK_EQUAL(text.GetContent(), "-0.667");
+    text.LogInt(-42);
+    BOOST_CHECK_EQUAL(text.GetContent(), "-42");
+
+    number.SetDecimals(2);
+    number.LogDouble(12.345);
+    BOOST_CHECK_EQUAL(number.GetContent(), "12.35");
+    BOOST_CHECK(number.GetDecimals() == 2);
+}
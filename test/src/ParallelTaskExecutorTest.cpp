@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <time.h>
+#include <unistd.h>
+#include "lib/ParallelTaskExecutor.h"
+
+using namespace frc973;
+
+namespace {
+
+struct OrderCheck {
+    std::atomic<int> nextStamp;
+    int stamp[16];
+    int runs[16];
+};
+
+void StampNode(void *ctx, int node) {
+    OrderCheck *check = static_cast<OrderCheck*>(ctx);
+    check->stamp[node] = check->nextStamp.fetch_add(1);
+    check->runs[node]++;
+}
+
+void SleepNode(void *ctx, int node) {
+    usleep(20000);
+}
+
+/**
+ * CPU time used so far by |thread|, in microseconds
+ */
+long ThreadCpuUs(pthread_t thread) {
+    clockid_t clock;
+    struct timespec ts;
+
+    if (pthread_getcpuclockid(thread, &clock) != 0 ||
+            clock_gettime(clock, &ts) != 0) {
+        return -1;
+    }
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(parallel_executor_respects_edges)
+{
+    ParallelTaskExecutor executor(3);
+    TaskGraph graph;
+
+    /* 0 -> {1, 2, 3} -> 4, plus a chain 5 -> 6 -> 7 off to the side */
+    for (int i = 0; i < 8; i++) {
+        graph.AddNode();
+    }
+    graph.AddEdge(0, 1);
+    graph.AddEdge(0, 2);
+    graph.AddEdge(0, 3);
+    graph.AddEdge(1, 4);
+    graph.AddEdge(2, 4);
+    graph.AddEdge(3, 4);
+    graph.AddEdge(5, 6);
+    graph.AddEdge(6, 7);
+
+    for (int iter = 0; iter < 500; iter++) {
+        OrderCheck check;
+        check.nextStamp = 0;
+        for (int i = 0; i < 16; i++) {
+            check.runs[i] = 0;
+        }
+
+        executor.Run(graph, StampNode, &check);
+
+        BOOST_REQUIRE(check.nextStamp == 8);
+        for (int i = 0; i < 8; i++) {
+            BOOST_REQUIRE(check.runs[i] == 1);
+        }
+        for (int i = 1; i <= 3; i++) {
+            BOOST_REQUIRE(check.stamp[0] < check.stamp[i]);
+            BOOST_REQUIRE(check.stamp[i] < check.stamp[4]);
+        }
+        BOOST_REQUIRE(check.stamp[5] < check.stamp[6]);
+        BOOST_REQUIRE(check.stamp[6] < check.stamp[7]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_executor_idle_worker_sleeps)
+{
+    ParallelTaskExecutor executor(2);
+    TaskGraph graph;
+
+    /* a chain leaves the second thread nothing to do for 100ms */
+    for (int i = 0; i < 5; i++) {
+        graph.AddNode();
+        if (i > 0) {
+            graph.AddEdge(i - 1, i);
+        }
+    }
+
+    long before = ThreadCpuUs(executor.GetWorkerThread(1));
+    executor.Run(graph, SleepNode, nullptr);
+    long used = ThreadCpuUs(executor.GetWorkerThread(1)) - before;
+
+    BOOST_REQUIRE(before >= 0);
+    BOOST_CHECK(used < 20000);
+}
@@ -0,0 +1,62 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/PeriodicTimer.h"
+
+using namespace frc973;
+
+BOOST_AUTO_TEST_CASE(periodic_timer_on_time)
+{
+    uint32_t missed;
+
+    BOOST_CHECK(PeriodicTimer::AdvanceDeadline(1000, 1500, 1000,
+                PeriodicTimer::SkipMissed, &missed) == 2000);
+    BOOST_CHECK(missed == 0);
+    BOOST_CHECK(PeriodicTimer::AdvanceDeadline(1000, 1500, 1000,
+                PeriodicTimer::CatchUp, &missed) == 2000);
+    BOOST_CHECK(missed == 0);
+}
+
+BOOST_AUTO_TEST_CASE(periodic_timer_skip_missed)
+{
+    uint32_t missed;
+
+    /* ran 2.5 periods over: boundaries at 2000 and 3000 were missed */
+    BOOST_CHECK(PeriodicTimer::AdvanceDeadline(1000, 3500, 1000,
+                PeriodicTimer::SkipMissed, &missed) == 4000);
+    BOOST_CHECK(missed == 2);
+
+    /* landing exactly on a boundary still counts it as missed */
+    BOOST_CHECK(PeriodicTimer::AdvanceDeadline(1000, 2000, 1000,
+                PeriodicTimer::SkipMissed, &missed) == 3000);
+    BOOST_CHECK(missed == 1);
+}
+
+BOOST_AUTO_TEST_CASE(periodic_timer_catch_up)
+{
+    uint32_t missed;
+
+    /* a few periods behind: run the next one right away */
+    BOOST_CHECK(PeriodicTimer::AdvanceDeadline(1000, 3500, 1000,
+                PeriodicTimer::CatchUp, &missed) == 2000);
+    BOOST_CHECK(missed == 0);
+
+    /* too far behind: give up and line up with the next boundary */
+    BOOST_CHECK(PeriodicTimer::AdvanceDeadline(1000, 20500, 1000,
+                PeriodicTimer::CatchUp, &missed) == 21000);
+    BOOST_CHECK(missed == 19);
+}
+
+BOOST_AUTO_TEST_CASE(periodic_timer_sleeps)
+{
+    PeriodicTimer timer(2000000);
+
+    timer.Reset();
+    uint64_t start = PeriodicTimer::GetMonotonicNs();
+    for (int i = 0; i < 5; i++) {
+        timer.WaitForNextPeriod();
+    }
+    uint64_t elapsed = PeriodicTimer::GetMonotonicNs() - start;
+
+    BOOST_CHECK(elapsed >= 10000000);
+    BOOST_CHECK(timer.GetWakeJitterStats().GetCount() == 5);
+}
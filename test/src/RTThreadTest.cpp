@@ -0,0 +1,20 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/RTThread.h"
+
+using namespace frc973;
+
+BOOST_AUTO_TEST_CASE(rt_thread_configure_and_report)
+{
+    RTThreadConfig config = {"rt thread test", 0, -1, 32 * 1024};
+    RTThread::ThreadStats stats;
+
+    /* normal priority on any cpu needs no privileges */
+    BOOST_CHECK(RTThread::Configure(config));
+
+    BOOST_REQUIRE(RTThread::GetThreadStats(RTThread::GetThreadId(), &stats));
+    BOOST_CHECK(stats.voluntarySwitches + stats.involuntarySwitches > 0);
+    BOOST_CHECK(stats.minorFaults > 0);
+
+    BOOST_CHECK(!RTThread::GetThreadStats(-1, &stats));
+}
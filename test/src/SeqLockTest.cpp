@@ -0,0 +1,66 @@
+#include <boost/test/unit_test.hpp>
+
+#include <pthread.h>
+#include "lib/util/SeqLock.h"
+
+using namespace frc973;
+
+namespace {
+
+struct Sample {
+    uint32_t a;
+    uint64_t b;
+    double c;
+};
+
+struct WriterArgs {
+    SeqLock<Sample> *lock;
+    uint32_t numWrites;
+};
+
+void *WriteSamples(void *p) {
+    WriterArgs *args = static_cast<WriterArgs*>(p);
+
+    for (uint32_t i = 1; i <= args->numWrites; i++) {
+        Sample sample = {i, i * 3ULL, i * 0.5};
+        args->lock->Write(sample);
+    }
+    return NULL;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(seq_lock_single_thread)
+{
+    Sample initial = {7, 8, 9.0};
+    SeqLock<Sample> lock(initial);
+    Sample out;
+
+    BOOST_CHECK(lock.Read(&out) == 0);
+    BOOST_CHECK(out.a == 7 && out.b == 8 && out.c == 9.0);
+
+    Sample next = {1, 2, 3.0};
+    lock.Write(next);
+    BOOST_CHECK(lock.Read(&out) == 1);
+    BOOST_CHECK(out.a == 1 && out.b == 2 && out.c == 3.0);
+    BOOST_CHECK(lock.GetVersion() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(seq_lock_reads_are_never_torn)
+{
+    SeqLock<Sample> lock;
+    WriterArgs args = {&lock, 200000};
+    pthread_t writer;
+    uint32_t lastSeen = 0;
+
+    pthread_create(&writer, NULL, WriteSamples, &args);
+    while (lastSeen < args.numWrites) {
+        Sample out = lock.Read();
+
+        BOOST_REQUIRE(out.b == out.a * 3ULL);
+        BOOST_REQUIRE(out.c == out.a * 0.5);
+        BOOST_REQUIRE(out.a >= lastSeen);
+        lastSeen = out.a;
+    }
+    pthread_join(writer, NULL);
+}
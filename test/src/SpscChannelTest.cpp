@@ -0,0 +1,70 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/SpscChannel.h"
+
+#include <pthread.h>
+#include <vector>
+
+using namespace frc973;
+
+BOOST_AUTO_TEST_CASE(spsc_ring_fills_and_wraps)
+{
+    SpscRing<int, 4> ring;
+    int val;
+
+    BOOST_CHECK(!ring.Recv(&val));
+    for (int i = 0; i < 4; i++) {
+        BOOST_CHECK(ring.Send(i));
+    }
+    BOOST_CHECK(!ring.Send(99));
+    BOOST_CHECK(ring.Size() == 4);
+
+    BOOST_CHECK(ring.Recv(&val) && val == 0);
+    BOOST_CHECK(ring.Send(4));
+
+    int batch[8];
+    BOOST_CHECK(ring.RecvBatch(batch, 2) == 2);
+    BOOST_CHECK(batch[0] == 1 && batch[1] == 2);
+
+    BOOST_CHECK(ring.Send(5));
+    std::vector<int> drained;
+    BOOST_CHECK(ring.Drain([&](int v) { drained.push_back(v); }) == 3);
+    BOOST_CHECK(drained == std::vector<int>({3, 4, 5}));
+    BOOST_CHECK(ring.Empty());
+}
+
+namespace {
+
+static constexpr int NUM_MESSAGES = 200000;
+
+BlockingSpscChannel<int, 64> channel;
+
+void *Producer(void *) {
+    for (int i = 0; i < NUM_MESSAGES; ) {
+        if (channel.Send(i)) {
+            i++;
+        }
+    }
+    return nullptr;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(spsc_channel_passes_values_in_order_across_threads)
+{
+    pthread_t thread;
+    bool inOrder = true;
+    int val;
+
+    BOOST_REQUIRE(pthread_create(&thread, NULL, Producer, NULL) == 0);
+    for (int i = 0; i < NUM_MESSAGES; i++) {
+        if (!channel.Recv(&val) || val != i) {
+            inOrder = false;
+            break;
+        }
+    }
+    pthread_join(thread, NULL);
+
+    BOOST_CHECK(inOrder);
+    BOOST_CHECK(!channel.Recv(&val, 1000));
+}
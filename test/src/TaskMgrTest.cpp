@@ -0,0 +1,277 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/CoopTask.h"
+#include "TestHelpers.h"
+
+#include "lib/util/VirtualClock.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <vector>
+
+using namespace frc973;
+
+namespace {
+
+class TickTask : public CoopTask {
+public:
+    TickTask() : numPeriodic(0) {}
+    void TaskPeriodic(RobotMode mode) override {
+        numPeriodic++;
+    }
+    int numPeriodic;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_rate_divisor)
+{
+    SteppedTaskMgr mgr;
+    TickTask fast, vision, dash;
+
+    mgr.RegisterTask("drive", &fast, TASK_PERIODIC);
+    mgr.RegisterTask("vision", &vision, TASK_PERIODIC, 4);
+    mgr.RegisterTask("dash", &dash, TASK_PERIODIC, 20);
+
+    for (int i = 0; i < 100; i++) {
+        mgr.RunCycle();
+    }
+
+    BOOST_CHECK(fast.numPeriodic == 100);
+    BOOST_CHECK(vision.numPeriodic == 25);
+    BOOST_CHECK(dash.numPeriodic == 5);
+    BOOST_CHECK(mgr.GetCycleCount() == 100);
+    BOOST_CHECK(mgr.GetTaskRateDivisor(1) == 4);
+}
+
+namespace {
+
+class StaggerTask : public CoopTask {
+public:
+    StaggerTask(int *perCycle, const int *cycle) :
+        m_perCycle(perCycle), m_cycle(cycle) {}
+    void TaskPeriodic(RobotMode mode) override {
+        m_perCycle[*m_cycle]++;
+    }
+private:
+    int *m_perCycle;
+    const int *m_cycle;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_rate_stagger)
+{
+    SteppedTaskMgr mgr;
+    int perCycle[8] = {0};
+    int cycle = 0;
+    StaggerTask a(perCycle, &cycle), b(perCycle, &cycle),
+                c(perCycle, &cycle), d(perCycle, &cycle);
+
+    /* four tasks at 1/4 rate should land on four different cycles */
+    mgr.RegisterTask("a", &a, TASK_PERIODIC, 4);
+    mgr.RegisterTask("b", &b, TASK_PERIODIC, 4);
+    mgr.RegisterTask("c", &c, TASK_PERIODIC, 4);
+    mgr.RegisterTask("d", &d, TASK_PERIODIC, 4);
+
+    for (cycle = 0; cycle < 8; cycle++) {
+        mgr.RunCycle();
+    }
+
+    for (int i = 0; i < 8; i++) {
+        BOOST_CHECK(perCycle[i] == 1);
+    }
+}
+
+namespace {
+
+class OrderTask : public CoopTask {
+public:
+    OrderTask(std::atomic<int> *clock) : stamp(-1), m_clock(clock) {}
+    void TaskPeriodic(RobotMode mode) override {
+        stamp = m_clock->fetch_add(1);
+    }
+    int stamp;
+private:
+    std::atomic<int> *m_clock;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_parallel_keeps_conflict_order)
+{
+    SteppedTaskMgr mgr;
+    std::atomic<int> clock(0);
+    OrderTask drive(&clock), shooter(&clock), lights(&clock),
+              hanger(&clock), joystick(&clock);
+
+    mgr.RegisterTask("joystick", &joystick, TASK_PERIODIC);
+    mgr.RegisterTask("drive", &drive, TASK_PERIODIC);
+    mgr.RegisterTask("shooter", &shooter, TASK_PERIODIC);
+    mgr.RegisterTask("lights", &lights, TASK_PERIODIC);
+    mgr.RegisterTask("hanger", &hanger, TASK_PERIODIC);
+
+    mgr.SetTaskResources(&drive, 0, 0x1);
+    mgr.SetTaskResources(&shooter, 0x1, 0x2);
+    mgr.SetTaskResources(&lights, 0, 0x4);
+    mgr.SetTaskResources(&hanger, 0, 0x8);
+    mgr.SetExecutionMode(TaskMgr::ParallelExecution, 2);
+    BOOST_CHECK(mgr.GetExecutionMode() == TaskMgr::ParallelExecution);
+
+    for (int i = 0; i < 200; i++) {
+        clock = 0;
+        mgr.RunCycle();
+
+        BOOST_REQUIRE(clock == 5);
+        /* undeclared tasks run alone, shooter reads what drive writes */
+        BOOST_REQUIRE(joystick.stamp == 0);
+        BOOST_REQUIRE(drive.stamp < shooter.stamp);
+    }
+
+    mgr.SetExecutionMode(TaskMgr::SerialExecution);
+    clock = 0;
+    mgr.RunCycle();
+    BOOST_CHECK(joystick.stamp == 0);
+    BOOST_CHECK(drive.stamp == 1);
+    BOOST_CHECK(shooter.stamp == 2);
+    BOOST_CHECK(lights.stamp == 3);
+    BOOST_CHECK(hanger.stamp == 4);
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_many_tasks_and_unregister)
+{
+    SteppedTaskMgr mgr;
+    std::atomic<int> clock(0);
+    std::vector<OrderTask*> tasks;
+    char name[16];
+
+    /* more than the old 32 task limit */
+    for (int i = 0; i < 100; i++) {
+        tasks.push_back(new OrderTask(&clock));
+        snprintf(name, sizeof(name), "task%d", i);
+        BOOST_REQUIRE(mgr.RegisterTask(name, tasks[i], TASK_PERIODIC));
+    }
+    BOOST_CHECK(mgr.GetNumTasks() == 100);
+
+    /* drop every third task, the rest keep their order */
+    for (int i = 0; i < 100; i += 3) {
+        BOOST_CHECK(mgr.UnregisterTask(tasks[i]));
+    }
+    BOOST_CHECK(!mgr.UnregisterTask(tasks[0]));
+    BOOST_CHECK(mgr.GetNumTasks() == 66);
+    BOOST_CHECK(mgr.GetTask(0) == tasks[1]);
+    BOOST_CHECK(mgr.GetTask(2) == tasks[4]);
+
+    mgr.RunCycle();
+
+    int expected = 0;
+    for (int i = 0; i < 100; i++) {
+        if (i % 3 == 0) {
+            BOOST_CHECK(tasks[i]->stamp == -1);
+        }
+        else {
+            BOOST_CHECK(tasks[i]->stamp == expected++);
+        }
+        delete tasks[i];
+    }
+}
+
+namespace {
+
+class BudgetTaskMgr : public TaskMgr {
+public:
+    BudgetTaskMgr() {
+        SetCycleOverrunThreshold(20000);
+    }
+    void RunCycle(uint32_t cycleUs) {
+        TaskPeriodicAll(MODE_TELEOP);
+        EndCycle(cycleUs);
+    }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_degrades_best_effort_tasks)
+{
+    BudgetTaskMgr mgr;
+    TickTask drive, logger;
+
+    mgr.RegisterTask("drive", &drive, TASK_PERIODIC);
+    mgr.RegisterTask("logger", &logger, TASK_PERIODIC | TASK_BEST_EFFORT);
+
+    /* overrun enough cycles to hit the top level: logger stops running */
+    for (int i = 0; i < MAX_DEGRADATION_LEVEL; i++) {
+        mgr.RunCycle(30000);
+    }
+    BOOST_CHECK(mgr.GetDegradationLevel() == MAX_DEGRADATION_LEVEL);
+
+    int loggerRuns = logger.numPeriodic;
+    for (int i = 0; i < 10; i++) {
+        mgr.RunCycle(30000);
+    }
+    BOOST_CHECK(logger.numPeriodic == loggerRuns);
+    BOOST_CHECK(drive.numPeriodic == MAX_DEGRADATION_LEVEL + 10);
+    BOOST_CHECK(mgr.GetTaskSkips(1) >= 10);
+    BOOST_CHECK(mgr.GetTaskSkips(0) == 0);
+
+    /* quiet cycles bring it back one level at a time */
+    for (int i = 0; i < DEGRADATION_RECOVERY_CYCLES * MAX_DEGRADATION_LEVEL;
+            i++) {
+        mgr.RunCycle(5000);
+    }
+    BOOST_CHECK(mgr.GetDegradationLevel() == 0);
+
+    loggerRuns = logger.numPeriodic;
+    mgr.RunCycle(5000);
+    BOOST_CHECK(logger.numPeriodic == loggerRuns + 1);
+}
+
+namespace {
+
+/**
+ * Runs in every periodic phase, and its first pre-periodic call takes
+ * |spinUs| of virtual time
+ */
+class SlowStartTask : public CoopTask {
+public:
+    SlowStartTask(uint32_t spinUs)
+        : spinUs(spinUs), numPre(0), numPeriodic(0), numPost(0) {}
+    void TaskPrePeriodic(RobotMode mode) override {
+        VirtualClock::AdvanceUs(spinUs);
+        spinUs = 0;
+        numPre++;
+    }
+    void TaskPeriodic(RobotMode mode) override {
+        numPeriodic++;
+    }
+    void TaskPostPeriodic(RobotMode mode) override {
+        numPost++;
+    }
+    uint32_t spinUs;
+    int numPre, numPeriodic, numPost;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_penalty_is_served_in_cycles)
+{
+    SteppedTaskMgr mgr;
+    SlowStartTask task(2500);
+
+    mgr.RegisterTask("lights", &task, TASK_PRE_PERIODIC | TASK_PERIODIC |
+            TASK_POST_PERIODIC | TASK_BEST_EFFORT);
+    mgr.SetTaskBudget(&task, 1000);
+
+    /* the first cycle runs in full, the 2500us call in it costs the whole
+     * task two cycles, and then it runs again */
+    VirtualClock::Enable(0);
+    for (int i = 0; i < 4; i++) {
+        mgr.RunCycle();
+    }
+    VirtualClock::Disable();
+
+    BOOST_CHECK(task.numPre == 2);
+    BOOST_CHECK(task.numPeriodic == 2);
+    BOOST_CHECK(task.numPost == 2);
+    BOOST_CHECK(mgr.GetTaskSkips(0) == 2);
+}
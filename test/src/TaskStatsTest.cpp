@@ -0,0 +1,137 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/TaskStats.h"
+#include "lib/TaskMgr.h"
+#include "lib/CoopTask.h"
+#include "lib/logging/LogSpreadsheet.h"
+#include "lib/logging/TaskStatsLogger.h"
+#include "TestHelpers.h"
+
+#include <string>
+
+using namespace frc973;
+
+BOOST_AUTO_TEST_CASE(task_stats_buckets)
+{
+    for (uint32_t us = 0; us < 200000; us += 7) {
+        int bucket = TaskStats::BucketFor(us);
+        BOOST_CHECK(bucket >= 0 && bucket < TaskStats::NUM_BUCKETS);
+        if (bucket < TaskStats::NUM_BUCKETS - 1) {
+            BOOST_CHECK(us <= TaskStats::BucketUpperBound(bucket));
+        }
+        if (bucket > 0) {
+            BOOST_CHECK(us > TaskStats::BucketUpperBound(bucket - 1));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(task_stats_snapshot)
+{
+    TaskStats stats;
+    TaskStats::Snapshot snap;
+
+    stats.GetSnapshot(&snap);
+    BOOST_CHECK(snap.count == 0);
+    BOOST_CHECK(snap.p99Us == 0);
+
+    stats.SetOverrunThreshold(1000);
+    for (uint32_t i = 1; i <= 100; i++) {
+        stats.Record(i * 10);
+    }
+    stats.Record(5000);
+
+    stats.GetSnapshot(&snap);
+    BOOST_CHECK(snap.count == 101);
+    BOOST_CHECK(snap.minUs == 10);
+    BOOST_CHECK(snap.maxUs == 5000);
+    BOOST_CHECK(snap.lastUs == 5000);
+    BOOST_CHECK(snap.overruns == 1);
+    BOOST_CHECK(snap.p50Us >= 500 && snap.p50Us <= 500 * 1.25);
+    BOOST_CHECK(snap.p99Us >= 990 && snap.p99Us <= 1000 * 1.25);
+
+    stats.Reset();
+    stats.GetSnapshot(&snap);
+    BOOST_CHECK(snap.count == 0);
+    BOOST_CHECK(snap.overruns == 0);
+    BOOST_CHECK(stats.GetOverrunThreshold() == 1000);
+}
+
+namespace {
+
+class CountingTask : public CoopTask {
+public:
+    CountingTask() : numPeriodic(0) {}
+    void TaskPeriodic(RobotMode mode) override {
+        numPeriodic++;
+    }
+    int numPeriodic;
+};
+
+/**
+ * What the spreadsheet would read from the column called |name|
+ */
+std::string ReadColumn(LogSpreadsheet &logger, const char *name) {
+    for (int i = 0; i < logger.GetNumCells(); i++) {
+        LogCell *cell = logger.GetCell(i);
+        if (std::string(cell->GetName()) == name) {
+            cell->UpdateContent();
+            return cell->GetContent();
+        }
+    }
+    return "missing";
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(task_mgr_records_stats)
+{
+    TestTaskMgr mgr;
+    CountingTask a, b;
+
+    BOOST_CHECK(mgr.RegisterTask("a", &a, TASK_PERIODIC));
+    BOOST_CHECK(mgr.RegisterTask("b", &b, TASK_PERIODIC));
+
+    for (int i = 0; i < 5; i++) {
+        mgr.RunCycle();
+    }
+
+    BOOST_CHECK(a.numPeriodic == 5);
+    BOOST_CHECK(mgr.GetTaskStats(&a, PHASE_PERIODIC)->GetCount() == 5);
+    BOOST_CHECK(mgr.GetTaskStats(&a, PHASE_PRE_PERIODIC)->GetCount() == 0);
+    BOOST_CHECK(mgr.GetCycleStats().GetCount() == 5);
+
+    /* stats follow the task when the registry shifts, and a reader
+     * holding the stats of an unregistered task can still read them */
+    const TaskStats *held = mgr.GetTaskStats(&a, PHASE_PERIODIC);
+    b.numPeriodic = 0;
+    mgr.UnregisterTask(&a);
+    mgr.RunCycle();
+    BOOST_CHECK(mgr.GetNumTasks() == 1);
+    BOOST_CHECK(mgr.GetTaskStats(&a, PHASE_PERIODIC) == nullptr);
+    BOOST_CHECK(held->GetCount() == 5);
+    BOOST_CHECK(mgr.GetTaskStats(&b, PHASE_PERIODIC)->GetCount() == 6);
+}
+
+BOOST_AUTO_TEST_CASE(task_stats_logger_logs_windows)
+{
+    TestTaskMgr mgr;
+    LogSpreadsheet logger(&mgr);
+    CountingTask a;
+
+    BOOST_CHECK(mgr.RegisterTask("a", &a, TASK_PERIODIC));
+    mgr.RunCycle(100);
+
+    TaskStatsLogger statsLogger(&mgr, &logger);
+
+    /* only what happened since the last row counts */
+    mgr.RunCycle(10);
+    mgr.RunCycle(30);
+    BOOST_CHECK_EQUAL(ReadColumn(logger, "Cycle avg us"), "20");
+    BOOST_CHECK(ReadColumn(logger, "a Periodic avg us") != "");
+    BOOST_CHECK_EQUAL(ReadColumn(logger, "Task skips in row"), "0");
+    BOOST_CHECK_EQUAL(ReadColumn(logger, "Task degradation"), "0");
+
+    /* nothing ran, so nothing to average */
+    BOOST_CHECK_EQUAL(ReadColumn(logger, "Cycle avg us"), "");
+    BOOST_CHECK_EQUAL(ReadColumn(logger, "a Periodic avg us"), "");
+}
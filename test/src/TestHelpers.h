@@ -0,0 +1,123 @@
+/*
+ * TestHelpers.h
+ *
+ * Bits of scaffolding shared by more than one test: TaskMgrs the test
+ * drives by hand and a scratch directory that cleans up after itself.
+ */
+
+#pragma once
+
+#include <boost/test/unit_test.hpp>
+
+#include "lib/TaskMgr.h"
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace frc973 {
+
+/**
+ * TaskMgr whose cycles are run by the test, on the test's thread
+ */
+class TestTaskMgr : public TaskMgr {
+public:
+    /**
+     * Run every task's periodic callbacks once, disabled, and record a
+     * cycle taking |cycleUs|
+     */
+    void RunCycle(uint32_t cycleUs = 10) {
+        TaskPrePeriodicAll(MODE_DISABLED);
+        TaskPeriodicAll(MODE_DISABLED);
+        TaskPostPeriodicAll(MODE_DISABLED);
+        EndCycle(cycleUs);
+    }
+
+    /**
+     * Record a cycle taking |cycleUs| without running anything
+     */
+    void FinishCycle(uint32_t cycleUs) {
+        EndCycle(cycleUs);
+    }
+
+    void SetPeriodUs(uint32_t periodUs) {
+        SetCycleOverrunThreshold(periodUs);
+    }
+};
+
+/**
+ * TaskMgr whose cycles are run by the test, in teleop and taking no time
+ */
+class SteppedTaskMgr : public TaskMgr {
+public:
+    void RunCycle() {
+        TaskPrePeriodicAll(MODE_TELEOP);
+        TaskPeriodicAll(MODE_TELEOP);
+        TaskPostPeriodicAll(MODE_TELEOP);
+        EndCycle(0);
+    }
+};
+
+/**
+ * Directory made under /tmp for one test and removed, with everything in
+ * it, when the test is done
+ */
+class TempDir {
+public:
+    explicit TempDir(const char *prefix) {
+        snprintf(m_path, sizeof(m_path), "/tmp/%sXXXXXX", prefix);
+        BOOST_REQUIRE(mkdtemp(m_path) != nullptr);
+    }
+
+    ~TempDir() {
+        for (const std::string &name : List(true)) {
+            if (unlink(name.c_str()) != 0) {
+                rmdir(name.c_str());
+            }
+        }
+        rmdir(m_path);
+    }
+
+    const char *GetPath() const {
+        return m_path;
+    }
+
+    /**
+     * Paths of the files in the directory, sorted, leaving out log
+     * indexes unless |indexes| is set
+     */
+    std::vector<std::string> List(bool indexes = false) const {
+        std::vector<std::string> names;
+        DIR *d = opendir(m_path);
+        struct dirent *entry;
+
+        if (d == NULL) {
+            return names;
+        }
+        while ((entry = readdir(d)) != NULL) {
+            const char *ext = strrchr(entry->d_name, '.');
+
+            if (entry->d_name[0] != '.' &&
+                    (indexes || ext == NULL || strcmp(ext, ".idx") != 0)) {
+                names.push_back(std::string(m_path) + "/" + entry->d_name);
+            }
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+private:
+    TempDir(const TempDir&) = delete;
+    TempDir &operator=(const TempDir&) = delete;
+
+    char m_path[64];
+};
+
+}
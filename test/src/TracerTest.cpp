@@ -0,0 +1,154 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lib/Tracer.h"
+#include "lib/CoopTask.h"
+#include "TestHelpers.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace frc973;
+
+namespace {
+
+std::string WriteTrace() {
+    char name[] = "/tmp/traceXXXXXX";
+    int fd = mkstemp(name);
+    std::stringstream contents;
+
+    close(fd);
+    BOOST_REQUIRE(Tracer::WriteChromeTrace(name));
+    std::ifstream in(name);
+    contents << in.rdbuf();
+    unlink(name);
+    return contents.str();
+}
+
+int Count(const std::string &haystack, const std::string &needle) {
+    int count = 0;
+
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+            pos = haystack.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+class NopTask : public CoopTask {
+public:
+    void TaskPeriodic(RobotMode mode) override {}
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(tracer_puts_every_thread_on_one_timeline)
+{
+    Tracer::Clear();
+    Tracer::Enable();
+    Tracer::SetThreadName("test main");
+
+    {
+        TraceSpan outer("outer", "test");
+        std::thread other([]() {
+            Tracer::SetThreadName("other");
+            TraceSpan span("inner", "test");
+        });
+
+        other.join();
+        Tracer::Instant("mark", "test");
+    }
+    Tracer::Disable();
+    Tracer::Begin("ignored", "test");
+
+    std::string trace = WriteTrace();
+    BOOST_CHECK(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")
+            == 0);
+    BOOST_CHECK(trace.find("\"args\":{\"name\":\"test main\"}") !=
+            std::string::npos);
+    BOOST_CHECK(trace.find("\"args\":{\"name\":\"other\"}") !=
+            std::string::npos);
+    BOOST_CHECK(Count(trace, "\"name\":\"outer\"") == 2);
+    BOOST_CHECK(Count(trace, "\"name\":\"inner\"") == 2);
+    BOOST_CHECK(Count(trace, "\"name\":\"mark\",\"cat\":\"test\","
+                "\"ph\":\"i\"") == 1);
+    BOOST_CHECK(Count(trace, "\"ph\":\"B\"") == Count(trace, "\"ph\":\"E\""));
+    BOOST_CHECK(trace.find("ignored") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_keeps_newest_events_when_ring_fills)
+{
+    Tracer::Clear();
+    Tracer::Enable(8);
+
+    /* a new thread, so it gets a ring of the new size */
+    std::thread recorder([]() {
+        for (int i = 0; i < 12; i++) {
+            Tracer::Instant("old", "test");
+        }
+        for (int i = 0; i < 8; i++) {
+            Tracer::Instant("new", "test");
+        }
+    });
+    recorder.join();
+    Tracer::Disable();
+
+    std::string trace = WriteTrace();
+    BOOST_CHECK(Count(trace, "\"name\":\"old\"") == 0);
+    BOOST_CHECK(Count(trace, "\"name\":\"new\"") == 8);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_writes_in_the_background)
+{
+    char name[] = "/tmp/traceXXXXXX";
+    int fd = mkstemp(name);
+    std::stringstream contents;
+
+    close(fd);
+    Tracer::Clear();
+    Tracer::Enable();
+    Tracer::Instant("background", "test");
+    Tracer::Disable();
+
+    BOOST_REQUIRE(Tracer::WriteChromeTraceAsync(name));
+    for (int i = 0; i < 1000 && Tracer::IsWriting(); i++) {
+        usleep(1000);
+    }
+    BOOST_REQUIRE(!Tracer::IsWriting());
+
+    std::ifstream in(name);
+    contents << in.rdbuf();
+    unlink(name);
+    BOOST_CHECK(Count(contents.str(), "\"name\":\"background\"") == 1);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_records_task_phases_and_calls)
+{
+    SteppedTaskMgr mgr;
+    NopTask task;
+    char name[32];
+
+    /* the manager keeps its own copy of the name */
+    snprintf(name, sizeof(name), "nop task");
+    mgr.RegisterTask(name, &task, TASK_PERIODIC);
+    name[0] = '\0';
+
+    Tracer::Clear();
+    Tracer::Enable();
+    mgr.RunCycle();
+    mgr.RunCycle();
+    Tracer::Disable();
+
+    std::string trace = WriteTrace();
+    BOOST_CHECK(Count(trace, "\"name\":\"PrePeriodic\",\"cat\":\"phase\"") ==
+            4);
+    BOOST_CHECK(Count(trace, "\"name\":\"PostPeriodic\",\"cat\":\"phase\"") ==
+            4);
+    BOOST_CHECK(Count(trace, "\"name\":\"nop task\",\"cat\":\"Periodic\"") ==
+            4);
+    BOOST_CHECK(Tracer::InternName("nop task") ==
+            Tracer::InternName(std::string("nop task").c_str()));
+}
@@ -1,3 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
 #define START_ROBOT_CLASS(_ClassName_) // do nothing
 
 namespace frc {
@@ -8,6 +13,33 @@ inline uint64_t GetFPGATime() {
 }
 
 class RobotStateInterface {
+public:
+    virtual ~RobotStateInterface() {}
+    virtual bool IsDisabled() const = 0;
+    virtual bool IsEnabled() const = 0;
+    virtual bool IsOperatorControl() const = 0;
+    virtual bool IsAutonomous() const = 0;
+    virtual bool IsTest() const = 0;
+};
+
+/* a driver station that never connects: disabled, on a full battery */
+class DriverStation : public RobotStateInterface {
+public:
+    enum Alliance { kRed, kBlue, kInvalid };
+
+    static DriverStation &GetInstance() {
+        static DriverStation instance;
+        return instance;
+    }
+
+    bool IsDisabled() const override { return true; }
+    bool IsEnabled() const override { return false; }
+    bool IsOperatorControl() const override { return false; }
+    bool IsAutonomous() const override { return false; }
+    bool IsTest() const override { return false; }
+
+    double GetBatteryVoltage() const { return 12.5; }
+    Alliance GetAlliance() const { return kInvalid; }
 };
 
 class IterativeRobot
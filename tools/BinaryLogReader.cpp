@@ -0,0 +1,429 @@
+/*
+ * BinaryLogReader.cpp
+ */
+
+#include "BinaryLogReader.h"
+#include "lib/logging/LogCompression.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace frc973 {
+
+BinaryLogReader::BinaryLogReader()
+	 : m_map(nullptr)
+	 , m_mapSize(0)
+	 , m_data(nullptr)
+	 , m_size(0)
+	 , m_decoded()
+	 , m_skippedBlocks(0)
+	 , m_header()
+	 , m_columns()
+	 , m_numRows(0)
+{
+}
+
+BinaryLogReader::~BinaryLogReader() {
+	Close();
+}
+
+bool BinaryLogReader::Open(const char *path, uint64_t begin, uint64_t end) {
+	struct stat st;
+	int fd;
+
+	Close();
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return false;
+	}
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(BinaryLogHeader)) {
+		fprintf(stderr, "%s: too short to be a binary log\n", path);
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "%s: mmap failed: %s\n", path, strerror(errno));
+		return false;
+	}
+	m_map = (const uint8_t*) data;
+	m_mapSize = st.st_size;
+	m_data = m_map;
+	m_size = m_mapSize;
+
+	memcpy(&m_header, m_data, sizeof(m_header));
+	if (m_header.magic != BINARY_LOG_MAGIC &&
+			m_header.magic != BINARY_LOG_COMPRESSED_MAGIC) {
+		fprintf(stderr, "%s: not a binary log\n", path);
+		Close();
+		return false;
+	}
+	if (m_header.version < 1 || m_header.version > BINARY_LOG_VERSION) {
+		fprintf(stderr, "%s: log version %d, expected up to %d\n", path,
+				m_header.version, BINARY_LOG_VERSION);
+		Close();
+		return false;
+	}
+	if (m_header.headerSize > m_size || m_header.recordSize == 0) {
+		fprintf(stderr, "%s: schema is truncated\n", path);
+		Close();
+		return false;
+	}
+
+	size_t pos = sizeof(BinaryLogHeader);
+	uint32_t offset = sizeof(BinaryLogRecordHeader) +
+		(m_header.numColumns + 7) / 8;
+	for (int i = 0; i < m_header.numColumns; i++) {
+		BinaryLogColumn raw;
+		Column column;
+
+		if (pos + sizeof(raw) > m_header.headerSize) {
+			fprintf(stderr, "%s: schema is truncated\n", path);
+			Close();
+			return false;
+		}
+		memcpy(&raw, m_data + pos, sizeof(raw));
+		pos += sizeof(raw);
+		if (pos + raw.nameLen > m_header.headerSize) {
+			fprintf(stderr, "%s: schema is truncated\n", path);
+			Close();
+			return false;
+		}
+
+		column.name.assign((const char*) m_data + pos, raw.nameLen);
+		column.type = (LogCellType) raw.type;
+		column.flags = raw.flags;
+		column.slotSize = raw.slotSize;
+		column.sampling = (LogSampling) raw.sampling;
+		column.decimals = raw.decimals;
+		column.offset = offset;
+		pos += raw.nameLen;
+		offset += raw.slotSize;
+		m_columns.push_back(column);
+	}
+	if (offset != m_header.recordSize) {
+		fprintf(stderr, "%s: columns add up to %u bytes but rows are %u\n",
+				path, offset, m_header.recordSize);
+		Close();
+		return false;
+	}
+
+	if (begin < m_header.headerSize) {
+		begin = m_header.headerSize;
+	}
+	if (end > m_mapSize) {
+		end = m_mapSize;
+	}
+	if (end < begin) {
+		end = begin;
+	}
+	if (m_header.magic == BINARY_LOG_COMPRESSED_MAGIC) {
+		DecodeBlocks(path, begin, end);
+	}
+	else if (m_header.version >= 2) {
+		ExpandRows(path, begin, end);
+	}
+	else if (begin != m_header.headerSize || end != m_mapSize) {
+		/* every row is the same size, so just copy the whole ones */
+		uint64_t first = (begin - m_header.headerSize) / m_header.recordSize;
+		uint64_t last = (end - m_header.headerSize) / m_header.recordSize;
+
+		m_decoded.assign(m_map, m_map + m_header.headerSize);
+		if (last > first) {
+			m_decoded.insert(m_decoded.end(),
+					m_map + m_header.headerSize + first * m_header.recordSize,
+					m_map + m_header.headerSize + last * m_header.recordSize);
+		}
+		m_data = m_decoded.data();
+		m_size = m_decoded.size();
+	}
+
+	m_numRows = (m_size - m_header.headerSize) / m_header.recordSize;
+	return true;
+}
+
+void BinaryLogReader::DecodeBlocks(const char *path, size_t begin,
+		size_t end) {
+	std::vector<uint8_t> encoded;
+	BinaryLogHeader header = m_header;
+	size_t pos = begin;
+	bool truncated = false;
+
+	m_decoded.assign(m_map, m_map + m_header.headerSize);
+	header.magic = BINARY_LOG_MAGIC;
+	memcpy(&m_decoded[0], &header, sizeof(header));
+
+	while (pos < end && pos + sizeof(BinaryLogBlockHeader) <= m_mapSize) {
+		BinaryLogBlockHeader block;
+		const uint8_t *payload = m_map + pos + sizeof(block);
+		size_t start = m_decoded.size();
+
+		memcpy(&block, m_map + pos, sizeof(block));
+		if (block.sync != BINARY_LOG_BLOCK_SYNC ||
+				block.rawSize != (uint64_t) block.numRows * m_header.recordSize) {
+			/* not a block header, look for the next one */
+			pos++;
+			continue;
+		}
+		if (block.compressedSize > m_mapSize - pos - sizeof(block)) {
+			/* cut short, unless it's a damaged header and more follows */
+			truncated = true;
+			pos++;
+			continue;
+		}
+		if (LogBlockChecksum(payload, block.compressedSize) != block.checksum) {
+			m_skippedBlocks++;
+			pos++;
+			continue;
+		}
+
+		encoded.resize(block.rawSize);
+		if (LzDecompress(payload, block.compressedSize, encoded.data(),
+					encoded.size()) != (long) block.rawSize) {
+			m_skippedBlocks++;
+			pos++;
+			continue;
+		}
+		m_decoded.resize(start + block.rawSize);
+		LogRowsDecode(encoded.data(), block.numRows, m_header.recordSize,
+				&m_decoded[start]);
+		pos += sizeof(block) + block.compressedSize;
+		truncated = false;
+	}
+
+	if (truncated) {
+		fprintf(stderr, "%s: ignoring the last block, it was cut short\n",
+				path);
+	}
+	if (m_skippedBlocks != 0) {
+		fprintf(stderr, "%s: skipped %llu damaged blocks\n", path,
+				(unsigned long long) m_skippedBlocks);
+	}
+
+	m_data = m_decoded.data();
+	m_size = m_decoded.size();
+}
+
+void BinaryLogReader::ExpandRows(const char *path, size_t begin,
+		size_t end) {
+	uint32_t bitmapSize = (m_columns.size() + 7) / 8;
+	uint32_t minSize = sizeof(BinaryLogRecordHeader) + bitmapSize;
+	size_t pos = begin;
+	uint64_t skipped = 0;
+	bool truncated = false;
+
+	m_decoded.assign(m_map, m_map + m_header.headerSize);
+
+	while (pos < end && pos + sizeof(BinaryLogRecordHeader) <= m_mapSize) {
+		BinaryLogRecordHeader header;
+		const uint8_t *src = m_map + pos;
+		const uint8_t *presence = src + sizeof(header);
+		size_t start = m_decoded.size();
+		uint32_t used = minSize;
+
+		memcpy(&header, src, sizeof(header));
+		if (header.sync != BINARY_LOG_ROW_SYNC || header.size < minSize ||
+				header.size > m_header.recordSize) {
+			/* not a row, look for the next one */
+			skipped++;
+			pos++;
+			continue;
+		}
+		if (header.size > m_mapSize - pos) {
+			/* cut short, unless it's a damaged header and more follows */
+			truncated = true;
+			pos++;
+			continue;
+		}
+
+		m_decoded.resize(start + m_header.recordSize, 0);
+		if (header.size == m_header.recordSize) {
+			/* every slot is in place */
+			memcpy(&m_decoded[start], src, header.size);
+			pos += header.size;
+			truncated = false;
+			continue;
+		}
+
+		memcpy(&m_decoded[start], src, minSize);
+		for (unsigned int i = 0; i < m_columns.size(); i++) {
+			const Column &column = m_columns[i];
+
+			if (((presence[i / 8] >> (i % 8)) & 1) == 0) {
+				continue;
+			}
+			if (used + column.slotSize > header.size) {
+				break;
+			}
+			memcpy(&m_decoded[start + column.offset], src + used,
+					column.slotSize);
+			used += column.slotSize;
+		}
+		if (used != header.size) {
+			/* the presence bits don't match the size, so it's damaged */
+			m_decoded.resize(start);
+			skipped++;
+			pos++;
+			continue;
+		}
+
+		header.size = m_header.recordSize;
+		memcpy(&m_decoded[start], &header, sizeof(header));
+		pos += used;
+		truncated = false;
+	}
+
+	if (truncated) {
+		fprintf(stderr, "%s: ignoring the last row, it was cut short\n", path);
+	}
+	if (skipped != 0) {
+		fprintf(stderr, "%s: skipped %llu damaged bytes\n", path,
+				(unsigned long long) skipped);
+	}
+
+	m_data = m_decoded.data();
+	m_size = m_decoded.size();
+}
+
+bool BinaryLogReader::WriteUncompressed(const char *path) const {
+	BinaryLogHeader header = m_header;
+	size_t rowsSize = m_numRows * m_header.recordSize;
+	FILE *out = fopen(path, "wb");
+	bool ok;
+
+	if (out == NULL) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	header.magic = BINARY_LOG_MAGIC;
+	ok = fwrite(&header, sizeof(header), 1, out) == 1;
+	ok = ok && fwrite(m_data + sizeof(header), 1,
+			m_header.headerSize - sizeof(header), out) ==
+		m_header.headerSize - sizeof(header);
+	ok = ok && fwrite(m_data + m_header.headerSize, 1, rowsSize, out) ==
+		rowsSize;
+	if (fclose(out) != 0 || !ok) {
+		fprintf(stderr, "%s: write failed\n", path);
+		return false;
+	}
+	return true;
+}
+
+void BinaryLogReader::Close() {
+	if (m_map != nullptr) {
+		munmap((void*) m_map, m_mapSize);
+	}
+	m_map = nullptr;
+	m_mapSize = 0;
+	m_data = nullptr;
+	m_size = 0;
+	m_decoded.clear();
+	m_skippedBlocks = 0;
+	m_columns.clear();
+	m_numRows = 0;
+}
+
+int BinaryLogReader::FindColumn(const char *name) const {
+	for (unsigned int i = 0; i < m_columns.size(); i++) {
+		if (m_columns[i].name == name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+const BinaryLogRecordHeader *BinaryLogReader::GetRow(uint64_t row) const {
+	if (row >= m_numRows) {
+		return nullptr;
+	}
+	return (const BinaryLogRecordHeader*)
+		(m_data + m_header.headerSize + row * m_header.recordSize);
+}
+
+bool BinaryLogReader::IsRowValid(uint64_t row) const {
+	const BinaryLogRecordHeader *header = GetRow(row);
+	return header != nullptr && header->sync == BINARY_LOG_ROW_SYNC;
+}
+
+bool BinaryLogReader::IsPresent(uint64_t row, int column) const {
+	const uint8_t *presence =
+		(const uint8_t*) GetRow(row) + sizeof(BinaryLogRecordHeader);
+	return (presence[column / 8] >> (column % 8)) & 1;
+}
+
+const uint8_t *BinaryLogReader::GetSlot(uint64_t row, int column) const {
+	return (const uint8_t*) GetRow(row) + m_columns[column].offset;
+}
+
+double BinaryLogReader::GetDouble(uint64_t row, int column) const {
+	double val;
+
+	if (m_columns[column].type == LOG_CELL_INT) {
+		return GetInt(row, column);
+	}
+	memcpy(&val, GetSlot(row, column), sizeof(val));
+	return val;
+}
+
+int32_t BinaryLogReader::GetInt(uint64_t row, int column) const {
+	int32_t val;
+
+	if (m_columns[column].type == LOG_CELL_DOUBLE) {
+		return (int32_t) GetDouble(row, column);
+	}
+	memcpy(&val, GetSlot(row, column), sizeof(val));
+	return val;
+}
+
+int BinaryLogReader::FormatCell(uint64_t row, int column, char *buf,
+		size_t size) const {
+	if (m_columns[column].sampling == LOG_SAMPLE_ON_CHANGE) {
+		/* carry the last value forward.  The writer repeats on-change
+		 * columns every so often, so this never looks back far */
+		while (row > 0 && !IsPresent(row, column)) {
+			row--;
+		}
+	}
+	if (!IsPresent(row, column)) {
+		buf[0] = '\0';
+		return 0;
+	}
+
+	return FormatBinaryLogSlot(m_columns[column].type, GetSlot(row, column),
+			m_columns[column].slotSize, m_columns[column].decimals, buf, size);
+}
+
+uint64_t BinaryLogReader::WriteCsv(FILE *out) const {
+	uint64_t skipped = 0;
+	char cell[256];
+
+	for (int col = 0; col < GetNumColumns(); col++) {
+		fprintf(out, "\"%s\",", GetColumnName(col));
+	}
+	fputc('\n', out);
+
+	for (uint64_t row = 0; row < GetNumRows(); row++) {
+		if (!IsRowValid(row)) {
+			skipped++;
+			continue;
+		}
+		for (int col = 0; col < GetNumColumns(); col++) {
+			FormatCell(row, col, cell, sizeof(cell));
+			fprintf(out, "\"%s\",", cell);
+		}
+		fputc('\n', out);
+	}
+	return skipped;
+}
+
+}
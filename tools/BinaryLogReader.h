@@ -0,0 +1,187 @@
+/*
+ * BinaryLogReader.h
+ *
+ * BinaryLogReader - host side reader for the binary logs LogSpreadsheet
+ * writes in LOG_FORMAT_BINARY mode (see lib/logging/BinaryLogFormat.h).
+ *
+ * The whole file is mapped into memory, so opening is cheap no matter how
+ * big the log is and any row can be looked at directly by index.  A row
+ * cut short by the robot losing power is ignored.
+ *
+ * Rows are presented with every slot in place.  Version 2 files, which
+ * leave out the slots of columns that weren't sampled, and compressed
+ * logs (LOG_FORMAT_COMPRESSED) are expanded into memory when opened and
+ * then read the same way.  A row or block cut short at the end is
+ * ignored and a damaged one is skipped.
+ *
+ * Part of a log can be read on its own by giving Open the byte range to
+ * read, usually from the log's index (see LogIndex.h); only that part is
+ * expanded.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+#include "lib/logging/BinaryLogFormat.h"
+
+namespace frc973 {
+
+class BinaryLogReader {
+public:
+	BinaryLogReader();
+	virtual ~BinaryLogReader();
+
+	/**
+	 * Map |path| and read its schema.  Complains on stderr and returns
+	 * false if it isn't a binary log this reader understands.
+	 *
+	 * @param begin offset of the first row (or block) to read
+	 * @param end only read rows (or blocks) starting before this offset
+	 */
+	bool Open(const char *path, uint64_t begin = 0,
+			uint64_t end = UINT64_MAX);
+
+	/**
+	 * Unmap the file
+	 */
+	void Close();
+
+	bool IsCompressed() const {
+		return m_map != m_data;
+	}
+
+	/**
+	 * Number of damaged blocks skipped in a compressed log
+	 */
+	uint64_t GetSkippedBlocks() const {
+		return m_skippedBlocks;
+	}
+
+	/**
+	 * Write the log out as a plain (uncompressed) binary log
+	 *
+	 * @return false if |path| couldn't be written
+	 */
+	bool WriteUncompressed(const char *path) const;
+
+	int GetNumColumns() const {
+		return m_columns.size();
+	}
+
+	const char *GetColumnName(int column) const {
+		return m_columns[column].name.c_str();
+	}
+
+	LogCellType GetColumnType(int column) const {
+		return m_columns[column].type;
+	}
+
+	/**
+	 * When the column was written.  An on-change column's value carries
+	 * on through the rows it's missing from.
+	 */
+	LogSampling GetColumnSampling(int column) const {
+		return m_columns[column].sampling;
+	}
+
+	/**
+	 * Find a column by the name it was registered under
+	 *
+	 * @return the column index, or -1 if there's no such column
+	 */
+	int FindColumn(const char *name) const;
+
+	/**
+	 * Number of complete rows in the file
+	 */
+	uint64_t GetNumRows() const {
+		return m_numRows;
+	}
+
+	uint64_t GetStartTimeUs() const {
+		return m_header.startTimeUs;
+	}
+
+	/**
+	 * @return the header of |row|, or nullptr if |row| is out of range
+	 */
+	const BinaryLogRecordHeader *GetRow(uint64_t row) const;
+
+	/**
+	 * @return false if |row| doesn't start with the row sync word (it was
+	 * torn or the file is corrupt)
+	 */
+	bool IsRowValid(uint64_t row) const;
+
+	/**
+	 * @return false if |column| was empty in |row|
+	 */
+	bool IsPresent(uint64_t row, int column) const;
+
+	double GetDouble(uint64_t row, int column) const;
+	int32_t GetInt(uint64_t row, int column) const;
+
+	/**
+	 * Format a cell the way the CSV writer would have ("%lf" for doubles,
+	 * "%d" for ints, the text itself for text, nothing for an empty cell,
+	 * and the last value written for an on-change column)
+	 *
+	 * @return length of the formatted text
+	 */
+	int FormatCell(uint64_t row, int column, char *buf, size_t size) const;
+
+	/**
+	 * Write the whole log to |out| as the quoted CSV LogSpreadsheet writes
+	 * in LOG_FORMAT_CSV mode, leaving out rows that aren't valid
+	 *
+	 * @return number of rows left out
+	 */
+	uint64_t WriteCsv(FILE *out) const;
+
+private:
+	struct Column {
+		std::string name;
+		LogCellType type;
+		uint32_t flags;
+		uint32_t slotSize;
+		uint32_t offset;
+		LogSampling sampling;
+		uint8_t decimals;
+	};
+
+	const uint8_t *GetSlot(uint64_t row, int column) const;
+
+	/**
+	 * Decompress every intact block of the mapped file starting in
+	 * [begin, end) into m_decoded
+	 */
+	void DecodeBlocks(const char *path, size_t begin, size_t end);
+
+	/**
+	 * Expand the sparse rows of a version 2 file starting in [begin, end)
+	 * into m_decoded
+	 */
+	void ExpandRows(const char *path, size_t begin, size_t end);
+
+	BinaryLogReader(const BinaryLogReader&) = delete;
+	BinaryLogReader &operator=(const BinaryLogReader&) = delete;
+
+	/* the file as mapped, and the log as read (the same unless the file
+	 * is compressed, when it's m_decoded) */
+	const uint8_t *m_map;
+	size_t m_mapSize;
+	const uint8_t *m_data;
+	size_t m_size;
+	std::vector<uint8_t> m_decoded;
+	uint64_t m_skippedBlocks;
+	BinaryLogHeader m_header;
+	std::vector<Column> m_columns;
+	uint64_t m_numRows;
+};
+
+}
@@ -0,0 +1,40 @@
+/*
+ * LogDecompress.cpp
+ *
+ * logdecompress - turn a compressed robot log (LOG_FORMAT_COMPRESSED) into
+ * a plain binary log that any reader of the binary format can use.
+ *
+ *     logdecompress log-123456.binz log-123456.bin
+ *
+ * A block cut short when the robot lost power, or damaged on disk, is
+ * left out; everything else is recovered.  logtocsv reads compressed logs
+ * directly, so this is only needed for other tools.
+ */
+
+#include <stdio.h>
+
+#include "BinaryLogReader.h"
+
+using namespace frc973;
+
+int main(int argc, char **argv) {
+	BinaryLogReader reader;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s log.binz out.bin\n", argv[0]);
+		return 2;
+	}
+	if (!reader.Open(argv[1])) {
+		return 1;
+	}
+	if (!reader.IsCompressed()) {
+		fprintf(stderr, "%s: not compressed, copying as is\n", argv[1]);
+	}
+	if (!reader.WriteUncompressed(argv[2])) {
+		return 1;
+	}
+
+	fprintf(stderr, "%s: %llu rows\n", argv[2],
+			(unsigned long long) reader.GetNumRows());
+	return 0;
+}
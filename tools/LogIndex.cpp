@@ -0,0 +1,86 @@
+/*
+ * LogIndex.cpp
+ */
+
+#include "LogIndex.h"
+
+#include <stdio.h>
+#include <string>
+
+namespace frc973 {
+
+LogIndex::LogIndex()
+	 : m_header()
+	 , m_entries()
+{
+}
+
+LogIndex::~LogIndex() {
+}
+
+bool LogIndex::Open(const char *logPath) {
+	std::string path = std::string(logPath) + ".idx";
+	FILE *in;
+	LogIndexEntry entry;
+
+	Close();
+
+	in = fopen(path.c_str(), "rb");
+	if (in == NULL) {
+		return false;
+	}
+	if (fread(&m_header, sizeof(m_header), 1, in) != 1 ||
+			m_header.magic != LOG_INDEX_MAGIC ||
+			m_header.version != LOG_INDEX_VERSION) {
+		fprintf(stderr, "%s: not a log index\n", path.c_str());
+		fclose(in);
+		return false;
+	}
+
+	/* a torn entry at the end just doesn't get read */
+	while (fread(&entry, sizeof(entry), 1, in) == 1) {
+		m_entries.push_back(entry);
+	}
+	fclose(in);
+	return true;
+}
+
+void LogIndex::Close() {
+	m_entries.clear();
+}
+
+std::vector<LogIndex::Range> LogIndex::FindRanges(int mode, uint64_t fromUs,
+		uint64_t toUs) const {
+	std::vector<Range> ranges;
+
+	for (size_t i = 0; i < m_entries.size(); i++) {
+		const LogIndexEntry &entry = m_entries[i];
+		const LogIndexEntry *next =
+			i + 1 < m_entries.size() ? &m_entries[i + 1] : nullptr;
+		uint64_t startUs = entry.timeUs - entry.modeStartUs;
+		uint64_t endUs = next != nullptr ?
+			next->timeUs - entry.modeStartUs : UINT64_MAX;
+		Range range;
+
+		/* the rows from this entry up to the next were taken between
+		 * startUs and endUs into the mode */
+		if ((mode >= 0 && entry.mode != mode) || startUs > toUs ||
+				endUs <= fromUs) {
+			continue;
+		}
+
+		range.begin = entry.offset;
+		range.end = next != nullptr ? next->offset : UINT64_MAX;
+		range.modeStartUs = entry.modeStartUs;
+		if (!ranges.empty() && ranges.back().end == range.begin &&
+				ranges.back().modeStartUs == range.modeStartUs) {
+			ranges.back().end = range.end;
+		}
+		else {
+			ranges.push_back(range);
+		}
+	}
+	return ranges;
+}
+
+}
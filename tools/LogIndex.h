@@ -0,0 +1,69 @@
+/*
+ * LogIndex.h
+ *
+ * LogIndex - host side reader for the index the log writer keeps next to
+ * each binary log (<log file>.idx, see lib/logging/BinaryLogFormat.h).
+ *
+ * Turns "rows taken between 3s and 5s into auto" into the byte ranges of
+ * the log holding them, which BinaryLogReader can then read on their own
+ * without touching the rest of the file.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "lib/logging/BinaryLogFormat.h"
+
+namespace frc973 {
+
+class LogIndex {
+public:
+	/**
+	 * Part of a log, all taken in one stretch of one mode
+	 */
+	struct Range {
+		uint64_t begin;			/* offset of the first row or block */
+		uint64_t end;			/* offset just past the last (or UINT64_MAX) */
+		uint64_t modeStartUs;	/* timeUs of the row the mode began on */
+	};
+
+	LogIndex();
+	virtual ~LogIndex();
+
+	/**
+	 * Read the index of the log at |logPath|
+	 *
+	 * @return false (quietly) if the log has no index, or (complaining on
+	 *     stderr) if it isn't one this reader understands
+	 */
+	bool Open(const char *logPath);
+
+	void Close();
+
+	size_t GetNumEntries() const {
+		return m_entries.size();
+	}
+
+	const LogIndexEntry &GetEntry(size_t entry) const {
+		return m_entries[entry];
+	}
+
+	/**
+	 * Find the parts of the log that might hold rows taken in |mode| between
+	 * |fromUs| and |toUs| (inclusive) after that mode began.  The ranges are
+	 * a superset; the caller still checks each row's time.
+	 *
+	 * @param mode a RobotMode, or -1 for any mode
+	 */
+	std::vector<Range> FindRanges(int mode, uint64_t fromUs,
+			uint64_t toUs) const;
+
+private:
+	LogIndexHeader m_header;
+	std::vector<LogIndexEntry> m_entries;
+};
+
+}
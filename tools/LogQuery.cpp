@@ -0,0 +1,264 @@
+/*
+ * LogQuery.cpp
+ *
+ * logquery - pull some columns over a stretch of time out of any number of
+ * binary robot logs, as CSV.
+ *
+ *     logquery -m auto -f 3 -t 5 -c "Drive current,Angle" log-*.binz
+ *
+ * prints every row taken between 3s and 5s into auto, in every log given,
+ * with the columns named (as registered with LogSpreadsheet::RegisterCell)
+ * after the file, mode and seconds into the mode.  Leave out -c for every
+ * column, -m for every mode, -f or -t for no limit.
+ *
+ * Logs with an index (<log>.idx) are only read where the index says the
+ * rows are; others are read whole.  The logs are read in parallel (-j
+ * threads, one per core by default) and printed in the order given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BinaryLogReader.h"
+#include "LogIndex.h"
+#include "lib/util/NumberFormat.h"
+
+using namespace frc973;
+
+namespace {
+
+const char *MODE_NAMES[] = {"disabled", "auto", "teleop", "test"};
+const int NUM_MODES = sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]);
+
+struct Query {
+	int mode;
+	uint64_t fromUs;
+	uint64_t toUs;
+	std::vector<std::string> columns;
+};
+
+const char *GetModeName(int mode) {
+	return mode >= 0 && mode < NUM_MODES ? MODE_NAMES[mode] : "?";
+}
+
+int ParseMode(const char *name) {
+	for (int i = 0; i < NUM_MODES; i++) {
+		if (strcmp(name, MODE_NAMES[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+std::vector<std::string> SplitColumns(const char *list) {
+	std::vector<std::string> columns;
+	const char *start = list;
+
+	for (const char *p = list; ; p++) {
+		if (*p == ',' || *p == '\0') {
+			columns.push_back(std::string(start, p - start));
+			start = p + 1;
+		}
+		if (*p == '\0') {
+			return columns;
+		}
+	}
+}
+
+/**
+ * Print the rows of |reader| (all of one log, or one range of it) that
+ * the query wants onto the end of |out|
+ *
+ * @param modeStartUs when the mode of the first row began, or UINT64_MAX
+ *     if that's for the rows to tell
+ */
+void QueryRows(const char *path, const BinaryLogReader &reader,
+		const Query &query, const std::vector<int> &columns,
+		uint64_t modeStartUs, std::string *out) {
+	char cell[256];
+	int lastMode = -1;
+
+	for (uint64_t row = 0; row < reader.GetNumRows(); row++) {
+		const BinaryLogRecordHeader *header = reader.GetRow(row);
+		uint64_t sinceUs;
+
+		if (!reader.IsRowValid(row)) {
+			continue;
+		}
+		if (header->mode != lastMode) {
+			/* an index range never crosses a mode change, so this only
+			 * happens reading a log whole */
+			if (lastMode >= 0 || modeStartUs == UINT64_MAX) {
+				modeStartUs = header->timeUs;
+			}
+			lastMode = header->mode;
+		}
+		sinceUs = header->timeUs - modeStartUs;
+		if ((query.mode >= 0 && header->mode != query.mode) ||
+				sinceUs < query.fromUs || sinceUs > query.toUs) {
+			continue;
+		}
+
+		*out += '"';
+		*out += path;
+		*out += "\",\"";
+		*out += GetModeName(header->mode);
+		*out += "\",\"";
+		FormatFixed(sinceUs / 1e6, FORMAT_DEFAULT_DECIMALS, cell, sizeof(cell));
+		*out += cell;
+		*out += "\",";
+		for (int col : columns) {
+			cell[0] = '\0';
+			if (col >= 0) {
+				reader.FormatCell(row, col, cell, sizeof(cell));
+			}
+			*out += '"';
+			*out += cell;
+			*out += "\",";
+		}
+		*out += '\n';
+	}
+}
+
+/**
+ * Run the query over one log
+ *
+ * @return false if the log couldn't be read
+ */
+bool QueryLog(const char *path, const Query &query, std::string *out) {
+	BinaryLogReader reader;
+	LogIndex index;
+	std::vector<LogIndex::Range> ranges;
+	std::vector<int> columns;
+
+	if (index.Open(path)) {
+		ranges = index.FindRanges(query.mode, query.fromUs, query.toUs);
+		if (ranges.empty()) {
+			return true;
+		}
+	}
+	else {
+		ranges.push_back({0, UINT64_MAX, UINT64_MAX});
+	}
+
+	for (const LogIndex::Range &range : ranges) {
+		if (!reader.Open(path, range.begin, range.end)) {
+			return false;
+		}
+		if (columns.empty()) {
+			if (query.columns.empty()) {
+				for (int col = 0; col < reader.GetNumColumns(); col++) {
+					columns.push_back(col);
+				}
+			}
+			for (const std::string &name : query.columns) {
+				columns.push_back(reader.FindColumn(name.c_str()));
+				if (columns.back() < 0) {
+					fprintf(stderr, "%s: no column \"%s\"\n", path,
+							name.c_str());
+				}
+			}
+		}
+		QueryRows(path, reader, query, columns, range.modeStartUs, out);
+	}
+	return true;
+}
+
+void Usage(const char *name) {
+	fprintf(stderr, "usage: %s [-m disabled|auto|teleop|test] [-f from_s] "
+			"[-t to_s]\n"
+			"           [-c column,column...] [-j threads] log.bin...\n",
+			name);
+}
+
+}
+
+int main(int argc, char **argv) {
+	Query query = {-1, 0, UINT64_MAX, {}};
+	unsigned int numThreads = std::thread::hardware_concurrency();
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:f:t:c:j:")) != -1) {
+		switch (opt) {
+			case 'm':
+				query.mode = ParseMode(optarg);
+				if (query.mode < 0) {
+					fprintf(stderr, "unknown mode \"%s\"\n", optarg);
+					return 2;
+				}
+				break;
+			case 'f':
+				query.fromUs = atof(optarg) * 1e6;
+				break;
+			case 't':
+				query.toUs = atof(optarg) * 1e6;
+				break;
+			case 'c':
+				query.columns = SplitColumns(optarg);
+				break;
+			case 'j':
+				numThreads = atoi(optarg);
+				break;
+			default:
+				Usage(argv[0]);
+				return 2;
+		}
+	}
+	if (optind == argc) {
+		Usage(argv[0]);
+		return 2;
+	}
+	if (numThreads < 1) {
+		numThreads = 1;
+	}
+
+	int numLogs = argc - optind;
+	std::vector<std::string> results(numLogs);
+	std::vector<char> ok(numLogs, false);
+	std::atomic<int> nextLog(0);
+	std::vector<std::thread> threads;
+
+	/* each thread takes the next log nobody has started on yet */
+	for (unsigned int i = 0; i < numThreads && (int) i < numLogs; i++) {
+		threads.emplace_back([&]() {
+			int log;
+
+			while ((log = nextLog.fetch_add(1)) < numLogs) {
+				ok[log] = QueryLog(argv[optind + log], query, &results[log]);
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	printf("\"file\",\"mode\",\"time\",");
+	if (query.columns.empty()) {
+		BinaryLogReader first;
+
+		/* every column of the first log; logs from the same code have the
+		 * same ones */
+		if (first.Open(argv[optind], 0, 0)) {
+			for (int col = 0; col < first.GetNumColumns(); col++) {
+				printf("\"%s\",", first.GetColumnName(col));
+			}
+		}
+	}
+	for (const std::string &name : query.columns) {
+		printf("\"%s\",", name.c_str());
+	}
+	putchar('\n');
+
+	int failed = 0;
+	for (int log = 0; log < numLogs; log++) {
+		fputs(results[log].c_str(), stdout);
+		failed += !ok[log];
+	}
+	return failed != 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * LogToCsv.cpp
+ *
+ * logtocsv - turn a binary robot log back into the quoted CSV LogSpreadsheet
+ * writes in LOG_FORMAT_CSV mode, so the existing log tooling can read it.
+ *
+ *     logtocsv log-123456.bin [log-123456.txt]
+ *
+ * Writes to stdout if no output file is given.
+ */
+
+#include <stdio.h>
+
+#include "BinaryLogReader.h"
+
+using namespace frc973;
+
+int main(int argc, char **argv) {
+	BinaryLogReader reader;
+	FILE *out = stdout;
+	uint64_t skipped;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: %s log.bin [out.csv]\n", argv[0]);
+		return 2;
+	}
+	if (!reader.Open(argv[1])) {
+		return 1;
+	}
+	if (argc == 3) {
+		out = fopen(argv[2], "w");
+		if (out == NULL) {
+			perror(argv[2]);
+			return 1;
+		}
+	}
+
+	skipped = reader.WriteCsv(out);
+	if (skipped != 0) {
+		fprintf(stderr, "%s: skipped %llu corrupt rows\n", argv[1],
+				(unsigned long long) skipped);
+	}
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}